@@ -14,13 +14,20 @@ layout (std430, binding = 0) buffer GridBuffer		{ CellGrid		grid[]; };
 
 uniform int		boundarySize;
 uniform uint	numCells;
+uniform uvec3	regionMin;
+uniform uvec3	regionSize;
 
 void main()
 {
-	const uint index = gl_GlobalInvocationID.x;
-	if (index >= numCells || grid[index].value <= VOXEL_FREE) return;
+	if (gl_GlobalInvocationID.x >= numCells) return;
 
-	ivec3 gridIndex = ivec3(getPosition(index));
+	// Threads only visit the region, whose size is given by numCells
+	const uint regionIndex = gl_GlobalInvocationID.x;
+	const uvec3 position = regionMin + uvec3(regionIndex / (regionSize.y * regionSize.z), (regionIndex / regionSize.z) % regionSize.y, regionIndex % regionSize.z);
+	const uint index = getPositionIndex(position);
+	if (grid[index].value <= VOXEL_FREE) return;
+
+	ivec3 gridIndex = ivec3(position);
 	ivec3 gridIndex_minusOne = clamp(gridIndex - ivec3(boundarySize), ivec3(0), ivec3(gridDims) - ivec3(1));
 	ivec3 gridIndex_plusOne = clamp(gridIndex + ivec3(boundarySize), ivec3(0), ivec3(gridDims) - ivec3(1));
 	bool boundary = false;
@@ -30,19 +30,17 @@ void main()
 	uint stackIdx = uint(floor(index / numNeighbors));
 	uvec4 gridPos = uvec4(getPosition(stack01[stackIdx]), grid[stack01[stackIdx]].value);
 
+	// Checked before indexing, since neighbours of border voxels fall outside the grid
 	ivec4 neighbor = ivec4(gridPos) + neighborOffset[neighborOffsetIdx];
-	uint neighborIdx = getPositionIndex(neighbor.xyz);
+	bool isOutside = neighbor.x < 0 || neighbor.x >= gridDims.x ||
+					 neighbor.y < 0 || neighbor.y >= gridDims.y ||
+					 neighbor.z < 0 || neighbor.z >= gridDims.z;
+	if (isOutside) return;
 
+	uint neighborIdx = getPositionIndex(uvec3(neighbor.xyz));
 	if (grid[neighborIdx].value == gridPos.w && newGrid[neighborIdx].value == VOXEL_EMPTY)
 	{
-		bool isOutside = neighbor.x < 0 || neighbor.x >= gridDims.x ||
-						 neighbor.y < 0 || neighbor.y >= gridDims.y ||
-						 neighbor.z < 0 || neighbor.z >= gridDims.z;
-
-		if (!isOutside)
-		{
-			newGrid[neighborIdx].value = uint16_t(gridPos.w);
-			stack02[atomicAdd(stackCounter, 1)] = neighborIdx;
-		}
+		newGrid[neighborIdx].value = uint16_t(gridPos.w);
+		stack02[atomicAdd(stackCounter, 1)] = neighborIdx;
 	}
 }
\ No newline at end of file
@@ -33,6 +33,7 @@ void main()
 
 	if (maxCount > 0)
 	{
-		cluster[index] = (clusterIdx + uint(2)) * (float(boundary[baseIndex + clusterIdx] > 0) * 2.0f - 1.0f);
+		// Negative values flag boundary faces
+		cluster[index] = (clusterIdx + uint(2)) * (1.0f - float(boundary[baseIndex + clusterIdx] > 0) * 2.0f);
 	}
 }
\ No newline at end of file
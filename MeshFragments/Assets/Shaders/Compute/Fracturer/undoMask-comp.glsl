@@ -10,8 +10,12 @@ layout (local_size_variable) in;
 
 layout (std430, binding = 0) buffer GridBuffer { CellGrid	grid[]; };
 
+#include <Assets/Shaders/Compute/Fracturer/voxel.glsl>
+
 uniform uint numCells;
 uniform uint position;
+uniform uvec3 regionMin;
+uniform uvec3 regionSize;
 
 subroutine uint16_t unmaskType(uint index);
 subroutine uniform unmaskType unmaskUniform;
@@ -30,8 +34,10 @@ uint16_t unmaskRightMost(uint index)
 
 void main()
 {
-	const uint index = gl_GlobalInvocationID.x;
-	if (index >= numCells) return;
+	if (gl_GlobalInvocationID.x >= numCells) return;
+
+	const uint regionIndex = gl_GlobalInvocationID.x;
+	const uint index = getPositionIndex(regionMin + uvec3(regionIndex / (regionSize.y * regionSize.z), (regionIndex / regionSize.z) % regionSize.y, regionIndex % regionSize.z));
 
 	grid[index].value = unmaskUniform(index);
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "stdafx.h"
+#include "ContactGraph.h"
+
+#include "DataStructures/RegularGrid.h"
+#include "Utilities/FragmentArchive.h"
+
+/// Initialization of static attributes
+const std::string ContactGraph::EXTENSION = "_contacts.txt";
+
+// [Public methods]
+
+void ContactGraph::build(RegularGrid& grid)
+{
+	const uvec3 numDivs = grid._numDivs;
+	const unsigned stride[3] = { numDivs.y * numDivs.z, numDivs.z, 1 };
+	std::unordered_map<uint32_t, ContactSums> contacts;
+	std::vector<uint8_t> isUsed(1 << grid.MASK_POSITION, 0);
+
+	this->clear();
+
+	#pragma omp parallel
+	{
+		std::unordered_map<uint32_t, ContactSums> threadContacts;
+		std::vector<uint8_t> isUsedThread(1 << grid.MASK_POSITION, 0);
+
+		#pragma omp for
+		for (int x = 0; x < numDivs.x; ++x)
+		{
+			for (unsigned y = 0; y < numDivs.y; ++y)
+			{
+				for (unsigned z = 0; z < numDivs.z; ++z)
+				{
+					const unsigned index = grid.getPositionIndex(x, y, z);
+					const uint16_t label = grid.unmask(grid._grid[index]._value);
+					if (label <= VOXEL_FREE)
+						continue;
+
+					isUsedThread[label] = 1;
+
+					// Only the faces towards the next voxel along each axis are checked, so that every face is visited once
+					const uvec3 voxel(x, y, z);
+					for (int axis = 0; axis < 3; ++axis)
+					{
+						if (voxel[axis] + 1 >= numDivs[axis])
+							continue;
+
+						const uint16_t neighbourLabel = grid.unmask(grid._grid[index + stride[axis]]._value);
+						if (neighbourLabel <= VOXEL_FREE || neighbourLabel == label)
+							continue;
+
+						const bool isLower = label < neighbourLabel;
+						ContactSums& sums = threadContacts[isLower ? (uint32_t(label) << 16 | neighbourLabel) : (uint32_t(neighbourLabel) << 16 | label)];
+
+						++sums._numFaces[axis];
+						sums._orientation[axis] += isLower ? 1 : -1;
+						for (int i = 0; i < 3; ++i)
+							sums._position[axis][i] += voxel[i] * 2 + (i == axis ? 2 : 1);
+					}
+				}
+			}
+		}
+
+		#pragma omp critical
+		{
+			for (const auto& threadContact : threadContacts)
+			{
+				ContactSums& sums = contacts[threadContact.first];
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					sums._numFaces[axis] += threadContact.second._numFaces[axis];
+					sums._orientation[axis] += threadContact.second._orientation[axis];
+					for (int i = 0; i < 3; ++i)
+						sums._position[axis][i] += threadContact.second._position[axis][i];
+				}
+			}
+
+			for (int labelIdx = 0; labelIdx < isUsedThread.size(); ++labelIdx)
+				isUsed[labelIdx] |= isUsedThread[labelIdx];
+		}
+	}
+
+	for (int labelIdx = VOXEL_FREE + 1; labelIdx < isUsed.size(); ++labelIdx)
+		if (isUsed[labelIdx])
+			_labels.push_back(static_cast<uint16_t>(labelIdx));
+
+	std::vector<uint32_t> keys;
+	keys.reserve(contacts.size());
+	for (const auto& contact : contacts)
+		keys.push_back(contact.first);
+	std::sort(keys.begin(), keys.end());
+
+	// Faces orthogonal to each axis are weighted by their area, as voxels are not necessarily cubes
+	const vec3 cellSize = grid._cellSize, minPoint = grid._aabb.min();
+	const double faceArea[3] = { cellSize.y * cellSize.z, cellSize.x * cellSize.z, cellSize.x * cellSize.y };
+
+	_contacts.resize(keys.size());
+
+	#pragma omp parallel for
+	for (int contactIdx = 0; contactIdx < keys.size(); ++contactIdx)
+	{
+		const ContactSums& sums = contacts.at(keys[contactIdx]);
+		Contact& contact = _contacts[contactIdx];
+		double area = .0, centroid[3] = { .0, .0, .0 };
+		vec3 normal(.0f);
+
+		contact._labels[0] = static_cast<uint16_t>(keys[contactIdx] >> 16);
+		contact._labels[1] = static_cast<uint16_t>(keys[contactIdx] & 0xFFFF);
+		for (int i = 0; i < 2; ++i)
+			contact._fragments[i] = static_cast<unsigned>(std::lower_bound(_labels.begin(), _labels.end(), contact._labels[i]) - _labels.begin());
+
+		contact._numFaces = 0;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			contact._numFaces += static_cast<unsigned>(sums._numFaces[axis]);
+			area += faceArea[axis] * sums._numFaces[axis];
+			normal[axis] = static_cast<float>(faceArea[axis] * sums._orientation[axis]);
+
+			for (int i = 0; i < 3; ++i)
+				centroid[i] += faceArea[axis] * sums._position[axis][i];
+		}
+
+		contact._area = static_cast<float>(area);
+		for (int i = 0; i < 3; ++i)
+			contact._centroid[i] = minPoint[i] + static_cast<float>(centroid[i] / (2.0 * area)) * cellSize[i];
+		contact._normal = glm::length(normal) > glm::epsilon<float>() ? glm::normalize(normal) : vec3(.0f);
+	}
+}
+
+void ContactGraph::clear()
+{
+	_contacts.clear();
+	_labels.clear();
+}
+
+bool ContactGraph::save(const std::string& filename, FragmentArchive* archive) const
+{
+	std::ostringstream stream;
+	stream << "Fragment A\tFragment B\tLabel A\tLabel B\tFaces\tArea\tCentroid x\tCentroid y\tCentroid z\tNormal x\tNormal y\tNormal z" << std::endl;
+
+	for (const Contact& contact : _contacts)
+	{
+		stream <<
+			contact._fragments[0] << "\t" << contact._fragments[1] << "\t" <<
+			contact._labels[0] << "\t" << contact._labels[1] << "\t" <<
+			contact._numFaces << "\t" << contact._area << "\t" <<
+			contact._centroid.x << "\t" << contact._centroid.y << "\t" << contact._centroid.z << "\t" <<
+			contact._normal.x << "\t" << contact._normal.y << "\t" << contact._normal.z << std::endl;
+	}
+
+	if (archive)
+		return archive->append(std::filesystem::path(filename + EXTENSION).filename().string(), stream.str());
+
+	std::ofstream file(filename + EXTENSION);
+	if (file.fail()) return false;
+
+	file << stream.str();
+	file.close();
+
+	return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+/**
+*	@file ContactGraph.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+class FragmentArchive;
+class RegularGrid;
+
+/**
+*	@brief Adjacency between the fragments of a labelled grid. Every pair of fragments sharing at least one voxel face is a contact, 
+*	described by the shared faces, their area, centroid and mean normal. Sums are kept in integer voxel units, so the result does not
+*	depend on the number of threads.
+*/
+class ContactGraph
+{
+public:
+	const static std::string EXTENSION;							//!< Suffix of the exported contact files
+
+	struct Contact
+	{
+		unsigned	_fragments[2];								//!< Index of both fragments, as in RegularGrid::toTriangleMesh
+		uint16_t	_labels[2];									//!< Grid value of both fragments, the lower one first
+		unsigned	_numFaces;									//!< Voxel faces shared by both fragments
+		float		_area;										//!< Area of the shared faces
+		vec3		_centroid;									//!< Area-weighted centroid of the shared faces
+		vec3		_normal;									//!< Mean normal of the interface, from the first fragment towards the second one
+	};
+
+protected:
+	struct ContactSums
+	{
+		uint64_t	_numFaces[3];								//!< Shared faces orthogonal to each axis
+		int64_t		_orientation[3];							//!< Faces where the lower label precedes the higher one along each axis, minus the opposite ones
+		uint64_t	_position[3][3];							//!< Sum of the face centres orthogonal to each axis, in half voxels
+
+		ContactSums() : _numFaces{ 0, 0, 0 }, _orientation{ 0, 0, 0 }, _position{ { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } } {}
+	};
+
+protected:
+	std::vector<Contact>		_contacts;						//!< Contacts sorted by labels
+	std::vector<uint16_t>		_labels;						//!< Sorted labels of the fragments
+
+public:
+	/**
+	*	@brief Builds the contacts from the labels of the grid in a single pass over its voxels.
+	*/
+	void build(RegularGrid& grid);
+
+	/**
+	*	@brief Removes every contact.
+	*/
+	void clear();
+
+	/**
+	*	@return Contacts between fragments.
+	*/
+	const std::vector<Contact>& getContacts() const { return _contacts; }
+
+	/**
+	*	@return Sorted labels of the fragments found in the grid.
+	*/
+	const std::vector<uint16_t>& getLabels() const { return _labels; }
+
+	/**
+	*	@brief Saves the contacts as a tab-separated table, appended to the archive if given.
+	*/
+	bool save(const std::string& filename, FragmentArchive* archive = nullptr) const;
+};
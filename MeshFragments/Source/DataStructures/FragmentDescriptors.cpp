@@ -0,0 +1,183 @@
+#include "stdafx.h"
+#include "FragmentDescriptors.h"
+
+#include "DataStructures/RegularGrid.h"
+#include "Utilities/FragmentArchive.h"
+#include "Utilities/NumpyFile.h"
+
+/// Initialization of static attributes
+const std::string FragmentDescriptors::EXTENSION = "_descriptors.npz";
+
+// [Public methods]
+
+void FragmentDescriptors::build(RegularGrid& grid, const std::vector<vec2>& surfaceArea)
+{
+	const uvec3 numDivs = grid._numDivs;
+	std::vector<VoxelSums> sums;
+
+	this->clear();
+
+	#pragma omp parallel
+	{
+		std::vector<VoxelSums> threadSums;						// Indexed by label, which are few and low
+
+		#pragma omp for
+		for (int x = 0; x < numDivs.x; ++x)
+		{
+			for (unsigned y = 0; y < numDivs.y; ++y)
+			{
+				for (unsigned z = 0; z < numDivs.z; ++z)
+				{
+					const uint16_t label = grid.unmask(grid._grid[grid.getPositionIndex(x, y, z)]._value);
+					if (label <= VOXEL_FREE)
+						continue;
+
+					if (label >= threadSums.size())
+						threadSums.resize(label + 1);
+
+					VoxelSums& voxelSums = threadSums[label];
+					const uvec3 voxel(x, y, z);
+
+					++voxelSums._count;
+					voxelSums._sum[0] += x;
+					voxelSums._sum[1] += y;
+					voxelSums._sum[2] += z;
+					voxelSums._sumProducts[0] += uint64_t(x) * x;
+					voxelSums._sumProducts[1] += uint64_t(y) * y;
+					voxelSums._sumProducts[2] += uint64_t(z) * z;
+					voxelSums._sumProducts[3] += uint64_t(x) * y;
+					voxelSums._sumProducts[4] += uint64_t(x) * z;
+					voxelSums._sumProducts[5] += uint64_t(y) * z;
+					voxelSums._min = glm::min(voxelSums._min, voxel);
+					voxelSums._max = glm::max(voxelSums._max, voxel);
+				}
+			}
+		}
+
+		#pragma omp critical
+		{
+			if (threadSums.size() > sums.size())
+				sums.resize(threadSums.size());
+
+			for (int label = 0; label < threadSums.size(); ++label)
+			{
+				const VoxelSums& threadVoxelSums = threadSums[label];
+				if (!threadVoxelSums._count)
+					continue;
+
+				VoxelSums& voxelSums = sums[label];
+				voxelSums._count += threadVoxelSums._count;
+				for (int i = 0; i < 3; ++i)
+					voxelSums._sum[i] += threadVoxelSums._sum[i];
+				for (int i = 0; i < 6; ++i)
+					voxelSums._sumProducts[i] += threadVoxelSums._sumProducts[i];
+				voxelSums._min = glm::min(voxelSums._min, threadVoxelSums._min);
+				voxelSums._max = glm::max(voxelSums._max, threadVoxelSums._max);
+			}
+		}
+	}
+
+	for (int label = 0; label < sums.size(); ++label)
+	{
+		if (sums[label]._count)
+		{
+			_descriptors.push_back(Descriptor());
+			_descriptors.back()._label = static_cast<uint16_t>(label);
+		}
+	}
+
+	// Moments are computed in voxel units and then scaled, adding the inertia of each voxel around its own centre
+	const vec3 cellSize = grid._cellSize, minPoint = grid._aabb.min();
+	const double cellVolume = static_cast<double>(cellSize.x) * cellSize.y * cellSize.z;
+	const int productIdx[3][3] = { { 0, 3, 4 }, { 3, 1, 5 }, { 4, 5, 2 } };
+
+	#pragma omp parallel for
+	for (int descriptorIdx = 0; descriptorIdx < _descriptors.size(); ++descriptorIdx)
+	{
+		Descriptor& descriptor = _descriptors[descriptorIdx];
+		const VoxelSums& voxelSums = sums[descriptor._label];
+		const double count = static_cast<double>(voxelSums._count), volume = count * cellVolume;
+		double mean[3], secondMoment[3][3], trace = .0;
+
+		for (int i = 0; i < 3; ++i)
+			mean[i] = voxelSums._sum[i] / count;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				const double covariance = voxelSums._sumProducts[productIdx[i][j]] / count - mean[i] * mean[j] + (i == j ? 1.0 / 12.0 : .0);
+				secondMoment[i][j] = volume * covariance * cellSize[i] * cellSize[j];
+			}
+
+			trace += secondMoment[i][i];
+		}
+
+		descriptor._voxels = static_cast<uint32_t>(voxelSums._count);
+		descriptor._volume = static_cast<float>(volume);
+		descriptor._aabbMin = minPoint + vec3(voxelSums._min) * cellSize;
+		descriptor._aabbMax = minPoint + vec3(voxelSums._max + uvec3(1)) * cellSize;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			descriptor._centroid[i] = minPoint[i] + static_cast<float>(mean[i] + .5) * cellSize[i];
+			for (int j = 0; j < 3; ++j)
+				descriptor._inertia[i][j] = static_cast<float>((i == j ? trace : .0) - secondMoment[i][j]);
+		}
+
+		const vec2 area = descriptorIdx < surfaceArea.size() ? surfaceArea[descriptorIdx] : vec2(.0f);
+		descriptor._crackArea = area.x;
+		descriptor._surfaceArea = area.x + area.y;
+		descriptor._breakageRatio = descriptor._surfaceArea > glm::epsilon<float>() ? descriptor._crackArea / descriptor._surfaceArea : .0f;
+	}
+}
+
+bool FragmentDescriptors::save(const std::string& filename, FragmentArchive* archive) const
+{
+	const size_t numFragments = _descriptors.size();
+	std::vector<uint16_t> labels(numFragments);
+	std::vector<uint32_t> voxels(numFragments);
+	std::vector<float> volume(numFragments), surfaceArea(numFragments), crackArea(numFragments), breakageRatio(numFragments);
+	std::vector<float> aabb(numFragments * 6), centroid(numFragments * 3), inertia(numFragments * 9);
+
+	#pragma omp parallel for
+	for (int idx = 0; idx < numFragments; ++idx)
+	{
+		const Descriptor& descriptor = _descriptors[idx];
+		labels[idx] = descriptor._label;
+		voxels[idx] = descriptor._voxels;
+		volume[idx] = descriptor._volume;
+		surfaceArea[idx] = descriptor._surfaceArea;
+		crackArea[idx] = descriptor._crackArea;
+		breakageRatio[idx] = descriptor._breakageRatio;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			aabb[idx * 6 + i] = descriptor._aabbMin[i];
+			aabb[idx * 6 + 3 + i] = descriptor._aabbMax[i];
+			centroid[idx * 3 + i] = descriptor._centroid[i];
+
+			for (int j = 0; j < 3; ++j)
+				inertia[idx * 9 + i * 3 + j] = descriptor._inertia[j][i];
+		}
+	}
+
+	NumpyFile::NpzArchive npzArchive;
+	npzArchive.add("labels", "<u2", { numFragments }, labels.data(), labels.size() * sizeof(uint16_t));
+	npzArchive.add("voxels", "<u4", { numFragments }, voxels.data(), voxels.size() * sizeof(uint32_t));
+	npzArchive.add("volume", "<f4", { numFragments }, volume.data(), volume.size() * sizeof(float));
+	npzArchive.add("surface_area", "<f4", { numFragments }, surfaceArea.data(), surfaceArea.size() * sizeof(float));
+	npzArchive.add("crack_area", "<f4", { numFragments }, crackArea.data(), crackArea.size() * sizeof(float));
+	npzArchive.add("breakage_ratio", "<f4", { numFragments }, breakageRatio.data(), breakageRatio.size() * sizeof(float));
+	npzArchive.add("aabb", "<f4", { numFragments, 2, 3 }, aabb.data(), aabb.size() * sizeof(float));
+	npzArchive.add("centroid", "<f4", { numFragments, 3 }, centroid.data(), centroid.size() * sizeof(float));
+	npzArchive.add("inertia", "<f4", { numFragments, 3, 3 }, inertia.data(), inertia.size() * sizeof(float));
+
+	if (archive)
+	{
+		std::ostringstream stream(std::ios::out | std::ios::binary);
+		return npzArchive.write(stream) && archive->append(std::filesystem::path(filename + EXTENSION).filename().string(), stream.str());
+	}
+
+	return npzArchive.write(filename + EXTENSION);
+}
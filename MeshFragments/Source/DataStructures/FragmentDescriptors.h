@@ -0,0 +1,70 @@
+#pragma once
+
+/**
+*	@file FragmentDescriptors.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+class FragmentArchive;
+class RegularGrid;
+
+/**
+*	@brief Geometric descriptors of the fragments of a labelled grid. Volume, bounding box, centroid and inertia tensor are accumulated 
+*	from the voxels in a single pass, whereas the surface area is measured by marching cubes as triangles are emitted, split into crack and 
+*	original surface according to the boundary mask. Descriptors are exported as a NumPy archive with one array per descriptor.
+*/
+class FragmentDescriptors
+{
+public:
+	const static std::string EXTENSION;							//!< Suffix of the exported descriptor files
+
+	struct Descriptor
+	{
+		uint16_t	_label;										//!< Grid value of the fragment
+		uint32_t	_voxels;									//!< Number of voxels of the fragment
+		float		_volume;									//!< Volume of the voxels
+		vec3		_aabbMin, _aabbMax;							//!< Bounding box of the voxels
+		vec3		_centroid;									//!< Centre of mass, with uniform density
+		mat3		_inertia;									//!< Inertia tensor about the centroid, with unit density
+		float		_surfaceArea;								//!< Area of the fragment mesh
+		float		_crackArea;									//!< Area of the triangles emitted from voxels masked as boundary
+		float		_breakageRatio;								//!< Fraction of the surface area originated by the fracture
+	};
+
+protected:
+	struct VoxelSums
+	{
+		uint64_t	_count;										//!< Number of voxels
+		uint64_t	_sum[3];									//!< Sum of the voxel indices along each axis
+		uint64_t	_sumProducts[6];							//!< Sum of xx, yy, zz, xy, xz and yz index products
+		uvec3		_min, _max;									//!< Bounding box, in voxels
+
+		VoxelSums() : _count(0), _sum{ 0, 0, 0 }, _sumProducts{ 0, 0, 0, 0, 0, 0 }, _min(std::numeric_limits<unsigned>::max()), _max(0) {}
+	};
+
+protected:
+	std::vector<Descriptor>		_descriptors;					//!< Descriptors of each fragment, sorted by label
+
+public:
+	/**
+	*	@brief Computes the descriptors of every fragment in a single pass over the grid.
+	*	@param surfaceArea Crack and original surface area of each fragment, sorted by label, as measured by RegularGrid::toTriangleMesh.
+	*/
+	void build(RegularGrid& grid, const std::vector<vec2>& surfaceArea);
+
+	/**
+	*	@brief Removes every descriptor.
+	*/
+	void clear() { _descriptors.clear(); }
+
+	/**
+	*	@return Descriptors of each fragment.
+	*/
+	const std::vector<Descriptor>& getDescriptors() const { return _descriptors; }
+
+	/**
+	*	@brief Saves the descriptors as an .npz archive, appended to the fragment archive if given.
+	*/
+	bool save(const std::string& filename, FragmentArchive* archive = nullptr) const;
+};
@@ -0,0 +1,101 @@
+#include "stdafx.h"
+#include "GridStatistics.h"
+
+#include "DataStructures/RegularGrid.h"
+
+// [Public methods]
+
+void GridStatistics::build(RegularGrid& grid)
+{
+	const uvec3 numDivs = grid._numDivs;
+	const uint16_t labelMask = uint16_t(~(1 << grid.MASK_POSITION));
+	std::vector<unsigned> voxels, boundaryVoxels;
+	std::vector<uvec3> minVoxel, maxVoxel;
+
+	_labels.clear();
+	_numOccupiedVoxels = 0;
+
+	#pragma omp parallel
+	{
+		// Dense counters indexed by label, grown up to the highest label found by each thread
+		std::vector<unsigned> threadVoxels, threadBoundaryVoxels;
+		std::vector<uvec3> threadMin, threadMax;
+
+		#pragma omp for
+		for (int x = 0; x < numDivs.x; ++x)
+		{
+			for (unsigned y = 0; y < numDivs.y; ++y)
+			{
+				// Rows are contiguous along z, hence each run of the same label is counted at once
+				const RegularGrid::CellGrid* row = grid._grid.data() + grid.getPositionIndex(x, y, 0);
+				unsigned z = 0;
+
+				while (z < numDivs.z)
+				{
+					const uint16_t label = row[z]._value & labelMask;
+					const unsigned runStart = z;
+					unsigned numBoundaryVoxels = 0;
+
+					for (; z < numDivs.z && (row[z]._value & labelMask) == label; ++z)
+						numBoundaryVoxels += row[z]._value >> grid.MASK_POSITION;
+
+					if (label <= VOXEL_FREE)
+						continue;
+
+					if (label >= threadVoxels.size())
+					{
+						threadVoxels.resize(label + 1, 0);
+						threadBoundaryVoxels.resize(label + 1, 0);
+						threadMin.resize(label + 1, uvec3(std::numeric_limits<unsigned>::max()));
+						threadMax.resize(label + 1, uvec3(0));
+					}
+
+					threadVoxels[label] += z - runStart;
+					threadBoundaryVoxels[label] += numBoundaryVoxels;
+					threadMin[label] = glm::min(threadMin[label], uvec3(x, y, runStart));
+					threadMax[label] = glm::max(threadMax[label], uvec3(x, y, z - 1));
+				}
+			}
+		}
+
+		#pragma omp critical
+		{
+			if (threadVoxels.size() > voxels.size())
+			{
+				voxels.resize(threadVoxels.size(), 0);
+				boundaryVoxels.resize(threadVoxels.size(), 0);
+				minVoxel.resize(threadVoxels.size(), uvec3(std::numeric_limits<unsigned>::max()));
+				maxVoxel.resize(threadVoxels.size(), uvec3(0));
+			}
+
+			for (int label = 0; label < threadVoxels.size(); ++label)
+			{
+				if (!threadVoxels[label])
+					continue;
+
+				voxels[label] += threadVoxels[label];
+				boundaryVoxels[label] += threadBoundaryVoxels[label];
+				minVoxel[label] = glm::min(minVoxel[label], threadMin[label]);
+				maxVoxel[label] = glm::max(maxVoxel[label], threadMax[label]);
+			}
+		}
+	}
+
+	for (int label = 0; label < voxels.size(); ++label)
+	{
+		if (voxels[label])
+		{
+			_labels.push_back(Label{ static_cast<uint16_t>(label), voxels[label], boundaryVoxels[label], minVoxel[label], maxVoxel[label] });
+			_numOccupiedVoxels += voxels[label];
+		}
+	}
+}
+
+std::vector<uint16_t> GridStatistics::getValues() const
+{
+	std::vector<uint16_t> values(_labels.size());
+	for (int idx = 0; idx < _labels.size(); ++idx)
+		values[idx] = _labels[idx]._value;
+
+	return values;
+}
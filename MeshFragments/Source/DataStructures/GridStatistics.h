@@ -0,0 +1,60 @@
+#pragma once
+
+/**
+*	@file GridStatistics.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+class RegularGrid;
+
+/**
+*	@brief Histogram of the labels of a regular grid, along with the bounding box and boundary voxels of each label. Everything is gathered
+*	in a single parallel pass over the rows of the grid, where each thread counts into dense arrays indexed by label that are merged at the end.
+*/
+class GridStatistics
+{
+public:
+	struct Label
+	{
+		uint16_t	_value;										//!< Grid value, without the boundary mask
+		unsigned	_voxels;									//!< Number of voxels with this value
+		unsigned	_boundaryVoxels;							//!< Voxels masked as boundary
+		uvec3		_min, _max;									//!< Bounding box, in voxels
+	};
+
+protected:
+	std::vector<Label>			_labels;						//!< Labels found in the grid, sorted by value
+	unsigned					_numOccupiedVoxels;				//!< Voxels with any label
+
+public:
+	/**
+	*	@brief Default constructor.
+	*/
+	GridStatistics() : _numOccupiedVoxels(0) {}
+
+	/**
+	*	@brief Gathers the statistics of every label of the grid, ignoring empty and free voxels.
+	*/
+	void build(RegularGrid& grid);
+
+	/**
+	*	@return Statistics of each label, sorted by value.
+	*/
+	const std::vector<Label>& getLabels() const { return _labels; }
+
+	/**
+	*	@return Number of different labels in the grid.
+	*/
+	size_t getNumLabels() const { return _labels.size(); }
+
+	/**
+	*	@return Number of voxels with any label.
+	*/
+	unsigned getNumOccupiedVoxels() const { return _numOccupiedVoxels; }
+
+	/**
+	*	@return Sorted values of the labels in the grid.
+	*/
+	std::vector<uint16_t> getValues() const;
+};
@@ -0,0 +1,307 @@
+#include "stdafx.h"
+#include "LinearBvh.h"
+
+// [Public methods]
+
+LinearBvh::LinearBvh(Model3D* model)
+{
+	std::vector<unsigned> faceIdx, modelCompIdx;
+	std::vector<Model3D::ModelComponent*> modelComponents = model->getModelComponents();
+
+	for (unsigned compIdx = 0; compIdx < modelComponents.size(); ++compIdx)
+	{
+		for (unsigned idx = 0; idx < modelComponents[compIdx]->_topology.size(); ++idx)
+		{
+			faceIdx.push_back(idx);
+			modelCompIdx.push_back(compIdx);
+		}
+	}
+
+	const unsigned numTriangles = static_cast<unsigned>(faceIdx.size());
+	std::vector<vec3> vertices(numTriangles * 3);
+	std::vector<AABB> triangleAABB(numTriangles);
+
+	#pragma omp parallel for
+	for (int idx = 0; idx < numTriangles; ++idx)
+	{
+		const Model3D::ModelComponent* modelComponent = modelComponents[modelCompIdx[idx]];
+		const Model3D::FaceGPUData& face = modelComponent->_topology[faceIdx[idx]];
+
+		for (int i = 0; i < 3; ++i)
+		{
+			vertices[idx * 3 + i] = modelComponent->_geometry[face._vertices[i]]._position;
+			triangleAABB[idx].update(vertices[idx * 3 + i]);
+		}
+	}
+
+	for (const AABB& aabb : triangleAABB)
+		_aabb.update(aabb);
+
+	// Centroids are quantized within the mesh bounds and sorted along the Z-order curve
+	const vec3 scale = vec3((1 << MORTON_BITS) - 1) / glm::max(_aabb.size(), vec3(glm::epsilon<float>()));
+	std::vector<unsigned> mortonCode(numTriangles), order(numTriangles), sortedCode(numTriangles);
+
+	#pragma omp parallel for
+	for (int idx = 0; idx < numTriangles; ++idx)
+	{
+		mortonCode[idx] = getMortonCode(uvec3((triangleAABB[idx].center() - _aabb.min()) * scale));
+		order[idx] = idx;
+	}
+
+	std::sort(std::execution::par_unseq, order.begin(), order.end(), [&](unsigned a, unsigned b) { return mortonCode[a] < mortonCode[b] || (mortonCode[a] == mortonCode[b] && a < b); });
+
+	#pragma omp parallel for
+	for (int idx = 0; idx < numTriangles; ++idx)
+		sortedCode[idx] = mortonCode[order[idx]];
+
+	if (numTriangles)
+		this->buildNode(sortedCode, triangleAABB, order, 0, numTriangles);
+
+	// Triangles are stored in the order of the leaves, with the edges needed by the intersection test
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		_vertex[axis].resize(numTriangles);
+		_edge1[axis].resize(numTriangles);
+		_edge2[axis].resize(numTriangles);
+	}
+	_faceIdx.resize(numTriangles);
+	_modelCompIdx.resize(numTriangles);
+
+	#pragma omp parallel for
+	for (int idx = 0; idx < numTriangles; ++idx)
+	{
+		const unsigned triangleIdx = order[idx];
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			_vertex[axis][idx] = vertices[triangleIdx * 3][axis];
+			_edge1[axis][idx] = vertices[triangleIdx * 3 + 1][axis] - vertices[triangleIdx * 3][axis];
+			_edge2[axis][idx] = vertices[triangleIdx * 3 + 2][axis] - vertices[triangleIdx * 3][axis];
+		}
+
+		_faceIdx[idx] = faceIdx[triangleIdx];
+		_modelCompIdx[idx] = modelCompIdx[triangleIdx];
+	}
+}
+
+LinearBvh::~LinearBvh()
+{
+}
+
+LinearBvh::RayHit LinearBvh::intersect(const vec3& origin, const vec3& direction, float maxDistance) const
+{
+	float packetOrigin[3 * PACKET_SIZE], packetDirection[3 * PACKET_SIZE], distance[PACKET_SIZE];
+	unsigned triangle[PACKET_SIZE];
+	RayHit hit;
+
+	// Only the first lane is used
+	std::fill(packetOrigin, packetOrigin + 3 * PACKET_SIZE, .0f);
+	std::fill(packetDirection, packetDirection + 3 * PACKET_SIZE, 1.0f);
+	std::fill(distance, distance + PACKET_SIZE, -1.0f);
+	std::fill(triangle, triangle + PACKET_SIZE, NO_TRIANGLE);
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		packetOrigin[axis * PACKET_SIZE] = origin[axis];
+		packetDirection[axis * PACKET_SIZE] = direction[axis];
+	}
+	distance[0] = maxDistance;
+
+	this->intersectPacket(packetOrigin, packetDirection, distance, triangle);
+
+	if (triangle[0] != NO_TRIANGLE)
+	{
+		hit._distance = distance[0];
+		hit._faceIdx = _faceIdx[triangle[0]];
+		hit._modelCompIdx = _modelCompIdx[triangle[0]];
+	}
+
+	return hit;
+}
+
+void LinearBvh::intersect(const std::vector<Model3D::RayGPUData>& rays, std::vector<RayHit>& hits) const
+{
+	const int numPackets = static_cast<int>((rays.size() + PACKET_SIZE - 1) / PACKET_SIZE);
+	hits.resize(rays.size());
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int packetIdx = 0; packetIdx < numPackets; ++packetIdx)
+	{
+		float origin[3 * PACKET_SIZE], direction[3 * PACKET_SIZE], distance[PACKET_SIZE];
+		unsigned triangle[PACKET_SIZE];
+		const size_t firstRay = static_cast<size_t>(packetIdx) * PACKET_SIZE, numRays = std::min(rays.size() - firstRay, static_cast<size_t>(PACKET_SIZE));
+
+		for (unsigned lane = 0; lane < PACKET_SIZE; ++lane)
+		{
+			const bool isActive = lane < numRays;
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				origin[axis * PACKET_SIZE + lane] = isActive ? rays[firstRay + lane]._origin[axis] : .0f;
+				direction[axis * PACKET_SIZE + lane] = isActive ? rays[firstRay + lane]._direction[axis] : 1.0f;
+			}
+
+			distance[lane] = isActive ? FLT_MAX : -1.0f;
+			triangle[lane] = NO_TRIANGLE;
+		}
+
+		this->intersectPacket(origin, direction, distance, triangle);
+
+		for (unsigned lane = 0; lane < numRays; ++lane)
+		{
+			RayHit& hit = hits[firstRay + lane];
+			hit = RayHit();
+
+			if (triangle[lane] != NO_TRIANGLE)
+			{
+				hit._distance = distance[lane];
+				hit._faceIdx = _faceIdx[triangle[lane]];
+				hit._modelCompIdx = _modelCompIdx[triangle[lane]];
+			}
+		}
+	}
+}
+
+// [Protected methods]
+
+unsigned LinearBvh::buildNode(const std::vector<unsigned>& mortonCode, const std::vector<AABB>& triangleAABB, const std::vector<unsigned>& order, unsigned begin, unsigned end)
+{
+	const unsigned nodeIdx = static_cast<unsigned>(_nodeCount.size());
+	AABB aabb;
+
+	for (unsigned idx = begin; idx < end; ++idx)
+		aabb.update(triangleAABB[order[idx]]);
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		_nodeMin[axis].push_back(aabb.min()[axis]);
+		_nodeMax[axis].push_back(aabb.max()[axis]);
+	}
+	_nodeAxis.push_back(0);
+	_nodeCount.push_back(end - begin);
+	_nodeOffset.push_back(begin);
+
+	if (end - begin <= MAX_LEAF_TRIANGLES)
+		return nodeIdx;
+
+	uint8_t axis;
+	const unsigned split = getSplit(mortonCode, begin, end, axis);
+
+	this->buildNode(mortonCode, triangleAABB, order, begin, split);
+	const unsigned secondChild = this->buildNode(mortonCode, triangleAABB, order, split, end);
+
+	_nodeAxis[nodeIdx] = axis;
+	_nodeCount[nodeIdx] = 0;
+	_nodeOffset[nodeIdx] = secondChild;
+
+	return nodeIdx;
+}
+
+unsigned LinearBvh::getMortonCode(const uvec3& position)
+{
+	unsigned code = 0;
+
+	for (unsigned bit = 0; bit < MORTON_BITS; ++bit)
+		code |= ((position.x >> bit) & 1) << (3 * bit + 2) | ((position.y >> bit) & 1) << (3 * bit + 1) | ((position.z >> bit) & 1) << (3 * bit);
+
+	return code;
+}
+
+unsigned LinearBvh::getSplit(const std::vector<unsigned>& mortonCode, unsigned begin, unsigned end, uint8_t& axis)
+{
+	const unsigned difference = mortonCode[begin] ^ mortonCode[end - 1];
+	axis = 0;
+
+	if (!difference)
+		return (begin + end) / 2;
+
+	unsigned bit = 3 * MORTON_BITS - 1;
+	while (!(difference & (1u << bit)))
+		--bit;
+
+	// Codes of the range share every bit above the differing one, so those without it come first
+	axis = 2 - bit % 3;
+	return static_cast<unsigned>(std::partition_point(mortonCode.begin() + begin, mortonCode.begin() + end, [bit](unsigned code) { return !(code & (1u << bit)); }) - mortonCode.begin());
+}
+
+void LinearBvh::intersectPacket(const float* origin, const float* direction, float* distance, unsigned* triangle) const
+{
+	float invDirection[3 * PACKET_SIZE];
+	unsigned stack[STACK_SIZE], stackSize = 0;
+
+	if (_nodeCount.empty())
+		return;
+
+	for (int idx = 0; idx < 3 * PACKET_SIZE; ++idx)
+		invDirection[idx] = 1.0f / direction[idx];
+
+	stack[stackSize++] = 0;
+
+	while (stackSize)
+	{
+		const unsigned nodeIdx = stack[--stackSize];
+		float tMin[PACKET_SIZE], tMax[PACKET_SIZE];
+		unsigned activeLanes = 0;
+
+		// Slab test of every lane against the node bounds
+		for (unsigned lane = 0; lane < PACKET_SIZE; ++lane)
+		{
+			tMin[lane] = .0f;
+			tMax[lane] = distance[lane];
+		}
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float nodeMin = _nodeMin[axis][nodeIdx], nodeMax = _nodeMax[axis][nodeIdx];
+			const float* laneOrigin = origin + axis * PACKET_SIZE, * laneInvDirection = invDirection + axis * PACKET_SIZE;
+
+			for (unsigned lane = 0; lane < PACKET_SIZE; ++lane)
+			{
+				const float t0 = (nodeMin - laneOrigin[lane]) * laneInvDirection[lane], t1 = (nodeMax - laneOrigin[lane]) * laneInvDirection[lane];
+				tMin[lane] = std::max(tMin[lane], std::min(t0, t1));
+				tMax[lane] = std::min(tMax[lane], std::max(t0, t1));
+			}
+		}
+
+		for (unsigned lane = 0; lane < PACKET_SIZE; ++lane)
+			activeLanes += tMin[lane] <= tMax[lane];
+
+		if (!activeLanes)
+			continue;
+
+		if (_nodeCount[nodeIdx])
+		{
+			// Moller-Trumbore test of every lane against each triangle of the leaf
+			for (unsigned triangleIdx = _nodeOffset[nodeIdx]; triangleIdx < _nodeOffset[nodeIdx] + _nodeCount[nodeIdx]; ++triangleIdx)
+			{
+				const vec3 vertex(_vertex[0][triangleIdx], _vertex[1][triangleIdx], _vertex[2][triangleIdx]);
+				const vec3 edge1(_edge1[0][triangleIdx], _edge1[1][triangleIdx], _edge1[2][triangleIdx]);
+				const vec3 edge2(_edge2[0][triangleIdx], _edge2[1][triangleIdx], _edge2[2][triangleIdx]);
+
+				for (unsigned lane = 0; lane < PACKET_SIZE; ++lane)
+				{
+					const vec3 laneDirection(direction[lane], direction[PACKET_SIZE + lane], direction[2 * PACKET_SIZE + lane]);
+					const vec3 s = vec3(origin[lane], origin[PACKET_SIZE + lane], origin[2 * PACKET_SIZE + lane]) - vertex;
+					const vec3 p = glm::cross(laneDirection, edge2), q = glm::cross(s, edge1);
+					const float invDet = 1.0f / glm::dot(edge1, p);
+					const float u = glm::dot(s, p) * invDet, v = glm::dot(laneDirection, q) * invDet, t = glm::dot(edge2, q) * invDet;
+					const bool isHit = u >= .0f && v >= .0f && u + v <= 1.0f && t > glm::epsilon<float>() && t < distance[lane];
+
+					distance[lane] = isHit ? t : distance[lane];
+					triangle[lane] = isHit ? triangleIdx : triangle[lane];
+				}
+			}
+		}
+		else
+		{
+			// The packet is assumed to be coherent, hence the first active lane decides which child is closer
+			unsigned firstLane = 0;
+			while (tMin[firstLane] > tMax[firstLane])
+				++firstLane;
+
+			const bool secondFirst = direction[_nodeAxis[nodeIdx] * PACKET_SIZE + firstLane] < .0f;
+			stack[stackSize++] = secondFirst ? nodeIdx + 1 : _nodeOffset[nodeIdx];
+			stack[stackSize++] = secondFirst ? _nodeOffset[nodeIdx] : nodeIdx + 1;
+		}
+	}
+}
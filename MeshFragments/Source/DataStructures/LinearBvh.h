@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Geometry/3D/AABB.h"
+#include "Graphics/Core/Model3D.h"
+
+/**
+*	@file LinearBvh.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Binary BVH of a triangle mesh built on the CPU from Morton codes and flattened in depth-first order. Node bounds and triangles are stored
+*	as structures of arrays, so that packets of rays are tested against a node or a triangle with a single loop over the packet.
+*/
+class LinearBvh
+{
+public:
+	const static unsigned MAX_LEAF_TRIANGLES = 4;		//!< Triangles below which a node is not split
+	const static unsigned PACKET_SIZE = 8;				//!< Rays traversed together in batched queries
+
+	/**
+	*	@brief Closest intersection of a ray.
+	*/
+	struct RayHit
+	{
+		float		_distance;							//!< Distance along the ray direction, FLT_MAX if nothing was hit
+		unsigned	_faceIdx;							//!< Face within its model component
+		unsigned	_modelCompIdx;						//!< Model component of the face
+
+		/**
+		*	@brief Default constructor, with no intersection.
+		*/
+		RayHit() : _distance(FLT_MAX), _faceIdx(std::numeric_limits<unsigned>::max()), _modelCompIdx(std::numeric_limits<unsigned>::max()) {}
+
+		/**
+		*	@return True if any triangle was hit.
+		*/
+		bool isHit() const { return _distance < FLT_MAX; }
+	};
+
+protected:
+	const static unsigned MORTON_BITS = 10;				//!< Bits per axis of the Morton codes
+	const static unsigned NO_TRIANGLE = std::numeric_limits<unsigned>::max();		//!< Lane of a packet that hit nothing
+	const static unsigned STACK_SIZE = 128;				//!< Maximum depth of the traversal, above 3 * MORTON_BITS plus the median splits of identical codes
+
+protected:
+	AABB						_aabb;					//!< Bounding box of the whole mesh
+	std::vector<uint8_t>		_nodeAxis;				//!< Axis of the split of inner nodes, used to visit the closest child first
+	std::vector<unsigned>		_nodeCount;				//!< Number of triangles of a leaf, zero for inner nodes
+	std::vector<float>			_nodeMax[3];			//!< Maximum corner of each node, one array per axis
+	std::vector<float>			_nodeMin[3];			//!< Minimum corner of each node, one array per axis
+	std::vector<unsigned>		_nodeOffset;			//!< First triangle of a leaf, or second child of an inner node. The first child always follows its parent
+
+	std::vector<float>			_edge1[3];				//!< Edge from the first to the second vertex of each triangle
+	std::vector<float>			_edge2[3];				//!< Edge from the first to the third vertex of each triangle
+	std::vector<unsigned>		_faceIdx;				//!< Face of each triangle within its model component
+	std::vector<unsigned>		_modelCompIdx;			//!< Model component of each triangle
+	std::vector<float>			_vertex[3];				//!< First vertex of each triangle
+
+protected:
+	/**
+	*	@brief Appends the subtree of the sorted triangles between begin and end.
+	*	@return Index of the subtree root.
+	*/
+	unsigned buildNode(const std::vector<unsigned>& mortonCode, const std::vector<AABB>& triangleAABB, const std::vector<unsigned>& order, unsigned begin, unsigned end);
+
+	/**
+	*	@return Morton code interleaving the lower MORTON_BITS bits of each coordinate.
+	*/
+	static unsigned getMortonCode(const uvec3& position);
+
+	/**
+	*	@brief Splits the range of sorted Morton codes at the highest differing bit, or in the middle if every code is the same.
+	*	@param axis Axis of the differing bit.
+	*/
+	static unsigned getSplit(const std::vector<unsigned>& mortonCode, unsigned begin, unsigned end, uint8_t& axis);
+
+	/**
+	*	@brief Traverses the tree with PACKET_SIZE rays at once, whose coordinates are given per axis. Unused lanes must have a negative distance.
+	*	@param distance Maximum distance of each ray, replaced by the closest intersection.
+	*	@param triangle Sorted triangle hit by each ray, left untouched if there is none.
+	*/
+	void intersectPacket(const float* origin, const float* direction, float* distance, unsigned* triangle) const;
+
+public:
+	/**
+	*	@brief Builds the tree from every model component of the given model.
+	*/
+	LinearBvh(Model3D* model);
+
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~LinearBvh();
+
+	/**
+	*	@return Bounding box of the whole mesh.
+	*/
+	AABB getAABB() const { return _aabb; }
+
+	/**
+	*	@return Number of nodes of the tree.
+	*/
+	size_t getNumNodes() const { return _nodeCount.size(); }
+
+	/**
+	*	@return Number of triangles of the tree.
+	*/
+	size_t getNumTriangles() const { return _faceIdx.size(); }
+
+	/**
+	*	@brief Finds the closest triangle along a single ray.
+	*	@param maxDistance Intersections further than this distance along direction are discarded.
+	*/
+	RayHit intersect(const vec3& origin, const vec3& direction, float maxDistance = FLT_MAX) const;
+
+	/**
+	*	@brief Finds the closest triangle for a batch of rays, traversed in packets of PACKET_SIZE rays in parallel. Rays are expected to be sorted
+	*	so that consecutive rays are coherent, e.g., in screen order.
+	*/
+	void intersect(const std::vector<Model3D::RayGPUData>& rays, std::vector<RayHit>& hits) const;
+};
+
@@ -0,0 +1,174 @@
+#include "stdafx.h"
+#include "MeshAdjacency.h"
+
+// [Public methods]
+
+MeshAdjacency::MeshAdjacency(const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, bool weld)
+{
+	if (weld)
+	{
+		this->weldVertices(vertices, faces);
+	}
+	else
+	{
+		_position.resize(vertices.size());
+		_cornerVertex.resize(faces.size() * 3);
+
+		#pragma omp parallel for
+		for (int idx = 0; idx < vertices.size(); ++idx)
+			_position[idx] = vertices[idx]._position;
+
+		#pragma omp parallel for
+		for (int idx = 0; idx < faces.size(); ++idx)
+			for (int i = 0; i < 3; ++i)
+				_cornerVertex[idx * 3 + i] = faces[idx]._vertices[i];
+	}
+
+	this->buildTwins();
+	this->buildVertexCorners();
+}
+
+void MeshAdjacency::getClusterBoundaries(const std::vector<float>& faceCluster, std::vector<std::vector<unsigned>>& loops, std::vector<float>& loopCluster) const
+{
+	const unsigned numHalfEdges = _cornerVertex.size();
+	std::vector<uint8_t> isBoundary(numHalfEdges);
+
+	#pragma omp parallel for
+	for (int halfEdge = 0; halfEdge < numHalfEdges; ++halfEdge)
+		isBoundary[halfEdge] = _twin[halfEdge] == NO_TWIN || faceCluster[face(_twin[halfEdge])] != faceCluster[face(halfEdge)];
+
+	for (unsigned startHalfEdge = 0; startHalfEdge < numHalfEdges; ++startHalfEdge)
+	{
+		if (!isBoundary[startHalfEdge])
+			continue;
+
+		std::vector<unsigned> loop;
+		unsigned halfEdge = startHalfEdge;
+
+		do
+		{
+			loop.push_back(halfEdge);
+			isBoundary[halfEdge] = 0;
+
+			// Rotate around the end vertex through faces of the same cluster until the next boundary half-edge is found
+			unsigned nextHalfEdge = next(halfEdge), valence = this->getVertexValence(_cornerVertex[nextHalfEdge]);
+			while (!isBoundary[nextHalfEdge] && nextHalfEdge != startHalfEdge && _twin[nextHalfEdge] != NO_TWIN && faceCluster[face(_twin[nextHalfEdge])] == faceCluster[face(halfEdge)] && valence--)
+				nextHalfEdge = next(_twin[nextHalfEdge]);
+
+			halfEdge = isBoundary[nextHalfEdge] || nextHalfEdge == startHalfEdge ? nextHalfEdge : NO_TWIN;
+		} 
+		while (halfEdge != startHalfEdge && halfEdge != NO_TWIN);
+
+		loops.push_back(std::move(loop));
+		loopCluster.push_back(faceCluster[face(startHalfEdge)]);
+	}
+}
+
+void MeshAdjacency::getFaceNeighbours(unsigned face, std::vector<unsigned>& neighbours) const
+{
+	neighbours.clear();
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const unsigned vertex = _cornerVertex[face * 3 + i];
+		const unsigned* corners = this->getVertexCorners(vertex);
+
+		for (unsigned cornerIdx = 0; cornerIdx < this->getVertexValence(vertex); ++cornerIdx)
+			neighbours.push_back(MeshAdjacency::face(corners[cornerIdx]));
+	}
+
+	std::sort(neighbours.begin(), neighbours.end());
+	neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+}
+
+// [Protected methods]
+
+void MeshAdjacency::buildTwins()
+{
+	// Both half-edges of an edge share the same key, and the lowest bit tells the direction
+	const unsigned numHalfEdges = _cornerVertex.size();
+	std::vector<std::pair<uint64_t, unsigned>> edgeKey(numHalfEdges);
+
+	#pragma omp parallel for
+	for (int halfEdge = 0; halfEdge < numHalfEdges; ++halfEdge)
+	{
+		const unsigned v1 = _cornerVertex[halfEdge], v2 = _cornerVertex[next(halfEdge)];
+		edgeKey[halfEdge] = std::make_pair((uint64_t(glm::min(v1, v2)) << 32) | glm::max(v1, v2), static_cast<unsigned>(halfEdge));
+	}
+
+	std::sort(std::execution::par_unseq, edgeKey.begin(), edgeKey.end());
+
+	_twin.resize(numHalfEdges);
+
+	#pragma omp parallel for
+	for (int idx = 0; idx < numHalfEdges; ++idx)
+	{
+		const uint64_t key = edgeKey[idx].first;
+		const bool sharedWithPrev = idx > 0 && edgeKey[idx - 1].first == key, sharedWithNext = idx + 1 < numHalfEdges && edgeKey[idx + 1].first == key;
+		const bool isManifold = sharedWithPrev != sharedWithNext && (!sharedWithPrev || idx < 2 || edgeKey[idx - 2].first != key) && (!sharedWithNext || idx + 2 >= numHalfEdges || edgeKey[idx + 2].first != key);
+		const unsigned halfEdge = edgeKey[idx].second, twinHalfEdge = sharedWithPrev ? edgeKey[idx - 1].second : (sharedWithNext ? edgeKey[idx + 1].second : NO_TWIN);
+
+		// Faces with opposite orientation are not paired, as rotations around vertices would not be consistent
+		_twin[halfEdge] = isManifold && _cornerVertex[halfEdge] == _cornerVertex[next(twinHalfEdge)] ? twinHalfEdge : NO_TWIN;
+	}
+}
+
+void MeshAdjacency::buildVertexCorners()
+{
+	const unsigned numCorners = _cornerVertex.size(), numVertices = _position.size();
+	std::vector<uint64_t> vertexCorner(numCorners);
+
+	#pragma omp parallel for
+	for (int corner = 0; corner < numCorners; ++corner)
+		vertexCorner[corner] = (uint64_t(_cornerVertex[corner]) << 32) | corner;
+
+	std::sort(std::execution::par_unseq, vertexCorner.begin(), vertexCorner.end());
+
+	_vertexCorners.resize(numCorners);
+	_vertexOffset.resize(numVertices + 1, numCorners);
+
+	#pragma omp parallel for
+	for (int idx = 0; idx < numCorners; ++idx)
+	{
+		const unsigned vertex = static_cast<unsigned>(vertexCorner[idx] >> 32);
+		_vertexCorners[idx] = static_cast<unsigned>(vertexCorner[idx] & 0xFFFFFFFF);
+
+		if (idx == 0 || static_cast<unsigned>(vertexCorner[idx - 1] >> 32) != vertex)
+			_vertexOffset[vertex] = idx;
+	}
+
+	// Vertices without faces start where the following vertex does
+	for (int vertex = static_cast<int>(numVertices) - 1; vertex >= 0; --vertex)
+		if (_vertexOffset[vertex] == numCorners)
+			_vertexOffset[vertex] = _vertexOffset[vertex + 1];
+}
+
+void MeshAdjacency::weldVertices(const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces)
+{
+	std::vector<unsigned> order(vertices.size());
+	std::iota(order.begin(), order.end(), 0);
+
+	std::sort(std::execution::par_unseq, order.begin(), order.end(), [&vertices](unsigned a, unsigned b) {
+		const vec3& pa = vertices[a]._position, & pb = vertices[b]._position;
+		return pa.x < pb.x || (pa.x == pb.x && (pa.y < pb.y || (pa.y == pb.y && pa.z < pb.z)));
+		});
+
+	std::vector<unsigned> weldedIndex(vertices.size());
+	_position.clear();
+	_position.reserve(vertices.size());
+
+	for (unsigned idx = 0; idx < order.size(); ++idx)
+	{
+		if (idx == 0 || vertices[order[idx]]._position != vertices[order[idx - 1]]._position)
+			_position.push_back(vertices[order[idx]]._position);
+
+		weldedIndex[order[idx]] = static_cast<unsigned>(_position.size() - 1);
+	}
+
+	_cornerVertex.resize(faces.size() * 3);
+
+	#pragma omp parallel for
+	for (int idx = 0; idx < faces.size(); ++idx)
+		for (int i = 0; i < 3; ++i)
+			_cornerVertex[idx * 3 + i] = weldedIndex[faces[idx]._vertices[i]];
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Graphics/Core/Model3D.h"
+
+/**
+*	@file MeshAdjacency.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Half-edge adjacency of a triangle mesh stored in flat arrays. Half-edge 3f + i goes from corner i to corner (i + 1) % 3 of face f, 
+*	and the corners around each vertex are stored in compressed rows. Everything is built by sorting keys, without per-face allocations.
+*/
+class MeshAdjacency
+{
+public:
+	inline const static unsigned NO_TWIN = std::numeric_limits<unsigned>::max();		//!< Half-edge on an open border or a non-manifold edge
+
+protected:
+	std::vector<unsigned>	_cornerVertex;				//!< Vertex of each corner, after welding
+	std::vector<vec3>		_position;					//!< Position of each welded vertex
+	std::vector<unsigned>	_twin;						//!< Opposite half-edge, NO_TWIN if none
+	std::vector<unsigned>	_vertexCorners;				//!< Corners around each vertex
+	std::vector<unsigned>	_vertexOffset;				//!< Start of the corners of each vertex in _vertexCorners, with one more element
+
+protected:
+	/**
+	*	@brief Pairs half-edges sharing the same vertices in opposite directions.
+	*/
+	void buildTwins();
+
+	/**
+	*	@brief Builds the compressed rows of corners around each vertex.
+	*/
+	void buildVertexCorners();
+
+	/**
+	*	@brief Assigns the same index to vertices with identical positions.
+	*/
+	void weldVertices(const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces);
+
+public:
+	/**
+	*	@brief Constructor. If weld is enabled, vertices with identical positions are merged so that faces with duplicated vertices are still connected.
+	*/
+	MeshAdjacency(const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, bool weld = true);
+
+	/**
+	*	@return Face of a half-edge or corner.
+	*/
+	static unsigned face(unsigned halfEdge) { return halfEdge / 3; }
+
+	/**
+	*	@brief Collects the closed loops of half-edges that separate each cluster from other clusters or from open borders.
+	*	@param faceCluster Cluster of each face.
+	*	@param loops Half-edges of each loop, in order.
+	*	@param loopCluster Cluster enclosed by each loop.
+	*/
+	void getClusterBoundaries(const std::vector<float>& faceCluster, std::vector<std::vector<unsigned>>& loops, std::vector<float>& loopCluster) const;
+
+	/**
+	*	@brief Collects the faces sharing at least one vertex with the given face, itself included.
+	*/
+	void getFaceNeighbours(unsigned face, std::vector<unsigned>& neighbours) const;
+
+	/**
+	*	@return Number of faces.
+	*/
+	unsigned getNumFaces() const { return static_cast<unsigned>(_cornerVertex.size() / 3); }
+
+	/**
+	*	@return Number of welded vertices.
+	*/
+	unsigned getNumVertices() const { return static_cast<unsigned>(_position.size()); }
+
+	/**
+	*	@return Position of a welded vertex.
+	*/
+	const vec3& getPosition(unsigned vertex) const { return _position[vertex]; }
+
+	/**
+	*	@return Pointer to the corners around a vertex, whose number is given by getVertexValence.
+	*/
+	const unsigned* getVertexCorners(unsigned vertex) const { return _vertexCorners.data() + _vertexOffset[vertex]; }
+
+	/**
+	*	@return Number of corners around a vertex.
+	*/
+	unsigned getVertexValence(unsigned vertex) const { return _vertexOffset[vertex + 1] - _vertexOffset[vertex]; }
+
+	/**
+	*	@return Next half-edge within the same face.
+	*/
+	static unsigned next(unsigned halfEdge) { return halfEdge - halfEdge % 3 + (halfEdge + 1) % 3; }
+
+	/**
+	*	@return Vertex where a half-edge starts.
+	*/
+	unsigned origin(unsigned halfEdge) const { return _cornerVertex[halfEdge]; }
+
+	/**
+	*	@return Previous half-edge within the same face.
+	*/
+	static unsigned prev(unsigned halfEdge) { return halfEdge - halfEdge % 3 + (halfEdge + 2) % 3; }
+
+	/**
+	*	@return Opposite half-edge, NO_TWIN if the edge is open or non-manifold.
+	*/
+	unsigned twin(unsigned halfEdge) const { return _twin[halfEdge]; }
+};
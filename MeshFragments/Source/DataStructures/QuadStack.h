@@ -55,6 +55,7 @@ public:
 	bool loadCube(RegularGrid* voxelization);
 	bool openCheckpoint(const std::string& filename);
 	void saveCheckpoint(const std::string& filename);
+	void saveCheckpoint(std::ostream& fout);
 	bool writeBand(const std::string& filename, uint16_t layer = 0);
 };
 
@@ -185,6 +186,13 @@ inline void QuadStack<T>::saveCheckpoint(const std::string& filename)
 	if (!fout.is_open())
 	    return;
 
+	this->saveCheckpoint(fout);
+	fout.close();
+}
+
+template<typename T>
+inline void QuadStack<T>::saveCheckpoint(std::ostream& fout)
+{
 	const size_t numCells = _width * _height * _depth;
 	const size_t tSize = sizeof(T);
 	std::vector<GStack<T>*> leaves;
@@ -218,8 +226,6 @@ inline void QuadStack<T>::saveCheckpoint(const std::string& filename)
 					fout.write((char*)&leaf->_intervals[interval]._length[x][y], sizeof(uint16_t));
 		}
 	}
-
-	fout.close();
 }
 
 template<typename T>
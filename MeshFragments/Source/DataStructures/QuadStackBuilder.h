@@ -0,0 +1,488 @@
+#pragma once
+
+#include "DataStructures/QuadStackReader.h"
+#include "DataStructures/RegularGrid.h"
+
+/**
+*	@file QuadStackBuilder.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Builds a QuadStack checkpoint straight from the cells of a RegularGrid. Columns are run-length encoded into flat
+*	arrays, and the nodes, intervals and heightfields of the quadtree are kept in contiguous arenas. The top levels of the quadtree are split serially,
+*	and the subtrees below them are built in parallel, each one in its own arena.
+*
+*	A region of columns becomes a leaf when all of its columns share the same sequence of values, as in QuadStack. Afterwards, the leading and
+*	trailing intervals that have the same values in every child are moved up to their parent.
+*
+*	The checkpoint follows the node order of QuadStack<T>::saveCheckpoint, but it is versioned (see QuadStackReader<T>::FORMAT_VERSION):
+*	heightfields store the exclusive upper z of each interval rather than run lengths, and their dimensions are 16-bit.
+*/
+template<typename T>
+class QuadStackBuilder
+{
+protected:
+	const static int SUBTREE_DEPTH = 4;							//!< Levels of the quadtree that are split before building subtrees in parallel
+
+	struct NodeRef
+	{
+		uint32_t	_arena, _node;
+	};
+
+	struct Node
+	{
+		uint16_t	_minPoint[2], _maxPoint[2];					//!< Rectangle of columns, max is exclusive
+		NodeRef		_children[4];								//!< Children in the order of QuadStack, _arena is NO_ARENA if missing
+		uint32_t	_firstInterval, _numIntervals;				//!< Range of intervals in the arena
+	};
+
+	struct Interval
+	{
+		T			_value;										//!< Value of the interval
+		size_t		_heightOffset;								//!< Heightfield of the interval in the arena, in x-major order
+	};
+
+	struct Arena
+	{
+		std::vector<uint16_t>	_heights;
+		std::vector<Interval>	_intervals;
+		std::vector<Node>		_nodes;
+	};
+
+	struct Job
+	{
+		uint16_t	_minPoint[2], _maxPoint[2];					//!< Region of the subtree, whose root is the first node of arena job + 1
+	};
+
+	const static uint32_t NO_ARENA = std::numeric_limits<uint32_t>::max();
+
+protected:
+	std::vector<Arena>		_arenas;							//!< Arena 0 keeps the top levels, the rest one subtree each
+	std::vector<uint64_t>	_columnHash;						//!< Hash of the sequence of values of every column
+	std::vector<size_t>		_columnOffset;						//!< First run of every column, plus the total number of runs
+	uint16_t				_width, _height, _depth;			//!< Dimensions of the voxelization
+	NodeRef					_root;								//!< Root of the quadtree
+	std::vector<uint16_t>	_runEnd;							//!< Upper z of every run, exclusive
+	std::vector<T>			_runValue;							//!< Value of every run
+
+protected:
+	/**
+	*	@brief Builds a subtree within a single arena.
+	*	@return Index of its root in the arena.
+	*/
+	uint32_t buildNode(uint32_t arenaIdx, uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1);
+
+	/**
+	*	@brief Run-length encodes every column of the grid.
+	*/
+	void encodeColumns(RegularGrid* grid);
+
+	/**
+	*	@return Index of a column in the run arrays.
+	*/
+	size_t getColumn(uint16_t x, uint16_t y) const { return size_t(x) * _height + y; }
+
+	/**
+	*	@brief Accumulates the serialized size and the number of non-empty nodes of a subtree.
+	*/
+	void getNodeSize(const NodeRef& ref, size_t& size, uint64_t& numNodes) const;
+
+	/**
+	*	@return True if every column of the region has the same sequence of values.
+	*/
+	bool isUniform(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1) const;
+
+	/**
+	*	@brief Fills a leaf with the intervals of its region.
+	*/
+	void makeLeaf(Arena& arena, uint32_t nodeIdx);
+
+	/**
+	*	@brief Moves the leading and trailing intervals shared by all the children of a node into it.
+	*/
+	void mergeChildren(Arena& arena, uint32_t nodeIdx);
+
+	/**
+	*	@brief Creates the top levels of the quadtree in arena 0 and collects the subtrees below them.
+	*	@return Reference to the node of the region.
+	*/
+	NodeRef planNode(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1, int depth, std::vector<Job>& jobs);
+
+	/**
+	*	@brief Writes the nodes of a subtree in preorder.
+	*/
+	char* writeNode(const NodeRef& ref, char* buffer) const;
+
+public:
+	/**
+	*	@brief Constructor.
+	*/
+	QuadStackBuilder();
+
+	/**
+	*	@brief Builds the quadtree of a grid.
+	*	@return False if the grid is empty or too large for the checkpoint.
+	*/
+	bool build(RegularGrid* grid);
+
+	/**
+	*	@brief Serializes the quadtree as a versioned checkpoint.
+	*/
+	void serialize(std::vector<char>& buffer) const;
+
+	/**
+	*	@brief Writes the checkpoint into a stream with a single call.
+	*/
+	void write(std::ostream& stream) const;
+};
+
+template<typename T>
+QuadStackBuilder<T>::QuadStackBuilder() : _width(0), _height(0), _depth(0), _root{ NO_ARENA, 0 }
+{
+}
+
+template<typename T>
+bool QuadStackBuilder<T>::build(RegularGrid* grid)
+{
+	const uvec3 numDivs = grid->getNumSubdivisions();
+	if (!numDivs.x || !numDivs.y || !numDivs.z || std::max({ numDivs.x, numDivs.y, numDivs.z }) > std::numeric_limits<uint16_t>::max())
+		return false;
+
+	_width = numDivs.x;
+	_height = numDivs.y;
+	_depth = numDivs.z;
+
+	this->encodeColumns(grid);
+
+	std::vector<Job> jobs;
+	_arenas.assign(1, Arena());
+	_root = this->planNode(0, _width, 0, _height, 0, jobs);
+	_arenas.resize(jobs.size() + 1);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int jobIdx = 0; jobIdx < jobs.size(); ++jobIdx)
+	{
+		const Job& job = jobs[jobIdx];
+		this->buildNode(jobIdx + 1, job._minPoint[0], job._maxPoint[0], job._minPoint[1], job._maxPoint[1]);
+	}
+
+	// Top nodes were created in preorder, hence children are merged before their parents
+	for (int nodeIdx = static_cast<int>(_arenas[0]._nodes.size()) - 1; nodeIdx >= 0; --nodeIdx)
+		this->mergeChildren(_arenas[0], nodeIdx);
+
+	return true;
+}
+
+template<typename T>
+void QuadStackBuilder<T>::serialize(std::vector<char>& buffer) const
+{
+	const uint32_t magic = QuadStackReader<T>::FORMAT_MAGIC, version = QuadStackReader<T>::FORMAT_VERSION;
+	const uint64_t tSize = sizeof(T);
+	size_t size = sizeof(uint32_t) * 2 + sizeof(uint64_t) + sizeof(uint16_t) * 3 + sizeof(uint64_t);
+	uint64_t numNodes = 0;
+
+	if (_root._arena != NO_ARENA) this->getNodeSize(_root, size, numNodes);
+	buffer.resize(size);
+
+	char* cursor = buffer.data();
+	auto write = [&cursor](const void* value, size_t numBytes) { std::memcpy(cursor, value, numBytes); cursor += numBytes; };
+
+	write(&magic, sizeof(uint32_t));
+	write(&version, sizeof(uint32_t));
+	write(&tSize, sizeof(uint64_t));
+	write(&_width, sizeof(uint16_t));
+	write(&_height, sizeof(uint16_t));
+	write(&_depth, sizeof(uint16_t));
+	write(&numNodes, sizeof(uint64_t));
+
+	if (_root._arena != NO_ARENA) this->writeNode(_root, cursor);
+}
+
+template<typename T>
+void QuadStackBuilder<T>::write(std::ostream& stream) const
+{
+	std::vector<char> buffer;
+	this->serialize(buffer);
+
+	stream.write(buffer.data(), buffer.size());
+}
+
+/// Protected methods
+
+template<typename T>
+uint32_t QuadStackBuilder<T>::buildNode(uint32_t arenaIdx, uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1)
+{
+	Arena& arena = _arenas[arenaIdx];
+	const uint32_t nodeIdx = static_cast<uint32_t>(arena._nodes.size());
+
+	Node node{ { x0, y0 }, { x1, y1 }, {}, 0, 0 };
+	for (NodeRef& child : node._children) child = NodeRef{ NO_ARENA, 0 };
+	arena._nodes.push_back(node);
+
+	if (((x1 - x0) <= 1 && (y1 - y0) <= 1) || this->isUniform(x0, x1, y0, y1))
+	{
+		this->makeLeaf(arena, nodeIdx);
+		return nodeIdx;
+	}
+
+	const uint16_t xMid = x0 + (x1 - x0 + 1) / 2, yMid = y0 + (y1 - y0 + 1) / 2;
+	const uint16_t childRegion[4][4] = { { x0, xMid, y0, yMid }, { x0, xMid, yMid, y1 }, { xMid, x1, y0, yMid }, { xMid, x1, yMid, y1 } };
+
+	for (int childIdx = 0; childIdx < 4; ++childIdx)
+	{
+		const uint16_t* region = childRegion[childIdx];
+		if (region[0] < region[1] && region[2] < region[3])
+		{
+			const uint32_t childNode = this->buildNode(arenaIdx, region[0], region[1], region[2], region[3]);
+			arena._nodes[nodeIdx]._children[childIdx] = NodeRef{ arenaIdx, childNode };
+		}
+	}
+
+	this->mergeChildren(arena, nodeIdx);
+
+	return nodeIdx;
+}
+
+template<typename T>
+void QuadStackBuilder<T>::encodeColumns(RegularGrid* grid)
+{
+	const RegularGrid::CellGrid* cells = grid->data();
+	const int numColumns = _width * _height;
+
+	_columnHash.resize(numColumns);
+	_columnOffset.resize(numColumns + 1);
+
+	// Count runs and hash their values
+	#pragma omp parallel for
+	for (int columnIdx = 0; columnIdx < numColumns; ++columnIdx)
+	{
+		const RegularGrid::CellGrid* column = cells + size_t(columnIdx) * _depth;
+		uint64_t hash = 14695981039346656037ull;
+		size_t numRuns = 0;
+
+		for (uint16_t z = 0; z < _depth; ++z)
+		{
+			if (z == 0 || column[z]._value != column[z - 1]._value)
+			{
+				hash = (hash ^ column[z]._value) * 1099511628211ull;
+				++numRuns;
+			}
+		}
+
+		_columnHash[columnIdx] = hash;
+		_columnOffset[columnIdx + 1] = numRuns;
+	}
+
+	_columnOffset[0] = 0;
+	for (int columnIdx = 0; columnIdx < numColumns; ++columnIdx)
+		_columnOffset[columnIdx + 1] += _columnOffset[columnIdx];
+
+	_runEnd.resize(_columnOffset.back());
+	_runValue.resize(_columnOffset.back());
+
+	#pragma omp parallel for
+	for (int columnIdx = 0; columnIdx < numColumns; ++columnIdx)
+	{
+		const RegularGrid::CellGrid* column = cells + size_t(columnIdx) * _depth;
+		size_t runIdx = _columnOffset[columnIdx];
+
+		for (uint16_t z = 0; z < _depth; ++z)
+		{
+			if (z > 0 && column[z]._value != column[z - 1]._value)
+				_runEnd[runIdx++] = z;
+
+			_runValue[runIdx] = static_cast<T>(column[z]._value);
+		}
+
+		_runEnd[runIdx] = _depth;
+	}
+}
+
+template<typename T>
+void QuadStackBuilder<T>::getNodeSize(const NodeRef& ref, size_t& size, uint64_t& numNodes) const
+{
+	const Arena& arena = _arenas[ref._arena];
+	const Node& node = arena._nodes[ref._node];
+	const size_t area = size_t(node._maxPoint[0] - node._minPoint[0]) * (node._maxPoint[1] - node._minPoint[1]);
+
+	if (node._numIntervals)
+	{
+		size += sizeof(uint64_t) + sizeof(uvec2) * 2 + node._numIntervals * (sizeof(uint16_t) * 2 + sizeof(T) + area * sizeof(uint16_t));
+		++numNodes;
+	}
+
+	for (const NodeRef& child : node._children)
+		if (child._arena != NO_ARENA) this->getNodeSize(child, size, numNodes);
+}
+
+template<typename T>
+bool QuadStackBuilder<T>::isUniform(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1) const
+{
+	const size_t firstColumn = this->getColumn(x0, y0), numRuns = _columnOffset[firstColumn + 1] - _columnOffset[firstColumn];
+	const T* firstValues = _runValue.data() + _columnOffset[firstColumn];
+
+	for (uint16_t x = x0; x < x1; ++x)
+	{
+		for (uint16_t y = y0; y < y1; ++y)
+		{
+			const size_t column = this->getColumn(x, y);
+			if (_columnHash[column] != _columnHash[firstColumn] || _columnOffset[column + 1] - _columnOffset[column] != numRuns ||
+				!std::equal(firstValues, firstValues + numRuns, _runValue.data() + _columnOffset[column]))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+template<typename T>
+void QuadStackBuilder<T>::makeLeaf(Arena& arena, uint32_t nodeIdx)
+{
+	Node& node = arena._nodes[nodeIdx];
+	const size_t firstColumn = this->getColumn(node._minPoint[0], node._minPoint[1]), numRuns = _columnOffset[firstColumn + 1] - _columnOffset[firstColumn];
+	const size_t area = size_t(node._maxPoint[0] - node._minPoint[0]) * (node._maxPoint[1] - node._minPoint[1]);
+
+	node._firstInterval = static_cast<uint32_t>(arena._intervals.size());
+	node._numIntervals = static_cast<uint32_t>(numRuns);
+
+	size_t heightOffset = arena._heights.size();
+	arena._heights.resize(heightOffset + numRuns * area);
+
+	for (size_t runIdx = 0; runIdx < numRuns; ++runIdx, heightOffset += area)
+	{
+		uint16_t* heights = arena._heights.data() + heightOffset;
+		for (uint16_t x = node._minPoint[0]; x < node._maxPoint[0]; ++x)
+			for (uint16_t y = node._minPoint[1]; y < node._maxPoint[1]; ++y)
+				*heights++ = _runEnd[_columnOffset[this->getColumn(x, y)] + runIdx];
+
+		arena._intervals.push_back(Interval{ _runValue[_columnOffset[firstColumn] + runIdx], heightOffset });
+	}
+}
+
+template<typename T>
+void QuadStackBuilder<T>::mergeChildren(Arena& arena, uint32_t nodeIdx)
+{
+	std::vector<std::pair<Arena*, Node*>> children;
+	for (const NodeRef& child : arena._nodes[nodeIdx]._children)
+		if (child._arena != NO_ARENA) children.emplace_back(&_arenas[child._arena], &_arenas[child._arena]._nodes[child._node]);
+
+	if (children.empty())
+		return;
+
+	uint32_t minIntervals = std::numeric_limits<uint32_t>::max();
+	for (const auto& child : children) minIntervals = std::min(minIntervals, child.second->_numIntervals);
+
+	auto getValue = [](const std::pair<Arena*, Node*>& child, uint32_t intervalIdx) { return child.first->_intervals[child.second->_firstInterval + intervalIdx]._value; };
+	auto isShared = [&children, &getValue](uint32_t intervalIdx, bool fromEnd)
+	{
+		const T value = getValue(children[0], fromEnd ? children[0].second->_numIntervals - 1 - intervalIdx : intervalIdx);
+		for (const auto& child : children)
+			if (getValue(child, fromEnd ? child.second->_numIntervals - 1 - intervalIdx : intervalIdx) != value) return false;
+
+		return true;
+	};
+
+	uint32_t numLeading = 0, numTrailing = 0;
+	while (numLeading < minIntervals && isShared(numLeading, false)) ++numLeading;
+	while (numLeading + numTrailing < minIntervals && isShared(numTrailing, true)) ++numTrailing;
+
+	if (!numLeading && !numTrailing)
+		return;
+
+	Node& node = arena._nodes[nodeIdx];
+	const uint16_t nodeHeight = node._maxPoint[1] - node._minPoint[1];
+	const size_t area = size_t(node._maxPoint[0] - node._minPoint[0]) * nodeHeight;
+
+	node._firstInterval = static_cast<uint32_t>(arena._intervals.size());
+	node._numIntervals = numLeading + numTrailing;
+
+	for (uint32_t mergeIdx = 0; mergeIdx < numLeading + numTrailing; ++mergeIdx)
+	{
+		const size_t heightOffset = arena._heights.size();
+		arena._heights.resize(heightOffset + area);
+
+		for (const auto& child : children)
+		{
+			const Node& childNode = *child.second;
+			const uint32_t intervalIdx = mergeIdx < numLeading ? mergeIdx : childNode._numIntervals - 1 - (mergeIdx - numLeading);
+			const uint16_t childHeight = childNode._maxPoint[1] - childNode._minPoint[1];
+			const uint16_t* source = child.first->_heights.data() + child.first->_intervals[childNode._firstInterval + intervalIdx]._heightOffset;
+
+			for (uint16_t x = childNode._minPoint[0]; x < childNode._maxPoint[0]; ++x, source += childHeight)
+				std::copy(source, source + childHeight, arena._heights.data() + heightOffset + size_t(x - node._minPoint[0]) * nodeHeight + (childNode._minPoint[1] - node._minPoint[1]));
+		}
+
+		arena._intervals.push_back(Interval{ getValue(children[0], mergeIdx < numLeading ? mergeIdx : children[0].second->_numIntervals - 1 - (mergeIdx - numLeading)), heightOffset });
+	}
+
+	for (auto& child : children)
+	{
+		child.second->_firstInterval += numLeading;
+		child.second->_numIntervals -= numLeading + numTrailing;
+	}
+}
+
+template<typename T>
+typename QuadStackBuilder<T>::NodeRef QuadStackBuilder<T>::planNode(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1, int depth, std::vector<Job>& jobs)
+{
+	if (depth == SUBTREE_DEPTH || ((x1 - x0) <= 1 && (y1 - y0) <= 1) || this->isUniform(x0, x1, y0, y1))
+	{
+		jobs.push_back(Job{ { x0, y0 }, { x1, y1 } });
+		return NodeRef{ static_cast<uint32_t>(jobs.size()), 0 };
+	}
+
+	const uint32_t nodeIdx = static_cast<uint32_t>(_arenas[0]._nodes.size());
+
+	Node node{ { x0, y0 }, { x1, y1 }, {}, 0, 0 };
+	for (NodeRef& child : node._children) child = NodeRef{ NO_ARENA, 0 };
+	_arenas[0]._nodes.push_back(node);
+
+	const uint16_t xMid = x0 + (x1 - x0 + 1) / 2, yMid = y0 + (y1 - y0 + 1) / 2;
+	const uint16_t childRegion[4][4] = { { x0, xMid, y0, yMid }, { x0, xMid, yMid, y1 }, { xMid, x1, y0, yMid }, { xMid, x1, yMid, y1 } };
+
+	for (int childIdx = 0; childIdx < 4; ++childIdx)
+	{
+		const uint16_t* region = childRegion[childIdx];
+		if (region[0] < region[1] && region[2] < region[3])
+		{
+			const NodeRef child = this->planNode(region[0], region[1], region[2], region[3], depth + 1, jobs);
+			_arenas[0]._nodes[nodeIdx]._children[childIdx] = child;
+		}
+	}
+
+	return NodeRef{ 0, nodeIdx };
+}
+
+template<typename T>
+char* QuadStackBuilder<T>::writeNode(const NodeRef& ref, char* buffer) const
+{
+	const Arena& arena = _arenas[ref._arena];
+	const Node& node = arena._nodes[ref._node];
+	const uint16_t width = node._maxPoint[0] - node._minPoint[0], height = node._maxPoint[1] - node._minPoint[1];
+	const size_t area = size_t(width) * height;
+
+	if (node._numIntervals)
+	{
+		const uint64_t numIntervals = node._numIntervals;
+		const uvec2 maxPoint(node._maxPoint[0], node._maxPoint[1]), minPoint(node._minPoint[0], node._minPoint[1]);
+
+		std::memcpy(buffer, &numIntervals, sizeof(uint64_t)); buffer += sizeof(uint64_t);
+		std::memcpy(buffer, &maxPoint, sizeof(uvec2)); buffer += sizeof(uvec2);
+		std::memcpy(buffer, &minPoint, sizeof(uvec2)); buffer += sizeof(uvec2);
+
+		for (uint32_t intervalIdx = node._firstInterval; intervalIdx < node._firstInterval + node._numIntervals; ++intervalIdx)
+		{
+			std::memcpy(buffer, &width, sizeof(uint16_t)); buffer += sizeof(uint16_t);
+			std::memcpy(buffer, &height, sizeof(uint16_t)); buffer += sizeof(uint16_t);
+			std::memcpy(buffer, &arena._intervals[intervalIdx]._value, sizeof(T)); buffer += sizeof(T);
+			std::memcpy(buffer, arena._heights.data() + arena._intervals[intervalIdx]._heightOffset, area * sizeof(uint16_t)); buffer += area * sizeof(uint16_t);
+		}
+	}
+
+	for (const NodeRef& child : node._children)
+		if (child._arena != NO_ARENA) buffer = this->writeNode(child, buffer);
+
+	return buffer;
+}
@@ -0,0 +1,330 @@
+#pragma once
+
+#include "DataStructures/RegularGrid.h"
+#include "Utilities/MappedFile.h"
+
+/**
+*	@file QuadStackReader.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Random access to a checkpoint written by QuadStackBuilder<T>. Only the node table is parsed; intervals and heightfields are
+*	queried in place, so voxels are never expanded unless the whole volume is decompressed.
+*
+*	Checkpoints start with FORMAT_MAGIC and FORMAT_VERSION. Files of QuadStack<T>::saveCheckpoint carry neither of them and store the
+*	_length of GStack intervals, whose meaning depends on how the stacks were built, so they are rejected rather than guessed.
+*
+*	Every node of the checkpoint covers a rectangle of columns and keeps a set of intervals, each one with a value and a heightfield with
+*	the (exclusive) upper z of the interval in every column. Nodes are written in preorder, hence the intervals of a column are spread
+*	along the chain of nodes from the deepest one covering it up to the root.
+*/
+template<typename T>
+class QuadStackReader
+{
+public:
+	inline const static uint32_t FORMAT_MAGIC = 0x4B545351;		//!< "QSTK" in little endian
+	inline const static uint32_t FORMAT_VERSION = 1;			//!< Heightfields store the upper z of every interval, with 16-bit dimensions
+
+	struct Interval
+	{
+		T			_value;										//!< Value of every voxel in the interval
+		uint16_t	_start, _end;								//!< Range of z, end is exclusive
+	};
+
+protected:
+	inline const static uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+
+	struct Node
+	{
+		uvec2		_minPoint, _maxPoint;						//!< Rectangle of columns, max is exclusive
+		uint32_t	_parent;									//!< Closest ancestor stored in the checkpoint
+		uint32_t	_firstInterval, _numIntervals;				//!< Range of intervals in _intervals
+	};
+
+	struct NodeInterval
+	{
+		T			_value;										//!< Value of the interval
+		const char*	_heightfield;								//!< Upper z for every column of the node, stored in x-major order
+	};
+
+protected:
+	std::vector<uint32_t>		_columnNode;					//!< Deepest node covering each column
+	const char*					_data;							//!< Checkpoint content
+	uint16_t					_width, _height, _depth;		//!< Dimensions of the voxelization
+	MappedFile					_file;							//!< Mapped checkpoint, if opened from the file system
+	std::vector<NodeInterval>	_intervals;						//!< Intervals of every node
+	std::vector<Node>			_nodes;							//!< Nodes of the checkpoint
+
+protected:
+	/**
+	*	@return Upper z of an interval in the given column.
+	*/
+	uint16_t getHeight(const Node& node, const NodeInterval& interval, uint16_t x, uint16_t y) const;
+
+	/**
+	*	@brief Parses the node table of a checkpoint.
+	*/
+	bool parse(const char* data, size_t size);
+
+public:
+	/**
+	*	@brief Constructor.
+	*/
+	QuadStackReader();
+
+	/**
+	*	@return Value of the voxel (x, y, z), VOXEL_EMPTY if out of bounds.
+	*/
+	T at(uint16_t x, uint16_t y, uint16_t z) const;
+
+	/**
+	*	@brief Writes the whole volume into a grid with the same dimensions.
+	*	@return False if dimensions do not match.
+	*/
+	bool decompress(RegularGrid* grid) const;
+
+	/**
+	*	@brief Retrieves the intervals of a column sorted by z.
+	*/
+	void getColumn(uint16_t x, uint16_t y, std::vector<Interval>& intervals) const;
+
+	/**
+	*	@return Number of nodes with intervals.
+	*/
+	size_t getNumNodes() const { return _nodes.size(); }
+
+	/**
+	*	@return Dimensions of the voxelization.
+	*/
+	uvec3 getNumSubdivisions() const { return uvec3(_width, _height, _depth); }
+
+	/**
+	*	@brief Maps a .qstack file and parses its node table.
+	*	@return Success of operation.
+	*/
+	bool open(const std::string& filename);
+
+	/**
+	*	@brief Parses a checkpoint which is already in memory, e.g., read from a FragmentArchive. The buffer must outlive the reader.
+	*	@return Success of operation.
+	*/
+	bool open(const char* data, size_t size);
+};
+
+template<typename T>
+QuadStackReader<T>::QuadStackReader() : _data(nullptr), _width(0), _height(0), _depth(0)
+{
+}
+
+template<typename T>
+T QuadStackReader<T>::at(uint16_t x, uint16_t y, uint16_t z) const
+{
+	if (x >= _width || y >= _height || z >= _depth)
+		return static_cast<T>(VOXEL_EMPTY);
+
+	// The voxel belongs to the interval with the lowest upper bound above z
+	T value = static_cast<T>(VOXEL_EMPTY);
+	uint16_t closestHeight = std::numeric_limits<uint16_t>::max();
+
+	for (uint32_t nodeIdx = _columnNode[y * _width + x]; nodeIdx != NO_NODE; nodeIdx = _nodes[nodeIdx]._parent)
+	{
+		const Node& node = _nodes[nodeIdx];
+		for (uint32_t intervalIdx = node._firstInterval; intervalIdx < node._firstInterval + node._numIntervals; ++intervalIdx)
+		{
+			const uint16_t height = this->getHeight(node, _intervals[intervalIdx], x, y);
+			if (height > z && height <= closestHeight)
+			{
+				closestHeight = height;
+				value = _intervals[intervalIdx]._value;
+			}
+		}
+	}
+
+	return value;
+}
+
+template<typename T>
+bool QuadStackReader<T>::decompress(RegularGrid* grid) const
+{
+	if (!grid || grid->getNumSubdivisions() != this->getNumSubdivisions())
+		return false;
+
+	RegularGrid::CellGrid* cells = grid->data();
+	const uvec3 numDivs = this->getNumSubdivisions();
+	const int numColumns = _width * _height;
+
+	#pragma omp parallel
+	{
+		std::vector<Interval> intervals;
+
+		#pragma omp for
+		for (int columnIdx = 0; columnIdx < numColumns; ++columnIdx)
+		{
+			const uint16_t x = columnIdx % _width, y = columnIdx / _width;
+			unsigned cellIdx = RegularGrid::getPositionIndex(x, y, 0, numDivs);
+			uint16_t z = 0;
+
+			this->getColumn(x, y, intervals);
+			for (const Interval& interval : intervals)
+			{
+				for (; z < interval._start; ++z) cells[cellIdx++]._value = VOXEL_EMPTY;
+				for (; z < interval._end; ++z) cells[cellIdx++]._value = static_cast<uint16_t>(interval._value);
+			}
+
+			for (; z < _depth; ++z) cells[cellIdx++]._value = VOXEL_EMPTY;
+		}
+	}
+
+	return true;
+}
+
+template<typename T>
+void QuadStackReader<T>::getColumn(uint16_t x, uint16_t y, std::vector<Interval>& intervals) const
+{
+	intervals.clear();
+	if (x >= _width || y >= _height)
+		return;
+
+	for (uint32_t nodeIdx = _columnNode[y * _width + x]; nodeIdx != NO_NODE; nodeIdx = _nodes[nodeIdx]._parent)
+	{
+		const Node& node = _nodes[nodeIdx];
+		for (uint32_t intervalIdx = node._firstInterval; intervalIdx < node._firstInterval + node._numIntervals; ++intervalIdx)
+			intervals.push_back(Interval{ _intervals[intervalIdx]._value, 0, std::min(this->getHeight(node, _intervals[intervalIdx], x, y), _depth) });
+	}
+
+	std::sort(intervals.begin(), intervals.end(), [](const Interval& a, const Interval& b) { return a._end < b._end; });
+
+	// Each interval starts where the previous one ends; empty intervals are dropped
+	uint16_t start = 0;
+	size_t numIntervals = 0;
+
+	for (Interval& interval : intervals)
+	{
+		if (interval._end <= start) continue;
+
+		interval._start = start;
+		start = interval._end;
+		intervals[numIntervals++] = interval;
+	}
+
+	intervals.resize(numIntervals);
+}
+
+template<typename T>
+bool QuadStackReader<T>::open(const std::string& filename)
+{
+	if (!_file.open(filename))
+		return false;
+
+	if (!this->parse(_file.data(), _file.size()))
+	{
+		_file.close();
+		return false;
+	}
+
+	return true;
+}
+
+template<typename T>
+bool QuadStackReader<T>::open(const char* data, size_t size)
+{
+	_file.close();
+
+	return this->parse(data, size);
+}
+
+/// Protected methods
+
+template<typename T>
+uint16_t QuadStackReader<T>::getHeight(const Node& node, const NodeInterval& interval, uint16_t x, uint16_t y) const
+{
+	const size_t offset = size_t(x - node._minPoint.x) * (node._maxPoint.y - node._minPoint.y) + (y - node._minPoint.y);
+
+	uint16_t height;
+	std::memcpy(&height, interval._heightfield + offset * sizeof(uint16_t), sizeof(uint16_t));
+
+	return height;
+}
+
+template<typename T>
+bool QuadStackReader<T>::parse(const char* data, size_t size)
+{
+	const char* cursor = data, *end = data + size;
+	auto read = [&cursor, end](void* value, size_t numBytes) -> bool
+	{
+		if (size_t(end - cursor) < numBytes) return false;
+		std::memcpy(value, cursor, numBytes);
+		cursor += numBytes;
+
+		return true;
+	};
+
+	uint32_t magic, version;
+	uint64_t tSize, numNodes;
+	_columnNode.clear();
+	_intervals.clear();
+	_nodes.clear();
+	_data = data;
+
+	if (!read(&magic, sizeof(uint32_t)) || magic != FORMAT_MAGIC || !read(&version, sizeof(uint32_t)) || version != FORMAT_VERSION)
+		return false;
+
+	if (!read(&tSize, sizeof(uint64_t)) || tSize != sizeof(T) || !read(&_width, sizeof(uint16_t)) || !read(&_height, sizeof(uint16_t)) || !read(&_depth, sizeof(uint16_t)) || !read(&numNodes, sizeof(uint64_t)))
+		return false;
+
+	_columnNode.resize(size_t(_width) * _height, NO_NODE);
+
+	std::vector<uint32_t> ancestors;
+	for (uint64_t nodeIdx = 0; nodeIdx < numNodes; ++nodeIdx)
+	{
+		uint64_t numIntervals;
+		Node node;
+
+		if (!read(&numIntervals, sizeof(uint64_t)) || !read(&node._maxPoint, sizeof(uvec2)) || !read(&node._minPoint, sizeof(uvec2)))
+			return false;
+
+		if (node._minPoint.x >= node._maxPoint.x || node._minPoint.y >= node._maxPoint.y || node._maxPoint.x > _width || node._maxPoint.y > _height)
+			return false;
+
+		const uint32_t width = node._maxPoint.x - node._minPoint.x, height = node._maxPoint.y - node._minPoint.y;
+		const size_t heightfieldSize = size_t(width) * height * sizeof(uint16_t);
+
+		node._firstInterval = static_cast<uint32_t>(_intervals.size());
+		node._numIntervals = static_cast<uint32_t>(numIntervals);
+
+		for (uint64_t intervalIdx = 0; intervalIdx < numIntervals; ++intervalIdx)
+		{
+			uint16_t lengthWidth, lengthHeight;
+			NodeInterval interval;
+
+			if (!read(&lengthWidth, sizeof(uint16_t)) || !read(&lengthHeight, sizeof(uint16_t)) || !read(&interval._value, sizeof(T)))
+				return false;
+
+			if (lengthWidth != width || lengthHeight != height || size_t(end - cursor) < heightfieldSize)
+				return false;
+
+			interval._heightfield = cursor;
+			cursor += heightfieldSize;
+			_intervals.push_back(interval);
+		}
+
+		// Preorder: the parent is the last visited node whose rectangle contains this one
+		while (!ancestors.empty())
+		{
+			const Node& ancestor = _nodes[ancestors.back()];
+			if (glm::all(glm::lessThanEqual(ancestor._minPoint, node._minPoint)) && glm::all(glm::lessThanEqual(node._maxPoint, ancestor._maxPoint))) break;
+			ancestors.pop_back();
+		}
+
+		node._parent = ancestors.empty() ? NO_NODE : ancestors.back();
+		ancestors.push_back(static_cast<uint32_t>(_nodes.size()));
+		_nodes.push_back(node);
+
+		for (uint32_t y = node._minPoint.y; y < node._maxPoint.y; ++y)
+			std::fill(_columnNode.begin() + y * _width + node._minPoint.x, _columnNode.begin() + y * _width + node._maxPoint.x, ancestors.back());
+	}
+
+	return true;
+}
@@ -2,28 +2,34 @@
 #include "RegularGrid.h"
 
 #include "Geometry/3D/AABB.h"
+#include "Geometry/3D/Intersections3D.h"
 #include "Geometry/3D/PointCloud3D.h"
 #include "Geometry/3D/Triangle3D.h"
 #include "Graphics/Core/CADModel.h"
 #include "Graphics/Core/FragmentationProcedure.h"
+#include "Graphics/Core/FragmentMeshBuilder.h"
 #include "Graphics/Core/MarchingCubes.h"
 #include "Graphics/Core/OpenGLUtilities.h"
 #include "Graphics/Core/ShaderList.h"
 #include "Graphics/Core/Tetravoxelizer.h"
 #include "Graphics/Core/Voronoi.h"
-#include "DataStructures/QuadStack.h"
+#include "DataStructures/GridStatistics.h"
+#include "DataStructures/QuadStackBuilder.h"
 #include "tinyply.h"
 #include "Utilities/ChronoUtilities.h"
+#include "Utilities/FragmentArchive.h"
+#include "Utilities/NumpyFile.h"
 #include "VoxWriter.h"
 
 /// Public methods
 
-RegularGrid::RegularGrid(const AABB& aabb, const ivec3& subdivisions) :
+RegularGrid::RegularGrid(const AABB& aabb, const ivec3& subdivisions, bool gpuBuffers) :
 	_aabb(aabb), _marchingCubes(nullptr), _numDivs(subdivisions)
 {
+	this->buildGrid(gpuBuffers);
 	this->setAABB(aabb, _numDivs);
-	this->buildGrid();
-	this->getComputeShaders();
+	if (gpuBuffers)
+		this->getComputeShaders();
 }
 
 RegularGrid::RegularGrid(const ivec3& subdivisions) : _cellSize(.0f), _marchingCubes(nullptr), _numDivs(subdivisions)
@@ -32,11 +38,24 @@ RegularGrid::RegularGrid(const ivec3& subdivisions) : _cellSize(.0f), _marchingC
 	this->getComputeShaders();
 }
 
+RegularGrid::RegularGrid(const RegularGrid& regulargrid) :
+	_aabb(regulargrid._aabb), _cellSize(regulargrid._cellSize), _countSSBO(0), _dirtyBricks(regulargrid._dirtyBricks), _grid(regulargrid._grid), _marchingCubes(nullptr), 
+	_maskedMax(regulargrid._maskedMax), _maskedMin(regulargrid._maskedMin), _numBricks(regulargrid._numBricks), _numDivs(regulargrid._numDivs), _ssbo(0)
+{
+	if (regulargrid._copyGridShader)
+		this->getComputeShaders();
+}
+
 RegularGrid::~RegularGrid()
 {
 	delete _marchingCubes;
-	ComputeShader::deleteBuffer(_countSSBO);
-	ComputeShader::deleteBuffer(_ssbo);
+
+	// CPU-only copies have no GPU buffers
+	if (_ssbo)
+	{
+		ComputeShader::deleteBuffer(_countSSBO);
+		ComputeShader::deleteBuffer(_ssbo);
+	}
 }
 
 unsigned RegularGrid::calculateMaxQuadrantOccupancy(unsigned subdivisions) const
@@ -61,25 +80,27 @@ unsigned RegularGrid::calculateMaxQuadrantOccupancy(unsigned subdivisions) const
 	return maxCount;
 }
 
-void RegularGrid::detectBoundaries(int boundarySize)
+void RegularGrid::clearDirty()
 {
-	ComputeShader* shader = ShaderList::getInstance()->getComputeShader(RendEnum::DETECT_BOUNDARIES);
+	std::fill(_dirtyBricks.begin(), _dirtyBricks.end(), 0);
+}
 
-	uvec3 numDivs = this->getNumSubdivisions();
-	unsigned numCells = numDivs.x * numDivs.y * numDivs.z;
-	unsigned numGroups = ComputeShader::getNumGroups(numCells);
+void RegularGrid::copyLabels(const RegularGrid& regulargrid)
+{
+	std::copy(regulargrid._grid.begin(), regulargrid._grid.end(), _grid.begin());
+	this->markDirty();
+}
 
-	shader->bindBuffers(std::vector<GLuint>{ _ssbo });
-	shader->use();
-	shader->setUniform("boundarySize", boundarySize);
-	shader->setUniform("gridDims", numDivs);
-	shader->setUniform("numCells", numCells);
-	shader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
+void RegularGrid::detectBoundaries(int boundarySize)
+{
+	uvec3 minCell, maxCell;
 
-	this->updateGrid();
+	// Voxels around the modified bricks may also change their boundary state
+	if (this->getDirtyRegion(minCell, maxCell, boundarySize))
+		this->detectBoundaries(boundarySize, minCell, maxCell);
 }
 
-void RegularGrid::erode(FractureParameters::ErosionType fractureParams, uint32_t convolutionSize, uint16_t numIterations, float erosionProbability, float erosionThreshold)
+void RegularGrid::erode(FractureParameters::ErosionType fractureParams, uint32_t convolutionSize, uint16_t numIterations, float erosionProbability, float erosionThreshold, const RandomStream& stream)
 {
 	if (!(convolutionSize % 2))
 		++convolutionSize;
@@ -119,9 +140,12 @@ void RegularGrid::erode(FractureParameters::ErosionType fractureParams, uint32_t
 
 	activations /= maskSize;
 
+	// Any voxel may be eroded
+	this->markDirty();
+
 	// Noise
 	std::vector<float> noiseBuffer;
-	this->fillNoiseBuffer(noiseBuffer, 1e6);
+	this->fillNoiseBuffer(noiseBuffer, 1e6, stream);
 
 	// Input data
 	uvec3 numDivs = this->getNumSubdivisions();
@@ -158,20 +182,54 @@ void RegularGrid::erode(FractureParameters::ErosionType fractureParams, uint32_t
 	ComputeShader::deleteBuffers(std::vector<GLuint>{ maskSSBO, noiseSSBO });
 }
 
-void RegularGrid::exportGrid(const std::string& filename, bool squared, FractureParameters::ExportGrid exportType)
+void RegularGrid::exportGrid(const std::string& filename, bool squared, FractureParameters::ExportGrid exportType, FragmentArchive* archive)
 {
+	const std::string path = filename + "." + FractureParameters::ExportGrid_STR[exportType];
+	const std::string entryName = std::filesystem::path(path).filename().string();
+
+	// VoxWriter can only target files, hence .vox grids are moved into the archive once written
+	if (exportType == FractureParameters::VOX)
+	{
+		this->exportVox(path, squared);
+		if (archive) archive->appendFile(entryName, path);
+		return;
+	}
+
+	std::ofstream file;
+	std::ostringstream buffer(std::ios::out | std::ios::binary);
+	std::ostream* stream = &buffer;
+
+	if (!archive)
+	{
+		file.open(path, std::ios::out | std::ios::binary);
+		if (!file.is_open()) return;
+		stream = &file;
+	}
+
 	if (exportType == FractureParameters::RLE)
-		this->exportRLE(filename + "." + FractureParameters::ExportGrid_STR[exportType]);
+		this->exportRLE(*stream);
 	else if (exportType == FractureParameters::QUADSTACK)
-		this->exportQuadStack(filename + "." + FractureParameters::ExportGrid_STR[exportType]);
+		this->exportQuadStack(*stream);
 	else if (exportType == FractureParameters::UNCOMPRESSED_BINARY)
-		this->exportRawCompressed(filename + "." + FractureParameters::ExportGrid_STR[exportType], squared);
+		this->exportRaw(*stream, squared);
+	else
+		this->exportNumpy(*stream, squared);
+
+	if (archive)
+		archive->append(entryName, buffer.str());
 	else
-		this->exportVox(filename + "." + FractureParameters::ExportGrid_STR[exportType], squared);
+		file.close();
 }
 
-void RegularGrid::fill(Model3D* model)
+void RegularGrid::fill(Model3D* model, bool conservative, bool solid)
 {
+	if (conservative)
+	{
+		this->fillConservative(model, solid);
+		this->updateSSBO();
+		return;
+	}
+
 	bool activeVoxels = false;
 	Tetravoxelizer tetravoxelizer;
 	tetravoxelizer.initialize(_numDivs);
@@ -206,13 +264,15 @@ void RegularGrid::fill(Model3D* model)
 
 	if (!activeVoxels)
 	{
-		this->fillNaive(model);
+		this->fillConservative(model, solid);
 		this->updateSSBO();
 	}
 }
 
 void RegularGrid::fill(const Voronoi& voronoi)
 {
+	this->markDirty();
+
 	#pragma omp parallel for
 	for (int x = 0; x < _numDivs.x; ++x)
 	{
@@ -235,12 +295,12 @@ void RegularGrid::fill(const Voronoi& voronoi)
 	}
 }
 
-void RegularGrid::fillNoiseBuffer(std::vector<float>& noiseBuffer, unsigned numSamples)
+void RegularGrid::fillNoiseBuffer(std::vector<float>& noiseBuffer, unsigned numSamples, const RandomStream& stream)
 {
 	noiseBuffer.resize(numSamples);
 	#pragma omp parallel for
 	for (int sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx)
-		noiseBuffer[sampleIdx] = RandomUtilities::getUniformRandom(.0f, 1.0f);
+		noiseBuffer[sampleIdx] = stream.getUniformRandom(sampleIdx);
 }
 
 void RegularGrid::getAABBs(std::vector<AABB>& aabb)
@@ -270,11 +330,57 @@ uvec3 RegularGrid::getClosestEntryVoxel(const Model3D::RayGPUData& ray)
 	return this->rayTraversalAmanatidesWoo(ray);
 }
 
+bool RegularGrid::getDirtyRegion(uvec3& minCell, uvec3& maxCell, unsigned halo) const
+{
+	uvec3 minBrick(std::numeric_limits<glm::uint>::max()), maxBrick(0);
+	bool isDirty = false;
+
+	for (unsigned x = 0; x < _numBricks.x; ++x)
+	{
+		for (unsigned y = 0; y < _numBricks.y; ++y)
+		{
+			for (unsigned z = 0; z < _numBricks.z; ++z)
+			{
+				if (_dirtyBricks[x * _numBricks.y * _numBricks.z + y * _numBricks.z + z])
+				{
+					minBrick = glm::min(minBrick, uvec3(x, y, z));
+					maxBrick = glm::max(maxBrick, uvec3(x, y, z));
+					isDirty = true;
+				}
+			}
+		}
+	}
+
+	if (!isDirty)
+		return false;
+
+	minCell = uvec3(glm::max(ivec3(minBrick * BRICK_SIZE) - ivec3(halo), ivec3(0)));
+	maxCell = glm::min((maxBrick + uvec3(1)) * BRICK_SIZE + uvec3(halo), _numDivs) - uvec3(1);
+
+	return true;
+}
+
 void RegularGrid::insertPoint(const vec3& position, unsigned index)
 {
 	uvec3 gridIndex = getPositionIndex(position);
 
 	_grid[this->getPositionIndex(gridIndex.x, gridIndex.y, gridIndex.z)]._value = index;
+	_dirtyBricks[this->getBrickIndex(gridIndex.x, gridIndex.y, gridIndex.z)] = 1;
+}
+
+void RegularGrid::markDirty()
+{
+	std::fill(_dirtyBricks.begin(), _dirtyBricks.end(), 1);
+}
+
+void RegularGrid::markDirty(const uvec3& minCell, const uvec3& maxCell)
+{
+	const uvec3 minBrick = minCell / BRICK_SIZE, maxBrick = glm::min(maxCell, _numDivs - uvec3(1)) / BRICK_SIZE;
+
+	for (unsigned x = minBrick.x; x <= maxBrick.x; ++x)
+		for (unsigned y = minBrick.y; y <= maxBrick.y; ++y)
+			for (unsigned z = minBrick.z; z <= maxBrick.z; ++z)
+				_dirtyBricks[x * _numBricks.y * _numBricks.z + y * _numBricks.z + z] = 1;
 }
 
 unsigned RegularGrid::numOccupiedVoxels()
@@ -290,17 +396,19 @@ void RegularGrid::queryCluster(
 	const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, std::vector<float>& clusterIdx,
 	std::vector<unsigned>& boundaryFaces, std::vector<std::unordered_map<unsigned, float>>& faceClusterOccupancy)
 {
-	std::unordered_map<uint16_t, unsigned> values;
+	GridStatistics statistics;
 	faceClusterOccupancy.resize(faces.size());
 
-	size_t numFragments = this->countValues(values);
+	statistics.build(*this);
+	size_t numFragments = statistics.getNumLabels();
 	size_t numSamples = 1000;
 	size_t actualSize = numFragments * faces.size();
 	size_t maxFaces = std::min(faces.size(), static_cast<size_t>(std::floor(ComputeShader::getMaxSSBOSize(sizeof(GLuint)) / numFragments)));
 	uvec3 numDivs = this->getNumSubdivisions();
 	unsigned numGroups = ComputeShader::getNumGroups(maxFaces * numSamples);
 	std::vector<float> noiseBuffer;
-	this->fillNoiseBuffer(noiseBuffer, numSamples * numSamples);
+	// Samples only locate points within faces, hence the stream does not depend on the fracture seed
+	this->fillNoiseBuffer(noiseBuffer, numSamples * numSamples, RandomStream(0, 0, 0, RandomStream::CLUSTER_NOISE));
 
 	ComputeShader::getMaxSSBOSize(sizeof(unsigned));
 
@@ -368,15 +476,7 @@ void RegularGrid::queryCluster(
 
 	float* clusterData = ComputeShader::readData(clusterSSBO, float());
 	clusterIdx = std::vector<float>(clusterData, clusterData + faces.size());
-
-	for (int idx = 0; idx < clusterIdx.size(); ++idx)
-	{
-		if (clusterIdx[idx] < .0f)
-		{
-			boundaryFaces.push_back(idx);
-			clusterIdx[idx] = -clusterIdx[idx];
-		}
-	}
+	RegularGrid::decodeClusters(clusterIdx, boundaryFaces);
 
 	ComputeShader::deleteBuffers(std::vector<GLuint> { countSSBO, vertexSSBO, gridSSBO, boundarySSBO, noiseSSBO });
 	free(count);
@@ -409,12 +509,213 @@ void RegularGrid::queryCluster(std::vector<vec4>* points, std::vector<float>& cl
 	ComputeShader::deleteBuffers(std::vector<GLuint> { vertexSSBO, gridSSBO, clusterSSBO });
 }
 
+void RegularGrid::queryClusterCPU(
+	const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, std::vector<float>& clusterIdx,
+	std::vector<unsigned>& boundaryFaces, std::vector<std::unordered_map<unsigned, float>>& faceClusterOccupancy)
+{
+	const int numFaces = static_cast<int>(faces.size());
+	const uint16_t boundaryMask = uint16_t(1 << MASK_POSITION);
+
+	clusterIdx.resize(numFaces);
+	faceClusterOccupancy.resize(numFaces);
+
+	#pragma omp parallel
+	{
+		std::vector<std::pair<uint16_t, uvec2>> histogram;			// Label, number of overlapped voxels and how many of them are masked as boundary
+
+		#pragma omp for schedule(dynamic, 256)
+		for (int faceIdx = 0; faceIdx < numFaces; ++faceIdx)
+		{
+			const uvec3& face = faces[faceIdx]._vertices;
+			Triangle3D triangle(vertices[face.x]._position, vertices[face.y]._position, vertices[face.z]._position);
+			const vec3 triangleMin = glm::min(glm::min(vertices[face.x]._position, vertices[face.y]._position), vertices[face.z]._position);
+			const vec3 triangleMax = glm::max(glm::max(vertices[face.x]._position, vertices[face.y]._position), vertices[face.z]._position);
+			const ivec3 minIndex(this->getPositionIndex(triangleMin)), maxIndex(this->getPositionIndex(triangleMax));
+
+			// Voxels overlapped by the triangle; if none of them is labelled, the search widens around its bounding box
+			histogram.clear();
+			for (int radius = 0; radius <= MAX_QUERY_RADIUS && histogram.empty(); ++radius)
+			{
+				const ivec3 start = glm::max(minIndex - ivec3(radius), ivec3(0)), end = glm::min(maxIndex + ivec3(radius), ivec3(_numDivs) - ivec3(1));
+
+				for (int x = start.x; x <= end.x; ++x)
+				{
+					for (int y = start.y; y <= end.y; ++y)
+					{
+						for (int z = start.z; z <= end.z; ++z)
+						{
+							const uint16_t value = _grid[this->getPositionIndex(x, y, z)]._value;
+							if (value <= VOXEL_FREE)
+								continue;
+
+							if (radius == 0)
+							{
+								const vec3 voxelMin = _aabb.min() + vec3(x, y, z) * _cellSize;
+								AABB voxel(voxelMin, voxelMin + _cellSize);
+								if (!Intersections3D::intersect(triangle, voxel))
+									continue;
+							}
+
+							const uint16_t label = this->unmask(value);
+							auto it = std::find_if(histogram.begin(), histogram.end(), [label](const std::pair<uint16_t, uvec2>& bin) { return bin.first == label; });
+							if (it == histogram.end())
+								it = histogram.insert(histogram.end(), std::make_pair(label, uvec2(0)));
+
+							++it->second.x;
+							it->second.y += static_cast<unsigned>((value & boundaryMask) != 0);
+						}
+					}
+				}
+			}
+
+			clusterIdx[faceIdx] = -1.0f;
+			if (histogram.empty())
+				continue;
+
+			unsigned numVoxels = 0;
+			auto best = histogram.begin();
+			for (auto it = histogram.begin(); it != histogram.end(); ++it)
+			{
+				numVoxels += it->second.x;
+				if (it->second.x > best->second.x || (it->second.x == best->second.x && it->first < best->first))
+					best = it;
+			}
+
+			std::unordered_map<unsigned, float>& occupancy = faceClusterOccupancy[faceIdx];
+			occupancy.clear();
+			for (const auto& bin : histogram)
+				occupancy[bin.first - (VOXEL_FREE + 1)] = bin.second.x / static_cast<float>(numVoxels);
+
+			// Same encoding as selectVoxelTriangle-comp: the sign flags boundary faces
+			clusterIdx[faceIdx] = best->first * (histogram.size() > 1 || best->second.y > 0 ? -1.0f : 1.0f);
+		}
+	}
+
+	RegularGrid::decodeClusters(clusterIdx, boundaryFaces);
+}
+
+std::vector<uint16_t> RegularGrid::refractureFragment(const uvec3& impact, unsigned numSeeds, unsigned spreading, RandomStream stream, uvec3& minCell, uvec3& maxCell)
+{
+	std::vector<uint16_t> labels;
+	const uint16_t label = this->unmask(this->at(impact.x, impact.y, impact.z));
+
+	if (label <= VOXEL_FREE)
+		return labels;
+
+	// Voxels of the impacted fragment, in breadth-first order from the impact; they are masked while waiting for a new label
+	const uint16_t pending = label | uint16_t(1 << MASK_POSITION);
+	const ivec3 offset[6] = { ivec3(1, 0, 0), ivec3(-1, 0, 0), ivec3(0, 1, 0), ivec3(0, -1, 0), ivec3(0, 0, 1), ivec3(0, 0, -1) };
+	std::vector<unsigned> fragmentCells{ this->getPositionIndex(impact.x, impact.y, impact.z) };
+
+	_grid[fragmentCells.front()]._value = pending;
+	minCell = maxCell = impact;
+
+	for (size_t cellIdx = 0; cellIdx < fragmentCells.size(); ++cellIdx)
+	{
+		const unsigned index = fragmentCells[cellIdx];
+		const ivec3 cell(index / (_numDivs.y * _numDivs.z), (index / _numDivs.z) % _numDivs.y, index % _numDivs.z);
+
+		minCell = glm::min(minCell, uvec3(cell));
+		maxCell = glm::max(maxCell, uvec3(cell));
+
+		for (const ivec3& neighbourOffset : offset)
+		{
+			const ivec3 neighbour = cell + neighbourOffset;
+			if (neighbour.x < 0 || neighbour.y < 0 || neighbour.z < 0 || neighbour.x >= _numDivs.x || neighbour.y >= _numDivs.y || neighbour.z >= _numDivs.z)
+				continue;
+
+			const unsigned neighbourIndex = this->getPositionIndex(neighbour.x, neighbour.y, neighbour.z);
+			if (this->unmask(_grid[neighbourIndex]._value) == label && _grid[neighbourIndex]._value != pending)
+			{
+				_grid[neighbourIndex]._value = pending;
+				fragmentCells.push_back(neighbourIndex);
+			}
+		}
+	}
+
+	// Labels not used by any other fragment
+	std::vector<uint8_t> isUsed(1 << MASK_POSITION, 0);
+
+	#pragma omp parallel
+	{
+		std::vector<uint8_t> isUsedThread(1 << MASK_POSITION, 0);
+
+		#pragma omp for
+		for (int idx = 0; idx < _grid.size(); ++idx)
+			isUsedThread[this->unmask(_grid[idx]._value)] = 1;
+
+		#pragma omp critical
+		for (int labelIdx = 0; labelIdx < isUsedThread.size(); ++labelIdx)
+			isUsed[labelIdx] |= isUsedThread[labelIdx];
+	}
+
+	// The impact keeps the previous label, while the remaining seeds are picked as the closest of several random voxels of the fragment
+	std::vector<unsigned> front{ fragmentCells.front() };
+	const unsigned numNewSeeds = glm::min(static_cast<unsigned>(stream.getUniformRandomInt(1, glm::max(numSeeds, 1u))), static_cast<unsigned>(fragmentCells.size()) - 1);
+	uint16_t newLabel = VOXEL_FREE;
+
+	_grid[fragmentCells.front()]._value = label;
+	labels.push_back(label);
+
+	for (unsigned seedIdx = 0; seedIdx < numNewSeeds; ++seedIdx)
+	{
+		unsigned cellIdx = static_cast<unsigned>(fragmentCells.size()) - 1;
+		for (unsigned attempt = 0; attempt < glm::max(spreading, 1u); ++attempt)
+			cellIdx = glm::min(cellIdx, static_cast<unsigned>(stream.getUniformRandomInt(1, fragmentCells.size() - 1)));
+
+		while (++newLabel < isUsed.size() && isUsed[newLabel]);
+		if (newLabel >= isUsed.size() || _grid[fragmentCells[cellIdx]]._value != pending)
+			continue;
+
+		_grid[fragmentCells[cellIdx]]._value = newLabel;
+		front.push_back(fragmentCells[cellIdx]);
+		labels.push_back(newLabel);
+	}
+
+	// Nothing to split, hence the pending mask is removed and neither the dirty bricks nor the GPU copy are touched
+	if (labels.size() < 2)
+	{
+		for (unsigned index : fragmentCells)
+			_grid[index]._value = label;
+
+		return labels;
+	}
+
+	// Flood the fragment from every seed at once, so that each voxel is taken by the closest seed in Manhattan distance
+	for (size_t frontIdx = 0; frontIdx < front.size(); ++frontIdx)
+	{
+		const unsigned index = front[frontIdx];
+		const ivec3 cell(index / (_numDivs.y * _numDivs.z), (index / _numDivs.z) % _numDivs.y, index % _numDivs.z);
+
+		for (const ivec3& neighbourOffset : offset)
+		{
+			const ivec3 neighbour = cell + neighbourOffset;
+			if (neighbour.x < 0 || neighbour.y < 0 || neighbour.z < 0 || neighbour.x >= _numDivs.x || neighbour.y >= _numDivs.y || neighbour.z >= _numDivs.z)
+				continue;
+
+			const unsigned neighbourIndex = this->getPositionIndex(neighbour.x, neighbour.y, neighbour.z);
+			if (_grid[neighbourIndex]._value == pending)
+			{
+				_grid[neighbourIndex]._value = _grid[index]._value;
+				front.push_back(neighbourIndex);
+			}
+		}
+	}
+
+	this->markDirty(minCell, maxCell);
+	this->updateSSBO(minCell, maxCell);
+
+	return labels;
+}
+
 void RegularGrid::resetFilling()
 {
 	size_t numCells = _numDivs.x * _numDivs.y * _numDivs.z;
 #pragma omp parallel for
 	for (int idx = 0; idx < numCells; ++idx)
 		_grid[idx]._value = glm::clamp(_grid[idx]._value, uint16_t(VOXEL_EMPTY), uint16_t(VOXEL_FREE + 1));
+
+	this->markDirty();
 }
 
 void RegularGrid::resetMarchingCubes()
@@ -440,29 +741,21 @@ void RegularGrid::setAABB(const AABB& aabb, const ivec3& gridDims)
 	this->cleanGrid();
 }
 
-std::vector<Model3D*> RegularGrid::toTriangleMesh(FractureParameters& fractParameters, std::vector<FragmentationProcedure::FragmentMetadata>& fragmentMetadata)
+std::vector<Model3D*> RegularGrid::toTriangleMesh(FractureParameters& fractParameters, std::vector<FragmentationProcedure::FragmentMetadata>& fragmentMetadata, Model3D* sourceMesh, std::vector<vec2>* surfaceArea)
 {
-	std::vector<Model3D*> meshes;
-	std::unordered_map<uint16_t, unsigned> valuesSet;
-	std::vector<uint16_t> values;
-	unsigned globalCount = 0;
+	GridStatistics statistics;
+	statistics.build(*this);
 
-	this->countValues(valuesSet);
-	meshes.resize(valuesSet.size());
+	const std::vector<uint16_t> values = statistics.getValues();
+	const unsigned globalCount = statistics.getNumOccupiedVoxels();
 
-	values.reserve(valuesSet.size());
-	fragmentMetadata.resize(valuesSet.size());
-	for (auto it = valuesSet.begin(); it != valuesSet.end(); )
-	{
-		fragmentMetadata[it->first - (VOXEL_FREE + 1)]._voxels = it->second;
-
-		globalCount += it->second;
-		values.push_back(std::move(valuesSet.extract(it++).key()));
-	}
+	// Metadata follows the order of the meshes, hence labels with gaps between them are packed
+	fragmentMetadata.resize(values.size());
 
 	#pragma omp parallel for
 	for (int idx = 0; idx < values.size(); ++idx)
 	{
+		fragmentMetadata[idx]._voxels = statistics.getLabels()[idx]._voxels;
 		fragmentMetadata[idx]._type = FragmentationProcedure::MESH;
 		fragmentMetadata[idx]._id = idx;
 		fragmentMetadata[idx]._percentage = fragmentMetadata[idx]._voxels / static_cast<float>(globalCount);
@@ -470,47 +763,101 @@ std::vector<Model3D*> RegularGrid::toTriangleMesh(FractureParameters& fractParam
 		fragmentMetadata[idx]._voxelizationSize = _numDivs;
 	}
 
-	std::sort(values.begin(), values.end());
+	return this->toTriangleMesh(fractParameters, values, sourceMesh, uvec3(0), _numDivs - uvec3(1), surfaceArea);
+}
+
+std::vector<Model3D*> RegularGrid::toTriangleMesh(FractureParameters& fractParameters, const std::vector<uint16_t>& values, Model3D* sourceMesh, const uvec3& minCell, const uvec3& maxCell, std::vector<vec2>* surfaceArea)
+{
+	std::vector<Model3D*> meshes(values.size());
+	if (surfaceArea)
+		surfaceArea->assign(values.size(), vec2(.0f));
 
 	if (_marchingCubes)
-		_marchingCubes->setGrid(*this);
+		_marchingCubes->setGrid(*this, minCell, maxCell);
 
 	vec3 scale = (_aabb.size()) / vec3(_numDivs);
 	vec3 minPoint = _aabb.min();
 	mat4 transformationMatrix = glm::translate(glm::mat4(1.0f), -vec3(1.0f) * scale) * glm::translate(glm::mat4(1.0f), minPoint) * glm::scale(glm::mat4(1.0f), scale);
 
-	for (int idx = 0; idx < values.size(); ++idx)
-		meshes[idx] = _marchingCubes->triangulateFieldGPU(_ssbo, values[idx], fractParameters, transformationMatrix);
+	if (_marchingCubes)
+	{
+		for (int idx = 0; idx < values.size(); ++idx)
+			meshes[idx] = _marchingCubes->triangulateFieldGPU(_ssbo, values[idx], fractParameters, transformationMatrix, minCell, maxCell, surfaceArea ? &(*surfaceArea)[idx] : nullptr);
+	}
+
+	if (sourceMesh && (fractParameters._highResolutionFragments || !_marchingCubes))
+	{
+		FragmentMeshBuilder fragmentMeshBuilder(this, sourceMesh);
+		fragmentMeshBuilder.build(values, meshes, fractParameters);
+	}
 
 	return meshes;
 }
 
 void RegularGrid::undoMask()
 {
-	uvec3 numDivs = this->getNumSubdivisions();
-	unsigned numCells = numDivs.x * numDivs.y * numDivs.z;
+	if (_maskedMin.x > _maskedMax.x)
+		return;
+
+	uvec3 regionSize = _maskedMax - _maskedMin + uvec3(1);
+	unsigned numCells = regionSize.x * regionSize.y * regionSize.z;
 	unsigned numGroups = ComputeShader::getNumGroups(numCells);
 
 	_undoMaskShader->bindBuffers(std::vector<GLuint>{ _ssbo });
 	_undoMaskShader->use();
+	_undoMaskShader->setUniform("gridDims", this->getNumSubdivisions());
 	_undoMaskShader->setUniform("numCells", numCells);
 	_undoMaskShader->setUniform("position", MASK_POSITION);
+	_undoMaskShader->setUniform("regionMin", _maskedMin);
+	_undoMaskShader->setUniform("regionSize", regionSize);
 	_undoMaskShader->setSubroutineUniform(GL_COMPUTE_SHADER, "unmaskUniform", "unmaskBit");
 	_undoMaskShader->applyActiveSubroutines();
 	_undoMaskShader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 
-	this->updateGrid();
+	this->updateGrid(_maskedMin, _maskedMax);
+
+	_maskedMin = _numDivs;
+	_maskedMax = uvec3(0);
 }
 
 void RegularGrid::updateGrid()
 {
-	CellGrid* gridData = ComputeShader::readData(_ssbo, CellGrid());
-	std::copy(gridData, gridData + _numDivs.x * _numDivs.y * _numDivs.z, _grid.begin());
+	this->updateGrid(uvec3(0), _numDivs - uvec3(1));
+}
+
+void RegularGrid::updateGrid(const uvec3& minCell, const uvec3& maxCell)
+{
+	// The mapped range spans whole slabs, but only the rows of the region are copied, as the CPU may be ahead of the GPU elsewhere
+	const unsigned firstIndex = this->getPositionIndex(minCell.x, minCell.y, minCell.z), lastIndex = this->getPositionIndex(maxCell.x, maxCell.y, maxCell.z);
+	const unsigned rowLength = maxCell.z - minCell.z + 1;
+	CellGrid* gridData = ComputeShader::readData(_ssbo, CellGrid(), firstIndex * sizeof(CellGrid), (lastIndex - firstIndex + 1) * sizeof(CellGrid));
+
+	#pragma omp parallel for
+	for (int x = minCell.x; x <= maxCell.x; ++x)
+	{
+		for (unsigned y = minCell.y; y <= maxCell.y; ++y)
+		{
+			const unsigned index = this->getPositionIndex(x, y, minCell.z);
+			std::copy(gridData + (index - firstIndex), gridData + (index - firstIndex + rowLength), _grid.begin() + index);
+		}
+	}
 }
 
 void RegularGrid::updateSSBO()
 {
-	ComputeShader::updateReadBufferSubset(_ssbo, _grid.data(), 0, _grid.size());
+	uvec3 minCell, maxCell;
+
+	if (this->getDirtyRegion(minCell, maxCell))
+		this->updateSSBO(minCell, maxCell);
+}
+
+void RegularGrid::updateSSBO(const uvec3& minCell, const uvec3& maxCell)
+{
+	if (!_ssbo)
+		return;
+
+	const unsigned firstIndex = this->getPositionIndex(minCell.x, minCell.y, minCell.z), lastIndex = this->getPositionIndex(maxCell.x, maxCell.y, maxCell.z);
+	ComputeShader::updateReadBufferSubset(_ssbo, _grid.data() + firstIndex, firstIndex * sizeof(CellGrid), lastIndex - firstIndex + 1);
 }
 
 // [Protected methods]
@@ -525,11 +872,33 @@ uint16_t RegularGrid::at(int x, int y, int z) const
 	return _grid[this->getPositionIndex(x, y, z)]._value;
 }
 
+uint16_t RegularGrid::getLabel(int x, int y, int z) const
+{
+	return this->unmask(this->at(x, y, z));
+}
+
 glm::uvec3 RegularGrid::getNumSubdivisions() const
 {
 	return _numDivs;
 }
 
+uvec3 RegularGrid::getSurfaceVoxel(const vec3& point, const vec3& direction) const
+{
+	const float step = glm::min(_cellSize.x, glm::min(_cellSize.y, _cellSize.z)) / 2.0f;
+
+	for (unsigned stepIdx = 0; stepIdx <= MAX_SURFACE_STEPS; ++stepIdx)
+	{
+		const ivec3 index(glm::floor((point + direction * (step * stepIdx) - _aabb.min()) / _cellSize));
+		if (glm::any(glm::lessThan(index, ivec3(0))) || glm::any(glm::greaterThanEqual(index, ivec3(_numDivs))))
+			continue;
+
+		if (this->isOccupied(index.x, index.y, index.z))
+			return uvec3(index);
+	}
+
+	return uvec3(std::numeric_limits<glm::uint>::max());
+}
+
 void RegularGrid::homogenize()
 {
 #pragma omp parallel for
@@ -537,7 +906,9 @@ void RegularGrid::homogenize()
 		for (int y = 0; y < _numDivs.y; ++y)
 			for (int z = 0; z < _numDivs.z; ++z)
 				if (this->at(x, y, z) != VOXEL_EMPTY)
-					this->set(x, y, z, VOXEL_FREE);
+					_grid[this->getPositionIndex(x, y, z)]._value = VOXEL_FREE;
+
+	this->markDirty();
 }
 
 bool RegularGrid::isBoundary(int x, int y, int z, int neighbourhoodSize) const
@@ -576,16 +947,22 @@ size_t RegularGrid::length() const
 void RegularGrid::set(int x, int y, int z, uint16_t i)
 {
 	_grid[this->getPositionIndex(x, y, z)]._value = i;
+	_dirtyBricks[this->getBrickIndex(x, y, z)] = 1;
 }
 
 /// Protected methods	
 
-void RegularGrid::buildGrid()
+void RegularGrid::buildGrid(bool gpuBuffers)
 {
 	_grid = std::vector<CellGrid>(_numDivs.x * _numDivs.y * _numDivs.z, CellGrid());
-	_ssbo = ComputeShader::setReadBuffer(_grid.data(), _grid.size(), GL_DYNAMIC_DRAW);
-	_countSSBO = ComputeShader::setWriteBuffer(GLuint(), _numDivs.x * _numDivs.y * _numDivs.z, GL_DYNAMIC_DRAW);
+	_ssbo = gpuBuffers ? ComputeShader::setReadBuffer(_grid.data(), _grid.size(), GL_DYNAMIC_DRAW) : 0;
+	_countSSBO = gpuBuffers ? ComputeShader::setWriteBuffer(GLuint(), _numDivs.x * _numDivs.y * _numDivs.z, GL_DYNAMIC_DRAW) : 0;
 	_voxelOpenGL = std::vector<unsigned char>(_numDivs.x * _numDivs.y * _numDivs.z, 0);
+
+	_numBricks = (_numDivs + uvec3(BRICK_SIZE - 1)) / BRICK_SIZE;
+	_dirtyBricks = std::vector<uint8_t>(_numBricks.x * _numBricks.y * _numBricks.z, 1);
+	_maskedMin = _numDivs;
+	_maskedMax = uvec3(0);
 }
 
 void RegularGrid::cleanGrid()
@@ -595,81 +972,86 @@ void RegularGrid::cleanGrid()
 	std::fill(_grid.begin(), _grid.begin() + numCells, CellGrid());
 	std::fill(_voxelOpenGL.begin(), _voxelOpenGL.begin() + numCells, 0);
 
-	ComputeShader::updateReadBufferSubset(_ssbo, _grid.data(), 0, numCells);
+	_numBricks = (_numDivs + uvec3(BRICK_SIZE - 1)) / BRICK_SIZE;
+	_dirtyBricks = std::vector<uint8_t>(_numBricks.x * _numBricks.y * _numBricks.z, 1);
+	_maskedMin = _numDivs;
+	_maskedMax = uvec3(0);
+
+	if (_ssbo)
+		ComputeShader::updateReadBufferSubset(_ssbo, _grid.data(), 0, numCells);
 }
 
-size_t RegularGrid::countValues(std::unordered_map<uint16_t, unsigned>& values)
+void RegularGrid::decodeClusters(std::vector<float>& clusterIdx, std::vector<unsigned>& boundaryFaces)
 {
-	unsigned index;
-	uint16_t value;
-	auto it = values.begin();
+	for (int idx = 0; idx < clusterIdx.size(); ++idx)
+	{
+		if (clusterIdx[idx] < .0f)
+		{
+			boundaryFaces.push_back(idx);
+			clusterIdx[idx] = -clusterIdx[idx];
+		}
+	}
+}
 
-	for (unsigned int x = 0; x < _numDivs.x; ++x)
-		for (unsigned int y = 0; y < _numDivs.y; ++y)
-			for (unsigned int z = 0; z < _numDivs.z; ++z)
-			{
-				index = this->getPositionIndex(x, y, z);
-				if (_grid[index]._value > VOXEL_FREE)
-				{
-					value = this->unmask(_grid[index]._value);
+void RegularGrid::detectBoundaries(int boundarySize, const uvec3& minCell, const uvec3& maxCell)
+{
+	ComputeShader* shader = ShaderList::getInstance()->getComputeShader(RendEnum::DETECT_BOUNDARIES);
 
-					it = values.find(value);
-					if (it != values.end())
-						++it->second;
-					else
-						values.insert(std::make_pair(value, 1));
-				}
-			}
+	uvec3 regionSize = maxCell - minCell + uvec3(1);
+	unsigned numCells = regionSize.x * regionSize.y * regionSize.z;
+	unsigned numGroups = ComputeShader::getNumGroups(numCells);
 
-	return values.size();
+	shader->bindBuffers(std::vector<GLuint>{ _ssbo });
+	shader->use();
+	shader->setUniform("boundarySize", boundarySize);
+	shader->setUniform("gridDims", this->getNumSubdivisions());
+	shader->setUniform("numCells", numCells);
+	shader->setUniform("regionMin", minCell);
+	shader->setUniform("regionSize", regionSize);
+	shader->execute(numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
+
+	_maskedMin = glm::min(_maskedMin, minCell);
+	_maskedMax = glm::max(_maskedMax, maxCell);
+
+	this->updateGrid(minCell, maxCell);
 }
 
-void RegularGrid::exportRawCompressed(const std::string& filename, bool squared)
+void RegularGrid::exportNumpy(std::ostream& stream, bool squared)
 {
-	std::ofstream file(filename, std::ios::out | std::ios::binary);
+	const uvec3 dims = this->getExportDimensions(squared);
+	const size_t numVoxels = static_cast<size_t>(dims.x) * dims.y * dims.z;
+	const std::vector<size_t> shape = { dims.x, dims.y, dims.z };
+
+	std::vector<uint16_t> volume(numVoxels, 0);
+	this->fillExportVolume(volume.data(), squared);
 
-	if (file.is_open())
+	const uint16_t maxValue = std::max_element(_grid.begin(), _grid.end(), [](const CellGrid& a, const CellGrid& b) { return a._value < b._value; })->_value;
+	if (maxValue <= std::numeric_limits<uint8_t>::max())
 	{
-		if (!squared)
-		{
-			file.write(reinterpret_cast<char*>(&_numDivs), sizeof(glm::uvec3));
-			file.write(reinterpret_cast<char*>(&_grid), _numDivs.x * _numDivs.y * _numDivs.z * sizeof(uint16_t));
-		}
-		else
-		{
-			uvec3 end = _numDivs;
-			ivec3 currentPosition;
-			end.x = end.y = end.z = glm::max(end.x, glm::max(end.y, end.z));
-			uvec3 start = (end - _numDivs) / uvec3(2);
+		std::vector<uint8_t> narrowVolume(numVoxels);
+		std::transform(volume.begin(), volume.end(), narrowVolume.begin(), [](uint16_t value) { return static_cast<uint8_t>(value); });
 
-			file.write(reinterpret_cast<char*>(&end), sizeof(glm::uvec3));
+		NumpyFile::write(stream, "|u1", shape, narrowVolume.data(), narrowVolume.size());
+	}
+	else
+		NumpyFile::write(stream, "<u2", shape, volume.data(), volume.size() * sizeof(uint16_t));
+}
 
-			// Reset first
-			for (int x = 0; x < end.x; ++x)
-			{
-				for (int y = 0; y < end.y; ++y)
-				{
-					for (int z = 0; z < end.z; ++z)
-					{
-						currentPosition = ivec3(x, y, z) - ivec3(start);
+void RegularGrid::exportRaw(std::ostream& stream, bool squared)
+{
+	RawHeader header{ { 'B', 'I', 'N', 'G' }, 1, sizeof(uint16_t), RawHeader::FLIP_Y, 0, this->getExportDimensions(squared), _numDivs };
+	if (squared) header._flags |= RawHeader::PADDED;
 
-						if (glm::all(glm::greaterThanEqual(currentPosition, ivec3(0))) && glm::all(glm::lessThan(currentPosition, ivec3(_numDivs))))
-							file.write(reinterpret_cast<char*>(&_grid[this->getPositionIndex(currentPosition.x, currentPosition.y, currentPosition.z)]), sizeof(uint16_t));
-						else
-						{
-							uint16_t empty = VOXEL_EMPTY;
-							file.write(reinterpret_cast<char*>(&empty), sizeof(uint16_t));
-						}
-					}
-				}
-			}
-		}
+	// Padding is already zeroed by the allocation, so only the occupied rows are copied
+	const size_t numVoxels = static_cast<size_t>(header._dims.x) * header._dims.y * header._dims.z;
+	std::vector<char> buffer(sizeof(RawHeader) + numVoxels * sizeof(uint16_t), 0);
+	std::memcpy(buffer.data(), &header, sizeof(RawHeader));
+	this->fillExportVolume(reinterpret_cast<uint16_t*>(buffer.data() + sizeof(RawHeader)), squared);
 
-		file.close();
-	}
+	stream.write(buffer.data(), buffer.size());
 }
 
-void RegularGrid::exportRLE(const std::string& filename)
+void RegularGrid::exportRLE(std::ostream& stream)
 {
 	struct RLEData
 	{
@@ -679,62 +1061,39 @@ void RegularGrid::exportRLE(const std::string& filename)
 
 	// Save in a binary file how many repetitions exist 
 	uint32_t size = _numDivs.x * _numDivs.y * _numDivs.z;
-	std::ofstream file(filename, std::ios::out | std::ios::binary);
 	std::vector<RLEData> rleData;
 
-	if (file.is_open())
-	{
-		uint16_t value = std::numeric_limits<uint16_t>::max();
-		uint32_t repetitions = 0, idx = 0;
+	uint16_t value = std::numeric_limits<uint16_t>::max();
+	uint32_t repetitions = 0, idx = 0;
 
-		while (idx < size)
+	while (idx < size)
+	{
+		while (idx < size && _grid[idx]._value == value)
 		{
-			while (idx < size && _grid[idx]._value == value)
-			{
-				++repetitions;
-				++idx;
-			}
-
-			if (repetitions > 0)
-				rleData.push_back({ value, repetitions });
-
-			value = _grid[idx]._value;
-			repetitions = 0;
+			++repetitions;
+			++idx;
 		}
 
-		file.write(reinterpret_cast<char*>(&_numDivs), sizeof(glm::uvec3));
-		for (RLEData& data : rleData)
-		{
-			file.write(reinterpret_cast<char*>(&data.value), sizeof(uint16_t));
-			file.write(reinterpret_cast<char*>(&data.repetitions), sizeof(uint32_t));
-		}
+		if (repetitions > 0)
+			rleData.push_back({ value, repetitions });
 
-		file.close();
+		value = _grid[idx]._value;
+		repetitions = 0;
 	}
-}
 
-void RegularGrid::exportQuadStack(const std::string& filename)
-{
-	QuadStack<uint16_t>* quadStack = new QuadStack<uint16_t>();
-	quadStack->loadCube(this);
-	quadStack->compress_y();
-	quadStack->compress_x();
-	//quadStack->calculateCompression();
-	quadStack->saveCheckpoint(filename);
-	delete quadStack;
+	stream.write(reinterpret_cast<char*>(&_numDivs), sizeof(glm::uvec3));
+	for (RLEData& data : rleData)
+	{
+		stream.write(reinterpret_cast<char*>(&data.value), sizeof(uint16_t));
+		stream.write(reinterpret_cast<char*>(&data.repetitions), sizeof(uint32_t));
+	}
 }
 
-void RegularGrid::exportUncompressed(const std::string& filename)
+void RegularGrid::exportQuadStack(std::ostream& stream)
 {
-	std::ofstream file(filename, std::ios::out);
-
-	if (file.is_open())
-	{
-		file.write(reinterpret_cast<char*>(&_numDivs), sizeof(glm::uvec3));
-		file.write(reinterpret_cast<char*>(&_grid), _numDivs.x * _numDivs.y * _numDivs.z * sizeof(uint16_t));
-
-		file.close();
-	}
+	QuadStackBuilder<uint16_t> quadStack;
+	if (quadStack.build(this))
+		quadStack.write(stream);
 }
 
 void RegularGrid::exportVox(const std::string& filename, bool squared)
@@ -786,33 +1145,182 @@ void RegularGrid::exportVox(const std::string& filename, bool squared)
 		}
 	}
 
-	// If path is empty then save in a file with random numbering
+	// The name is derived from the given path, so that repeated runs write the same files; iterations already have unique filenames
 	std::string filePath = filename;
 	if (filePath.empty())
 		filePath = "Output/grid";
 	if (filePath.find(".vox") == std::string::npos)
-		filePath += std::to_string(RandomUtilities::getUniformRandomInt(0, 10e6)) + ".vox";
+		filePath += ".vox";
 
 	//vox.PrintStats();
 	vox.SaveToFile(filePath);
 }
 
-void RegularGrid::fillNaive(Model3D* model)
+void RegularGrid::fillConservative(Model3D* model, bool solid)
 {
-	CADModel* cadModel = dynamic_cast<CADModel*>(model);
-	if (cadModel)
+	// Bounding boxes are slightly enlarged so that triangles lying on a face of a voxel also reach the neighbouring one
+	const float epsilon = 1e-4f;
+
+	for (Model3D::ModelComponent* modelComponent : model->getModelComponents())
 	{
-		static const unsigned numVoxelizationSamples = cadModel->getAABB().volume() * 10000;
-		PointCloud3D* sampledPointCloud = cadModel->sampleCPU(numVoxelizationSamples, 0);
-		auto points = sampledPointCloud->getPoints();
+		const std::vector<Model3D::VertexGPUData>& vertices = modelComponent->_geometry;
+		const std::vector<Model3D::FaceGPUData>& faces = modelComponent->_topology;
+		std::vector<uvec3> minCell(faces.size()), maxCell(faces.size());
 
 		#pragma omp parallel for
-		for (int idx = 0; idx < points->size(); ++idx)
+		for (int faceIdx = 0; faceIdx < faces.size(); ++faceIdx)
+		{
+			vec3 minPoint = vertices[faces[faceIdx]._vertices.x]._position, maxPoint = minPoint;
+			for (int i = 1; i < 3; ++i)
+			{
+				minPoint = glm::min(minPoint, vertices[faces[faceIdx]._vertices[i]]._position);
+				maxPoint = glm::max(maxPoint, vertices[faces[faceIdx]._vertices[i]]._position);
+			}
+
+			minCell[faceIdx] = uvec3(glm::clamp(ivec3(glm::floor((minPoint - _aabb.min()) / _cellSize - vec3(epsilon))), ivec3(0), ivec3(_numDivs) - ivec3(1)));
+			maxCell[faceIdx] = uvec3(glm::clamp(ivec3(glm::floor((maxPoint - _aabb.min()) / _cellSize + vec3(epsilon))), ivec3(0), ivec3(_numDivs) - ivec3(1)));
+		}
+
+		// Faces are binned by the slabs along x they overlap
+		std::vector<unsigned> slabOffset(_numDivs.x + 1, 0), slabFaces;
+
+		for (unsigned faceIdx = 0; faceIdx < faces.size(); ++faceIdx)
+			for (unsigned x = minCell[faceIdx].x; x <= maxCell[faceIdx].x; ++x)
+				++slabOffset[x + 1];
+
+		std::partial_sum(slabOffset.begin(), slabOffset.end(), slabOffset.begin());
+		std::vector<unsigned> slabCount(slabOffset.begin(), slabOffset.end() - 1);
+		slabFaces.resize(slabOffset.back());
+
+		for (unsigned faceIdx = 0; faceIdx < faces.size(); ++faceIdx)
+			for (unsigned x = minCell[faceIdx].x; x <= maxCell[faceIdx].x; ++x)
+				slabFaces[slabCount[x]++] = faceIdx;
+
+		#pragma omp parallel for schedule(dynamic)
+		for (int x = 0; x < _numDivs.x; ++x)
+		{
+			for (unsigned slabIdx = slabOffset[x]; slabIdx < slabOffset[x + 1]; ++slabIdx)
+			{
+				const unsigned faceIdx = slabFaces[slabIdx];
+				Triangle3D triangle(vertices[faces[faceIdx]._vertices.x]._position, vertices[faces[faceIdx]._vertices.y]._position, vertices[faces[faceIdx]._vertices.z]._position);
+
+				for (unsigned y = minCell[faceIdx].y; y <= maxCell[faceIdx].y; ++y)
+				{
+					for (unsigned z = minCell[faceIdx].z; z <= maxCell[faceIdx].z; ++z)
+					{
+						const unsigned index = this->getPositionIndex(x, y, z);
+						if (_grid[index]._value != VOXEL_EMPTY)
+							continue;
+
+						AABB voxel(_aabb.min() + _cellSize * vec3(x, y, z), _aabb.min() + _cellSize * vec3(x + 1, y + 1, z + 1));
+						if (Intersections3D::intersect(triangle, voxel))
+							_grid[index]._value = VOXEL_FREE;
+					}
+				}
+			}
+		}
+	}
+
+	if (solid)
+		this->fillInterior();
+
+	this->markDirty();
+}
+
+void RegularGrid::fillExportVolume(uint16_t* volume, bool squared) const
+{
+	static_assert(sizeof(CellGrid) == sizeof(uint16_t), "CellGrid rows are copied as raw uint16_t");
+
+	const uvec3 dims = this->getExportDimensions(squared);
+
+	#pragma omp parallel for
+	for (int x = 0; x < _numDivs.x; ++x)
+	{
+		for (int y = 0; y < _numDivs.y; ++y)
+		{
+			const size_t dstIndex = (static_cast<size_t>(x) * dims.y + (_numDivs.y - 1 - y)) * dims.z;
+			std::memcpy(&volume[dstIndex], &_grid[this->getPositionIndex(x, y, 0)], _numDivs.z * sizeof(uint16_t));
+		}
+	}
+}
+
+void RegularGrid::fillInterior()
+{
+	const ivec3 offset[6] = { ivec3(1, 0, 0), ivec3(-1, 0, 0), ivec3(0, 1, 0), ivec3(0, -1, 0), ivec3(0, 0, 1), ivec3(0, 0, -1) };
+	std::vector<std::atomic<uint8_t>> isExterior(_grid.size());
+	std::vector<unsigned> frontier;
+
+	// Empty voxels on the border of the grid
+	#pragma omp parallel
+	{
+		std::vector<unsigned> threadFrontier;
+
+		#pragma omp for
+		for (int x = 0; x < _numDivs.x; ++x)
 		{
-			glm::uvec3 gridIndex = this->getPositionIndex(points->at(idx));
-			this->set(gridIndex.x, gridIndex.y, gridIndex.z, VOXEL_FREE);
+			for (unsigned y = 0; y < _numDivs.y; ++y)
+			{
+				const bool isBorderRow = x == 0 || x == _numDivs.x - 1 || y == 0 || y == _numDivs.y - 1;
+				const unsigned zStep = isBorderRow ? 1 : glm::max(_numDivs.z - 1, 1u);
+
+				for (unsigned z = 0; z < _numDivs.z; z += zStep)
+				{
+					const unsigned index = this->getPositionIndex(x, y, z);
+					if (_grid[index]._value == VOXEL_EMPTY)
+					{
+						isExterior[index] = 1;
+						threadFrontier.push_back(index);
+					}
+				}
+			}
 		}
+
+		#pragma omp critical
+		frontier.insert(frontier.end(), threadFrontier.begin(), threadFrontier.end());
 	}
+
+	while (!frontier.empty())
+	{
+		std::vector<unsigned> nextFrontier;
+
+		#pragma omp parallel
+		{
+			std::vector<unsigned> threadFrontier;
+
+			#pragma omp for
+			for (int frontierIdx = 0; frontierIdx < frontier.size(); ++frontierIdx)
+			{
+				const unsigned index = frontier[frontierIdx];
+				const ivec3 cell(index / (_numDivs.y * _numDivs.z), (index / _numDivs.z) % _numDivs.y, index % _numDivs.z);
+
+				for (const ivec3& neighbourOffset : offset)
+				{
+					const ivec3 neighbour = cell + neighbourOffset;
+					if (neighbour.x < 0 || neighbour.y < 0 || neighbour.z < 0 || neighbour.x >= _numDivs.x || neighbour.y >= _numDivs.y || neighbour.z >= _numDivs.z)
+						continue;
+
+					const unsigned neighbourIndex = this->getPositionIndex(neighbour.x, neighbour.y, neighbour.z);
+					if (_grid[neighbourIndex]._value == VOXEL_EMPTY && !isExterior[neighbourIndex].exchange(1))
+						threadFrontier.push_back(neighbourIndex);
+				}
+			}
+
+			#pragma omp critical
+			nextFrontier.insert(nextFrontier.end(), threadFrontier.begin(), threadFrontier.end());
+		}
+
+		frontier.swap(nextFrontier);
+	}
+
+	#pragma omp parallel for
+	for (int idx = 0; idx < _grid.size(); ++idx)
+		if (_grid[idx]._value == VOXEL_EMPTY && !isExterior[idx])
+			_grid[idx]._value = VOXEL_FREE;
+}
+
+unsigned RegularGrid::getBrickIndex(int x, int y, int z) const
+{
+	return (x / BRICK_SIZE) * _numBricks.y * _numBricks.z + (y / BRICK_SIZE) * _numBricks.z + z / BRICK_SIZE;
 }
 
 void RegularGrid::getComputeShaders()
@@ -828,12 +1336,20 @@ void RegularGrid::getComputeShaders()
 	_undoMaskShader = ShaderList::getInstance()->getComputeShader(RendEnum::UNDO_MASK_SHADER);
 }
 
+uvec3 RegularGrid::getExportDimensions(bool squared) const
+{
+	if (!squared)
+		return _numDivs;
+
+	return uvec3(glm::max(_numDivs.x, glm::max(_numDivs.y, _numDivs.z)));
+}
+
 uvec3 RegularGrid::getPositionIndex(const vec3& position)
 {
-	unsigned x = (position.x - _aabb.min().x) / _cellSize.x, y = (position.y - _aabb.min().y) / _cellSize.y, z = (position.z - _aabb.min().z) / _cellSize.z;
-	unsigned zeroUnsigned = 0;
+	// Clamped before the conversion, so that positions below the minimum corner map to the first cell instead of wrapping around
+	const ivec3 index(glm::floor((position - _aabb.min()) / _cellSize));
 
-	return uvec3(glm::clamp(x, zeroUnsigned, _numDivs.x - 1), glm::clamp(y, zeroUnsigned, _numDivs.y - 1), glm::clamp(z, zeroUnsigned, _numDivs.z - 1));
+	return uvec3(glm::clamp(index, ivec3(0), ivec3(_numDivs) - ivec3(1)));
 }
 
 unsigned RegularGrid::getPositionIndex(int x, int y, int z) const
@@ -5,6 +5,7 @@
 #include "Graphics/Core/Model3D.h"
 
 class AABB;
+class FragmentArchive;
 class MarchingCubes;
 class Texture;
 class Voronoi;
@@ -14,8 +15,15 @@ class Voronoi;
 
 class RegularGrid
 {
+	friend class ContactGraph;
+	friend class FragmentDescriptors;
+	friend class GridStatistics;
+
 protected:
+	const unsigned BRICK_SIZE = 8;								//!< Side of the bricks whose modification is tracked
 	const unsigned MASK_POSITION = 15;
+	const int MAX_QUERY_RADIUS = 2;								//!< Voxels around a triangle that are searched if it overlaps no labelled voxel
+	const unsigned MAX_SURFACE_STEPS = 4;						//!< Half-cell steps taken from a surface point in search of an occupied voxel
 
 public:
 	struct CellGrid
@@ -26,33 +34,53 @@ public:
 		CellGrid(uint16_t value) : _value(value)/*, _boundary(0), _padding(.0f)*/ {}
 	};
 
+	/**
+	*	@brief Header of uncompressed binary grids. The payload that follows is a C-ordered (x, y, z) uint16_t volume, z varying fastest.
+	*/
+	struct RawHeader
+	{
+		enum Flags : uint8_t { FLIP_Y = 1, PADDED = 2 };
+
+		char		_magic[4];				//!< "BING"
+		uint8_t		_version;				//!< Format version
+		uint8_t		_bytesPerVoxel;			//!< Size of each voxel in the payload
+		uint8_t		_flags;					//!< Axis convention applied to the payload, matching decompress_grid.py
+		uint8_t		_padding;
+		uvec3		_dims;					//!< Dimensions of the stored volume
+		uvec3		_gridDims;				//!< Dimensions of the voxelization before padding
+	};
+
 protected:
 	std::vector<CellGrid>		_grid;					//!< Color index of regular grid
 
 	AABB						_aabb;					//!< Bounding box of the scene
 	vec3						_cellSize;				//!< Size of each grid cell
 	GLuint						_countSSBO;				//!< GPU buffer to save the number of occupied voxels per cell		
+	std::vector<uint8_t>		_dirtyBricks;			//!< Bricks modified since the last call to clearDirty()
 	MarchingCubes*				_marchingCubes;			//!< Marching cubes algorithm
+	uvec3						_maskedMax;				//!< Maximum voxel of the region where boundaries were detected
+	uvec3						_maskedMin;				//!< Minimum voxel of the region where boundaries were detected, greater than _maskedMax if there is none
+	uvec3						_numBricks;				//!< Number of bricks along each axis
 	uvec3						_numDivs;				//!< Number of subdivisions of space between mininum and maximum point
 	GLuint						_ssbo;					//!< GPU buffer to save the grid
 	std::vector<unsigned char>	_voxelOpenGL;			//!< CPU buffer to save the number of occupied voxels per cell	
 
-	// Compute shaders
-	ComputeShader* _assignVertexClusterShader;			//!< Shader to assign a cluster to each vertex
-	ComputeShader* _copyGridShader;						//!< Copies the content of one grid into another
-	ComputeShader* _countQuadrantOccupancyShader;		//!< Shader to count the number of occupied voxels per quadrant
-	ComputeShader* _countVoxelTriangleShader;
-	ComputeShader* _erodeShader;
-	ComputeShader* _pickVoxelTriangleShader;
-	ComputeShader* _removeIsolatedRegionsShader;
-	ComputeShader* _resetCounterShader;					//!< Shader to reset the counter
-	ComputeShader* _undoMaskShader;
+	// Compute shaders, null for CPU-only grids
+	ComputeShader* _assignVertexClusterShader = nullptr;		//!< Shader to assign a cluster to each vertex
+	ComputeShader* _copyGridShader = nullptr;					//!< Copies the content of one grid into another
+	ComputeShader* _countQuadrantOccupancyShader = nullptr;		//!< Shader to count the number of occupied voxels per quadrant
+	ComputeShader* _countVoxelTriangleShader = nullptr;
+	ComputeShader* _erodeShader = nullptr;
+	ComputeShader* _pickVoxelTriangleShader = nullptr;
+	ComputeShader* _removeIsolatedRegionsShader = nullptr;
+	ComputeShader* _resetCounterShader = nullptr;				//!< Shader to reset the counter
+	ComputeShader* _undoMaskShader = nullptr;
 
 protected:
 	/**
-	*	@brief Builds a 3D grid.
+	*	@brief Builds a 3D grid, along with its GPU buffers if requested.
 	*/
-	void buildGrid();
+	void buildGrid(bool gpuBuffers = true);
 
 	/**
 	*	@brief Cleans the current grid.
@@ -60,29 +88,35 @@ protected:
 	void cleanGrid();
 
 	/**
-	*	@return Number of different values in grid.
+	*	@brief Decodes the clusters written by selectVoxelTriangle-comp, or by its CPU counterpart. A negative value flags a boundary face, which is
+	*	appended to boundaryFaces, while unlabelled faces are written as -1 and thus decoded as boundary faces of VOXEL_FREE.
 	*/
-	size_t countValues(std::unordered_map<uint16_t, unsigned>& values);
+	static void decodeClusters(std::vector<float>& clusterIdx, std::vector<unsigned>& boundaryFaces);
 
 	/**
-	*	@brief Exports the grid as a raw file.
+	*	@brief Runs the boundary detection shader over the voxels between minCell and maxCell.
 	*/
-	void exportRawCompressed(const std::string& filename, bool squared);
+	void detectBoundaries(int boundarySize, const uvec3& minCell, const uvec3& maxCell);
 
 	/**
-	*	@brief Exports the grid into a .rle file.
+	*	@brief Exports the grid as a .npy array with the layout of exportRaw. Labels are narrowed to uint8 whenever they fit.
 	*/
-	void exportRLE(const std::string& filename);
+	void exportNumpy(std::ostream& stream, bool squared);
 
 	/**
-	*	@brief Exports the grid into a .vox file.
+	*	@brief Exports the grid as a raw file, preceded by a RawHeader and written with a single call.
 	*/
-	void exportQuadStack(const std::string& filename);
+	void exportRaw(std::ostream& stream, bool squared);
 
 	/**
-	*	@brief Exports the grid as a raw file.
+	*	@brief Exports the grid into a .rle file.
+	*/
+	void exportRLE(std::ostream& stream);
+
+	/**
+	*	@brief Exports the grid into a .qstack file, built by QuadStackBuilder.
 	*/
-	void exportUncompressed(const std::string& filename);
+	void exportQuadStack(std::ostream& stream);
 
 	/**
 	*	@brief Exports the grid into a .vox file.
@@ -90,15 +124,38 @@ protected:
 	void exportVox(const std::string& filename, bool squared);
 
 	/**
-	*	@brief Fills the grid with the content of the model.
+	*	@brief Voxelizes the surface of the model on the CPU, testing each triangle against the voxels of its bounding box. Triangles are binned 
+	*	into slabs along x, hence every slab is written by a single thread. Open and non-manifold meshes are supported.
+	*	@param solid Fills the voxels enclosed by the surface afterwards.
+	*/
+	void fillConservative(Model3D* model, bool solid);
+
+	/**
+	*	@brief Copies the grid into a zero-initialized buffer of getExportDimensions() voxels, flipping y and padding the high end as decompress_grid.py does.
+	*/
+	void fillExportVolume(uint16_t* volume, bool squared) const;
+
+	/**
+	*	@brief Marks as free every empty voxel that cannot be reached from the border of the grid without crossing occupied voxels. 
+	*	The exterior is flooded in parallel, one breadth-first level at a time.
+	*/
+	void fillInterior();
+
+	/**
+	*	@return Index of the brick containing the given voxel.
 	*/
-	void fillNaive(Model3D* model);
+	unsigned getBrickIndex(int x, int y, int z) const;
 
 	/**
 	*	@brief Retrieves compute shaders from the shader list.
 	*/
 	void getComputeShaders();
 
+	/**
+	*	@return Dimensions of the exported volume, either the grid dimensions or a cube of the largest one.
+	*/
+	uvec3 getExportDimensions(bool squared) const;
+
 	/**
 	*	@return Index of grid cell to be filled.
 	*/
@@ -147,9 +204,10 @@ public:
 
 public:
 	/**
-	*	@brief Constructor which specifies the area and the number of divisions of such area.
+	*	@brief Constructor which specifies the area and the number of divisions of such area. If gpuBuffers is disabled, neither GPU buffers nor
+	*	shaders are allocated, as in CPU-only copies, hence the grid can be built and filled with no OpenGL context.
 	*/
-	RegularGrid(const AABB& aabb, const ivec3& subdivisions);
+	RegularGrid(const AABB& aabb, const ivec3& subdivisions, bool gpuBuffers = true);
 
 	/**
 	*	@brief Constructor of an abstract regular grid with no notion of space size.
@@ -157,9 +215,10 @@ public:
 	RegularGrid(const ivec3& subdivisions);
 
 	/**
-	*	@brief Invalid copy constructor.
+	*	@brief CPU-only copy of a grid, e.g., for worker threads. No GPU buffer nor marching cubes instance is allocated, hence only methods 
+	*	working on the CPU copy of the grid can be used. Shaders are only fetched if the copied grid has them.
 	*/
-	RegularGrid(const RegularGrid& regulargrid) = delete;
+	RegularGrid(const RegularGrid& regulargrid);
 
 	/**
 	*	@brief Destructor.
@@ -172,24 +231,37 @@ public:
 	unsigned calculateMaxQuadrantOccupancy(const unsigned subdivisions = 1) const;
 
 	/**
-	*	@brief Detects which voxels are in the boundary of fragments.
+	*	@brief Forgets the modified bricks, once boundaries and meshes are up to date with the grid.
+	*/
+	void clearDirty();
+
+	/**
+	*	@brief Copies the voxels of a grid with the same dimensions.
+	*/
+	void copyLabels(const RegularGrid& regulargrid);
+
+	/**
+	*	@brief Detects which voxels are in the boundary of fragments. Only the modified bricks, enlarged by boundarySize, are visited.
 	*/
 	void detectBoundaries(int boundarySize);
 
 	/**
-	*	@brief
+	*	@brief Erodes the boundaries of fragments. Noise is drawn from the given stream.
 	*/
-	void erode(FractureParameters::ErosionType fractureParams, uint32_t convolutionSize, uint16_t numIterations, float erosionProbability, float erosionThreshold);
+	void erode(FractureParameters::ErosionType fractureParams, uint32_t convolutionSize, uint16_t numIterations, float erosionProbability, float erosionThreshold, const RandomStream& stream);
 
 	/**
-	*	@brief Exports fragments into several models in a PLY file.
+	*	@brief Exports the grid in the required format. The extension is appended to filename.
+	*	@param archive If not null, the grid is appended to it instead of being written as a separate file.
 	*/
-	void exportGrid(const std::string& filename, bool squared = false, FractureParameters::ExportGrid exportType = FractureParameters::QUADSTACK);
+	void exportGrid(const std::string& filename, bool squared = false, FractureParameters::ExportGrid exportType = FractureParameters::QUADSTACK, FragmentArchive* archive = nullptr);
 
 	/**
-	*	@brief
+	*	@brief Voxelizes the model. The Tetravoxelizer is used unless conservative is set, and the CPU surface voxelizer serves as fallback if 
+	*	the former finds no voxel, e.g., for open meshes.
+	*	@param solid Fills the interior of the surface found by the CPU voxelizer.
 	*/
-	void fill(Model3D* model);
+	void fill(Model3D* model, bool conservative = false, bool solid = true);
 
 	/**
 	*	@brief
@@ -197,9 +269,9 @@ public:
 	void fill(const Voronoi& voronoi);
 
 	/**
-	*	@brief
+	*	@brief Fills noiseBuffer with numSamples uniform values in [0, 1), the i-th being the i-th value of the stream.
 	*/
-	void fillNoiseBuffer(std::vector<float>& noiseBuffer, unsigned numSamples);
+	void fillNoiseBuffer(std::vector<float>& noiseBuffer, unsigned numSamples, const RandomStream& stream);
 
 	/**
 	*	@return Bounding box of the regular grid.
@@ -222,11 +294,27 @@ public:
 	template<typename T>
 	void getData(std::vector<std::vector<std::vector<T>>>& data);
 
+	/**
+	*	@brief Bounding box of the bricks modified since the last call to clearDirty(), enlarged by halo voxels and clamped to the grid.
+	*	@return False if no brick has been modified.
+	*/
+	bool getDirtyRegion(uvec3& minCell, uvec3& maxCell, unsigned halo = 0) const;
+
 	/**
 	*	@brief Inserts a new point in the grid.
 	*/
 	void insertPoint(const vec3& position, unsigned index);
 
+	/**
+	*	@brief Marks every brick as modified.
+	*/
+	void markDirty();
+
+	/**
+	*	@brief Marks the bricks overlapping the voxels between minCell and maxCell as modified.
+	*/
+	void markDirty(const uvec3& minCell, const uvec3& maxCell);
+
 	/**
 	*	@return Number of occupied voxels.
 	*/
@@ -242,6 +330,25 @@ public:
 	*/
 	void queryCluster(std::vector<vec4>* points, std::vector<float>& clusterIdx);
 
+	/**
+	*	@brief Queries cluster for each triangle of the given mesh without the GPU. Triangles are tested against every labelled voxel within their bounding box,
+	*	and the occupancy of each fragment is the fraction of overlapped voxels that belong to it. Faces overlapping several fragments, or voxels masked as
+	*	boundary, are reported in boundaryFaces. Clusters are encoded and decoded as in queryCluster, hence faces that reach no labelled voxel are
+	*	assigned VOXEL_FREE and reported as boundary faces.
+	*/
+	void queryClusterCPU(const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, std::vector<float>& clusterIdx, std::vector<unsigned>& boundaryFaces, std::vector<std::unordered_map<unsigned, float>>& faceClusterOccupancy);
+
+	/**
+	*	@brief Splits the fragment containing the impact voxel without touching the rest of the grid. Its voxels are flooded again from the impact
+	*	and from up to numSeeds additional seeds, which are biased towards the impact as spreading grows. Only the modified range is uploaded to the GPU.
+	*	@param stream Random stream from where the number and location of new seeds are drawn.
+	*	@param minCell Minimum voxel of the flooded region. Other components of the impacted label keep it and are not included.
+	*	@param maxCell Maximum voxel of the flooded region.
+	*	@return Labels of the modified fragments, starting with the impacted one. Empty if the impact is not labelled, and only the impacted label if
+	*	no seed could be placed; in that case the grid is left untouched and nothing is marked as dirty.
+	*/
+	std::vector<uint16_t> refractureFragment(const uvec3& impact, unsigned numSeeds, unsigned spreading, RandomStream stream, uvec3& minCell, uvec3& maxCell);
+
 	/**
 	*	@brief Resets regular grid to avoid filling it again.
 	*/
@@ -265,15 +372,24 @@ public:
 	/**
 	*	@brief Substitutes current grid with new values.
 	*/
-	void swap(CellGrid* newGrid, unsigned size) { std::copy(newGrid, newGrid + size, _grid.begin()); }
+	void swap(CellGrid* newGrid, unsigned size) { std::copy(newGrid, newGrid + size, _grid.begin()); this->markDirty(); }
 
 	/**
-	*	@brief Transforms the regular grid into a triangle mesh per value.
+	*	@brief Transforms the regular grid into a triangle mesh per value. If a source mesh is given and high-resolution fragments are enabled, 
+	*	the outer surface of each fragment is taken from it instead of marching cubes. If surfaceArea is given, it receives the area of the 
+	*	marching cubes surface of each fragment, split into triangles emitted from voxels masked as boundary (x) and the rest (y). Grids with no 
+	*	marching cubes instance, e.g., CPU-only grids, get the outer surface taken from the source mesh and a crack surface made of voxel faces, 
+	*	which is smoothed on the CPU.
 	*/
-	std::vector<Model3D*> toTriangleMesh(FractureParameters& fractParameters, std::vector<FragmentationProcedure::FragmentMetadata>& fragmentMetadata);
+	std::vector<Model3D*> toTriangleMesh(FractureParameters& fractParameters, std::vector<FragmentationProcedure::FragmentMetadata>& fragmentMetadata, Model3D* sourceMesh = nullptr, std::vector<vec2>* surfaceArea = nullptr);
 
 	/**
-	*	@brief Undo the detection of boundaries, thus removing the included mask.
+	*	@brief Transforms the given values into triangle meshes, only visiting the voxels between minCell and maxCell.
+	*/
+	std::vector<Model3D*> toTriangleMesh(FractureParameters& fractParameters, const std::vector<uint16_t>& values, Model3D* sourceMesh, const uvec3& minCell, const uvec3& maxCell, std::vector<vec2>* surfaceArea = nullptr);
+
+	/**
+	*	@brief Undo the detection of boundaries, thus removing the included mask. Only the region where boundaries were detected is visited.
 	*/
 	void undoMask();
 
@@ -283,10 +399,20 @@ public:
 	void updateGrid();
 
 	/**
-	*	@brief Updates SSBO content with the CPU's one.
+	*	@brief Updates the voxels between minCell and maxCell with the GPU's content.
+	*/
+	void updateGrid(const uvec3& minCell, const uvec3& maxCell);
+
+	/**
+	*	@brief Updates SSBO content with the CPU's one, limited to the modified bricks.
 	*/
 	void updateSSBO();
 
+	/**
+	*	@brief Updates the SSBO range spanning the voxels between minCell and maxCell with the CPU's content.
+	*/
+	void updateSSBO(const uvec3& minCell, const uvec3& maxCell);
+
 	// ----------- External functions ----------
 
 	/**
@@ -307,12 +433,24 @@ public:
 	*/
 	uint16_t at(int x, int y, int z) const;
 
+	/**
+	*   Read voxel without the boundary mask.
+	*   @return Label of the voxel.
+	*/
+	uint16_t getLabel(int x, int y, int z) const;
+
 	/**
 	*   Voxel space dimensions.
 	*   @return Space dimension
 	*/
 	glm::uvec3 getNumSubdivisions() const;
 
+	/**
+	*	@brief Marches from a point of the mesh surface along direction in steps of half a cell, as the surface may lie slightly outside its voxels.
+	*	@return First occupied voxel, or the maximum unsigned value if there is none within MAX_SURFACE_STEPS steps.
+	*/
+	uvec3 getSurfaceVoxel(const vec3& point, const vec3& direction) const;
+
 	/**
 	*   Set every voxel that is not EMPTY as FREE.
 	*/
@@ -4,141 +4,117 @@
 // [Public methods]
 
 WingedTriangleMesh::WingedTriangleMesh(
-	const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, std::vector<std::unordered_map<unsigned, float>> faceClusterOccupancy)
+	const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, const std::vector<std::unordered_map<unsigned, float>>& faceClusterOccupancy) :
+	_adjacency(vertices, faces)
 {
-	_cellSize = vec3(.0f);
+	const unsigned numFaces = _adjacency.getNumFaces();
 
-	for (int idx = 0; idx < faceClusterOccupancy.size(); ++idx)
-	{
-		Triangle3D triangle(vertices[faces[idx]._vertices.x]._position, vertices[faces[idx]._vertices.y]._position, vertices[faces[idx]._vertices.z]._position);
-		AABB aabb = triangle.aabb();
-
-		_aabb.update(vertices[faces[idx]._vertices.x]._position);
-		_aabb.update(vertices[faces[idx]._vertices.y]._position);
-		_aabb.update(vertices[faces[idx]._vertices.z]._position);
-		_cellSize = glm::max(_cellSize, aabb.size());
-		_triangle.push_back(new WingedTriangle{triangle, faceClusterOccupancy[idx], static_cast<unsigned>(idx) });
-	}
+	_clusterOffset.resize(numFaces + 1, 0);
+	for (unsigned idx = 0; idx < numFaces; ++idx)
+		_clusterOffset[idx + 1] = _clusterOffset[idx] + faceClusterOccupancy[idx].size();
 
-	_cellSize /= 2.0f;
-	_numDivs = glm::ceil(_aabb.size() / _cellSize);
+	_clusterIdx.resize(_clusterOffset[numFaces]);
+	_clusterProbability.resize(_clusterOffset[numFaces]);
+	_finalCluster.resize(numFaces, 0);
+	_test.resize(numFaces, 0);
+	_boundary.resize(numFaces, 0);
 
-	_pointGrid.resize(_numDivs.x);
-	for (int x = 0; x < _numDivs.x; ++x)
+	#pragma omp parallel for
+	for (int idx = 0; idx < numFaces; ++idx)
 	{
-		_pointGrid[x].resize(_numDivs.y);
-		for (int y = 0; y < _numDivs.y; ++y)
-		{
-			_pointGrid[x][y].resize(_numDivs.z);
-		}
-	}
+		unsigned offset = _clusterOffset[idx];
+		float maxProb = .0f;
 
-	for (int idx = 0; idx < _triangle.size(); ++idx)
-	{
-		uvec3 position;
-		for (int i = 0; i < 3; ++i)
+		for (const auto& pair : faceClusterOccupancy[idx])
 		{
-			position = this->getPositionIndex(_triangle[idx]->_triangle.getPoint(i));
-			_pointGrid[position.x][position.y][position.z].push_back(std::make_pair(_triangle[idx], i));
-		}
-	}
-
-	this->checkVertexConnectivity();
-
-	_pointGrid.clear();
+			_clusterIdx[offset] = pair.first;
+			_clusterProbability[offset++] = pair.second;
 
-	//this->eraseFlatTriangles();
-	//
-	for (int idx = 0; idx < _triangle.size(); ++idx)
-	{
-		float maxProb = .0f;
-		for (const auto& pair : _triangle[idx]->_cluster)
 			if (pair.second > maxProb)
 			{
-				_triangle[idx]->_finalCluster = pair.first;
+				_finalCluster[idx] = pair.first;
 				maxProb = pair.second;
 			}
+		}
 	}
 
-	for (int idx = 0; idx < _triangle.size(); ++idx)
+	#pragma omp parallel for
+	for (int idx = 0; idx < numFaces; ++idx)
 	{
 		unsigned boundaries = 0;
 		for (int i = 0; i < 3; ++i)
 		{
-			std::unordered_set<unsigned> cluster;
-			for (auto& pair : _triangle[idx]->_connectionVertexWise[i])
-				cluster.insert(pair.first->_finalCluster);
+			const unsigned vertex = _adjacency.origin(idx * 3 + i);
+			const unsigned* corners = _adjacency.getVertexCorners(vertex);
+			bool severalClusters = false;
+
+			for (unsigned cornerIdx = 0; cornerIdx < _adjacency.getVertexValence(vertex) && !severalClusters; ++cornerIdx)
+				severalClusters = _finalCluster[MeshAdjacency::face(corners[cornerIdx])] != _finalCluster[MeshAdjacency::face(corners[0])];
 
-			boundaries += unsigned(cluster.size() > 1);
+			boundaries += unsigned(severalClusters);
 		}
 
-		_triangle[idx]->_boundary = boundaries >= 2;
+		_boundary[idx] = boundaries >= 2;
 	}
 }
 
 WingedTriangleMesh::~WingedTriangleMesh()
 {
-	for (WingedTriangle* triangle : _triangle)
-		delete triangle;
-	_triangle.clear();
 }
 
 void WingedTriangleMesh::computeAlgebraicConvexity()
 {
-	for (int idx = 0; idx < _triangle.size(); ++idx)
+	#pragma omp parallel for
+	for (int idx = 0; idx < _finalCluster.size(); ++idx)
 	{
-		WingedTriangle* triangle = _triangle[idx];
-		triangle->_test = triangle->_finalCluster;
+		_test[idx] = _finalCluster[idx];
 
-		if (!triangle->_boundary)
+		if (!_boundary[idx])
 			continue;
 
 		for (int i = 0; i < 3; ++i)
 		{
-			unsigned newCluster = triangle->_finalCluster;
-			auto neighbourIt = triangle->_connectionVertexWise[i].begin();
-			while (neighbourIt != triangle->_connectionVertexWise[i].end())
+			const unsigned vertex = _adjacency.origin(idx * 3 + i);
+			const unsigned* corners = _adjacency.getVertexCorners(vertex);
+			const unsigned valence = _adjacency.getVertexValence(vertex);
+			unsigned newCluster = _finalCluster[idx];
+
+			for (unsigned cornerIdx = 0; cornerIdx < valence; ++cornerIdx)
 			{
-				if (neighbourIt->first->_finalCluster != newCluster)
+				if (_finalCluster[MeshAdjacency::face(corners[cornerIdx])] != newCluster)
 				{
-					newCluster = neighbourIt->first->_finalCluster;
+					newCluster = _finalCluster[MeshAdjacency::face(corners[cornerIdx])];
 					break;
 				}
-				++neighbourIt;
 			}
 
-			if (newCluster == triangle->_finalCluster)
+			if (newCluster == _finalCluster[idx])
 				continue;
 
 			float maxDot = FLT_MAX;
-			WingedTriangle* neighbourTriangle = nullptr;
-			vec3 b = triangle->_triangle.getPoint(i);
-			vec3 a = triangle->_triangle.getPoint((i - 1 + 3) % 3);
+			bool neighbourFound = false;
+			vec3 b = _adjacency.getPosition(vertex);
+			vec3 a = _adjacency.getPosition(_adjacency.origin(MeshAdjacency::prev(idx * 3 + i)));
 			vec3 v1 = glm::normalize(b - a);
 
-			for (const auto& neighbourPair : triangle->_connectionVertexWise[i])
+			for (unsigned cornerIdx = 0; cornerIdx < valence; ++cornerIdx)
 			{
-				if (neighbourPair.first->_finalCluster == triangle->_finalCluster)
+				if (_finalCluster[MeshAdjacency::face(corners[cornerIdx])] == _finalCluster[idx])
 				{
-					vec3 c = neighbourPair.first->_triangle.getPoint((neighbourPair.second + 1) % 3);
+					vec3 c = _adjacency.getPosition(_adjacency.origin(MeshAdjacency::next(corners[cornerIdx])));
 					vec3 v2 = glm::normalize(c - a);
 					float angle = glm::dot(v1, v2);
 
 					if (angle < maxDot)
 					{
 						maxDot = angle;
-						neighbourTriangle = neighbourPair.first;
+						neighbourFound = true;
 					}
 				}
 			}
 
-			if (neighbourTriangle && maxDot < 0.0f)
-			{
-				//neighbourTriangle->_finalCluster = newCluster;
-				//neighbourTriangle->_boundary = false;
-				//neighbourTriangle->_test = true;
-				triangle->_test = triangle->_finalCluster + 1;
-			}
+			if (neighbourFound && maxDot < 0.0f)
+				_test[idx] = _finalCluster[idx] + 1;
 		}
 	}
 }
@@ -148,209 +124,135 @@ void WingedTriangleMesh::computeHardCluster(float smoothness)
 	//	E(x¯) = ∑f∈Fe1(f, xf) + λ∑{ f,g }∈Ne2(xf, xg)
 	//	e1(f, xf) = −log(max(P(f | xf), ϵ1))
 	//	e2(xf, xg) = { −log(wmax(1− | θ(f,g)|/π,ϵ2))0 xf≠xg xf = xg }
-	std::vector<unsigned> newCluster(_triangle.size());
+	std::vector<unsigned> newCluster(_finalCluster.size());
 	float epsilon1 = glm::epsilon<float>(), epsilon2 = glm::epsilon<float>();
 
-	for (int idx = 0; idx < _triangle.size(); ++idx)
+	#pragma omp parallel for
+	for (int idx = 0; idx < _finalCluster.size(); ++idx)
 	{
-		WingedTriangle* triangle = _triangle[idx];
 		float minEnergy = FLT_MAX;
-		unsigned minCluster = triangle->_finalCluster;
-
-		newCluster[idx] = triangle->_finalCluster;
+		unsigned minCluster = _finalCluster[idx];
+		std::vector<unsigned> clusterIdx, neighbours;
 
-		std::unordered_set<unsigned> clusterIdx;
-		this->getClusters(idx, clusterIdx);
+		_adjacency.getFaceNeighbours(idx, neighbours);
+		this->getClusters(idx, neighbours, clusterIdx);
 
-		if (clusterIdx.size() <= 1)
-			continue;
-
-		for (auto cluster : clusterIdx)
+		if (clusterIdx.size() > 1)
 		{
-			float energy = .0f;
+			const vec3 normal = this->getNormal(idx);
 
-			auto clusterIt = triangle->_cluster.find(cluster);
-			if (clusterIt != triangle->_cluster.end())
+			for (auto cluster : clusterIdx)
 			{
-				energy += -log(glm::max(clusterIt->second, epsilon1));
-			}
+				float energy = .0f, occupancy = this->getOccupancy(idx, cluster);
 
-			for (WingedTriangle* neighbour : triangle->_connectionVertex)
-			{
-				if (neighbour->_finalCluster != cluster)
+				if (occupancy >= .0f)
+					energy += -log(glm::max(occupancy, epsilon1));
+
+				for (unsigned neighbour : neighbours)
 				{
-					float dihedrical = glm::acos(triangle->_triangle.getDihedralAngle(neighbour->_triangle)) / glm::pi<float>(), w = (dihedrical < .0f) ? .08f : 1.0f;
-					energy += smoothness * -log(w * glm::max(1.0f - glm::abs(dihedrical), epsilon2));
+					if (neighbour != idx && _finalCluster[neighbour] != cluster)
+					{
+						const vec3 neighbourNormal = this->getNormal(neighbour);
+						const float cosAngle = glm::clamp(glm::dot(normal, neighbourNormal) / (glm::length(normal) * glm::length(neighbourNormal)), -1.0f, 1.0f);
+						float dihedrical = glm::acos(cosAngle) / glm::pi<float>(), w = (dihedrical < .0f) ? .08f : 1.0f;
+						energy += smoothness * -log(w * glm::max(1.0f - glm::abs(dihedrical), epsilon2));
+					}
 				}
-			}
 
-			if (energy < minEnergy)
-			{
-				minEnergy = energy;
-				minCluster = cluster;
+				if (energy < minEnergy)
+				{
+					minEnergy = energy;
+					minCluster = cluster;
+				}
 			}
 		}
 
-		triangle->_finalCluster = minCluster;
+		newCluster[idx] = minCluster;
 	}
 
-	for (int idx = 0; idx < _triangle.size(); ++idx)
-	{
-		_triangle[idx]->_finalCluster = newCluster[idx];
-	}
+	_finalCluster.swap(newCluster);
 }
 
 void WingedTriangleMesh::computeSoftCluster(float threshold)
 {
-	std::vector<unsigned> newCluster(_triangle.size());
+	std::vector<unsigned> newCluster(_finalCluster.size());
 
-#pragma omp parallel for
-	for (int idx = 0; idx < _triangle.size(); ++idx)
+	#pragma omp parallel for
+	for (int idx = 0; idx < _finalCluster.size(); ++idx)
 	{
-		WingedTriangle* triangle = _triangle[idx];
 		float maxOccupancy = .0f;
-		unsigned finalCluster = triangle->_finalCluster;
-
-		newCluster[idx] = triangle->_finalCluster;
+		unsigned finalCluster = _finalCluster[idx];
+		std::vector<unsigned> clusterIdx, neighbours;
 
-		std::unordered_set<unsigned> clusterIdx;
-		this->getClusters(idx, clusterIdx);
+		_adjacency.getFaceNeighbours(idx, neighbours);
+		this->getClusters(idx, neighbours, clusterIdx);
 
-		if (clusterIdx.size() <= 1)
-			continue;
-
-		for (auto cluster : clusterIdx)
+		if (clusterIdx.size() > 1)
 		{
-			float occupancy = .0f;
+			for (auto cluster : clusterIdx)
+			{
+				float occupancy = .0f;
 
-			auto clusterIt = triangle->_cluster.find(cluster);
-			//if (clusterIt != triangle->_cluster.end())
-			//{
-			//	++occupancy;
-			//}
+				for (unsigned neighbour : neighbours)
+					if (this->getOccupancy(neighbour, cluster) >= .0f)
+						++occupancy;
 
-			for (WingedTriangle* neighbour : triangle->_connectionVertex)
-			{
-				clusterIt = neighbour->_cluster.find(cluster);
-				if (clusterIt != triangle->_cluster.end())
+				if (occupancy > maxOccupancy)
 				{
-					++occupancy;
+					maxOccupancy = occupancy;
+					finalCluster = cluster;
 				}
 			}
-
-			if (occupancy > maxOccupancy)
-			{
-				maxOccupancy = occupancy;
-				finalCluster = cluster;
-			}
 		}
 
-		if (triangle->_finalCluster != finalCluster)
-			std::cout << "Hola" << std::endl;
-
-		triangle->_finalCluster = finalCluster;
+		newCluster[idx] = finalCluster;
 	}
 
-#pragma omp parallel for
-	for (int idx = 0; idx < _triangle.size(); ++idx)
-	{
-		_triangle[idx]->_finalCluster = newCluster[idx];
-	}
+	_finalCluster.swap(newCluster);
 }
 
 void WingedTriangleMesh::getFaceCluster(unsigned numFaces, std::vector<float>& clusterIdx)
 {
 #pragma omp parallel for
-	for (int idx = 0; idx < _triangle.size(); ++idx)
-		//if (_triangle[idx]->_test)
-		//	clusterIdx[_triangle[idx]->_face] = 700;
-		//else
-			clusterIdx[_triangle[idx]->_face] = _triangle[idx]->_test;
+	for (int idx = 0; idx < _test.size(); ++idx)
+		clusterIdx[idx] = _test[idx];
 }
 
 // [Protected methods]
 
-void WingedTriangleMesh::checkVertexConnectivity()
+void WingedTriangleMesh::getClusters(unsigned idx, const std::vector<unsigned>& neighbours, std::vector<unsigned>& clusterIdx) const
 {
-	for (int x = 0; x < _numDivs.x; ++x)
-	{
-		for (int y = 0; y < _numDivs.y; ++y)
-		{
-			for (int z = 0; z < _numDivs.z; ++z)
-			{
-				std::vector<std::pair<WingedTriangle*, unsigned>>* vertices = &_pointGrid[x][y][z];
-				for (int i = 0; i < vertices->size(); ++i)
-				{
-					for (int j = i; j < vertices->size(); ++j)
-					{
-						if (glm::distance(vertices->at(i).first->_triangle.getPoint(vertices->at(i).second),
-							vertices->at(j).first->_triangle.getPoint(vertices->at(j).second)) < glm::epsilon<float>())
-						{
-							vertices->at(i).first->_connectionVertex.insert(vertices->at(j).first);
-							vertices->at(i).first->_connectionVertexWise[vertices->at(i).second][vertices->at(j).first] = vertices->at(j).second;
-
-							vertices->at(j).first->_connectionVertex.insert(vertices->at(i).first);
-							vertices->at(j).first->_connectionVertexWise[vertices->at(j).second][vertices->at(i).first] = vertices->at(i).second;
-						}
-					}
-				}
-			}
-		}
-	}
-}
+	clusterIdx.clear();
 
-void WingedTriangleMesh::eraseFlatTriangles()
-{
-	std::vector<bool> removable(_triangle.size());
+	for (unsigned neighbour : neighbours)
+		clusterIdx.insert(clusterIdx.end(), _clusterIdx.begin() + _clusterOffset[neighbour], _clusterIdx.begin() + _clusterOffset[neighbour + 1]);
+	clusterIdx.insert(clusterIdx.end(), _clusterIdx.begin() + _clusterOffset[idx], _clusterIdx.begin() + _clusterOffset[idx + 1]);
 
-#pragma omp parallel for
-	for (int idx = 0; idx < _triangle.size(); ++idx)
-	{
-		std::unordered_set<unsigned> clusters;
-		this->getClusters(idx, clusters);
-
-		removable[idx] = clusters.size() < 2;
-	}
-
-	unsigned erasedTriangles = 0;
-	for (int idx = 0; idx < _triangle.size(); ++idx)
-	{
-		if (removable[idx])
-		{
-			delete _triangle[idx - erasedTriangles];
-			_triangle.erase(_triangle.begin() + idx - erasedTriangles);
-			++erasedTriangles;
-		}
-	}
+	std::sort(clusterIdx.begin(), clusterIdx.end());
+	clusterIdx.erase(std::unique(clusterIdx.begin(), clusterIdx.end()), clusterIdx.end());
 }
 
-void WingedTriangleMesh::getClusters(unsigned idx, std::unordered_set<unsigned>& clusterIdx)
+vec3 WingedTriangleMesh::getNormal(unsigned face) const
 {
-	for (const auto& cluster : _triangle[idx]->_cluster)
-		clusterIdx.insert(cluster.first);
+	const vec3 a = _adjacency.getPosition(_adjacency.origin(face * 3)), b = _adjacency.getPosition(_adjacency.origin(face * 3 + 1)), c = _adjacency.getPosition(_adjacency.origin(face * 3 + 2));
 
-	for (const auto neighbor : _triangle[idx]->_connectionVertex)
-		for (const auto& cluster : neighbor->_cluster)
-			clusterIdx.insert(cluster.first);
+	return glm::cross(b - a, c - a);
 }
 
-uvec3 WingedTriangleMesh::getPositionIndex(const vec3& position)
+float WingedTriangleMesh::getOccupancy(unsigned face, unsigned cluster) const
 {
-	unsigned x = (position.x - _aabb.min().x) / _cellSize.x, y = (position.y - _aabb.min().y) / _cellSize.y, z = (position.z - _aabb.min().z) / _cellSize.z;
-	unsigned zeroUnsigned = 0;
-
-	return uvec3(glm::clamp(x, zeroUnsigned, _numDivs.x - 1), glm::clamp(y, zeroUnsigned, _numDivs.y - 1), glm::clamp(z, zeroUnsigned, _numDivs.z - 1));
-}
+	for (unsigned offset = _clusterOffset[face]; offset < _clusterOffset[face + 1]; ++offset)
+		if (_clusterIdx[offset] == cluster)
+			return _clusterProbability[offset];
 
-unsigned WingedTriangleMesh::getPositionIndex(int x, int y, int z) const
-{
-	return x * _numDivs.y * _numDivs.z + y * _numDivs.z + z;
+	return -1.0f;
 }
 
-bool WingedTriangleMesh::processTriangle(unsigned idx)
+bool WingedTriangleMesh::processTriangle(unsigned idx) const
 {
-	std::unordered_set<unsigned> clusters;
-	this->getClusters(idx, clusters);
+	std::vector<unsigned> clusters, neighbours;
+	_adjacency.getFaceNeighbours(idx, neighbours);
+	this->getClusters(idx, neighbours, clusters);
 
 	return clusters.size() > 1;
 }
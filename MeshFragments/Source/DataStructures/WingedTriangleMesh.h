@@ -1,67 +1,45 @@
 #pragma once
 
-#include "Geometry/3D/AABB.h"
-#include "Geometry/3D/Triangle3D.h"
+#include "DataStructures/MeshAdjacency.h"
 #include "Graphics/Core/Model3D.h"
 
 class WingedTriangleMesh
 {
 protected:
-	struct WingedTriangle
-	{
-		Triangle3D							_triangle;
-		std::unordered_map<unsigned, float>	_cluster;
-		unsigned							_face, _finalCluster;
-		bool								_boundary;
-		unsigned							_test;
-		std::unordered_set<WingedTriangle*>	_connectionVertex;
-		std::unordered_map<WingedTriangle*, unsigned>	_connectionVertexWise[3];
-	};
+	MeshAdjacency			_adjacency;						//!< Half-edge adjacency, with vertices welded by position
+	std::vector<uint8_t>	_boundary;						//!< Faces whose vertices touch several clusters in at least two corners
+	std::vector<unsigned>	_clusterIdx;					//!< Clusters overlapped by each face, stored in compressed rows
+	std::vector<unsigned>	_clusterOffset;					//!< Start of the clusters of each face in _clusterIdx, with one more element
+	std::vector<float>		_clusterProbability;			//!< Occupancy of each cluster in _clusterIdx
+	std::vector<unsigned>	_finalCluster;					//!< Predominant cluster of each face
+	std::vector<unsigned>	_test;							//!< Output of the convexity analysis
 
 protected:
-	std::vector<std::vector<std::vector<std::vector<std::pair<WingedTriangle*, unsigned>>>>>	_pointGrid;
-	std::vector<WingedTriangle*>																_triangle;
-
-	AABB					_aabb;									//!< Bounding box of the scene
-	vec3					_cellSize;								//!< Size of each grid cell
-	uvec3					_numDivs;								//!< Number of subdivisions of space between mininum and maximum point
-
-protected:
-	/**
-	*	@brief Checks connectivity between faces.
-	*/
-	void checkVertexConnectivity();
-
 	/**
-	*	@brief Erases triangles whose neighbors and themselves belong to the same cluster.
+	*	@brief Retrieves clusters in a face and its neighbours, sorted and without repetitions.
 	*/
-	void eraseFlatTriangles();
+	void getClusters(unsigned idx, const std::vector<unsigned>& neighbours, std::vector<unsigned>& clusterIdx) const;
 
 	/**
-	*	@brief Retrieves clusters in a face and its neighbours.	
+	*	@return Normal of a face, not normalized.
 	*/
-	void getClusters(unsigned idx, std::unordered_set<unsigned>& clusterIdx);
+	vec3 getNormal(unsigned face) const;
 
 	/**
-	*	@return Index of grid cell to be filled.
+	*	@return Occupancy of a cluster in a face, a negative value if the face does not overlap it.
 	*/
-	uvec3 getPositionIndex(const vec3& position);
-
-	/**
-	*	@return Index in grid array of a non-real position.
-	*/
-	unsigned getPositionIndex(int x, int y, int z) const;
+	float getOccupancy(unsigned face, unsigned cluster) const;
 
 	/**
 	*	@return True if triangle is surrounded by other clusters.
 	*/
-	bool processTriangle(unsigned idx);
+	bool processTriangle(unsigned idx) const;
 
 public:
 	/**
 	*	@brief Constructor from a set of faces, given the vertices forming such faces.
 	*/
-	WingedTriangleMesh(const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, std::vector<std::unordered_map<unsigned, float>> faceClusterOccupancy);
+	WingedTriangleMesh(const std::vector<Model3D::VertexGPUData>& vertices, const std::vector<Model3D::FaceGPUData>& faces, const std::vector<std::unordered_map<unsigned, float>>& faceClusterOccupancy);
 
 	/**
 	*	@brief Destructor.
@@ -88,4 +66,3 @@ public:
 	*/
 	void getFaceCluster(unsigned numFaces, std::vector<float>& clusterIdx);
 };
-
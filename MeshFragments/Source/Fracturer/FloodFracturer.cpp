@@ -179,8 +179,11 @@ namespace fracturer {
 		// Remove mask
 		_unmaskShader->use();
 		_unmaskShader->bindBuffers(std::vector<GLuint>{ grid.ssbo() });
+		_unmaskShader->setUniform("gridDims", numDivs);
 		_unmaskShader->setUniform("numCells", numCells);
 		_unmaskShader->setUniform("position", glm::uint(Seeder::VOXEL_ID_POSITION));
+		_unmaskShader->setUniform("regionMin", uvec3(0));
+		_unmaskShader->setUniform("regionSize", numDivs);
 		_unmaskShader->setSubroutineUniform(GL_COMPUTE_SHADER, "unmaskUniform", "unmaskRightMost");
 		_unmaskShader->applyActiveSubroutines();
 		_unmaskShader->execute(ComputeShader::getNumGroups(numCells), 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
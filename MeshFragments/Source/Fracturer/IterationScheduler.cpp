@@ -0,0 +1,141 @@
+#include "stdafx.h"
+#include "IterationScheduler.h"
+
+#include "NaiveFracturer.h"
+#include "Seeder.h"
+
+namespace fracturer {
+	// [Public methods]
+
+	IterationScheduler::IterationScheduler(const RegularGrid& baseGrid, unsigned numWorkers, unsigned depth, const LinearBvh* bvh) :
+		_baseGrid(new RegularGrid(baseGrid)), _bvh(bvh), _nextJob(0), _numWorkers(glm::max(numWorkers, 1u)), _stop(false)
+	{
+		// Besides workers and queued results, one grid is being extracted and another one is being exported
+		const unsigned numGrids = _numWorkers + depth + 2;
+		for (unsigned gridIdx = 0; gridIdx < numGrids; ++gridIdx)
+		{
+			_grids.push_back(new RegularGrid(baseGrid));
+			_freeGrids.push(_grids.back());
+		}
+	}
+
+	IterationScheduler::~IterationScheduler()
+	{
+		this->stop();
+
+		delete _baseGrid;
+		for (RegularGrid* grid : _grids)
+			delete grid;
+	}
+
+	RegularGrid* IterationScheduler::acquire(size_t jobIdx)
+	{
+		std::unique_lock<std::mutex> lock(_resultMutex);
+		_resultCondition.wait(lock, [this, jobIdx]() { return _results.find(jobIdx) != _results.end(); });
+
+		Result result = _results[jobIdx];
+		_results.erase(jobIdx);
+		lock.unlock();
+
+		if (result._error)
+		{
+			this->release(result._grid);
+			std::rethrow_exception(result._error);
+		}
+
+		return result._grid;
+	}
+
+	void IterationScheduler::launch(const std::vector<Job>& jobs, const FractureParameters& fractParameters)
+	{
+		this->stop();
+
+		// The singleton is not created concurrently by workers
+		NaiveFracturer::getInstance();
+
+		_fractParameters = fractParameters;
+		_jobs = jobs;
+		_nextJob = 0;
+		_results.clear();
+		_stop = false;
+
+		for (unsigned workerIdx = 0; workerIdx < _numWorkers; ++workerIdx)
+			_workers.emplace_back(&IterationScheduler::work, this);
+	}
+
+	void IterationScheduler::release(RegularGrid* grid)
+	{
+		_freeGrids.push(grid);
+	}
+
+	void IterationScheduler::stop()
+	{
+		_stop = true;
+
+		// Workers waiting for a grid are woken up with one grid each, as the pool has room for every grid
+		for (size_t workerIdx = 0; workerIdx < _workers.size(); ++workerIdx)
+			_freeGrids.push(nullptr);
+
+		for (std::thread& worker : _workers)
+			worker.join();
+		_workers.clear();
+
+		// Recover the pool, except for the grids owned by the consumer
+		RegularGrid* grid;
+		std::vector<RegularGrid*> freeGrids;
+		while (_freeGrids.tryPop(grid))
+			if (grid) freeGrids.push_back(grid);
+		for (auto& result : _results)
+			freeGrids.push_back(result.second._grid);
+		_results.clear();
+
+		for (RegularGrid* freeGrid : freeGrids)
+			_freeGrids.push(freeGrid);
+	}
+
+	// [Protected methods]
+
+	void IterationScheduler::work()
+	{
+		NaiveFracturer* fracturer = NaiveFracturer::getInstance();
+		RegularGrid* grid;
+
+		// The grid is taken before the job, hence the lowest pending job always owns a grid and the consumer cannot starve
+		while (_freeGrids.pop(grid) && grid)
+		{
+			const size_t jobIdx = _stop ? _jobs.size() : _nextJob++;
+			if (jobIdx >= _jobs.size())
+			{
+				_freeGrids.push(grid);
+				break;
+			}
+
+			const Job& job = _jobs[jobIdx];
+			Result result{ nullptr, grid };
+
+			// The OpenGL context belongs to the consumer thread, hence workers are restricted to the CPU fracturer
+			FractureParameters jobParameters = _fractParameters;
+			jobParameters._iteration = job._iteration;
+			jobParameters._launchGPU = false;
+			jobParameters._numExtraSeeds = job._numFragments * 2;
+			jobParameters._numSeeds = job._numFragments;
+
+			try
+			{
+				grid->copyLabels(*_baseGrid);
+				fracturer->build(*grid, Seeder::generateSeeds(*grid, jobParameters, std::vector<glm::uvec4>(), _bvh), &jobParameters);
+			}
+			catch (...)
+			{
+				result._error = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(_resultMutex);
+				_results[jobIdx] = result;
+			}
+
+			_resultCondition.notify_all();
+		}
+	}
+}
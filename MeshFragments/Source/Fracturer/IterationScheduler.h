@@ -0,0 +1,93 @@
+#pragma once
+
+#include "DataStructures/LinearBvh.h"
+#include "DataStructures/RegularGrid.h"
+#include "Graphics/Core/FractureParameters.h"
+#include "Utilities/BoundedQueue.h"
+
+namespace fracturer {
+
+	/**
+	*   Fracture stage of the dataset pipeline. Several iterations of the same voxelization are fractured concurrently by worker threads, each
+	*   one running the seeding and the CPU naive fracturer of a different job. Grids come from a fixed pool: a worker cannot start a job until a
+	*   grid is released by the consumer, which caps the memory and keeps fracturing from running arbitrarily ahead of the next stages. Results
+	*   are retrieved in the order of jobs, so the output does not depend on the number of workers.
+	*/
+	class IterationScheduler
+	{
+	public:
+		struct Job
+		{
+			std::string			_filename;				//!< Path of the exported files, without extension
+			int					_iteration;				//!< Key of the random streams of the job
+			int					_numFragments;			//!< Number of seeds
+		};
+
+	protected:
+		struct Result
+		{
+			std::exception_ptr	_error;					//!< Exception raised by the job, if any
+			RegularGrid*		_grid;					//!< Fractured grid
+		};
+
+	protected:
+		RegularGrid*							_baseGrid;			//!< Voxelization shared by every job
+		const LinearBvh*						_bvh;				//!< Mesh of the voxelization, if impacts are casted against it. Only read by workers
+		FractureParameters						_fractParameters;	//!< Parameters shared by every job
+		BoundedQueue<RegularGrid*>				_freeGrids;			//!< Grids available for new jobs
+		std::vector<RegularGrid*>				_grids;				//!< Pool of grids, owned by the scheduler
+		std::vector<Job>						_jobs;				//!< Jobs to be fractured
+		std::atomic<size_t>						_nextJob;			//!< Index of the next job to be taken by a worker
+		unsigned								_numWorkers;		//!< Number of worker threads
+		std::condition_variable					_resultCondition;	//!< Signaled whenever a job is finished
+		std::mutex								_resultMutex;		//!< Guards the results
+		std::unordered_map<size_t, Result>		_results;			//!< Finished jobs which have not been acquired yet
+		std::atomic<bool>						_stop;				//!< Workers must not start more jobs
+		std::vector<std::thread>				_workers;			//!< Worker threads
+
+	protected:
+		/**
+		*   @brief Fractures jobs until there are no more or the scheduler is stopped.
+		*/
+		void work();
+
+	public:
+		/**
+		*   @brief Constructor. Must be called from the thread owning the OpenGL context, although grids are only used on the CPU afterwards.
+		*   @param depth Number of fractured grids that may wait for the next stages besides those of the workers.
+		*   @param bvh Mesh of the voxelization for ray-casted impacts, not owned by the scheduler.
+		*/
+		IterationScheduler(const RegularGrid& baseGrid, unsigned numWorkers, unsigned depth, const LinearBvh* bvh = nullptr);
+
+		/**
+		*   @brief Destructor. Stops the workers.
+		*/
+		virtual ~IterationScheduler();
+
+		/**
+		*   @brief Waits until the jobIdx-th job is fractured. The exception raised by such job, if any, is thrown again.
+		*   @return Fractured grid, which must be given back through release().
+		*/
+		RegularGrid* acquire(size_t jobIdx);
+
+		/**
+		*   @return Number of jobs that are fractured concurrently.
+		*/
+		unsigned getNumWorkers() const { return _numWorkers; }
+
+		/**
+		*   @brief Launches the workers on the given jobs.
+		*/
+		void launch(const std::vector<Job>& jobs, const FractureParameters& fractParameters);
+
+		/**
+		*   @brief Gives back a grid obtained from acquire() so that another job can be fractured.
+		*/
+		void release(RegularGrid* grid);
+
+		/**
+		*   @brief Prevents workers from starting new jobs and waits for them.
+		*/
+		void stop();
+	};
+}
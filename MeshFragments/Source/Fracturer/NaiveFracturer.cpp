@@ -28,7 +28,7 @@ namespace fracturer {
 		uvec3 numDivs = grid.getNumSubdivisions();
 		unsigned numCells = numDivs.x * numDivs.y * numDivs.z;
 		RegularGrid::CellGrid* gridData = grid.data();
-		DistFunction distanceFunction = _distanceFunctionMap[fractParameters->_distanceFunction];
+		DistFunction distanceFunction = _distanceFunctionMap.at(fractParameters->_distanceFunction);
 
 		// Iteration data
 		ivec3 cellPoint;
@@ -61,10 +61,10 @@ namespace fracturer {
 			}
 		}
 
-		//if (fractParameters->_removeIsolatedRegions)
-		//{
-		//    this->removeIsolatedRegionsCPU(grid, seeds);
-		//}
+		if (fractParameters->_removeIsolatedRegions)
+		{
+			this->removeIsolatedRegionsCPU(grid, seeds);
+		}
 	}
 
 
@@ -108,53 +108,96 @@ namespace fracturer {
 		}
 	}
 
+	void NaiveFracturer::relabelIsolatedRegions(const RegularGrid::CellGrid* gridData, std::vector<RegularGrid::CellGrid>& newGrid, const uvec3& numDivs)
+	{
+		const int numCells = static_cast<int>(newGrid.size());
+		const ivec3 offset[6] = { ivec3(+1, 0, 0), ivec3(-1, 0, 0), ivec3(0, +1, 0), ivec3(0, -1, 0), ivec3(0, 0, +1), ivec3(0, 0, -1) };
+		std::vector<unsigned> front;
+
+		// Every reached voxel spreads its label over the unreached ones, in index order so that ties are always solved the same way
+		for (int cellIdx = 0; cellIdx < numCells; ++cellIdx)
+			if (newGrid[cellIdx]._value != VOXEL_EMPTY)
+				front.push_back(cellIdx);
+
+		for (size_t frontIdx = 0; frontIdx < front.size(); ++frontIdx)
+		{
+			const unsigned index = front[frontIdx];
+			const ivec3 cell(index / (numDivs.y * numDivs.z), (index / numDivs.z) % numDivs.y, index % numDivs.z);
+
+			for (const ivec3& neighbourOffset : offset)
+			{
+				const ivec3 neighbour = cell + neighbourOffset;
+				if (neighbour.x < 0 || neighbour.y < 0 || neighbour.z < 0 || neighbour.x >= numDivs.x || neighbour.y >= numDivs.y || neighbour.z >= numDivs.z)
+					continue;
+
+				const unsigned neighbourIndex = RegularGrid::getPositionIndex(neighbour.x, neighbour.y, neighbour.z, numDivs);
+				if (gridData[neighbourIndex]._value != VOXEL_EMPTY && newGrid[neighbourIndex]._value == VOXEL_EMPTY)
+				{
+					newGrid[neighbourIndex]._value = newGrid[index]._value;
+					front.push_back(neighbourIndex);
+				}
+			}
+		}
+
+		// Components with no reached voxel, e.g. disconnected parts of the model without seeds, keep their label
+		for (int cellIdx = 0; cellIdx < numCells; ++cellIdx)
+			if (newGrid[cellIdx]._value == VOXEL_EMPTY)
+				newGrid[cellIdx]._value = gridData[cellIdx]._value;
+	}
+
 	void NaiveFracturer::removeIsolatedRegionsCPU(RegularGrid& grid, const std::vector<glm::uvec4>& seeds)
 	{
 		uvec3 numDivs = grid.getNumSubdivisions();
 		unsigned numCells = numDivs.x * numDivs.y * numDivs.z, cellIndex;
-		std::list<glm::uvec4> front(seeds.begin(), seeds.end());                    // Linked list where to push/pop voxels
-		std::vector<RegularGrid::CellGrid> newGrid(numCells);
-		std::fill(newGrid.begin(), newGrid.end(), RegularGrid::CellGrid(VOXEL_EMPTY));
 		RegularGrid::CellGrid* gridData = grid.data();
 
+		// Voxels are only kept if reached from the seed of their label, hence the new grid starts empty
+		std::vector<RegularGrid::CellGrid> newGrid(numCells);
+		std::vector<glm::uvec4> front, nextFront;                                   // Voxels of the current and next level, w is the label of the voxel in the fractured grid
+
 		for (const glm::uvec4& seed : seeds)
 		{
-			newGrid[RegularGrid::getPositionIndex(seed.x, seed.y, seed.z, numDivs)]._value = seed.w;
+			cellIndex = RegularGrid::getPositionIndex(seed.x, seed.y, seed.z, numDivs);
+			if (gridData[cellIndex]._value == VOXEL_EMPTY || newGrid[cellIndex]._value != VOXEL_EMPTY) continue;
+
+			newGrid[cellIndex]._value = gridData[cellIndex]._value;
+			front.push_back(glm::uvec4(seed.x, seed.y, seed.z, gridData[cellIndex]._value));
 		}
 
-		// Iterate while voxel list is not empty
-		while (!front.empty()) {
-			glm::uvec4 v = front.front();
+		// Expand level by level, as the GPU pass does with its two stacks
+		while (!front.empty())
+		{
+			nextFront.clear();
 
-			// Expand front
+			for (const glm::uvec4& v : front)
+			{
 #define expand(dx, dy, dz)\
-            cellIndex = RegularGrid::getPositionIndex(v.x + (dx), v.y + (dy), v.z + (dz), numDivs);\
-            if (gridData[cellIndex]._value == v.w && newGrid[cellIndex]._value == VOXEL_EMPTY) {\
-                front.push_back(glm::uvec4(v.x + (dx), v.y + (dy), v.z + (dz), v.w));\
-                newGrid[cellIndex]._value = v.w;\
-            }
-
-			// Remove from list
-			front.pop_front();
-
-			if (v.x < numDivs.x - 1) { expand(+1, 0, 0); }
-			if (v.x > 0) { expand(-1, 0, 0); }
-			if (v.y < numDivs.y - 1) { expand(0, +1, 0); }
-			if (v.y > 0) { expand(0, -1, 0); }
-			if (v.z < numDivs.z - 1) { expand(0, 0, +1); }
-			if (v.z > 0) { expand(0, 0, -1); }
+                cellIndex = RegularGrid::getPositionIndex(v.x + (dx), v.y + (dy), v.z + (dz), numDivs);\
+                if (gridData[cellIndex]._value == v.w && newGrid[cellIndex]._value == VOXEL_EMPTY) {\
+                    nextFront.push_back(glm::uvec4(v.x + (dx), v.y + (dy), v.z + (dz), v.w));\
+                    newGrid[cellIndex]._value = v.w;\
+                }
+
+				if (v.x < numDivs.x - 1) { expand(+1, 0, 0); }
+				if (v.x > 0) { expand(-1, 0, 0); }
+				if (v.y < numDivs.y - 1) { expand(0, +1, 0); }
+				if (v.y > 0) { expand(0, -1, 0); }
+				if (v.z < numDivs.z - 1) { expand(0, 0, +1); }
+				if (v.z > 0) { expand(0, 0, -1); }
+#undef expand
+			}
+
+			std::swap(front, nextFront);
 		}
 
+		this->relabelIsolatedRegions(gridData, newGrid, numDivs);
+
 		// Move operator
 		grid.swap(newGrid.data(), newGrid.size());
 	}
 
 	void NaiveFracturer::removeIsolatedRegionsGPU(const GLuint gridSSBO, RegularGrid& grid, const std::vector<glm::uvec4>& seeds)
 	{
-		// Set seeds
-		for (auto& seed : seeds)
-			grid.set(seed.x, seed.y, seed.z, seed.w);
-
 		ComputeShader* shader = ShaderList::getInstance()->getComputeShader(RendEnum::REMOVE_ISOLATED_REGIONS);
 
 		// Define neighbors
@@ -164,17 +207,24 @@ namespace fracturer {
 		uvec3 numDivs = grid.getNumSubdivisions();
 		unsigned numCells = numDivs.x * numDivs.y * numDivs.z;
 		unsigned nullCount = 0;
-		unsigned stackSize = seeds.size();
-		RegularGrid::CellGrid* gridData = ComputeShader::readData(gridSSBO, RegularGrid::CellGrid());
+		RegularGrid::CellGrid* gridPointer = ComputeShader::readData(gridSSBO, RegularGrid::CellGrid());
+		const std::vector<RegularGrid::CellGrid> gridData(gridPointer, gridPointer + numCells);		// Kept for relabelling, once the buffer is no longer mapped
 		unsigned numNeigh = offset.size();
 
-		// New regular grid
-		std::vector<RegularGrid::CellGrid> newGrid(gridData, gridData + numCells);
+		// New regular grid, where voxels are only kept if reached from the seed of their label
+		std::vector<RegularGrid::CellGrid> newGrid(numCells);
+		std::vector<GLuint> seedsInt;
 		for (glm::uvec4 seed : seeds)
 		{
-			newGrid[RegularGrid::getPositionIndex(seed.x, seed.y, seed.z, numDivs)]._value = seed.w;
+			const unsigned cellIndex = RegularGrid::getPositionIndex(seed.x, seed.y, seed.z, numDivs);
+			if (gridData[cellIndex]._value == VOXEL_EMPTY || newGrid[cellIndex]._value != VOXEL_EMPTY) continue;
+
+			newGrid[cellIndex]._value = gridData[cellIndex]._value;
+			seedsInt.push_back(cellIndex);
 		}
 
+		unsigned stackSize = seedsInt.size();
+
 		GLuint stack1SSBO = ComputeShader::setWriteBuffer(GLuint(), numCells, GL_DYNAMIC_DRAW);
 		GLuint stack2SSBO = ComputeShader::setWriteBuffer(GLuint(), numCells, GL_DYNAMIC_DRAW);
 		const GLuint newGridSSBO = ComputeShader::setReadBuffer(&newGrid[0], numCells, GL_DYNAMIC_DRAW);
@@ -182,10 +232,7 @@ namespace fracturer {
 		const GLuint stackSizeSSBO = ComputeShader::setWriteBuffer(GLuint(), 1, GL_DYNAMIC_DRAW);
 
 		// Load seeds as a subset
-		std::vector<GLuint> seedsInt;
-		for (auto& seed : seeds) seedsInt.push_back(RegularGrid::getPositionIndex(seed.x, seed.y, seed.z, numDivs));
-
-		ComputeShader::updateReadBufferSubset(stack1SSBO, seedsInt.data(), 0, seeds.size());
+		ComputeShader::updateReadBufferSubset(stack1SSBO, seedsInt.data(), 0, seedsInt.size());
 
 		shader->use();
 		shader->setUniform("gridDims", numDivs);
@@ -207,13 +254,18 @@ namespace fracturer {
 		}
 
 		RegularGrid::CellGrid* resultPointer = ComputeShader::readData(newGridSSBO, RegularGrid::CellGrid());
-		grid.swap(resultPointer, numCells);
+		newGrid.assign(resultPointer, resultPointer + numCells);
+		this->relabelIsolatedRegions(gridData.data(), newGrid, numDivs);
+		grid.swap(newGrid.data(), numCells);
 
-		ComputeShader::deleteBuffers(std::vector<GLuint>{ stack1SSBO, stack2SSBO, newGridSSBO, neighborSSBO, stackSize });
+		ComputeShader::deleteBuffers(std::vector<GLuint>{ stack1SSBO, stack2SSBO, newGridSSBO, neighborSSBO, stackSizeSSBO });
 	}
 
 	void NaiveFracturer::build(RegularGrid& grid, const std::vector<glm::uvec4>& seeds, FractureParameters* fractParameters)
 	{
+		// The CPU path writes through the raw grid pointer, so the whole grid is flagged beforehand
+		grid.markDirty();
+
 		if (fractParameters->_launchGPU)
 		{
 			this->buildGPU(grid, seeds, fractParameters);
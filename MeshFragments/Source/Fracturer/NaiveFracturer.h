@@ -41,6 +41,14 @@ namespace fracturer {
 		*/
 		void buildGPU(RegularGrid& grid, const std::vector<glm::uvec4>& seeds, FractureParameters* fractParameters);
 
+		/**
+		*   Assigns the voxels not reached from the seed of their label to the closest reached voxel of any label, so that every fragment is a single
+		*   component. Components without any reached voxel keep their label.
+		*   @param[in] gridData Fractured grid
+		*   @param[in] newGrid Grid where only the voxels reached from seeds are labelled
+		*/
+		void relabelIsolatedRegions(const RegularGrid::CellGrid* gridData, std::vector<RegularGrid::CellGrid>& newGrid, const uvec3& numDivs);
+
 		/*
 		*  Removes fragments isolated with respect to the fragment where a seed was originally placed.
 		*/
@@ -1,52 +1,68 @@
 #include "stdafx.h"
 #include "Seeder.h"
 
-#include <boost/random.hpp>
-#include <boost/random/normal_distribution.hpp>
-
 namespace fracturer
 {
-    Halton_sampler  Seeder::_haltonSampler;
-    Halton_enum     Seeder::_haltonEnum (1, 1);
-
-    boost::mt19937  Seeder::_boostRng;
-    boost::normal_distribution<> Seeder::_boostNormalDistribution = boost::normal_distribution<>(.5, .25);
-    std::unique_ptr<boost::variate_generator<boost::mt19937&, boost::normal_distribution<>>> Seeder::_boostGenerator;
-
-    fracturer::Seeder::RandomInitUniformMap Seeder::_randomInitFunction = {
-        { FractureParameters::STD_UNIFORM, [](int size) -> void {}},
-        { FractureParameters::HALTON, [](int size) -> void { Seeder::_haltonSampler.init_faure(); Seeder::_haltonEnum = Halton_enum(size, 1); }},	
-        { FractureParameters::BOOST_NORMAL_DISTRIBUTION, [](int size) -> void { 
-            Seeder::_boostGenerator.reset(new boost::variate_generator<boost::mt19937&, boost::normal_distribution<>>(
-                Seeder::_boostRng, Seeder::_boostNormalDistribution
-            ));
-        }}
-    };
+    const Halton_sampler Seeder::_haltonSampler = []() { Halton_sampler sampler; sampler.init_faure(); return sampler; }();
 
+    // Values are indexed by (index, coord), so that every coordinate of a seed is drawn from a different position of the stream
     fracturer::Seeder::RandomUniformMap Seeder::_randomFunction = {
-        { FractureParameters::STD_UNIFORM, [](int min, int max, int index, int coord) -> int { return RandomUtilities::getUniformRandomInt(min, max); }},
-        { FractureParameters::HALTON, [](int min, int max, int index, int coord) -> int { return int(Seeder::_haltonSampler.sample(coord, index) * (max - min) + min); }},
-        { FractureParameters::BOOST_NORMAL_DISTRIBUTION, [](int min, int max, int index, int coord) -> int { return int(glm::clamp((*Seeder::_boostGenerator.get())(), .0, 1.0) * (max - min) + min); }}
+        { FractureParameters::STD_UNIFORM, [](const RandomStream& stream, int min, int max, int index, int coord) -> int { return int(stream.getUniformRandom(min, max, uint64_t(index) * 3 + coord)); }},
+        { FractureParameters::HALTON, [](const RandomStream& stream, int min, int max, int index, int coord) -> int { return int(Seeder::_haltonSampler.sample(coord, index) * (max - min) + min); }},
+        { FractureParameters::BOOST_NORMAL_DISTRIBUTION, [](const RandomStream& stream, int min, int max, int index, int coord) -> int { return int(glm::clamp(stream.getNormalRandom(.5f, .25f, uint64_t(index) * 3 + coord), .0f, 1.0f) * (max - min) + min); }}
     };
 
     fracturer::Seeder::RandomUniformMapFloat Seeder::_randomFunctionFloat = {
-        { FractureParameters::STD_UNIFORM, [](float min, float max, int index, int coord) -> float { return RandomUtilities::getUniformRandom(min, max); }},
-        { FractureParameters::HALTON, [](float min, float max, int index, int coord) -> float { return Seeder::_haltonSampler.sample(coord, index) * (max - min) + min; }},
-        { FractureParameters::BOOST_NORMAL_DISTRIBUTION, [](float min, float max, int index, int coord) -> float { return glm::clamp((*Seeder::_boostGenerator.get())(), .0, 1.0) * (max - min) + min; }}
+        { FractureParameters::STD_UNIFORM, [](const RandomStream& stream, float min, float max, int index, int coord) -> float { return stream.getUniformRandom(min, max, uint64_t(index) * 3 + coord); }},
+        { FractureParameters::HALTON, [](const RandomStream& stream, float min, float max, int index, int coord) -> float { return Seeder::_haltonSampler.sample(coord, index) * (max - min) + min; }},
+        { FractureParameters::BOOST_NORMAL_DISTRIBUTION, [](const RandomStream& stream, float min, float max, int index, int coord) -> float { return glm::clamp(stream.getNormalRandom(.5f, .25f, uint64_t(index) * 3 + coord), .0f, 1.0f) * (max - min) + min; }}
     };
 
-    void Seeder::getFloatNoise(unsigned int maxBufferSize, unsigned int nseeds, int randomSeedFunction, std::vector<float>& noiseBuffer)
+    std::vector<glm::uvec4> Seeder::generateSeeds(const RegularGrid& grid, const FractureParameters& fractParameters, const std::vector<glm::uvec4>& impacts, const LinearBvh* bvh)
+    {
+        std::vector<glm::uvec4> seeds;
+        if (impacts.empty())
+        {
+            if (bvh && fractParameters._rayImpacts)
+                seeds = Seeder::rayImpacts(grid, *bvh, fractParameters._numSeeds, fractParameters._seedingRandom, fractParameters.getRandomStream(RandomStream::SEEDING));
+            else
+                seeds = Seeder::uniform(grid, fractParameters._numSeeds, fractParameters._seedingRandom, fractParameters.getRandomStream(RandomStream::SEEDING), OUTER);
+            if (fractParameters._numImpacts > 0)
+                seeds = Seeder::nearSeeds(grid, seeds, fractParameters._numImpacts, fractParameters._biasSeeds, fractParameters._biasFocus, fractParameters.getRandomStream(RandomStream::NEAR_SEEDING));
+        }
+        else
+        {
+            seeds = Seeder::nearSeeds(grid, impacts, 1, fractParameters._biasSeeds, fractParameters._biasFocus, fractParameters.getRandomStream(RandomStream::NEAR_SEEDING));
+        }
+
+        if (fractParameters._numExtraSeeds > 0)
+        {
+            DistanceFunction mergeDFunc = static_cast<DistanceFunction>(fractParameters._mergeSeedsDistanceFunction);
+            auto extraSeeds = Seeder::uniform(grid, fractParameters._numExtraSeeds, fractParameters._seedingRandom, fractParameters.getRandomStream(RandomStream::EXTRA_SEEDING), BOTH);
+            extraSeeds.insert(extraSeeds.begin(), seeds.begin(), seeds.end());
+
+            Seeder::mergeSeeds(seeds, extraSeeds, mergeDFunc);
+            seeds.insert(seeds.end(), extraSeeds.begin(), extraSeeds.end());
+        }
+
+        return seeds;
+    }
+
+    void Seeder::getFloatNoise(unsigned int nseeds, int randomSeedFunction, const RandomStream& stream, std::vector<float>& noiseBuffer)
     {
-        _randomInitFunction[randomSeedFunction](maxBufferSize);
+        const RandomFunctionFloat& randomFunction = _randomFunctionFloat[randomSeedFunction];
+        const size_t offset = noiseBuffer.size();
+        noiseBuffer.resize(offset + (nseeds + 1) / 2 * 2);
 
-        for (unsigned int seed = 0; seed < nseeds; seed += 2)
+        #pragma omp parallel for
+        for (int seed = 0; seed < static_cast<int>(nseeds); seed += 2)
         {
-            noiseBuffer.push_back(_randomFunctionFloat[randomSeedFunction](.0f, 1.0f, seed / 2, 0));
-            noiseBuffer.push_back(_randomFunctionFloat[randomSeedFunction](.0f, 1.0f, seed / 2, 1));
+            noiseBuffer[offset + seed + 0] = randomFunction(stream, .0f, 1.0f, seed / 2, 0);
+            noiseBuffer[offset + seed + 1] = randomFunction(stream, .0f, 1.0f, seed / 2, 1);
         }
     }
 
-    std::vector<glm::uvec4> Seeder::nearSeeds(const RegularGrid& grid, const std::vector<glm::uvec4>& frags, unsigned numImpacts, unsigned numSeeds, unsigned spreading)
+    std::vector<glm::uvec4> Seeder::nearSeeds(const RegularGrid& grid, const std::vector<glm::uvec4>& frags, unsigned numImpacts, unsigned numSeeds, unsigned spreading, RandomStream stream)
 	{
         // Custom glm::uvec3 comparator
         auto comparator = [](const glm::uvec3& lhs, const glm::uvec3& rhs) {
@@ -63,17 +79,17 @@ namespace fracturer
 
 		for (int idx = 0; idx < numImpacts; ++idx)
 		{
-            uvec4 frag = frags[RandomUtilities::getUniformRandomInt(0, frags.size() - 1)];
-            nseeds = RandomUtilities::getUniformRandomInt(1, numPendingSeeds);
+            uvec4 frag = frags[stream.getUniformRandomInt(0, frags.size() - 1)];
+            nseeds = stream.getUniformRandomInt(1, numPendingSeeds);
             currentSeeds = 0;
 			
             // Bruteforce seed search
             while (currentSeeds != nseeds) 
             {
                 // Generate random seed
-                int x = numDivs2.x - RandomUtilities::getBiasedRandomInt(0, numDivs.x, spreading);
-                int y = numDivs2.y - RandomUtilities::getBiasedRandomInt(0, numDivs.y, spreading);
-                int z = numDivs2.z - RandomUtilities::getBiasedRandomInt(0, numDivs.z, spreading);
+                int x = numDivs2.x - stream.getBiasedRandomInt(0, numDivs.x, spreading);
+                int y = numDivs2.y - stream.getBiasedRandomInt(0, numDivs.y, spreading);
+                int z = numDivs2.z - stream.getBiasedRandomInt(0, numDivs.z, spreading);
 
                 x = (frag.x + x + numDivs.x) % numDivs.x;
                 y = (frag.y + y + numDivs.y) % numDivs.y;
@@ -151,7 +167,72 @@ namespace fracturer
         }
     }
 
-    std::vector<glm::uvec4> Seeder::uniform(const RegularGrid& grid, unsigned int nseeds, int randomSeedFunction, Location location) {
+    std::vector<glm::uvec4> Seeder::rayImpacts(const RegularGrid& grid, const LinearBvh& bvh, unsigned int nseeds, int randomSeedFunction, const RandomStream& stream)
+    {
+        // Custom glm::uvec3 comparator
+        auto comparator = [](const glm::uvec3& lhs, const glm::uvec3& rhs) {
+            if      (lhs.x != rhs.x) return lhs.x < rhs.x;
+            else if (lhs.y != rhs.y) return lhs.y < rhs.y;
+            else                     return lhs.z < rhs.z;
+        };
+
+        // Set where to store seeds
+        std::set<glm::uvec3, decltype(comparator)> seeds(comparator);
+        const RandomFunctionFloat& randomFunction = _randomFunctionFloat[randomSeedFunction];
+        const AABB aabb = bvh.getAABB();
+        const float radius = glm::length(aabb.extent()) * 1.01f + glm::epsilon<float>();
+        std::vector<Model3D::RayGPUData> rays;
+        std::vector<LinearBvh::RayHit> hits;
+        unsigned int attempt = 0;
+
+        while (seeds.size() != nseeds) {
+            // Check attempt number
+            if (attempt >= static_cast<unsigned int>(MAX_TRIES))
+                throw SeederSearchError("Max. number of tries surpassed (" + std::to_string(MAX_TRIES) + ")");
+
+            // A batch per missing seed, as most rays hit the mesh
+            rays.resize(glm::max(nseeds - static_cast<unsigned>(seeds.size()), LinearBvh::PACKET_SIZE));
+
+            #pragma omp parallel for
+            for (int rayIdx = 0; rayIdx < static_cast<int>(rays.size()); ++rayIdx)
+            {
+                const int index = static_cast<int>(attempt + rayIdx) * 2;
+                const float cosTheta = randomFunction(stream, -1.0f, 1.0f, index, 0), phi = randomFunction(stream, .0f, 2.0f * glm::pi<float>(), index, 1);
+                const float sinTheta = std::sqrt(glm::max(.0f, 1.0f - cosTheta * cosTheta));
+                const vec3 origin = aabb.center() + vec3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta) * radius;
+                const vec3 target = aabb.min() + aabb.size() * vec3(randomFunction(stream, .0f, 1.0f, index + 1, 0), randomFunction(stream, .0f, 1.0f, index + 1, 1), randomFunction(stream, .0f, 1.0f, index + 1, 2));
+
+                rays[rayIdx] = Model3D::RayGPUData(origin, target);
+            }
+
+            bvh.intersect(rays, hits);
+
+            // Hits are visited in order, so that seeds do not depend on the number of threads
+            for (size_t rayIdx = 0; rayIdx < rays.size() && seeds.size() != nseeds; ++rayIdx)
+            {
+                if (!hits[rayIdx].isHit()) continue;
+
+                const glm::uvec3 voxel = grid.getSurfaceVoxel(rays[rayIdx].getPoint(hits[rayIdx]._distance), rays[rayIdx]._direction);
+                if (voxel.x != std::numeric_limits<glm::uint>::max())
+                    seeds.insert(voxel);
+            }
+
+            attempt += static_cast<unsigned int>(rays.size());
+        }
+
+        // Array of generated seeds
+        std::vector<glm::uvec4> result;
+
+        // Generate array of seed
+        unsigned int nseed = VOXEL_FREE + 1;
+
+        for (glm::uvec3 seed : seeds)
+            result.push_back(glm::uvec4(seed, nseed++));
+
+        return result;
+    }
+
+    std::vector<glm::uvec4> Seeder::uniform(const RegularGrid& grid, unsigned int nseeds, int randomSeedFunction, const RandomStream& stream, Location location) {
         // Custom glm::uvec3 comparator
         auto comparator = [](const glm::uvec3& lhs, const glm::uvec3& rhs) {
             if      (lhs.x != rhs.x) return lhs.x < rhs.x;
@@ -163,9 +244,8 @@ namespace fracturer
         std::set<glm::uvec3, decltype(comparator)> seeds(comparator);
         // Current try number
         uvec3 numDivs = grid.getNumSubdivisions() - uvec3(2);
-        unsigned int attempt = 0, maxDim = glm::max(numDivs.x, glm::max(numDivs.y, numDivs.z));
-
-        _randomInitFunction[randomSeedFunction](maxDim);
+        unsigned int attempt = 0;
+        const RandomFunction& randomFunction = _randomFunction[randomSeedFunction];
 
         // Bruteforce seed search
         while (seeds.size() != nseeds) {
@@ -174,9 +254,9 @@ namespace fracturer
                 throw SeederSearchError("Max. number of tries surpassed (" + std::to_string(MAX_TRIES) + ")");
 
             // Generate random seed
-            int x = _randomFunction[randomSeedFunction](0, numDivs.x + 1, attempt, 0);
-            int y = _randomFunction[randomSeedFunction](0, numDivs.y + 1, attempt, 1);
-            int z = _randomFunction[randomSeedFunction](0, numDivs.z + 1, attempt, 2);
+            int x = randomFunction(stream, 0, numDivs.x + 1, attempt, 0);
+            int y = randomFunction(stream, 0, numDivs.y + 1, attempt, 1);
+            int z = randomFunction(stream, 0, numDivs.z + 1, attempt, 2);
             glm::uvec3 voxel(x, y, z);
 
             // Is occupied the voxel?
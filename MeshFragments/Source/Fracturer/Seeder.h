@@ -1,9 +1,10 @@
 #pragma once
 
+#include "DataStructures/LinearBvh.h"
 #include "DataStructures/RegularGrid.h"
 #include "Fracturer.h"
-#include "Utilities/HaltonEnum.h"
 #include "Utilities/HaltonSampler.h"
+#include "Utilities/RandomStream.h"
 
 namespace fracturer 
 {
@@ -24,23 +25,14 @@ namespace fracturer
         enum Location { INNER, OUTER, BOTH };
 
     public:
-        typedef std::function<void(int size)> RandomInitFunction;
-        typedef std::unordered_map<uint16_t, RandomInitFunction> RandomInitUniformMap;
-
-        typedef std::function<int(int min, int max, int index, int coord)> RandomFunction;
+        typedef std::function<int(const RandomStream& stream, int min, int max, int index, int coord)> RandomFunction;
         typedef std::unordered_map<uint16_t, RandomFunction> RandomUniformMap;
 
-        typedef std::function<float(float min, float max, int index, int coord)> RandomFunctionFloat;
+        typedef std::function<float(const RandomStream& stream, float min, float max, int index, int coord)> RandomFunctionFloat;
         typedef std::unordered_map<uint16_t, RandomFunctionFloat> RandomUniformMapFloat;
 
-        static Halton_sampler               _haltonSampler;
-        static Halton_enum                  _haltonEnum;
-
-        static boost::mt19937               _boostRng;
-        static boost::normal_distribution<> _boostNormalDistribution;
-        static std::unique_ptr<boost::variate_generator<boost::mt19937&, boost::normal_distribution<>>> _boostGenerator;
+        static const Halton_sampler         _haltonSampler;             //!< Faure-permuted sampler, initialized once and only read afterwards
 
-        static RandomInitUniformMap         _randomInitFunction;
         static RandomUniformMap             _randomFunction;
         static RandomUniformMapFloat        _randomFunctionFloat;
 
@@ -49,14 +41,21 @@ namespace fracturer
 
     public:
         /**
-        *   @brief 
+        *   @brief Seeds of a fracture as configured by fractParameters: uniform seeds, or seeds spread around the impacts if any, merged with extra seeds.
+        *   Each step draws from its own stream of fractParameters, so it can be called from several threads for different iterations.
+        *   @param bvh Mesh of the grid, against which rays are casted instead of drawing uniform seeds if ray-casted impacts are enabled.
+        */
+        static std::vector<glm::uvec4> generateSeeds(const RegularGrid& grid, const FractureParameters& fractParameters, const std::vector<glm::uvec4>& impacts, const LinearBvh* bvh = nullptr);
+
+        /**
+        *   @brief Appends nseeds values in [0, 1) to noiseBuffer. Each value only depends on the stream and its index, so the buffer is filled in parallel.
         */
-        static void getFloatNoise(unsigned int maxBufferSize, unsigned int nseeds, int randomSeedFunction, std::vector<float>& noiseBuffer);
+        static void getFloatNoise(unsigned int nseeds, int randomSeedFunction, const RandomStream& stream, std::vector<float>& noiseBuffer);
 
     	/**
     	*   @brief Creates seeds near the current ones. 
     	*/
-        static std::vector<glm::uvec4> nearSeeds(const RegularGrid& grid, const std::vector<glm::uvec4>& frags, unsigned numImpacts, unsigned numSeeds, unsigned spreading);
+        static std::vector<glm::uvec4> nearSeeds(const RegularGrid& grid, const std::vector<glm::uvec4>& frags, unsigned numImpacts, unsigned numSeeds, unsigned spreading, RandomStream stream);
     	
         /**
         *   Merge seeds randomly until there are no extra seeds.
@@ -66,6 +65,13 @@ namespace fracturer
         */
         static void mergeSeeds(const std::vector<glm::uvec4>& frags, std::vector<glm::uvec4>& seeds, DistanceFunction dfunc);
 
+        /**
+        *   Seeds on the voxels first hit by rays casted against the mesh, from random points of its bounding sphere towards random points
+        *   of its bounding box. Rays are traversed in batches, thus thousands of impacts are found at a fraction of the cost of single queries.
+        *   Seed ids start at VOXEL_FREE + 1, as in uniform().
+        */
+        static std::vector<glm::uvec4> rayImpacts(const RegularGrid& grid, const LinearBvh& bvh, unsigned int nseeds, int randomSeedFunction, const RandomStream& stream);
+
         /**
         *   Brute force generator of seeds using an uniform distribution
         *   Just tries in the voxel space till it founds a "fill" voxel.
@@ -73,6 +79,6 @@ namespace fracturer
         *   Warning! every seeds has: x, y, z, colorIndex. Min colorIndex is 2
         *   becouse in Flood algorithm colorIndex 1 is reserved for 'free' voxel.
         */
-        static std::vector<glm::uvec4> uniform(const RegularGrid& grid, unsigned int nseeds, int randomSeedFunction, Location location = OUTER);
+        static std::vector<glm::uvec4> uniform(const RegularGrid& grid, unsigned int nseeds, int randomSeedFunction, const RandomStream& stream, Location location = OUTER);
     };
 }
@@ -1,7 +1,8 @@
 #include "stdafx.h"
 #include "PointCloud3D.h"
 
-#include "happly.h"
+#include "Utilities/FragmentArchive.h"
+#include "Utilities/PointCloudCodec.h"
 
 /// [Public methods]
 
@@ -96,42 +97,52 @@ void PointCloud3D::push_back(const vec4* points, unsigned numPoints)
 	}
 }
 
-std::thread* PointCloud3D::save(const std::string& filename, FractureParameters::ExportPointCloudExtension pointCloudExtension)
+std::thread* PointCloud3D::save(const std::string& filename, FractureParameters::ExportPointCloudExtension pointCloudExtension, FragmentArchive* archive)
 {
-	const std::string extensionStr = FractureParameters::ExportPointCloud_STR[pointCloudExtension];
-	std::thread* thread;
+	const std::string path = filename + "." + FractureParameters::ExportPointCloud_STR[pointCloudExtension];
 
 #if TESTING_FORMAT_MODE
 	std::vector<vec4> points = _points;
-	if (pointCloudExtension == FractureParameters::ExportPointCloudExtension::PLY)
-		thread = new std::thread(&PointCloud3D::savePLY, this, filename + "." + extensionStr, std::move(points));
-	else if (pointCloudExtension == FractureParameters::ExportPointCloudExtension::XYZ)
-		thread = new std::thread(&PointCloud3D::saveXYZ, this, filename + "." + extensionStr, std::move(points));
-	else
-		thread = new std::thread(&PointCloud3D::saveCompressed, this, filename + "." + extensionStr, std::move(points));
+	return new std::thread(&PointCloud3D::saveFile, this, path, pointCloudExtension, std::move(points), archive);
 #else
-	if (pointCloudExtension == FractureParameters::ExportPointCloudExtension::PLY)
-		thread = new std::thread(&PointCloud3D::savePLY, this, filename + "." + extensionStr, std::move(_points));
-	else if (pointCloudExtension == FractureParameters::ExportPointCloudExtension::XYZ)
-		thread = new std::thread(&PointCloud3D::saveXYZ, this, filename + "." + extensionStr, std::move(_points));
-	else
-		thread = new std::thread(&PointCloud3D::saveCompressed, this, filename + "." + extensionStr, std::move(_points));
+	return new std::thread(&PointCloud3D::saveFile, this, path, pointCloudExtension, std::move(_points), archive);
 #endif 
+}
 
-	return thread;
+void PointCloud3D::save(NumpyFile::NpzArchive& archive, const std::string& name) const
+{
+	const std::vector<float> positions = PointCloud3D::getPositionArray(_points);
+	archive.add(name, "<f4", { _points.size(), 3 }, positions.data(), positions.size() * sizeof(float));
 }
 
-void PointCloud3D::subselect(unsigned numPoints)
+void PointCloud3D::subselect(unsigned numPoints, const RandomStream& stream)
 {
 	if (numPoints >= _points.size()) return;
 
-	std::shuffle(_points.begin(), _points.end(), std::mt19937(std::random_device()()));
+	// Only the first numPoints positions need to be drawn
+	for (unsigned pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+		std::swap(_points[pointIdx], _points[pointIdx + stream.at(pointIdx) % (_points.size() - pointIdx)]);
 	_points.resize(numPoints);
 }
 
 // Protected methods
 
-void PointCloud3D::saveCompressed(const std::string& filename, const std::vector<glm::vec4>&& points)
+std::vector<float> PointCloud3D::getPositionArray(const std::vector<glm::vec4>& points)
+{
+	std::vector<float> positions(points.size() * 3);
+
+	#pragma omp parallel for
+	for (int idx = 0; idx < points.size(); ++idx)
+	{
+		positions[idx * 3 + 0] = points[idx].x;
+		positions[idx * 3 + 1] = points[idx].y;
+		positions[idx * 3 + 2] = points[idx].z;
+	}
+
+	return positions;
+}
+
+void PointCloud3D::saveCompressed(std::ostream& stream, const std::vector<glm::vec4>& points)
 {
 	pcl::io::compression_Profiles_e compressionProfile = pcl::io::HIGH_RES_OFFLINE_COMPRESSION_WITHOUT_COLOR;
 	auto encoder = new pcl::io::OctreePointCloudCompression<pcl::PointXYZ>(compressionProfile, false);
@@ -140,38 +151,115 @@ void PointCloud3D::saveCompressed(const std::string& filename, const std::vector
 	for (const vec4& point : points)
 		cloud->push_back(pcl::PointXYZ(point.x, point.y, point.z));
 
-	std::stringstream compressedData;
-	encoder->encodePointCloud(cloud, compressedData);
+	encoder->encodePointCloud(cloud, stream);
 
-	std::ofstream file(filename, std::ios::out | std::ios::binary);
-	if (!file.is_open()) return;
+	delete encoder;
+}
+
+void PointCloud3D::saveFile(const std::string& path, FractureParameters::ExportPointCloudExtension pointCloudExtension, const std::vector<glm::vec4>&& points, FragmentArchive* archive)
+{
+	if (archive)
+	{
+		std::ostringstream stream(std::ios::out | std::ios::binary);
+		this->saveStream(stream, pointCloudExtension, points);
+		archive->append(std::filesystem::path(path).filename().string(), stream.str());
+	}
+	else
+	{
+		std::ofstream file(path, std::ios::out | std::ios::binary);
+		if (!file.is_open()) return;
 
-	file.write(compressedData.str().c_str(), compressedData.str().length());
-	file.close();
+		this->saveStream(file, pointCloudExtension, points);
+		file.close();
+	}
+}
 
-	delete encoder;
+void PointCloud3D::saveNumpy(std::ostream& stream, const std::vector<glm::vec4>& points)
+{
+	const std::vector<float> positions = PointCloud3D::getPositionArray(points);
+	NumpyFile::write(stream, "<f4", { points.size(), 3 }, positions.data(), positions.size() * sizeof(float));
 }
 
-void PointCloud3D::savePLY(const std::string& filename, const std::vector<glm::vec4>&& points)
+void PointCloud3D::savePLY(std::ostream& stream, const std::vector<glm::vec4>& points)
 {
-	std::vector<std::array<double, 3>> vertices(points.size());
+	// Only the number of vertices changes from one header to another
+	static const std::string headerStart = "ply\nformat binary_little_endian 1.0\nelement vertex ";
+	static const std::string headerEnd = "\nproperty float x\nproperty float y\nproperty float z\nend_header\n";
+	const size_t VERTEX_SIZE = 3 * sizeof(float);
+
+	const std::string header = headerStart + std::to_string(points.size()) + headerEnd;
+	std::vector<char> buffer(header.size() + points.size() * VERTEX_SIZE);
+	std::memcpy(buffer.data(), header.data(), header.size());
+
+	char* vertices = buffer.data() + header.size();
+
 	#pragma omp parallel for
 	for (int idx = 0; idx < points.size(); ++idx)
-		vertices[idx] = { points[idx].x, points[idx].z, points[idx].y };
+	{
+		const float vertex[3] = { points[idx].x, points[idx].z, points[idx].y };
+		std::memcpy(vertices + idx * VERTEX_SIZE, vertex, VERTEX_SIZE);
+	}
 
-	happly::PLYData plyOut;
-	plyOut.addVertexPositions(vertices);
-	plyOut.write(filename, happly::DataFormat::Binary);
+	stream.write(buffer.data(), buffer.size());
 }
 
-void PointCloud3D::saveXYZ(const std::string& filename, const std::vector<glm::vec4>&& points)
+void PointCloud3D::saveQuantized(std::ostream& stream, const std::vector<glm::vec4>& points)
 {
-	std::ofstream file(filename);
-	if (!file.is_open()) return;
-
-	for (const vec4& point : points)
-		file << point.x << " " << point.y << " " << point.z << std::endl;
+	std::vector<char> data;
+	PointCloudCodec::encode(points, data);
+	stream.write(data.data(), data.size());
+}
 
-	file.close();
+void PointCloud3D::saveStream(std::ostream& stream, FractureParameters::ExportPointCloudExtension pointCloudExtension, const std::vector<glm::vec4>& points)
+{
+	if (pointCloudExtension == FractureParameters::ExportPointCloudExtension::PLY)
+		this->savePLY(stream, points);
+	else if (pointCloudExtension == FractureParameters::ExportPointCloudExtension::XYZ)
+		this->saveXYZ(stream, points);
+	else if (pointCloudExtension == FractureParameters::ExportPointCloudExtension::NUMPY_POINT_CLOUD)
+		this->saveNumpy(stream, points);
+	else if (pointCloudExtension == FractureParameters::ExportPointCloudExtension::QUANTIZED_POINT_CLOUD)
+		this->saveQuantized(stream, points);
+	else
+		this->saveCompressed(stream, points);
 }
 
+void PointCloud3D::saveXYZ(std::ostream& stream, const std::vector<glm::vec4>& points)
+{
+	const int CHUNK_SIZE = 4096;									// Points formatted by each iteration
+	const int MAX_POINT_LENGTH = 3 * 16;							// Shortest round-trip float takes up to 15 characters, plus separator
+
+	const int numPoints = static_cast<int>(points.size());
+	const int numChunks = (numPoints + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	std::vector<char> buffer(static_cast<size_t>(numPoints) * MAX_POINT_LENGTH);
+	std::vector<size_t> chunkLength(numChunks);
+
+	#pragma omp parallel for
+	for (int chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+	{
+		char* begin = buffer.data() + static_cast<size_t>(chunkIdx) * CHUNK_SIZE * MAX_POINT_LENGTH, *current = begin;
+		const int endIdx = std::min(numPoints, (chunkIdx + 1) * CHUNK_SIZE);
+
+		for (int idx = chunkIdx * CHUNK_SIZE; idx < endIdx; ++idx)
+		{
+			current = std::to_chars(current, current + 15, points[idx].x).ptr;
+			*current++ = ' ';
+			current = std::to_chars(current, current + 15, points[idx].y).ptr;
+			*current++ = ' ';
+			current = std::to_chars(current, current + 15, points[idx].z).ptr;
+			*current++ = '\n';
+		}
+
+		chunkLength[chunkIdx] = current - begin;
+	}
+
+	// Chunks are compacted so that the whole cloud is written at once
+	size_t length = 0;
+	for (int chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+	{
+		std::memmove(buffer.data() + length, buffer.data() + static_cast<size_t>(chunkIdx) * CHUNK_SIZE * MAX_POINT_LENGTH, chunkLength[chunkIdx]);
+		length += chunkLength[chunkIdx];
+	}
+
+	stream.write(buffer.data(), length);
+}
@@ -5,6 +5,9 @@
 #include "pcl/point_cloud.h"
 #include "pcl/point_types.h"
 #include "pcl/compression/octree_pointcloud_compression.h"
+#include "Utilities/NumpyFile.h"
+
+class FragmentArchive;
 
 /**
 *	@file PointCloud3D.h
@@ -22,10 +25,27 @@ class PointCloud3D
 	AABB					_aabb;						//!< Boundaries
 
 protected:
-	// Parallel saving
-	void saveCompressed(const std::string& filename, const std::vector<glm::vec4>&& points);
-	void savePLY(const std::string& filename, const std::vector<glm::vec4>&& points);
-	void saveXYZ(const std::string& filename, const std::vector<glm::vec4>&& points);
+	/**
+	*	@return Positions as a row-major float32 N x 3 array.
+	*/
+	static std::vector<float> getPositionArray(const std::vector<glm::vec4>& points);
+
+	/**
+	*	@brief Writes the points either into a file or, if an archive is given, into an entry named after the file.
+	*/
+	void saveFile(const std::string& path, FractureParameters::ExportPointCloudExtension pointCloudExtension, const std::vector<glm::vec4>&& points, FragmentArchive* archive);
+
+	/**
+	*	@brief Writes the points into a stream with the required format.
+	*/
+	void saveStream(std::ostream& stream, FractureParameters::ExportPointCloudExtension pointCloudExtension, const std::vector<glm::vec4>& points);
+
+	// Formats
+	void saveCompressed(std::ostream& stream, const std::vector<glm::vec4>& points);
+	void saveNumpy(std::ostream& stream, const std::vector<glm::vec4>& points);
+	void savePLY(std::ostream& stream, const std::vector<glm::vec4>& points);
+	void saveQuantized(std::ostream& stream, const std::vector<glm::vec4>& points);
+	void saveXYZ(std::ostream& stream, const std::vector<glm::vec4>& points);
 
 public:
 	/**
@@ -106,8 +126,14 @@ public:
 
 	/**
 	*	@brief Saves the point cloud according to the required extension. Performed in a different thread.
+	*	@param archive If not null, the point cloud is appended to it instead of being written as a separate file.
+	*/
+	std::thread* save(const std::string& filename, FractureParameters::ExportPointCloudExtension pointCloudExtension, FragmentArchive* archive = nullptr);
+
+	/**
+	*	@brief Appends the point cloud to an .npz archive as a float32 N x 3 array, so that several clouds are written in a single file.
 	*/
-	std::thread* save(const std::string& filename, FractureParameters::ExportPointCloudExtension pointCloudExtension);
+	void save(NumpyFile::NpzArchive& archive, const std::string& name) const;
 
 	/**
 	*	@brief Number of points that this cloud contains.
@@ -115,8 +141,8 @@ public:
 	size_t size() const { return _points.size(); }
 
 	/**
-	*	@brief Subselects a number of points from the cloud.
+	*	@brief Subselects a number of points from the cloud through a partial Fisher-Yates shuffle driven by the stream.
 	*/
-	void subselect(unsigned numPoints);
+	void subselect(unsigned numPoints, const RandomStream& stream);
 };
 
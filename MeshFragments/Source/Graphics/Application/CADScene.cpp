@@ -2,6 +2,7 @@
 #include "CADScene.h"
 
 #include "DataStructures/FragmentGraph.h"
+#include "DataStructures/GridStatistics.h"
 #include "DataStructures/WingedTriangleMesh.h"
 #include "Geometry/3D/PointCloud3D.h"
 #include "Graphics/Application/TextureList.h"
@@ -15,8 +16,11 @@
 #include "Graphics/Core/OpenGLUtilities.h"
 #include "Graphics/Core/Voronoi.h"
 #include "progressbar.hpp"
+#include "Utilities/BoundedQueue.h"
 #include "Utilities/ChronoUtilities.h"
 #include "Utilities/FileManagement.h"
+#include "Utilities/FragmentArchive.h"
+#include "Utilities/NumpyFile.h"
 #include "Utilities/ResourceTracker.h"
 
 /// Initialization of static attributes
@@ -27,7 +31,7 @@ const std::string CADScene::TARGET_PATH = "D:/allopezr/Research/serapis.obj";
 // [Public methods]
 
 CADScene::CADScene() :
-	_aabbRenderer(nullptr), _fragmentBoundaries(nullptr), _generateDataset(false), _mesh(nullptr), _meshGrid(nullptr), _pointCloud(nullptr), _pointCloudRenderer(nullptr)
+	_aabbRenderer(nullptr), _fragmentBoundaries(nullptr), _generateDataset(false), _mesh(nullptr), _meshBvh(nullptr), _meshGrid(nullptr), _pointCloud(nullptr), _pointCloudRenderer(nullptr)
 {
 	_aabbRenderer = new AABBSet();
 	_aabbRenderer->load();
@@ -42,11 +46,22 @@ CADScene::~CADScene()
 	delete _aabbRenderer;
 	delete _fragmentBoundaries;
 	delete _mesh;
+	delete _meshBvh;
 	delete _meshGrid;
 	delete _pointCloud;
 	delete _pointCloudRenderer;
 }
 
+void CADScene::exportContactGraph()
+{
+	const std::string folder = INTERACTIVE_APP_FOLDER + _mesh->getShortName() + "/";
+	if (!std::filesystem::exists(folder)) std::filesystem::create_directory(folder);
+
+	ContactGraph contactGraph;
+	contactGraph.build(*_meshGrid);
+	contactGraph.save(folder + "grid");
+}
+
 void CADScene::exportFragments(const FractureParameters& fractureParameters, const std::string& extension)
 {
 	// Is folder created
@@ -136,7 +151,8 @@ void CADScene::exportPointClouds(const FractureParameters& fractureParameters)
 	{
 		for (int targetCount : fractureParameters._targetPoints)
 		{
-			PointCloud3D* pc = dynamic_cast<CADModel*>(_fractureMeshes[idx])->sampleCPU(targetCount, fractureParameters._pointCloudSeedingRandom);
+			PointCloud3D* pc = dynamic_cast<CADModel*>(_fractureMeshes[idx])->sampleCPU(
+				targetCount, fractureParameters._pointCloudSeedingRandom, fractureParameters.getRandomStream(RandomStream::POINT_CLOUD_SAMPLING).getSubstream(idx + 1).getSubstream(targetCount));
 			pc->save(folder + std::to_string(targetCount), static_cast<FractureParameters::ExportPointCloudExtension>(fractureParameters._exportPointCloudExtension));
 			delete pc;
 		}
@@ -151,7 +167,7 @@ void CADScene::exportPointCloud(FractureParameters& fractureParameters, const st
 
 		for (int targetPoints : fractureParameters._targetPoints)
 		{
-			PointCloud3D* pointCloud = _mesh->sampleCPU(targetPoints, fractureParameters._pointCloudSeedingRandom);
+			PointCloud3D* pointCloud = _mesh->sampleCPU(targetPoints, fractureParameters._pointCloudSeedingRandom, fractureParameters.getRandomStream(RandomStream::POINT_CLOUD_SAMPLING).getSubstream(targetPoints));
 			#if TESTING_FORMAT_MODE
 			for (int pointCloudFormat = 0; pointCloudFormat < FractureParameters::NUM_POINT_CLOUD_EXTENSIONS; ++pointCloudFormat)
 			{
@@ -172,6 +188,9 @@ std::string CADScene::fractureGrid(std::vector<FragmentationProcedure::FragmentM
 	this->eraseFragmentContent();
 	if (!_generateDataset && _meshGrid)
 		this->allocateMeshGrid(_fractParameters);
+	// Every interactive fracture draws a different pattern, whereas the dataset generation sets the iteration explicitly
+	if (!_generateDataset)
+		++fractureParameters._iteration;
 	this->rebuildGrid(fractureParameters);
 	const std::string result = this->fractureModel(fractureParameters);
 	if (prepareScene)
@@ -227,6 +246,32 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 		while (!fileList.empty() && fileList[0].find(fractureProcedure._startVessel) == std::string::npos);
 	}
 
+	// Models of other shards are left to their processes, whereas models finished by a previous run are skipped
+	DatasetManifest manifest;
+	std::vector<DatasetManifest::Job> manifestJobs;
+	manifest.open(fractureProcedure._currentDestinationFolder + "manifest/", fractureProcedure._shardIdx, fractureProcedure._numShards, fractureProcedure._resume);
+
+	for (auto path = fileList.begin(); path != fileList.end(); )
+	{
+		const std::string modelName = std::filesystem::path(*path).stem().string();
+		if (!manifest.isAssigned(modelName))
+		{
+			path = fileList.erase(path);
+			continue;
+		}
+
+		for (int numFragments = fractureProcedure._fragmentInterval.x; numFragments <= fractureProcedure._fragmentInterval.y; ++numFragments)
+			for (int iteration = 0; iteration < fractureProcedure.getNumIterations(numFragments); ++iteration)
+				manifestJobs.push_back({ modelName, numFragments, iteration });
+
+		if (manifest.isCompleted(modelName))
+			path = fileList.erase(path);
+		else
+			++path;
+	}
+
+	manifest.writeJobs(manifestJobs);
+
 	ResourceTracker* tracker = ResourceTracker::getInstance();
 	tracker->openStream("Output/log" + ChronoUtilities::getCurrentDateTime() + ".txt");
 	tracker->track(10000);
@@ -239,7 +284,6 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 	for (const std::string& path : fileList)
 	{
 		std::vector<FragmentationProcedure::FragmentMetadata> modelMetadata;
-		std::vector<std::thread*> threads;
 
 		tracker->recordEvent(ResourceTracker::MODEL_LOAD);
 		this->loadModel(path);
@@ -249,6 +293,10 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 		const std::string meshFile = meshFolder + modelName + "_";
 		if (!std::filesystem::exists(meshFolder)) std::filesystem::create_directory(meshFolder);
 
+		// Random streams are keyed by model and iteration, so that any iteration can be reproduced on its own
+		fractureProcedure._fractureParameters._modelKey = RandomStream::hash(modelName);
+		fractureProcedure._fractureParameters._iteration = 0;
+
 		// Calculate size of voxelization according to model size
 		const AABB aabb = _mesh->getAABB();
 		fractureProcedure._fractureParameters._voxelizationSize = glm::ceil(aabb.size() * vec3(fractureProcedure._fractureParameters._voxelPerMetricUnit));
@@ -268,10 +316,47 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 
 		// Initialize grid content
 		unsigned maxDimension = glm::max(fractureProcedure._fractureParameters._voxelizationSize.x, glm::max(fractureProcedure._fractureParameters._voxelizationSize.y, fractureProcedure._fractureParameters._voxelizationSize.z));
+		auto getIterationFile = [&](int numFragments, int iteration) -> std::string
+			{
+				return meshFile + std::to_string(numFragments) + "f_" + std::to_string(maxDimension) + "r_" + std::to_string(iteration) + "it";
+			};
+
+		// Savers append fragments directly to the archive, so no loose files are left behind. Its index is written on destruction, even if an error is thrown
+		bool resumeModel = manifest.isStarted(modelName);
+		std::unique_ptr<FragmentArchive> archive;
+		if (fractureProcedure._archiveResultingFiles)
+		{
+			const std::string archiveFile = meshFolder + modelName + FragmentArchive::EXTENSION;
+			const FragmentArchive::Compression compression = fractureProcedure._compressResultingFiles ? FragmentArchive::DEFLATE : FragmentArchive::STORED;
+
+			// Entries are named after the file of their iteration, followed by a suffix starting with '_' or '.'
+			std::unordered_set<std::string> recordedFiles;
+			for (int numFragments = fractureProcedure._fragmentInterval.x; numFragments <= fractureProcedure._fragmentInterval.y; ++numFragments)
+				for (int iteration = 0; iteration < fractureProcedure.getNumIterations(numFragments); ++iteration)
+					if (manifest.isRecorded(modelName, numFragments, iteration))
+						recordedFiles.insert(std::filesystem::path(getIterationFile(numFragments, iteration)).filename().string());
+
+			auto isRecorded = [&recordedFiles](const std::string& name) -> bool
+				{
+					for (size_t position = name.find_first_of("_."); position != std::string::npos; position = name.find_first_of("_.", position + 1))
+						if (recordedFiles.find(name.substr(0, position)) != recordedFiles.end())
+							return true;
+
+					return false;
+				};
+
+			// Finished jobs are redone if their entries cannot be recovered
+			archive.reset(new FragmentArchive());
+			if (!resumeModel || !archive->resume(archiveFile, compression, isRecorded))
+			{
+				resumeModel = false;
+				archive->create(archiveFile, compression);
+			}
+		}
 		
 		tracker->recordEvent(ResourceTracker::VOXELIZATION);
 		_meshGrid->setAABB(_mesh->getAABB(), fractureProcedure._fractureParameters._voxelizationSize);
-		_meshGrid->fill(_mesh);
+		_meshGrid->fill(_mesh, fractureProcedure._fractureParameters._conservativeVoxelization, fractureProcedure._fractureParameters._solidVoxelization);
 		tracker->recordEvent(ResourceTracker::MEMORY_ALLOCATION);
 		_meshGrid->resetMarchingCubes();
 
@@ -287,212 +372,255 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 		if (fractureProcedure._fractureParameters._exportGrid)
 			this->exportGrid(fractureProcedure._fractureParameters, meshFolder);
 
+		// Impacts are casted against the hierarchy from the workers, hence it is built while the geometry is still available
+		if (fractureProcedure._fractureParameters._rayImpacts)
+			this->getMeshBvh();
+
 		_mesh->getModelComponent(0)->releaseMemory();
 
 		size_t numGeneratedFragments = 0;
+		int modelIteration = 0;
 
-		for (int numFragments = fractureProcedure._fragmentInterval.x; numFragments <= fractureProcedure._fragmentInterval.y && numGeneratedFragments < fractureProcedure._maxFragmentsModel; ++numFragments)
-		{
-			const std::string fragmentFile = meshFile + std::to_string(numFragments) + "f_";
-
-			fractureProcedure._fractureParameters._numExtraSeeds = numFragments * 2;
-			fractureProcedure._fractureParameters._numSeeds = numFragments;
-			const int numIterations = glm::mix(
-				fractureProcedure._iterationInterval.x, fractureProcedure._iterationInterval.y,
-				static_cast<float>(numFragments - fractureProcedure._fragmentInterval.x) / (fractureProcedure._fragmentInterval.y - fractureProcedure._fragmentInterval.x));
+		std::unique_ptr<fracturer::IterationScheduler> scheduler;
+		BoundedQueue<IterationOutput*> exportQueue(fractureProcedure._pipelineDepth), retiredQueue;
+		std::exception_ptr exportError;
 
-			std::cout << modelName << " - " << numFragments << " fragments ";
-			progressbar bar(numIterations);
-
-			for (int iteration = 0; iteration < numIterations && numGeneratedFragments < fractureProcedure._maxFragmentsModel; ++iteration)
+		// Iterations that cannot be exported are retired without being recorded, once their savers are done with the meshes
+		auto discardIteration = [&](IterationOutput* output)
 			{
-				bar.update();
-
-				unsigned idx = 0;
-				const std::string itFile = fragmentFile + std::to_string(maxDimension) + "r_" + std::to_string(iteration) + "it";
-				std::vector<FragmentationProcedure::FragmentMetadata> localMetadata;
+				for (std::thread* thread : output->_threads)
+				{
+					if (!thread) continue;
+					thread->join();
+					delete thread;
+				}
+				output->_threads.clear();
 
-				tracker->recordFilename(itFile);
+				if (output->_grid)
+					scheduler->release(output->_grid);
+				output->_grid = nullptr;
 
-				tracker->recordEvent(ResourceTracker::FRACTURE);
-				this->fractureGrid(fragmentMetadata, fractureProcedure._fractureParameters, false);
+				retiredQueue.push(output);
+			};
 
-				tracker->recordEvent(ResourceTracker::DATA_TYPE_CONVERSION);
-				this->prepareScene(fractureProcedure._fractureParameters, fragmentMetadata);
+		// Export stage, overlapped with the fracture and extraction of the following iterations. Simplification relies on global state, hence a single thread
+		std::thread exportStage([&]()
+			{
+				IterationOutput* output = nullptr, * previousOutput = nullptr;
 
-				tracker->recordEvent(ResourceTracker::STORAGE);
-				// Grid
-				if (fractureProcedure._fractureParameters._exportGrid)
+				try
 				{
-					#if TESTING_FORMAT_MODE
-					for (int gridFormat = 0; gridFormat < FractureParameters::NUM_GRID_EXTENSIONS; ++gridFormat)
+					while (exportQueue.pop(output))
 					{
-						fractureProcedure._fractureParameters._exportGridExtension = static_cast<FractureParameters::ExportGrid>(gridFormat);
-						#endif
-						_meshGrid->exportGrid(itFile, true, static_cast<FractureParameters::ExportGrid>(fractureProcedure._fractureParameters._exportGridExtension));
-
-						FragmentationProcedure::FragmentMetadata metadata;
-						metadata._type = FragmentationProcedure::VOXEL;
-						metadata._vesselName = itFile + "." + FractureParameters::ExportGrid_STR[fractureProcedure._fractureParameters._exportGridExtension];
-						metadata._voxelizationSize = fractureProcedure._fractureParameters._voxelizationSize;
-						localMetadata.push_back(metadata);
-					#if TESTING_FORMAT_MODE
-					}
-					#endif
-				}
+						if (!output->_recorded)
+							this->exportIteration(*output, fractureProcedure._packPointClouds, archive.get());
+						modelMetadata.insert(modelMetadata.end(), output->_localMetadata.begin(), output->_localMetadata.end());
 
-				for (Model3D* fracture : _fractureMeshes)
-				{
-					CADModel* cadModel = dynamic_cast<CADModel*>(fracture);
-					const std::string filename = itFile + "_" + std::to_string(idx);
-					std::string simplificationFilename;
+						if (output->_grid)
+							scheduler->release(output->_grid);
+						output->_grid = nullptr;
 
-					// Point clouds
-					if (fractureProcedure._fractureParameters._exportPointCloud)
-					{
-						for (int targetCount : fractureProcedure._fractureParameters._targetPoints)
+						// Savers of the previous iteration have been writing meanwhile
+						if (previousOutput)
 						{
-							PointCloud3D* pointCloud = dynamic_cast<CADModel*>(fracture)->sampleCPU(targetCount, fractureProcedure._fractureParameters._pointCloudSeedingRandom);
-							simplificationFilename = filename + "_" + std::to_string(targetCount) + "p";
-
-							#if TESTING_FORMAT_MODE
-							for (int pointCloudFormat = 0; pointCloudFormat < FractureParameters::NUM_POINT_CLOUD_EXTENSIONS; ++pointCloudFormat)
-							{
-								fractureProcedure._fractureParameters._exportPointCloudExtension = static_cast<FractureParameters::ExportPointCloudExtension>(pointCloudFormat);
-							#endif
-								FragmentationProcedure::FragmentMetadata metadata;
-								metadata._type = FragmentationProcedure::POINT_CLOUD;
-								metadata._vesselName = simplificationFilename + "." + FractureParameters::ExportPointCloud_STR[fractureProcedure._fractureParameters._exportPointCloudExtension];
-								metadata._numPoints = pointCloud->getNumPoints();
-								localMetadata.push_back(metadata);
-
-								threads.push_back(pointCloud->save(simplificationFilename, static_cast<FractureParameters::ExportPointCloudExtension>(fractureProcedure._fractureParameters._exportPointCloudExtension)));
-							#if TESTING_FORMAT_MODE
-							}
-							#endif
-
-							delete pointCloud;
+							this->recordIteration(*previousOutput, manifest, archive.get());
+							retiredQueue.push(previousOutput);
 						}
+
+						previousOutput = output;
+						output = nullptr;
 					}
 
-					// Triangles
-					if (fractureProcedure._fractureParameters._exportMesh)
+					if (previousOutput)
 					{
-						if (!fractureProcedure._fractureParameters._targetTriangles.empty())
-						{
-							for (int targetCount : fractureProcedure._fractureParameters._targetTriangles)
-							{
-								cadModel->simplify(targetCount);
-
-								#if TESTING_FORMAT_MODE
-								for (int meshFormat = 0; meshFormat < FractureParameters::NUM_EXPORT_MESH_EXTENSIONS; ++meshFormat)
-								{
-									fractureProcedure._fractureParameters._exportMeshExtension = static_cast<FractureParameters::ExportMeshExtension>(meshFormat);
-								#endif
-									simplificationFilename = filename + "_" + std::to_string(targetCount) + "t";
-
-									fragmentMetadata[idx]._vesselName = simplificationFilename + "." + FractureParameters::ExportMesh_STR[fractureProcedure._fractureParameters._exportMeshExtension];
-									fragmentMetadata[idx]._numVertices = fracture->getNumVertices();
-									fragmentMetadata[idx]._numFaces = fracture->getNumFaces();
-									localMetadata.push_back(fragmentMetadata[idx]);
-
-									threads.push_back(cadModel->save(simplificationFilename, static_cast<FractureParameters::ExportMeshExtension>(fractureProcedure._fractureParameters._exportMeshExtension)));
-								#if TESTING_FORMAT_MODE
-								}
-								#endif
-							}
-						}
-						else
-						{
-							#if TESTING_FORMAT_MODE
-							for (int meshFormat = 0; meshFormat < FractureParameters::NUM_EXPORT_MESH_EXTENSIONS; ++meshFormat)
-							{
-								fractureProcedure._fractureParameters._exportMeshExtension = static_cast<FractureParameters::ExportMeshExtension>(meshFormat);
-							#endif
-								fragmentMetadata[idx]._vesselName = filename + "." + FractureParameters::ExportMesh_STR[fractureProcedure._fractureParameters._exportMeshExtension];
-								fragmentMetadata[idx]._numVertices = cadModel->getNumVertices();
-								fragmentMetadata[idx]._numFaces = cadModel->getNumFaces();
-								localMetadata.push_back(fragmentMetadata[idx]);
-
-								threads.push_back(cadModel->save(filename, static_cast<FractureParameters::ExportMeshExtension>(fractureProcedure._fractureParameters._exportMeshExtension)));
-							#if TESTING_FORMAT_MODE
-							}
-							#endif
-						}
+						this->recordIteration(*previousOutput, manifest, archive.get());
+						retiredQueue.push(previousOutput);
+						previousOutput = nullptr;
 					}
-
-					++idx;
 				}
+				catch (...)
+				{
+					// The error is thrown again by the main thread, which finds the queue closed
+					exportError = std::current_exception();
+					exportQueue.close();
+
+					if (previousOutput) discardIteration(previousOutput);
+					if (output) discardIteration(output);
+					while (exportQueue.pop(output))
+						discardIteration(output);
+				}
+			});
 
-				numGeneratedFragments += _fractureMeshes.size();
-				modelMetadata.insert(modelMetadata.end(), localMetadata.begin(), localMetadata.end());
-				fragmentMetadata.clear();
-
-				this->eraseFragmentContent();
-			}
-
-			std::cout << std::endl;
-		}
+		auto queueIteration = [&](IterationOutput* output)
+			{
+				if (!exportQueue.push(output))
+				{
+					discardIteration(output);
+					std::rethrow_exception(exportError);
+				}
+			};
 
-		tracker->recordEvent(ResourceTracker::NULL_EVENT);
-		this->exportMetadata(meshFile, modelMetadata, std::to_string(maxDimension));
+		// Iterations finished by a previous run only carry their metadata through the export stage, so that it keeps its order
+		auto resumeIteration = [&](const DatasetManifest::Job& job) -> bool
+			{
+				DatasetManifest::Record record;
+				if (!resumeModel || !manifest.getRecord(job._model, job._numFragments, job._iteration, record))
+					return false;
+
+				IterationOutput* output = new IterationOutput;
+				output->_grid = nullptr;
+				output->_job = job;
+				output->_localMetadata = std::move(record._metadata);
+				output->_recorded = true;
+				numGeneratedFragments += record._numFragments;
+
+				queueIteration(output);
+				return true;
+			};
+
+		// Meshes are released by this thread, as they were created along with the OpenGL context
+		auto retireIterations = [&retiredQueue]()
+			{
+				IterationOutput* output;
+				while (retiredQueue.tryPop(output))
+				{
+					for (Model3D* mesh : output->_meshes) delete mesh;
+					delete output;
+				}
+			};
 
-		progressbar threadBar(threads.size());
-		std::cout << "Waiting threads to finish..." << std::endl;
-		for (int threadIdx = 0; threadIdx < threads.size(); ++threadIdx)
+		try
 		{
-			threadBar.update();
-			if (!threads[threadIdx]) continue;
-			threads[threadIdx]->join();
-			delete threads[threadIdx];
-		}
-
-		std::cout << std::endl;
-
-		if (fractureProcedure._compressResultingFiles)
-		{		
-			if (fractureProcedure._fractureParameters._exportGrid)
+			if (fractureProcedure._numWorkers > 1 && fractureProcedure._fractureParameters._fractureAlgorithm == FractureParameters::NAIVE && !fractureProcedure._fractureParameters._erode)
 			{
-				#if TESTING_FORMAT_MODE
-				for (int gridFormat = 0; gridFormat < FractureParameters::NUM_GRID_EXTENSIONS; ++gridFormat)
+				// Jobs are enumerated as in the serial loop, hence iterations keep their random streams and filenames. Finished ones are not scheduled
+				std::vector<DatasetManifest::Job> iterations;
+				std::vector<fracturer::IterationScheduler::Job> jobs;
+				for (int numFragments = fractureProcedure._fragmentInterval.x; numFragments <= fractureProcedure._fragmentInterval.y; ++numFragments)
 				{
-					fractureProcedure._fractureParameters._exportGridExtension = static_cast<FractureParameters::ExportGrid>(gridFormat);
-				#endif
-					std::thread zipGrid(&CADScene::launchZipingProcess, this, meshFolder, FractureParameters::ExportGrid_STR[fractureProcedure._fractureParameters._exportGridExtension]);
-					zipGrid.detach();
-				#if TESTING_FORMAT_MODE
+					for (int iteration = 0; iteration < fractureProcedure.getNumIterations(numFragments); ++iteration)
+					{
+						iterations.push_back({ modelName, numFragments, iteration });
+						++modelIteration;
+
+						if (!resumeModel || !manifest.isRecorded(modelName, numFragments, iteration))
+							jobs.push_back({ getIterationFile(numFragments, iteration), modelIteration, numFragments });
+					}
 				}
-				#endif
-			}
 
-			if (fractureProcedure._fractureParameters._exportMesh)
-			{
-				#if TESTING_FORMAT_MODE
-				for (int meshFormat = 0; meshFormat < FractureParameters::NUM_EXPORT_MESH_EXTENSIONS; ++meshFormat)
+				scheduler.reset(new fracturer::IterationScheduler(*_meshGrid, fractureProcedure._numWorkers, fractureProcedure._pipelineDepth, _meshBvh));
+				scheduler->launch(jobs, fractureProcedure._fractureParameters);
+
+				std::cout << modelName << " - " << iterations.size() << " iterations on " << scheduler->getNumWorkers() << " workers ";
+				progressbar bar(static_cast<int>(iterations.size()));
+
+				// Meshes are extracted on this thread, as it owns the OpenGL context
+				for (size_t iterationIdx = 0, jobIdx = 0; iterationIdx < iterations.size() && numGeneratedFragments < fractureProcedure._maxFragmentsModel; ++iterationIdx)
 				{
-					fractureProcedure._fractureParameters._exportMeshExtension = static_cast<FractureParameters::ExportMeshExtension>(meshFormat);
-				#endif
-					std::thread zipMesh(&CADScene::launchZipingProcess, this, meshFolder, FractureParameters::ExportMesh_STR[fractureProcedure._fractureParameters._exportMeshExtension]);
-					zipMesh.detach();
-				#if TESTING_FORMAT_MODE
+					bar.update();
+					if (resumeIteration(iterations[iterationIdx]))
+						continue;
+
+					const fracturer::IterationScheduler::Job& job = jobs[jobIdx];
+					tracker->recordFilename(job._filename);
+					fractureProcedure._fractureParameters._iteration = job._iteration;
+					fractureProcedure._fractureParameters._numExtraSeeds = job._numFragments * 2;
+					fractureProcedure._fractureParameters._numSeeds = job._numFragments;
+
+					tracker->recordEvent(ResourceTracker::FRACTURE);
+					RegularGrid* grid = scheduler->acquire(jobIdx++);
+
+					tracker->recordEvent(ResourceTracker::DATA_TYPE_CONVERSION);
+					_meshGrid->copyLabels(*grid);
+					_meshGrid->updateSSBO();
+					_meshGrid->detectBoundaries(1);
+					this->prepareScene(fractureProcedure._fractureParameters, fragmentMetadata);
+
+					IterationOutput* output = this->releaseIteration(fractureProcedure._fractureParameters, job._filename, fragmentMetadata);
+					output->_grid = grid;
+					if (fractureProcedure._fractureParameters._exportContacts)
+						output->_contactGraph.build(*_meshGrid);
+					output->_job = iterations[iterationIdx];
+					numGeneratedFragments += output->_meshes.size();
+
+					tracker->recordEvent(ResourceTracker::STORAGE);
+					queueIteration(output);
+					retireIterations();
 				}
-				#endif
-			}
 
-			if (fractureProcedure._fractureParameters._exportPointCloud)
+				scheduler->stop();
+				std::cout << std::endl;
+			}
+			else
 			{
-				#if TESTING_FORMAT_MODE
-				for (int pointCloudFormat = 0; pointCloudFormat < FractureParameters::NUM_POINT_CLOUD_EXTENSIONS; ++pointCloudFormat)
+				for (int numFragments = fractureProcedure._fragmentInterval.x; numFragments <= fractureProcedure._fragmentInterval.y && numGeneratedFragments < fractureProcedure._maxFragmentsModel; ++numFragments)
 				{
-					fractureProcedure._fractureParameters._exportPointCloudExtension = static_cast<FractureParameters::ExportPointCloudExtension>(pointCloudFormat);
-				#endif
-					std::thread zipPointCloud(&CADScene::launchZipingProcess, this, meshFolder, FractureParameters::ExportPointCloud_STR[fractureProcedure._fractureParameters._exportPointCloudExtension]);
-					zipPointCloud.detach();
-				#if TESTING_FORMAT_MODE
+					fractureProcedure._fractureParameters._numExtraSeeds = numFragments * 2;
+					fractureProcedure._fractureParameters._numSeeds = numFragments;
+					const int numIterations = fractureProcedure.getNumIterations(numFragments);
+
+					std::cout << modelName << " - " << numFragments << " fragments ";
+					progressbar bar(numIterations);
+
+					for (int iteration = 0; iteration < numIterations && numGeneratedFragments < fractureProcedure._maxFragmentsModel; ++iteration)
+					{
+						bar.update();
+						++modelIteration;
+						if (resumeIteration({ modelName, numFragments, iteration }))
+							continue;
+
+						const std::string itFile = getIterationFile(numFragments, iteration);
+
+						tracker->recordFilename(itFile);
+						fractureProcedure._fractureParameters._iteration = modelIteration;
+
+						tracker->recordEvent(ResourceTracker::FRACTURE);
+						this->fractureGrid(fragmentMetadata, fractureProcedure._fractureParameters, false);
+
+						tracker->recordEvent(ResourceTracker::DATA_TYPE_CONVERSION);
+						this->prepareScene(fractureProcedure._fractureParameters, fragmentMetadata);
+
+						IterationOutput* output = this->releaseIteration(fractureProcedure._fractureParameters, itFile, fragmentMetadata);
+						output->_job = { modelName, numFragments, iteration };
+						numGeneratedFragments += output->_meshes.size();
+						if (fractureProcedure._fractureParameters._exportContacts)
+							output->_contactGraph.build(*_meshGrid);
+
+						// The grid is overwritten by the next iteration, hence it cannot wait for the export stage
+						tracker->recordEvent(ResourceTracker::STORAGE);
+						if (fractureProcedure._fractureParameters._exportGrid)
+							this->exportIterationGrid(*_meshGrid, *output, archive.get());
+
+						queueIteration(output);
+						retireIterations();
+					}
+
+					std::cout << std::endl;
 				}
-				#endif
 			}
 		}
+		catch (...)
+		{
+			exportQueue.close();
+			exportStage.join();
+			retireIterations();
+			throw;
+		}
+
+		exportQueue.close();
+		exportStage.join();
+		retireIterations();
+
+		if (exportError)
+			std::rethrow_exception(exportError);
+		scheduler.reset();
+
+		tracker->recordEvent(ResourceTracker::NULL_EVENT);
+		this->exportMetadata(meshFile, modelMetadata, std::to_string(maxDimension));
+
+		archive.reset();
+
+		manifest.record(modelName);
 
 		//if (!fractureProcedure._onlineFolder.empty())
 		//{
@@ -508,11 +636,23 @@ void CADScene::generateDataset(FragmentationProcedure& fractureProcedure, const
 
 void CADScene::hit(const Model3D::RayGPUData& ray)
 {
-	if (_meshGrid)
+	if (_meshGrid && _mesh)
 	{
-		uvec3 hit = _meshGrid->getClosestEntryVoxel(ray);
+		// The impact is placed where the ray meets the surface, rather than on the first occupied voxel crossed by the ray
+		const LinearBvh::RayHit rayHit = this->getMeshBvh()->intersect(ray._origin, ray._direction);
+		if (!rayHit.isHit()) return;
+
+		uvec3 hit = _meshGrid->getSurfaceVoxel(ray._origin + ray._direction * rayHit._distance, ray._direction);
+		if (hit.x == std::numeric_limits<glm::uint>::max())
+			hit = _meshGrid->getClosestEntryVoxel(ray);
 		if (hit.x == std::numeric_limits<glm::uint>::max()) return;
 
+		if (_fractParameters._localizedImpacts && !_fractureMeshes.empty())
+		{
+			this->refractureFragment(hit);
+			return;
+		}
+
 		_impactSeeds.push_back(uvec4(hit, VOXEL_FREE + 1));
 		this->fractureGrid(_fragmentMetadata, _fractParameters);
 		_impactSeeds.clear();
@@ -556,10 +696,24 @@ void CADScene::allocateMeshGrid(FractureParameters& fractParameters)
 	}
 
 	_meshGrid->setAABB(aabb, fractParameters._voxelizationSize);
-	_meshGrid->fill(_mesh);
+	_meshGrid->fill(_mesh, fractParameters._conservativeVoxelization, fractParameters._solidVoxelization);
 	_meshGrid->resetMarchingCubes();
 }
 
+Material* CADScene::createFragmentMaterial(unsigned idx)
+{
+	Material* material = new Material;
+	Texture* kad = new Texture(vec4(ColorUtilities::HSVtoRGB(ColorUtilities::getHueValue(idx), 1.0f, 1.0f), 1.0f));
+	material->setTexture(Texture::KAD_TEXTURE, kad);
+	material->setTexture(Texture::KS_TEXTURE, TextureList::getInstance()->getTexture(CGAppEnum::TEXTURE_WHITE));
+	material->setShininess(500.0f);
+
+	_fragmentMaterials.push_back(material);
+	_fragmentTextures.push_back(kad);
+
+	return material;
+}
+
 void CADScene::eraseFragmentContent()
 {
 	delete _pointCloud;
@@ -570,6 +724,7 @@ void CADScene::eraseFragmentContent()
 
 	for (Model3D* fractureMesh : _fractureMeshes) delete fractureMesh;
 	_fractureMeshes.clear();
+	_fragmentLabels.clear();
 
 	for (Material* material : _fragmentMaterials) delete material;
 	for (Texture* texture : _fragmentTextures) delete texture;
@@ -577,6 +732,153 @@ void CADScene::eraseFragmentContent()
 	_fragmentTextures.clear();
 }
 
+void CADScene::exportIteration(IterationOutput& output, bool packPointClouds, FragmentArchive* archive)
+{
+	std::vector<std::thread*>& threads = output._threads;
+	unsigned idx = 0;
+	FractureParameters& fractParameters = output._fractParameters;
+	const std::string pointCloudArchiveFile = output._filename + "_p.npz";
+	NumpyFile::NpzArchive pointCloudArchive;
+
+	if (output._grid && fractParameters._exportGrid)
+		this->exportIterationGrid(*output._grid, output, archive);
+
+	if (fractParameters._exportContacts)
+		output._contactGraph.save(output._filename, archive);
+
+	if (fractParameters._exportDescriptors)
+		output._fragmentDescriptors.save(output._filename, archive);
+
+	for (Model3D* fracture : output._meshes)
+	{
+		CADModel* cadModel = dynamic_cast<CADModel*>(fracture);
+		const std::string filename = output._filename + "_" + std::to_string(idx);
+		std::string simplificationFilename;
+
+		// Point clouds
+		if (fractParameters._exportPointCloud)
+		{
+			for (int targetCount : fractParameters._targetPoints)
+			{
+				PointCloud3D* pointCloud = dynamic_cast<CADModel*>(fracture)->sampleCPU(
+					targetCount, fractParameters._pointCloudSeedingRandom, 
+					fractParameters.getRandomStream(RandomStream::POINT_CLOUD_SAMPLING).getSubstream(idx + 1).getSubstream(targetCount));
+				simplificationFilename = filename + "_" + std::to_string(targetCount) + "p";
+
+				#if TESTING_FORMAT_MODE
+				for (int pointCloudFormat = 0; pointCloudFormat < FractureParameters::NUM_POINT_CLOUD_EXTENSIONS; ++pointCloudFormat)
+				{
+					fractParameters._exportPointCloudExtension = static_cast<FractureParameters::ExportPointCloudExtension>(pointCloudFormat);
+				#endif
+					FragmentationProcedure::FragmentMetadata metadata;
+					metadata._type = FragmentationProcedure::POINT_CLOUD;
+					metadata._vesselName = simplificationFilename + "." + FractureParameters::ExportPointCloud_STR[fractParameters._exportPointCloudExtension];
+					metadata._numPoints = pointCloud->getNumPoints();
+
+					if (packPointClouds && fractParameters._exportPointCloudExtension == FractureParameters::NUMPY_POINT_CLOUD)
+					{
+						// Keys of the archive are the filenames without the iteration prefix
+						const std::string key = std::to_string(idx) + "_" + std::to_string(targetCount) + "p";
+						metadata._vesselName = pointCloudArchiveFile + ":" + key;
+						pointCloud->save(pointCloudArchive, key);
+					}
+					else
+						threads.push_back(pointCloud->save(simplificationFilename, static_cast<FractureParameters::ExportPointCloudExtension>(fractParameters._exportPointCloudExtension), archive));
+
+					output._localMetadata.push_back(metadata);
+				#if TESTING_FORMAT_MODE
+				}
+				#endif
+
+				delete pointCloud;
+			}
+		}
+
+		// Triangles
+		if (fractParameters._exportMesh)
+		{
+			if (!fractParameters._targetTriangles.empty())
+			{
+				for (int targetCount : fractParameters._targetTriangles)
+				{
+					cadModel->simplify(targetCount);
+
+					#if TESTING_FORMAT_MODE
+					for (int meshFormat = 0; meshFormat < FractureParameters::NUM_EXPORT_MESH_EXTENSIONS; ++meshFormat)
+					{
+						fractParameters._exportMeshExtension = static_cast<FractureParameters::ExportMeshExtension>(meshFormat);
+					#endif
+						simplificationFilename = filename + "_" + std::to_string(targetCount) + "t";
+
+						output._fragmentMetadata[idx]._vesselName = simplificationFilename + "." + FractureParameters::ExportMesh_STR[fractParameters._exportMeshExtension];
+						output._fragmentMetadata[idx]._numVertices = fracture->getNumVertices();
+						output._fragmentMetadata[idx]._numFaces = fracture->getNumFaces();
+						output._localMetadata.push_back(output._fragmentMetadata[idx]);
+
+						threads.push_back(cadModel->save(simplificationFilename, static_cast<FractureParameters::ExportMeshExtension>(fractParameters._exportMeshExtension), archive));
+					#if TESTING_FORMAT_MODE
+					}
+					#endif
+				}
+			}
+			else
+			{
+				#if TESTING_FORMAT_MODE
+				for (int meshFormat = 0; meshFormat < FractureParameters::NUM_EXPORT_MESH_EXTENSIONS; ++meshFormat)
+				{
+					fractParameters._exportMeshExtension = static_cast<FractureParameters::ExportMeshExtension>(meshFormat);
+				#endif
+					output._fragmentMetadata[idx]._vesselName = filename + "." + FractureParameters::ExportMesh_STR[fractParameters._exportMeshExtension];
+					output._fragmentMetadata[idx]._numVertices = cadModel->getNumVertices();
+					output._fragmentMetadata[idx]._numFaces = cadModel->getNumFaces();
+					output._localMetadata.push_back(output._fragmentMetadata[idx]);
+
+					threads.push_back(cadModel->save(filename, static_cast<FractureParameters::ExportMeshExtension>(fractParameters._exportMeshExtension), archive));
+				#if TESTING_FORMAT_MODE
+				}
+				#endif
+			}
+		}
+
+		++idx;
+	}
+
+	if (!pointCloudArchive.empty())
+	{
+		threads.push_back(new std::thread([npzArchive = std::move(pointCloudArchive), pointCloudArchiveFile, archive]()
+			{
+				if (archive)
+				{
+					std::ostringstream stream(std::ios::out | std::ios::binary);
+					if (npzArchive.write(stream)) archive->append(std::filesystem::path(pointCloudArchiveFile).filename().string(), stream.str());
+				}
+				else
+					npzArchive.write(pointCloudArchiveFile);
+			}));
+	}
+}
+
+void CADScene::exportIterationGrid(RegularGrid& grid, IterationOutput& output, FragmentArchive* archive)
+{
+	FractureParameters& fractParameters = output._fractParameters;
+
+	#if TESTING_FORMAT_MODE
+	for (int gridFormat = 0; gridFormat < FractureParameters::NUM_GRID_EXTENSIONS; ++gridFormat)
+	{
+		fractParameters._exportGridExtension = static_cast<FractureParameters::ExportGrid>(gridFormat);
+		#endif
+		grid.exportGrid(output._filename, true, static_cast<FractureParameters::ExportGrid>(fractParameters._exportGridExtension), archive);
+
+		FragmentationProcedure::FragmentMetadata metadata;
+		metadata._type = FragmentationProcedure::VOXEL;
+		metadata._vesselName = output._filename + "." + FractureParameters::ExportGrid_STR[fractParameters._exportGridExtension];
+		metadata._voxelizationSize = fractParameters._voxelizationSize;
+		output._localMetadata.push_back(metadata);
+	#if TESTING_FORMAT_MODE
+	}
+	#endif
+}
+
 void CADScene::exportMetadata(const std::string& filename, std::vector<FragmentationProcedure::FragmentMetadata>& fragmentSize, const std::string& voxelizationSize)
 {
 	std::ofstream gridOutputStream(filename + voxelizationSize + "_metadata_grid.txt");
@@ -625,34 +927,7 @@ std::string CADScene::fractureModel(FractureParameters& fractParameters)
 {
 	fracturer::DistanceFunction dfunc = static_cast<fracturer::DistanceFunction>(fractParameters._distanceFunction);
 
-	std::vector<uvec4> seeds;
-	if (_impactSeeds.empty())
-	{
-		if (fractParameters._numImpacts == 0)
-		{
-			seeds = fracturer::Seeder::uniform(*_meshGrid, fractParameters._numSeeds, fractParameters._seedingRandom, fracturer::Seeder::OUTER);
-		}
-		else
-		{
-			seeds = fracturer::Seeder::uniform(*_meshGrid, fractParameters._numSeeds, fractParameters._seedingRandom, fracturer::Seeder::OUTER);
-			seeds = fracturer::Seeder::nearSeeds(*_meshGrid, seeds, fractParameters._numImpacts, fractParameters._biasSeeds, fractParameters._biasFocus);
-		}
-	}
-	else
-	{
-		seeds = _impactSeeds;
-		seeds = fracturer::Seeder::nearSeeds(*_meshGrid, seeds, 1, fractParameters._biasSeeds, fractParameters._biasFocus);
-	}
-
-	if (fractParameters._numExtraSeeds > 0)
-	{
-		fracturer::DistanceFunction mergeDFunc = static_cast<fracturer::DistanceFunction>(fractParameters._mergeSeedsDistanceFunction);
-		auto extraSeeds = fracturer::Seeder::uniform(*_meshGrid, fractParameters._numExtraSeeds, fractParameters._seedingRandom, fracturer::Seeder::BOTH);
-		extraSeeds.insert(extraSeeds.begin(), seeds.begin(), seeds.end());
-
-		fracturer::Seeder::mergeSeeds(seeds, extraSeeds, mergeDFunc);
-		seeds.insert(seeds.end(), extraSeeds.begin(), extraSeeds.end());
-	}
+	std::vector<uvec4> seeds = fracturer::Seeder::generateSeeds(*_meshGrid, fractParameters, _impactSeeds, fractParameters._rayImpacts ? this->getMeshBvh() : nullptr);
 
 	if (fractParameters._fractureAlgorithm != FractureParameters::VORONOI)
 	{
@@ -680,7 +955,7 @@ std::string CADScene::fractureModel(FractureParameters& fractParameters)
 	{
 		_meshGrid->erode(static_cast<FractureParameters::ErosionType>(
 			fractParameters._erosionConvolution), fractParameters._erosionSize, fractParameters._erosionIterations,
-			fractParameters._erosionProbability, fractParameters._erosionThreshold);
+			fractParameters._erosionProbability, fractParameters._erosionThreshold, fractParameters.getRandomStream(RandomStream::EROSION_NOISE));
 	}
 	else
 	{
@@ -690,17 +965,12 @@ std::string CADScene::fractureModel(FractureParameters& fractParameters)
 	return "";
 }
 
-void CADScene::launchZipingProcess(const std::string& folder, const std::string& extension)
+const LinearBvh* CADScene::getMeshBvh()
 {
-	// Time sleep	
-	//std::this_thread::sleep_for(std::chrono::seconds(60));
-
-	const std::string currentPath = std::filesystem::current_path().string();
-	const std::string systemUnit = currentPath.substr(0, currentPath.find_first_of("/\\"));
-	const std::string cd = "cd " + currentPath;
-	const std::string command = cd + " && " + systemUnit + " && " + "Bash\\zip.bat " + folder + " " + folder.substr(0, folder.find_first_of("/\\")) + " " + extension + " >nul";
+	if (!_meshBvh)
+		_meshBvh = new LinearBvh(_mesh);
 
-	std::system(command.c_str());	
+	return _meshBvh;
 }
 
 void CADScene::loadDefaultCamera(Camera* camera)
@@ -780,7 +1050,9 @@ void CADScene::loadModels()
 void CADScene::loadModel(const std::string& path)
 {
 	delete _mesh;
+	delete _meshBvh;
 	_mesh = new CADModel(path, true, false);
+	_meshBvh = nullptr;
 	_mesh->load();
 	_mesh->setMaterial(MaterialList::getInstance()->getMaterial(CGAppEnum::MATERIAL_CAD_WHITE));
 
@@ -790,27 +1062,20 @@ void CADScene::loadModel(const std::string& path)
 
 void CADScene::prepareScene(FractureParameters& fractParameters, std::vector<FragmentationProcedure::FragmentMetadata>& fragmentMetadata, FragmentationProcedure* datasetProcedure)
 {
-	_fractureMeshes = _meshGrid->toTriangleMesh(fractParameters, fragmentMetadata);
+	// Crack and original surfaces are told apart by the boundary mask, hence descriptors are measured before undoing it
+	std::vector<vec2> surfaceArea;
+	_fractureMeshes = _meshGrid->toTriangleMesh(fractParameters, fragmentMetadata, _mesh, fractParameters._exportDescriptors ? &surfaceArea : nullptr);
+	if (fractParameters._exportDescriptors)
+		_fragmentDescriptors.build(*_meshGrid, surfaceArea);
 
 	if (fractParameters._renderMesh and !GENERATE_DATASET)
 	{
-		Texture* whiteTexture = TextureList::getInstance()->getTexture(CGAppEnum::TEXTURE_WHITE);
-
 		for (int idx = 0; idx < _fractureMeshes.size(); ++idx)
-		{
-			Material* material = new Material;
-			Texture* kad = new Texture(vec4(ColorUtilities::HSVtoRGB(ColorUtilities::getHueValue(idx), 1.0f, 1.0f), 1.0f));
-			material->setTexture(Texture::KAD_TEXTURE, kad);
-			material->setTexture(Texture::KS_TEXTURE, whiteTexture);
-			material->setShininess(500.0f);
-			_fractureMeshes[idx]->setMaterial(material);
-
-			_fragmentMaterials.push_back(material);
-			_fragmentTextures.push_back(kad);
-		}
+			_fractureMeshes[idx]->setMaterial(this->createFragmentMaterial(idx));
 	}
 
 	_meshGrid->undoMask();
+	_meshGrid->clearDirty();
 
 	if (fractParameters._renderGrid and !GENERATE_DATASET)
 	{
@@ -823,7 +1088,7 @@ void CADScene::prepareScene(FractureParameters& fractParameters, std::vector<Fra
 
 	if (fractParameters._renderPointCloud and !GENERATE_DATASET)
 	{
-		_pointCloud = _mesh->sample(fractParameters._targetPoints.empty() ? 1000 : fractParameters._targetPoints[0], fractParameters._pointCloudSeedingRandom);
+		_pointCloud = _mesh->sample(fractParameters._targetPoints.empty() ? 1000 : fractParameters._targetPoints[0], fractParameters._pointCloudSeedingRandom, fractParameters.getRandomStream(RandomStream::POINT_CLOUD_SAMPLING));
 		_pointCloudRenderer = new DrawPointCloud(_pointCloud);
 
 		std::vector<float> vertexClusterIdx;
@@ -837,6 +1102,134 @@ void CADScene::rebuildGrid(FractureParameters& fractureParameters)
 	_meshGrid->resetFilling();
 }
 
+void CADScene::refractureFragment(const uvec3& voxel)
+{
+	// Meshes are sorted by label after a complete fracture
+	if (_fragmentLabels.size() != _fractureMeshes.size())
+	{
+		GridStatistics statistics;
+		statistics.build(*_meshGrid);
+		_fragmentLabels = statistics.getValues();
+	}
+
+	uvec3 minCell, maxCell;
+	++_fractParameters._iteration;
+	std::vector<uint16_t> labels = _meshGrid->refractureFragment(voxel, _fractParameters._biasSeeds, _fractParameters._biasFocus, _fractParameters.getRandomStream(RandomStream::REFRACTURE), minCell, maxCell);
+	if (labels.size() < 2)
+		return;
+
+	// Other components of the impacted label keep it without being flooded, so meshes and counts cover every voxel of the modified labels
+	GridStatistics statistics;
+	statistics.build(*_meshGrid);
+
+	std::vector<unsigned> voxels(labels.size(), 0);
+	for (const GridStatistics::Label& label : statistics.getLabels())
+	{
+		auto labelIt = std::find(labels.begin(), labels.end(), label._value);
+		if (labelIt == labels.end())
+			continue;
+
+		voxels[labelIt - labels.begin()] = label._voxels;
+		minCell = glm::min(minCell, label._min);
+		maxCell = glm::max(maxCell, label._max);
+	}
+
+	// Boundaries are detected around dirty bricks, hence the untouched components are flagged as well
+	_meshGrid->markDirty(minCell, maxCell);
+	_meshGrid->detectBoundaries(1);
+	std::vector<Model3D*> meshes = _meshGrid->toTriangleMesh(_fractParameters, labels, _mesh, minCell, maxCell);
+	_meshGrid->undoMask();
+	_meshGrid->clearDirty();
+
+	// Replace the mesh of the impacted fragment and append the new ones, leaving the rest untouched
+	for (int idx = 0; idx < labels.size(); ++idx)
+	{
+		size_t meshIdx = std::find(_fragmentLabels.begin(), _fragmentLabels.end(), labels[idx]) - _fragmentLabels.begin();
+		if (meshIdx < _fractureMeshes.size())
+		{
+			delete _fractureMeshes[meshIdx];
+			_fractureMeshes[meshIdx] = meshes[idx];
+		}
+		else
+		{
+			_fragmentLabels.push_back(labels[idx]);
+			_fractureMeshes.push_back(meshes[idx]);
+		}
+
+		if (_fractParameters._renderMesh and !GENERATE_DATASET)
+		{
+			while (_fragmentMaterials.size() <= meshIdx)
+				this->createFragmentMaterial(_fragmentMaterials.size());
+			meshes[idx]->setMaterial(_fragmentMaterials[meshIdx]);
+		}
+	}
+
+	// Metadata of modified fragments, which follows the order of the meshes as in RegularGrid::toTriangleMesh
+	const unsigned occupiedVoxels = statistics.getNumOccupiedVoxels();
+	for (int idx = 0; idx < labels.size(); ++idx)
+	{
+		const unsigned metadataIdx = static_cast<unsigned>(std::find(_fragmentLabels.begin(), _fragmentLabels.end(), labels[idx]) - _fragmentLabels.begin());
+		if (metadataIdx >= _fragmentMetadata.size())
+			_fragmentMetadata.resize(metadataIdx + 1);
+
+		FragmentationProcedure::FragmentMetadata& metadata = _fragmentMetadata[metadataIdx];
+		metadata._type = FragmentationProcedure::MESH;
+		metadata._id = metadataIdx;
+		metadata._voxels = voxels[idx];
+		metadata._occupiedVoxels = occupiedVoxels;
+		metadata._percentage = voxels[idx] / static_cast<float>(occupiedVoxels);
+		metadata._voxelizationSize = _meshGrid->getNumSubdivisions();
+	}
+
+	if (_fractParameters._renderGrid and !GENERATE_DATASET)
+		_aabbRenderer->setColorIndex(_meshGrid->data(), _meshGrid->getNumSubdivisions().x * _meshGrid->getNumSubdivisions().y * _meshGrid->getNumSubdivisions().z);
+
+	if (_pointCloudRenderer)
+	{
+		std::vector<float> vertexClusterIdx;
+		_meshGrid->queryCluster(_pointCloud->getPoints(), vertexClusterIdx);
+		_pointCloudRenderer->getModelComponent(0)->setClusterIdx(vertexClusterIdx);
+	}
+}
+
+void CADScene::recordIteration(IterationOutput& output, DatasetManifest& manifest, FragmentArchive* archive)
+{
+	for (std::thread* thread : output._threads)
+	{
+		if (!thread) continue;
+		thread->join();
+		delete thread;
+	}
+	output._threads.clear();
+
+	// Entries must reach the archive file before the job is taken as finished
+	if (!output._recorded)
+	{
+		if (archive) archive->flush();
+		manifest.record(output._job, output._meshes.size(), output._localMetadata);
+		output._recorded = true;
+	}
+}
+
+CADScene::IterationOutput* CADScene::releaseIteration(const FractureParameters& fractParameters, const std::string& filename, std::vector<FragmentationProcedure::FragmentMetadata>& fragmentMetadata)
+{
+	IterationOutput* output = new IterationOutput;
+	output->_filename = filename;
+	output->_fractParameters = fractParameters;
+	output->_fragmentDescriptors = std::move(_fragmentDescriptors);
+	output->_fragmentMetadata = std::move(fragmentMetadata);
+	output->_grid = nullptr;
+	output->_meshes = std::move(_fractureMeshes);
+	output->_recorded = false;
+
+	fragmentMetadata.clear();
+	_fragmentDescriptors.clear();
+	_fractureMeshes.clear();
+	this->eraseFragmentContent();
+
+	return output;
+}
+
 // [Rendering]
 
 void CADScene::drawAsTriangles(Camera* camera, const mat4& mModel, RenderingParameters* rendParams)
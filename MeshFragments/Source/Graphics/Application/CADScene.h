@@ -1,14 +1,20 @@
 #pragma once
 
+#include "DataStructures/ContactGraph.h"
+#include "DataStructures/FragmentDescriptors.h"
+#include "DataStructures/LinearBvh.h"
 #include "DataStructures/RegularGrid.h"
 #include "Fracturer/FloodFracturer.h"
+#include "Fracturer/IterationScheduler.h"
 #include "Fracturer/NaiveFracturer.h"
 #include "Fracturer/Seeder.h"
 #include "Graphics/Application/SSAOScene.h"
+#include "Graphics/Core/DatasetManifest.h"
 
 class AABBSet;
 class DrawLines;
 class DrawPointCloud;
+class FragmentArchive;
 class FractureParameters;
 class FragmentationProcedure;
 class PointCloud3D;
@@ -50,17 +56,39 @@ protected:
 	const static std::string INTERACTIVE_APP_FOLDER;			//!< Location of the folder where data is saved in the interactive application
 	const static std::string TARGET_PATH;						//!< Location of the default mesh in the file system
 
+protected:
+	/**
+	*	@brief Fragments of a dataset iteration travelling from the extraction to the export stage.
+	*/
+	struct IterationOutput
+	{
+		ContactGraph											_contactGraph;			//!< Contacts between the fragments, if exported
+		std::string												_filename;				//!< Path of the iteration files, without extension
+		FragmentDescriptors										_fragmentDescriptors;	//!< Geometric descriptors of each fragment, if exported
+		std::vector<FragmentationProcedure::FragmentMetadata>	_fragmentMetadata;		//!< Metadata of each fragment mesh
+		FractureParameters										_fractParameters;		//!< Copy of the parameters, as the next iterations modify them
+		RegularGrid*											_grid;					//!< Fractured grid to be exported and given back to the scheduler, if any
+		DatasetManifest::Job									_job;					//!< Job of the iteration within the manifest
+		std::vector<FragmentationProcedure::FragmentMetadata>	_localMetadata;			//!< Metadata of the exported files
+		std::vector<Model3D*>									_meshes;				//!< Fragment meshes
+		bool													_recorded;				//!< Finished job, either by a previous run or once its savers are joined
+		std::vector<std::thread*>								_threads;				//!< Savers of the iteration
+	};
+
 protected:
 	AABBSet*					_aabbRenderer;					//!< Buffer of voxels
 	DrawLines*					_fragmentBoundaries;			//!<
+	FragmentDescriptors			_fragmentDescriptors;			//!< Descriptors of the current fracture meshes, if exported
 	FractureParameters			_fractParameters;				//!< 
 	std::vector<Model3D*>		_fractureMeshes;				//!<
 	std::vector<Material*>		_fragmentMaterials;				//!< Material for each fragment, built with marching cubes
 	FragmentMetadataBuffer		_fragmentMetadata;				//!< Metadata of the current fragmentation procedure
+	std::vector<uint16_t>		_fragmentLabels;				//!< Grid value of each fracture mesh, filled on the first localized impact
 	std::vector<Texture*>		_fragmentTextures;				//!< Texture for each fragment, built with marching cubes
 	bool						_generateDataset;
 	std::vector<uvec4>			_impactSeeds;					//!< Seeds obtained by impacting the user's ray to the voxelization
 	CADModel*					_mesh;							//!< Mesh to be fractured
+	LinearBvh*					_meshBvh;						//!< Hierarchy of the mesh for picking and ray-casted impacts, built on demand
 	RegularGrid*				_meshGrid;						//!< Mesh regular grid
 	PointCloud3D*				_pointCloud;					//!<
 	DrawPointCloud*				_pointCloudRenderer;			//!<
@@ -76,11 +104,26 @@ protected:
 	*/
 	void allocateMeshGrid(FractureParameters& fractParameters);
 
+	/**
+	*	@brief Creates the material of the idx-th fracture mesh.
+	*/
+	Material* createFragmentMaterial(unsigned idx);
+
 	/**
 	*	@brief Erase content from a previous fragmentation process.
 	*/
 	void eraseFragmentContent();
 
+	/**
+	*	@brief Samples, simplifies and saves the fragments of an iteration. Only CPU work is done, so that it can be run out of the OpenGL thread.
+	*/
+	void exportIteration(IterationOutput& output, bool packPointClouds, FragmentArchive* archive);
+
+	/**
+	*	@brief Exports the fractured grid of an iteration.
+	*/
+	void exportIterationGrid(RegularGrid& grid, IterationOutput& output, FragmentArchive* archive);
+
 	/**
 	*	@brief
 	*/
@@ -92,9 +135,9 @@ protected:
 	std::string fractureModel(FractureParameters& fractParameters);
 
 	/**
-	*	@brief Saves the whole folder into another one.
+	*	@return Hierarchy of the loaded mesh, built on the first call after loading it. The geometry of the mesh must not have been released by then.
 	*/
-	void launchZipingProcess(const std::string& folder, const std::string& extension);
+	const LinearBvh* getMeshBvh();
 
 	/**
 	*	@brief Loads a camera with code-defined values.
@@ -136,6 +179,21 @@ protected:
 	*/
 	void rebuildGrid(FractureParameters& fractParameters);
 
+	/**
+	*	@brief Splits the fragment hit at the given voxel, rebuilding only the meshes of the fragments that change.
+	*/
+	void refractureFragment(const uvec3& voxel);
+
+	/**
+	*	@brief Waits for the savers of an iteration and records it as finished in the manifest.
+	*/
+	void recordIteration(IterationOutput& output, DatasetManifest& manifest, FragmentArchive* archive);
+
+	/**
+	*	@brief Moves the fragments of the current iteration out of the scene, so that they can be exported while the next one is fractured.
+	*/
+	IterationOutput* releaseIteration(const FractureParameters& fractParameters, const std::string& filename, std::vector<FragmentationProcedure::FragmentMetadata>& fragmentMetadata);
+
 	// ------------- Rendering ----------------
 
 	/**
@@ -206,6 +264,11 @@ public:
 	*/
 	void exportFragments(const FractureParameters& fractureParameters, const std::string& extension = ".obj");
 
+	/**
+	*	@brief Exports the contacts between the fragments of the current grid.
+	*/
+	void exportContactGraph();
+
 	/**
 	*	@brief
 	*/
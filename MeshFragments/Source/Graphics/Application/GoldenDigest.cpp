@@ -0,0 +1,410 @@
+#include "stdafx.h"
+#include "GoldenDigest.h"
+
+#include "Fracturer/FloodFracturer.h"
+#include "Fracturer/NaiveFracturer.h"
+#include "Fracturer/Seeder.h"
+#include "Geometry/3D/PointCloud3D.h"
+#include "Graphics/Application/StageBenchmark.h"
+#include "Graphics/Core/Voronoi.h"
+#include "Utilities/RandomStream.h"
+
+/// Initialization of static attributes
+const std::vector<std::pair<std::string, std::string>> GoldenDigest::EQUIVALENT_JOBS = {
+	{ "naive_cpu",			"naive_gpu" }
+};
+
+const std::vector<GoldenDigest::Job> GoldenDigest::JOBS = {
+	{ "voronoi",			FractureParameters::VORONOI,	false,	false,	true },
+	{ "naive_cpu",			FractureParameters::NAIVE,		false,	false,	true },
+	{ "naive_gpu",			FractureParameters::NAIVE,		true,	false,	false },
+	{ "flood",				FractureParameters::FLOOD,		true,	false,	false },
+	{ "flood_eroded",		FractureParameters::FLOOD,		true,	true,	false }
+};
+
+// [Public methods]
+
+GoldenDigest::GoldenDigest()
+{
+	_fractParameters._biasSeeds = 0;
+	_fractParameters._metricVoxelization = false;
+	_fractParameters._renderGrid = false;
+	_fractParameters._renderMesh = false;
+	_fractParameters._renderPointCloud = false;
+}
+
+GoldenDigest::~GoldenDigest()
+{
+}
+
+bool GoldenDigest::run(const std::string& folder, const std::string& goldenFile, bool record, bool headless)
+{
+	_entries.clear();
+	_folder = folder;
+	std::filesystem::create_directories(_folder);
+
+	// The tetrahedral voxelization is rendered, hence headless grids are filled conservatively
+	_fractParameters._conservativeVoxelization = headless;
+
+	bool match = true;
+	for (const StageBenchmark::VesselProfile& profile : StageBenchmark::VESSEL_PROFILES)
+	{
+		// Coarser vessels than those of the benchmark keep the jobs small
+		CADModel* model = nullptr;
+		if (headless)
+		{
+			// Loading materials requires an OpenGL context, so the vessel is inserted as is
+			std::vector<vec4> vertices;
+			std::vector<uvec4> faces;
+			StageBenchmark::createVessel(profile, 32, 64, vertices, faces);
+
+			model = new CADModel();
+			model->insert(vertices.data(), static_cast<unsigned>(vertices.size()), faces.data(), static_cast<unsigned>(faces.size()));
+		}
+		else
+		{
+			const std::string filename = _folder + "vessels/" + profile._name + ".obj";
+			if (!StageBenchmark::createVessel(profile, filename, 32, 64))
+				return false;
+
+			model = new CADModel(filename, false, false);
+			model->load();
+		}
+
+		for (const Job& job : JOBS)
+			if (job._headless || !headless)
+				this->runJob(profile._name, model, job, headless);
+
+		delete model;
+
+		for (const auto& equivalentJobs : EQUIVALENT_JOBS)
+			match &= this->compareJobs(profile._name + "_" + equivalentJobs.first, profile._name + "_" + equivalentJobs.second);
+	}
+
+	std::filesystem::remove_all(_folder + "scratch/");
+	writeEntries(_folder + "digests.tsv", _entries);
+
+	if (record)
+	{
+		// A baseline where equivalent jobs disagree would hide the divergence from every later run
+		if (!match)
+		{
+			std::cout << "Golden digests are not recorded, as equivalent jobs diverge" << std::endl;
+			return false;
+		}
+
+		std::filesystem::path goldenPath(goldenFile);
+		if (goldenPath.has_parent_path())
+			std::filesystem::create_directories(goldenPath.parent_path());
+
+		std::cout << "Recording " << _entries.size() << " golden digests in " << goldenFile << std::endl;
+		return writeEntries(goldenFile, _entries);
+	}
+
+	std::vector<Entry> goldenEntries;
+	if (!readEntries(goldenFile, goldenEntries) || goldenEntries.empty())
+	{
+		std::cout << "No golden digests found in " << goldenFile << "; they must be recorded explicitly" << std::endl;
+		return false;
+	}
+
+	match &= compare(goldenEntries, _entries);
+	std::cout << (match ? "Every stage matches the golden digests" : "Some stages diverge from the golden digests") << std::endl;
+
+	return match;
+}
+
+// [Protected methods]
+
+void GoldenDigest::addEntry(const std::string& job, const std::string& stage, const Digest& digest)
+{
+	_entries.push_back(Entry{ job, stage, digest.toString() });
+}
+
+bool GoldenDigest::compare(const std::vector<Entry>& expected, const std::vector<Entry>& found)
+{
+	std::unordered_map<std::string, std::string> expectedDigests, foundDigests;
+	for (const Entry& entry : expected)
+		expectedDigests[entry._job + "\t" + entry._stage] = entry._digest;
+	for (const Entry& entry : found)
+		foundDigests[entry._job + "\t" + entry._stage] = entry._digest;
+
+	// Later stages depend on earlier ones, hence only the first divergence of a job is meaningful
+	std::unordered_set<std::string> divergedJobs;
+	for (const Entry& entry : expected)
+	{
+		if (divergedJobs.find(entry._job) != divergedJobs.end())
+			continue;
+
+		auto digest = foundDigests.find(entry._job + "\t" + entry._stage);
+		if (digest == foundDigests.end() || digest->second != entry._digest)
+		{
+			std::cout << "Job " << entry._job << " first diverges at stage " << entry._stage << ": expected " << entry._digest << ", found "
+				<< (digest == foundDigests.end() ? "nothing" : digest->second) << std::endl;
+			divergedJobs.insert(entry._job);
+		}
+	}
+
+	for (const Entry& entry : found)
+	{
+		if (divergedJobs.find(entry._job) == divergedJobs.end() && expectedDigests.find(entry._job + "\t" + entry._stage) == expectedDigests.end())
+		{
+			std::cout << "Job " << entry._job << " has no golden digest for stage " << entry._stage << std::endl;
+			divergedJobs.insert(entry._job);
+		}
+	}
+
+	return divergedJobs.empty();
+}
+
+bool GoldenDigest::compareJobs(const std::string& job, const std::string& equivalentJob) const
+{
+	std::unordered_map<std::string, std::string> equivalentDigests;
+	for (const Entry& entry : _entries)
+		if (entry._job == equivalentJob)
+			equivalentDigests[entry._stage] = entry._digest;
+
+	// Stages run by a single job, e.g., erosion, are skipped
+	for (const Entry& entry : _entries)
+	{
+		if (entry._job != job)
+			continue;
+
+		auto digest = equivalentDigests.find(entry._stage);
+		if (digest != equivalentDigests.end() && digest->second != entry._digest)
+		{
+			std::cout << "Jobs " << job << " and " << equivalentJob << " first diverge at stage " << entry._stage << ": " << entry._digest << " and " << digest->second << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void GoldenDigest::digestExporter(const std::string& job, const std::string& stage, const std::function<void(const std::string&)>& exporter)
+{
+	const std::string folder = _folder + "scratch/";
+	std::filesystem::remove_all(folder);
+	std::filesystem::create_directories(folder);
+
+	exporter(folder);
+
+	// Directory iteration order is unspecified
+	std::vector<std::filesystem::path> files;
+	for (const auto& file : std::filesystem::directory_iterator(folder))
+		if (file.is_regular_file())
+			files.push_back(file.path());
+	std::sort(files.begin(), files.end());
+
+	Digest digest;
+	for (const std::filesystem::path& file : files)
+	{
+		digest.update(file.filename().string());
+		digest.updateFile(file.string());
+	}
+
+	this->addEntry(job, stage, digest);
+	std::filesystem::remove_all(folder);
+}
+
+void GoldenDigest::digestFragments(const std::string& job, std::vector<Model3D*>& fragments)
+{
+	std::vector<CADModel*> meshes;
+	for (Model3D* fragment : fragments)
+		meshes.push_back(dynamic_cast<CADModel*>(fragment));
+
+	Digest topologyDigest;
+	for (CADModel* mesh : meshes)
+	{
+		for (Model3D::ModelComponent* component : mesh->getModelComponents())
+		{
+			std::unordered_map<uint64_t, unsigned> edges;
+			for (const Model3D::FaceGPUData& face : component->_topology)
+			{
+				for (int i = 0; i < 3; ++i)
+				{
+					const uint64_t v0 = face._vertices[i], v1 = face._vertices[(i + 1) % 3];
+					++edges[(std::min(v0, v1) << 32) | std::max(v0, v1)];
+				}
+			}
+
+			uint32_t numBoundaryEdges = 0, numNonManifoldEdges = 0;
+			for (const auto& edge : edges)
+			{
+				if (edge.second == 1) ++numBoundaryEdges;
+				else if (edge.second > 2) ++numNonManifoldEdges;
+			}
+
+			topologyDigest.update(static_cast<uint32_t>(component->_geometry.size()));
+			topologyDigest.update(static_cast<uint32_t>(component->_topology.size()));
+			topologyDigest.update(static_cast<uint32_t>(edges.size()));
+			topologyDigest.update(numBoundaryEdges);
+			topologyDigest.update(numNonManifoldEdges);
+		}
+	}
+	this->addEntry(job, "mesh_topology", topologyDigest);
+
+	for (int meshFormat = 0; meshFormat < FractureParameters::NUM_EXPORT_MESH_EXTENSIONS; ++meshFormat)
+	{
+		this->digestExporter(job, std::string("export_mesh_") + FractureParameters::ExportMesh_STR[meshFormat], [&](const std::string& folder)
+			{
+				for (int idx = 0; idx < meshes.size(); ++idx)
+				{
+					std::thread* thread = meshes[idx]->save(folder + "fragment_" + std::to_string(idx), static_cast<FractureParameters::ExportMeshExtension>(meshFormat));
+					thread->join();
+					delete thread;
+				}
+			});
+	}
+
+	std::vector<PointCloud3D*> pointClouds;
+	Digest samplingDigest;
+	for (int idx = 0; idx < meshes.size(); ++idx)
+	{
+		pointClouds.push_back(meshes[idx]->sampleCPU(_numSamples, _fractParameters._pointCloudSeedingRandom, _fractParameters.getRandomStream(RandomStream::POINT_CLOUD_SAMPLING).getSubstream(idx + 1)));
+		samplingDigest.update(*pointClouds.back()->getPoints());
+	}
+	this->addEntry(job, "sampling", samplingDigest);
+
+	for (int pointCloudFormat = 0; pointCloudFormat < FractureParameters::NUM_POINT_CLOUD_EXTENSIONS; ++pointCloudFormat)
+	{
+		this->digestExporter(job, std::string("export_point_cloud_") + FractureParameters::ExportPointCloud_STR[pointCloudFormat], [&](const std::string& folder)
+			{
+				for (int idx = 0; idx < pointClouds.size(); ++idx)
+				{
+					// Saving moves the points out of the cloud
+					PointCloud3D copy(*pointClouds[idx]);
+					std::thread* thread = copy.save(folder + "fragment_" + std::to_string(idx), static_cast<FractureParameters::ExportPointCloudExtension>(pointCloudFormat));
+					thread->join();
+					delete thread;
+				}
+			});
+	}
+
+	for (PointCloud3D* pointCloud : pointClouds)
+		delete pointCloud;
+}
+
+Digest GoldenDigest::digestGrid(RegularGrid& grid)
+{
+	const uvec3 numDivs = grid.getNumSubdivisions();
+
+	Digest digest;
+	digest.update(numDivs);
+	digest.update(grid.data(), static_cast<size_t>(numDivs.x) * numDivs.y * numDivs.z * sizeof(RegularGrid::CellGrid));
+
+	return digest;
+}
+
+bool GoldenDigest::readEntries(const std::string& filename, std::vector<Entry>& entries)
+{
+	std::ifstream stream(filename);
+	if (!stream.is_open())
+		return false;
+
+	std::string line;
+	while (std::getline(stream, line))
+	{
+		std::istringstream lineStream(line);
+		Entry entry;
+
+		if (std::getline(lineStream, entry._job, '\t') && std::getline(lineStream, entry._stage, '\t') && std::getline(lineStream, entry._digest))
+			entries.push_back(entry);
+	}
+
+	return true;
+}
+
+void GoldenDigest::runJob(const std::string& modelName, CADModel* model, const Job& job, bool headless)
+{
+	const std::string jobName = modelName + "_" + job._name;
+
+	_fractParameters._erode = job._erode;
+	_fractParameters._fractureAlgorithm = job._fractureAlgorithm;
+	_fractParameters._launchGPU = job._launchGPU;
+	_fractParameters._modelKey = RandomStream::hash(modelName);
+	_fractParameters._numExtraSeeds = _numFragments * 2;
+	_fractParameters._numSeeds = _numFragments;
+	_fractParameters._voxelizationSize = StageBenchmark::getGridDimensions(model->getAABB(), _resolution);
+
+	RegularGrid grid(model->getAABB(), _fractParameters._voxelizationSize, !headless);
+	grid.fill(model, _fractParameters._conservativeVoxelization, _fractParameters._solidVoxelization);
+	if (!headless)
+		grid.resetMarchingCubes();
+	this->addEntry(jobName, "voxelization", digestGrid(grid));
+
+	const std::vector<uvec4> seeds = fracturer::Seeder::generateSeeds(grid, _fractParameters, std::vector<uvec4>());
+	Digest seedDigest;
+	seedDigest.update(seeds);
+	this->addEntry(jobName, "seeding", seedDigest);
+
+	if (job._fractureAlgorithm == FractureParameters::VORONOI)
+	{
+		std::vector<vec3> seeds3;
+		for (const vec4& seed : seeds)
+			seeds3.push_back(seed + vec4(.5f));
+
+		Voronoi voronoi(seeds3);
+		grid.fill(voronoi);
+		grid.updateSSBO();
+	}
+	else
+	{
+		fracturer::Fracturer* fracturer = nullptr;
+		if (job._fractureAlgorithm == FractureParameters::NAIVE)
+			fracturer = fracturer::NaiveFracturer::getInstance();
+		else
+			fracturer = fracturer::FloodFracturer::getInstance();
+
+		fracturer->setDistanceFunction(static_cast<fracturer::DistanceFunction>(_fractParameters._distanceFunction));
+		fracturer->build(grid, seeds, &_fractParameters);
+	}
+	this->addEntry(jobName, "fracture", digestGrid(grid));
+
+	if (job._erode)
+	{
+		grid.erode(static_cast<FractureParameters::ErosionType>(_fractParameters._erosionConvolution), _fractParameters._erosionSize, _fractParameters._erosionIterations,
+			_fractParameters._erosionProbability, _fractParameters._erosionThreshold, _fractParameters.getRandomStream(RandomStream::EROSION_NOISE));
+		this->addEntry(jobName, "erosion", digestGrid(grid));
+	}
+	else if (!headless)
+	{
+		grid.detectBoundaries(1);
+		this->addEntry(jobName, "boundaries", digestGrid(grid));
+	}
+
+	std::vector<FragmentationProcedure::FragmentMetadata> fragmentMetadata;
+	std::vector<Model3D*> fragments = grid.toTriangleMesh(_fractParameters, fragmentMetadata, model);
+	grid.undoMask();
+	grid.clearDirty();
+
+	Digest voxelDigest;
+	for (const FragmentationProcedure::FragmentMetadata& metadata : fragmentMetadata)
+		voxelDigest.update(metadata._voxels);
+	this->addEntry(jobName, "fragment_voxels", voxelDigest);
+
+	for (int gridFormat = 0; gridFormat < FractureParameters::NUM_GRID_EXTENSIONS; ++gridFormat)
+	{
+		this->digestExporter(jobName, std::string("export_grid_") + FractureParameters::ExportGrid_STR[gridFormat], [&](const std::string& folder)
+			{
+				grid.exportGrid(folder + "grid", true, static_cast<FractureParameters::ExportGrid>(gridFormat));
+			});
+	}
+
+	this->digestFragments(jobName, fragments);
+
+	for (Model3D* fragment : fragments)
+		delete fragment;
+}
+
+bool GoldenDigest::writeEntries(const std::string& filename, const std::vector<Entry>& entries)
+{
+	std::ofstream stream(filename);
+	if (!stream.is_open())
+		return false;
+
+	for (const Entry& entry : entries)
+		stream << entry._job << "\t" << entry._stage << "\t" << entry._digest << std::endl;
+
+	return stream.good();
+}
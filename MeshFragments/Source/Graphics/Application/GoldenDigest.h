@@ -0,0 +1,118 @@
+#pragma once
+
+#include "DataStructures/RegularGrid.h"
+#include "Graphics/Core/CADModel.h"
+#include "Graphics/Core/FractureParameters.h"
+#include "Utilities/Digest.h"
+
+/**
+*	@file GoldenDigest.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Runs small fixed-seed fracture jobs over the synthetic vessels of StageBenchmark and hashes the label grid after every stage, the
+*	voxels of each fragment, the topology of the extracted meshes and the bytes written by every exporter. Digests are compared against a golden 
+*	file, reporting the first diverging stage of each job, so that optimized fracturers and writers cannot silently change the dataset. Jobs listed in
+*	EQUIVALENT_JOBS, such as the CPU and GPU naive fracturers, must also produce the same digests as each other at every stage. Headless runs only
+*	execute the CPU-only jobs over vessels built in memory, with no window nor OpenGL context, and are compared against their own golden file.
+*/
+class GoldenDigest
+{
+public:
+	struct Entry
+	{
+		std::string		_job;												//!< Model and algorithm
+		std::string		_stage;												//!< Stage of the job, in execution order
+		std::string		_digest;											//!< Hash of the output of the stage
+	};
+
+	struct Job
+	{
+		std::string		_name;												//!< Unique name within the model
+		int				_fractureAlgorithm;									//!< Algorithm of FractureParameters
+		bool			_launchGPU;											//!< Only used by the naive algorithm
+		bool			_erode;												//!< Erosion instead of boundary detection
+		bool			_headless;											//!< Runs on the CPU only, hence it is also part of headless runs
+	};
+
+	const static std::vector<std::pair<std::string, std::string>> EQUIVALENT_JOBS;	//!< Jobs whose stages must match each other
+	const static std::vector<Job> JOBS;										//!< Jobs run over every model
+
+public:
+	unsigned				_numFragments = 6;								//!< Seeds of every fracture
+	unsigned				_numSamples = 1024;								//!< Points sampled from every fragment
+	int						_resolution = 64;								//!< Maximum subdivisions of the grid
+
+protected:
+	std::vector<Entry>		_entries;										//!< Digests of the current run
+	std::string				_folder;										//!< Destination of generated models, digests and exported files
+	FractureParameters		_fractParameters;								//!< Fixed parameters of every job
+
+protected:
+	/**
+	*	@brief Appends the digest of a stage.
+	*/
+	void addEntry(const std::string& job, const std::string& stage, const Digest& digest);
+
+	/**
+	*	@brief Compares the digests of two entry sets and reports the first diverging stage of every job. Returns true if they match.
+	*/
+	static bool compare(const std::vector<Entry>& expected, const std::vector<Entry>& found);
+
+	/**
+	*	@brief Compares the stages shared by two jobs of the current run and reports the first one where they diverge. Returns true if they match.
+	*/
+	bool compareJobs(const std::string& job, const std::string& equivalentJob) const;
+
+	/**
+	*	@brief Hashes the files written by an exporter into an empty scratch folder, in the order of their names.
+	*/
+	void digestExporter(const std::string& job, const std::string& stage, const std::function<void(const std::string&)>& exporter);
+
+	/**
+	*	@brief Hashes the topology of the fragments, their sampled points and the files of every mesh and point cloud exporter.
+	*/
+	void digestFragments(const std::string& job, std::vector<Model3D*>& fragments);
+
+	/**
+	*	@return Hash of the labels of a grid, boundary mask included.
+	*/
+	static Digest digestGrid(RegularGrid& grid);
+
+	/**
+	*	@brief Reads entries from a tab-separated file. Returns false if it cannot be opened.
+	*/
+	static bool readEntries(const std::string& filename, std::vector<Entry>& entries);
+
+	/**
+	*	@brief Runs a job over a loaded model, hashing every stage. Headless jobs use a CPU-only grid, which skips the stages run by compute shaders
+	*	and only extracts the outer surface of the fragments.
+	*/
+	void runJob(const std::string& modelName, CADModel* model, const Job& job, bool headless);
+
+	/**
+	*	@brief Writes entries into a tab-separated file.
+	*/
+	static bool writeEntries(const std::string& filename, const std::vector<Entry>& entries);
+
+public:
+	/**
+	*	@brief Constructor.
+	*/
+	GoldenDigest();
+
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~GoldenDigest();
+
+	/**
+	*	@brief Runs every job and compares its digests against goldenFile, or records them into it if record is enabled. Digests of the run are also
+	*	written in folder. Returns false if any stage diverges, if equivalent jobs differ or if goldenFile is missing and record is disabled.
+	*	@param headless Only runs the CPU-only jobs, which need no OpenGL context.
+	*/
+	bool run(const std::string& folder, const std::string& goldenFile, bool record = false, bool headless = false);
+};
+
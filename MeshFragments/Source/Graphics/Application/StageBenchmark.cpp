@@ -0,0 +1,505 @@
+#include "stdafx.h"
+#include "StageBenchmark.h"
+
+#include "DataStructures/ContactGraph.h"
+#include "DataStructures/FragmentDescriptors.h"
+#include "DataStructures/GridStatistics.h"
+#include "Fracturer/FloodFracturer.h"
+#include "Fracturer/NaiveFracturer.h"
+#include "Fracturer/Seeder.h"
+#include "Geometry/3D/PointCloud3D.h"
+#include "Graphics/Core/Voronoi.h"
+#include "Utilities/ChronoUtilities.h"
+#include "Utilities/FileManagement.h"
+#include "Utilities/RandomStream.h"
+
+/// Initialization of static attributes
+const std::vector<StageBenchmark::VesselProfile> StageBenchmark::VESSEL_PROFILES = {
+	{ "vessel_jar",		.30f, .45f, .45f, .85f, .28f, .34f, .04f },
+	{ "vessel_amphora",	.12f, .40f, .40f, .80f, .14f, .20f, .035f },
+	{ "vessel_bowl",	.30f, .60f, .60f, .90f, .62f, .65f, .05f },
+	{ "vessel_beaker",	.35f, .30f, .33f, .70f, .36f, .45f, .03f }
+};
+const long StageBenchmark::MEMORY_SAMPLING_MS = 1;
+
+// [Public methods]
+
+StageBenchmark::StageBenchmark() : _baselineWorkingSet(0), _repetition(0), _resolution(0), _sampling(false), _stagePeakWorkingSet(0)
+{
+	_fractParameters._biasSeeds = 0;
+	_fractParameters._metricVoxelization = false;
+	_fractParameters._renderGrid = false;
+	_fractParameters._renderMesh = false;
+	_fractParameters._renderPointCloud = false;
+}
+
+StageBenchmark::~StageBenchmark()
+{
+	_stream.close();
+}
+
+bool StageBenchmark::createVessel(const VesselProfile& profile, const std::string& filename, unsigned numProfileSamples, unsigned numRevolutionSegments)
+{
+	std::filesystem::create_directories(std::filesystem::path(filename).parent_path());
+
+	std::ofstream stream(filename);
+	if (!stream.is_open())
+		return false;
+
+	std::vector<vec4> vertices;
+	std::vector<uvec4> faces;
+	createVessel(profile, numProfileSamples, numRevolutionSegments, vertices, faces);
+
+	for (const vec4& vertex : vertices)
+		stream << "v " << vertex.x << " " << vertex.y << " " << vertex.z << "\n";
+
+	for (const uvec4& face : faces)
+		stream << "f " << face.x + 1 << " " << face.y + 1 << " " << face.z + 1 << "\n";
+
+	return stream.good();
+}
+
+void StageBenchmark::createVessel(const VesselProfile& profile, unsigned numProfileSamples, unsigned numRevolutionSegments, std::vector<vec4>& vertices, std::vector<uvec4>& faces)
+{
+	auto getRadius = [&profile](float height) -> float
+		{
+			if (height < profile._bellyHeight)
+				return glm::mix(profile._baseRadius, profile._bellyRadius, glm::smoothstep(.0f, profile._bellyHeight, height));
+			if (height < profile._neckHeight)
+				return glm::mix(profile._bellyRadius, profile._neckRadius, glm::smoothstep(profile._bellyHeight, profile._neckHeight, height));
+
+			return glm::mix(profile._neckRadius, profile._lipRadius, glm::smoothstep(profile._neckHeight, 1.0f, height));
+		};
+
+	// Closed profile traversed counterclockwise in the (radius, height) plane, so that faces point outwards once revolved around the Y axis
+	std::vector<vec2> profilePoints{ vec2(.0f) };
+	for (unsigned sample = 0; sample <= numProfileSamples; ++sample)
+	{
+		const float height = static_cast<float>(sample) / numProfileSamples;
+		profilePoints.push_back(vec2(getRadius(height), height));
+	}
+
+	for (int sample = numProfileSamples; sample >= 0; --sample)
+	{
+		const float height = glm::mix(profile._thickness, 1.0f, static_cast<float>(sample) / numProfileSamples);
+		profilePoints.push_back(vec2(glm::max(getRadius(height) - profile._thickness, profile._thickness), height));
+	}
+	profilePoints.push_back(vec2(.0f, profile._thickness));
+
+	// Points on the axis are not revolved
+	std::vector<unsigned> firstVertex;
+	for (const vec2& point : profilePoints)
+	{
+		firstVertex.push_back(static_cast<unsigned>(vertices.size()));
+
+		if (point.x == .0f)
+		{
+			vertices.push_back(vec4(.0f, point.y, .0f, 1.0f));
+		}
+		else
+		{
+			for (unsigned segment = 0; segment < numRevolutionSegments; ++segment)
+			{
+				const float angle = glm::two_pi<float>() * segment / numRevolutionSegments;
+				vertices.push_back(vec4(point.x * std::cos(angle), point.y, -point.x * std::sin(angle), 1.0f));
+			}
+		}
+	}
+
+	auto getVertex = [&](size_t pointIdx, unsigned segment) -> unsigned
+		{
+			return firstVertex[pointIdx] + (profilePoints[pointIdx].x == .0f ? 0 : segment % numRevolutionSegments);
+		};
+
+	for (size_t pointIdx = 0; pointIdx + 1 < profilePoints.size(); ++pointIdx)
+	{
+		for (unsigned segment = 0; segment < numRevolutionSegments; ++segment)
+		{
+			const unsigned a0 = getVertex(pointIdx, segment), a1 = getVertex(pointIdx, segment + 1);
+			const unsigned b0 = getVertex(pointIdx + 1, segment), b1 = getVertex(pointIdx + 1, segment + 1);
+
+			// Quads touching the axis collapse into a single triangle
+			if (profilePoints[pointIdx].x != .0f)
+				faces.push_back(uvec4(a0, a1, b1, 0));
+			if (profilePoints[pointIdx + 1].x != .0f)
+				faces.push_back(uvec4(a0, b1, b0, 0));
+		}
+	}
+}
+
+ivec3 StageBenchmark::getGridDimensions(const AABB& aabb, int resolution)
+{
+	const vec3 size = aabb.size();
+	ivec3 gridDims(glm::floor(vec3(resolution) * size / glm::max(size.x, glm::max(size.y, size.z))));
+
+	// Same rounding as the dataset generation, with at least four subdivisions per axis
+	for (int i = 0; i < 3; ++i)
+	{
+		while (gridDims[i] % 4 != 0) ++gridDims[i];
+		while (gridDims[i] % 4 != 0 or gridDims[i] > resolution) --gridDims[i];
+		gridDims[i] = glm::max(gridDims[i], 4);
+	}
+
+	return gridDims;
+}
+
+bool StageBenchmark::run(const std::string& folder, const std::string& realFolder, const std::string& extension)
+{
+	_folder = folder;
+	std::filesystem::create_directories(_folder);
+
+	_stream.open(_folder + "benchmark_" + ChronoUtilities::getCurrentDateTime() + ".csv");
+	if (!_stream.is_open())
+		return false;
+
+	_stream << "model,resolution,repetition,stage,seconds,work,unit,throughput,baseline_working_set_bytes,working_set_bytes,stage_peak_working_set_bytes" << std::endl;
+
+	_fractParameters._numExtraSeeds = _numFragments * 2;
+	_fractParameters._numSeeds = _numFragments;
+
+	std::vector<std::string> models;
+	for (const VesselProfile& profile : VESSEL_PROFILES)
+	{
+		const std::string filename = _folder + "vessels/" + profile._name + ".obj";
+		if (createVessel(profile, filename, _numProfileSamples, _numRevolutionSegments))
+			models.push_back(filename);
+	}
+
+	if (!realFolder.empty() && std::filesystem::exists(realFolder))
+	{
+		std::vector<std::string> realModels;
+		FileManagement::searchFiles(realFolder, extension, realModels);
+		std::sort(realModels.begin(), realModels.end());
+
+		if (realModels.size() > _maxRealModels)
+			realModels.resize(_maxRealModels);
+		models.insert(models.end(), realModels.begin(), realModels.end());
+	}
+
+	for (const std::string& filename : models)
+		this->benchmarkModel(filename);
+
+	std::filesystem::remove_all(_folder + "scratch/");
+	_stream.close();
+
+	return true;
+}
+
+// [Protected methods]
+
+void StageBenchmark::benchmarkFragments(std::vector<Model3D*>& fragments)
+{
+	std::vector<CADModel*> meshes;
+	for (Model3D* fragment : fragments)
+		meshes.push_back(dynamic_cast<CADModel*>(fragment));
+
+	for (int meshFormat = 0; meshFormat < FractureParameters::NUM_EXPORT_MESH_EXTENSIONS; ++meshFormat)
+	{
+		this->measureExporter(std::string("export_mesh_") + FractureParameters::ExportMesh_STR[meshFormat], [&](const std::string& folder)
+			{
+				std::vector<std::thread*> threads;
+				for (int idx = 0; idx < meshes.size(); ++idx)
+					threads.push_back(meshes[idx]->save(folder + "fragment_" + std::to_string(idx), static_cast<FractureParameters::ExportMeshExtension>(meshFormat)));
+
+				for (std::thread* thread : threads)
+				{
+					thread->join();
+					delete thread;
+				}
+			});
+	}
+
+	std::vector<PointCloud3D*> pointClouds;
+	this->measure("sampling", "points", [&]() -> double
+		{
+			double numPoints = .0;
+			for (int idx = 0; idx < meshes.size(); ++idx)
+			{
+				pointClouds.push_back(meshes[idx]->sampleCPU(_numSamples, _fractParameters._pointCloudSeedingRandom, _fractParameters.getRandomStream(RandomStream::POINT_CLOUD_SAMPLING).getSubstream(idx + 1)));
+				numPoints += pointClouds.back()->getNumPoints();
+			}
+
+			return numPoints;
+		});
+
+	for (int pointCloudFormat = 0; pointCloudFormat < FractureParameters::NUM_POINT_CLOUD_EXTENSIONS; ++pointCloudFormat)
+	{
+		// Saving moves the points out of the cloud, so every format writes its own copy
+		std::vector<PointCloud3D*> copies;
+		for (PointCloud3D* pointCloud : pointClouds)
+			copies.push_back(new PointCloud3D(*pointCloud));
+
+		this->measureExporter(std::string("export_point_cloud_") + FractureParameters::ExportPointCloud_STR[pointCloudFormat], [&](const std::string& folder)
+			{
+				std::vector<std::thread*> threads;
+				for (int idx = 0; idx < copies.size(); ++idx)
+					threads.push_back(copies[idx]->save(folder + "fragment_" + std::to_string(idx), static_cast<FractureParameters::ExportPointCloudExtension>(pointCloudFormat)));
+
+				for (std::thread* thread : threads)
+				{
+					thread->join();
+					delete thread;
+				}
+			});
+
+		for (PointCloud3D* copy : copies)
+			delete copy;
+	}
+
+	for (PointCloud3D* pointCloud : pointClouds)
+		delete pointCloud;
+
+	this->measure("simplification", "triangles", [&]() -> double
+		{
+			double numTriangles = .0;
+			for (CADModel* mesh : meshes)
+			{
+				const unsigned numFaces = mesh->getNumFaces();
+				numTriangles += numFaces;
+				mesh->simplify(numFaces / 2);
+			}
+
+			return numTriangles;
+		});
+}
+
+void StageBenchmark::benchmarkGrid(CADModel* model)
+{
+	const ivec3 gridDims = getGridDimensions(model->getAABB(), _resolution);
+	const double numCells = static_cast<double>(gridDims.x) * gridDims.y * gridDims.z;
+	_fractParameters._voxelizationSize = gridDims;
+
+	RegularGrid grid(gridDims);
+	this->measure("voxelization_conservative", "cells", [&]() -> double
+		{
+			grid.setAABB(model->getAABB(), gridDims);
+			grid.fill(model, true, _fractParameters._solidVoxelization);
+			return numCells;
+		});
+
+	this->measure("voxelization", "cells", [&]() -> double
+		{
+			grid.setAABB(model->getAABB(), gridDims);
+			grid.fill(model, false, _fractParameters._solidVoxelization);
+			return numCells;
+		});
+	grid.resetMarchingCubes();
+
+	// Every algorithm splits the grid from the same seeds
+	std::vector<uvec4> seeds;
+	this->measure("seeding", "seeds", [&]() -> double
+		{
+			seeds = fracturer::Seeder::generateSeeds(grid, _fractParameters, std::vector<uvec4>());
+			return static_cast<double>(seeds.size());
+		});
+
+	grid.resetFilling();
+	this->measure("fracture_voronoi", "cells", [&]() -> double
+		{
+			std::vector<vec3> seeds3;
+			for (const vec4& seed : seeds)
+				seeds3.push_back(seed + vec4(.5f));
+
+			Voronoi voronoi(seeds3);
+			grid.fill(voronoi);
+			grid.updateSSBO();
+			return numCells;
+		});
+
+	const fracturer::DistanceFunction dfunc = static_cast<fracturer::DistanceFunction>(_fractParameters._distanceFunction);
+	fracturer::NaiveFracturer* naiveFracturer = fracturer::NaiveFracturer::getInstance();
+	naiveFracturer->setDistanceFunction(dfunc);
+
+	for (bool launchGPU : { false, true })
+	{
+		_fractParameters._launchGPU = launchGPU;
+		grid.resetFilling();
+		this->measure(launchGPU ? "fracture_naive_gpu" : "fracture_naive_cpu", "cells", [&]() -> double
+			{
+				naiveFracturer->build(grid, seeds, &_fractParameters);
+				return numCells;
+			});
+	}
+
+	fracturer::FloodFracturer* floodFracturer = fracturer::FloodFracturer::getInstance();
+	if (floodFracturer->setDistanceFunction(dfunc))
+	{
+		// Buffers are sized for this grid before measuring, as prepareSSBOs() does not release the previous ones
+		floodFracturer->destroy();
+		floodFracturer->prepareSSBOs(&_fractParameters);
+		grid.resetFilling();
+		this->measure("fracture_flood", "cells", [&]() -> double
+			{
+				floodFracturer->build(grid, seeds, &_fractParameters);
+				return numCells;
+			});
+	}
+
+	this->measure("boundaries", "cells", [&]() -> double
+		{
+			grid.detectBoundaries(1);
+			return numCells;
+		});
+
+	std::vector<Model3D*> fragments;
+	std::vector<FragmentationProcedure::FragmentMetadata> fragmentMetadata;
+	std::vector<vec2> surfaceArea;
+	this->measure("marching_cubes", "triangles", [&]() -> double
+		{
+			fragments = grid.toTriangleMesh(_fractParameters, fragmentMetadata, model, &surfaceArea);
+
+			double numTriangles = .0;
+			for (Model3D* fragment : fragments)
+				numTriangles += fragment->getNumFaces();
+
+			return numTriangles;
+		});
+	grid.undoMask();
+	grid.clearDirty();
+
+	ContactGraph contactGraph;
+	this->measure("contact_graph", "cells", [&]() -> double
+		{
+			contactGraph.build(grid);
+			return numCells;
+		});
+
+	GridStatistics statistics;
+	this->measure("label_statistics", "cells", [&]() -> double
+		{
+			statistics.build(grid);
+			return numCells;
+		});
+
+	FragmentDescriptors fragmentDescriptors;
+	this->measure("descriptors", "cells", [&]() -> double
+		{
+			fragmentDescriptors.build(grid, surfaceArea);
+			return numCells;
+		});
+
+	for (int gridFormat = 0; gridFormat < FractureParameters::NUM_GRID_EXTENSIONS; ++gridFormat)
+	{
+		this->measureExporter(std::string("export_grid_") + FractureParameters::ExportGrid_STR[gridFormat], [&](const std::string& folder)
+			{
+				grid.exportGrid(folder + "grid", true, static_cast<FractureParameters::ExportGrid>(gridFormat));
+			});
+	}
+
+	this->measure("erosion", "cells", [&]() -> double
+		{
+			grid.erode(static_cast<FractureParameters::ErosionType>(_fractParameters._erosionConvolution), _fractParameters._erosionSize, _fractParameters._erosionIterations,
+				_fractParameters._erosionProbability, _fractParameters._erosionThreshold, _fractParameters.getRandomStream(RandomStream::EROSION_NOISE));
+			return numCells;
+		});
+
+	this->benchmarkFragments(fragments);
+
+	for (Model3D* fragment : fragments)
+		delete fragment;
+}
+
+void StageBenchmark::benchmarkModel(const std::string& filename)
+{
+	_model = std::filesystem::path(filename).stem().string();
+	_fractParameters._modelKey = RandomStream::hash(_model);
+	_repetition = 0;
+	_resolution = 0;
+
+	CADModel* model = new CADModel(filename, false, false);
+	this->measure("model_load", "triangles", [&]() -> double
+		{
+			model->load();
+			return model->getNumFaces();
+		});
+
+	for (int resolution : _resolutions)
+	{
+		for (unsigned repetition = 0; repetition < _numRepetitions; ++repetition)
+		{
+			std::cout << "Benchmarking " << _model << " at " << resolution << " (" << repetition + 1 << "/" << _numRepetitions << ")" << std::endl;
+
+			_repetition = repetition;
+			_resolution = resolution;
+			this->benchmarkGrid(model);
+		}
+	}
+
+	delete model;
+}
+
+uintmax_t StageBenchmark::getFolderSize(const std::string& folder)
+{
+	uintmax_t size = 0;
+	for (const auto& file : std::filesystem::recursive_directory_iterator(folder))
+		if (file.is_regular_file())
+			size += file.file_size();
+
+	return size;
+}
+
+size_t StageBenchmark::getWorkingSet()
+{
+	PROCESS_MEMORY_COUNTERS_EX pmc;
+	GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&pmc, sizeof(pmc));
+
+	return pmc.WorkingSetSize;
+}
+
+void StageBenchmark::measure(const std::string& stage, const std::string& unit, const std::function<double()>& stageFunction)
+{
+	this->startMemorySampling();
+	ChronoUtilities::initChrono();
+	const double work = stageFunction();
+	glFinish();															// GPU stages are only issued otherwise
+	const double seconds = ChronoUtilities::getDuration(ChronoUtilities::NANOSECONDS) / 1e9;
+	this->stopMemorySampling();
+
+	this->writeMeasurement(stage, unit, seconds, work);
+}
+
+void StageBenchmark::measureExporter(const std::string& stage, const std::function<void(const std::string&)>& stageFunction)
+{
+	const std::string folder = _folder + "scratch/";
+	std::filesystem::remove_all(folder);
+	std::filesystem::create_directories(folder);
+
+	this->startMemorySampling();
+	ChronoUtilities::initChrono();
+	stageFunction(folder);
+	const double seconds = ChronoUtilities::getDuration(ChronoUtilities::NANOSECONDS) / 1e9;
+	this->stopMemorySampling();
+
+	this->writeMeasurement(stage, "bytes", seconds, static_cast<double>(getFolderSize(folder)));
+	std::filesystem::remove_all(folder);
+}
+
+void StageBenchmark::startMemorySampling()
+{
+	_baselineWorkingSet = _stagePeakWorkingSet = getWorkingSet();
+	_sampling = true;
+
+	// Only this thread writes the peak until it is joined
+	_samplingThread = std::thread([this]()
+		{
+			while (_sampling)
+			{
+				_stagePeakWorkingSet = glm::max(_stagePeakWorkingSet, getWorkingSet());
+				std::this_thread::sleep_for(std::chrono::milliseconds(MEMORY_SAMPLING_MS));
+			}
+		});
+}
+
+void StageBenchmark::stopMemorySampling()
+{
+	_sampling = false;
+	_samplingThread.join();
+
+	_stagePeakWorkingSet = glm::max(_stagePeakWorkingSet, getWorkingSet());
+}
+
+void StageBenchmark::writeMeasurement(const std::string& stage, const std::string& unit, double seconds, double work)
+{
+	_stream << _model << "," << _resolution << "," << _repetition << "," << stage << "," << seconds << "," << work << "," << unit << "," 
+		<< (seconds > .0 ? work / seconds : .0) << "," << _baselineWorkingSet << "," << getWorkingSet() << "," << _stagePeakWorkingSet << std::endl;
+}
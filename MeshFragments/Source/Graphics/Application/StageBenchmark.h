@@ -0,0 +1,139 @@
+#pragma once
+
+#include "DataStructures/RegularGrid.h"
+#include "Graphics/Core/CADModel.h"
+#include "Graphics/Core/FractureParameters.h"
+
+/**
+*	@file StageBenchmark.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Measures every stage of the dataset generation (voxelization, seeding, fracture, erosion, boundary detection, marching cubes, 
+*	simplification, sampling and exporters) over several grid resolutions. Inputs are vessels revolved from procedural profiles, so that no data
+*	files are needed, and optionally real models. Each measurement is written as a row of a CSV file with its throughput and the memory of the process:
+*	its working set when the stage starts and ends, and the peak sampled while the stage runs.
+*/
+class StageBenchmark
+{
+public:
+	struct VesselProfile
+	{
+		std::string	_name;													//!< Name of the generated model
+		float		_baseRadius;											//!< Radius at the bottom
+		float		_bellyHeight, _bellyRadius;								//!< Widest section
+		float		_neckHeight, _neckRadius;								//!< Narrowest section
+		float		_lipRadius;												//!< Radius at the top
+		float		_thickness;												//!< Wall thickness, relative to the height
+	};
+
+	const static std::vector<VesselProfile> VESSEL_PROFILES;				//!< Synthetic inputs
+	const static long						MEMORY_SAMPLING_MS;				//!< Interval between samples of the working set while a stage runs
+
+public:
+	unsigned				_maxRealModels = 4;								//!< Models taken from the real dataset, if it is found
+	unsigned				_numFragments = 8;								//!< Seeds of every fracture
+	unsigned				_numProfileSamples = 64;						//!< Samples of each wall of a revolved profile
+	unsigned				_numRepetitions = 3;							//!< Times every model and resolution is measured
+	unsigned				_numRevolutionSegments = 128;					//!< Segments of a revolved profile
+	unsigned				_numSamples = 4096;								//!< Points sampled from every fragment
+	std::vector<int>		_resolutions = { 64, 128, 256, 512 };			//!< Maximum subdivisions of the grid
+
+protected:
+	size_t					_baselineWorkingSet;							//!< Working set when the stage being measured started
+	std::string				_folder;										//!< Destination of generated models, results and exported files
+	FractureParameters		_fractParameters;								//!< Parameters shared by every stage
+	std::string				_model;											//!< Model being measured
+	int						_repetition;									//!< Repetition being measured
+	int						_resolution;									//!< Resolution being measured
+	std::atomic<bool>		_sampling;										//!< The stage being measured is still running
+	std::thread				_samplingThread;								//!< Samples the working set while a stage runs
+	size_t					_stagePeakWorkingSet;							//!< Largest working set sampled during the stage being measured
+	std::ofstream			_stream;										//!< Results
+
+protected:
+	/**
+	*	@brief Loads a model and measures every stage at every resolution.
+	*/
+	void benchmarkModel(const std::string& filename);
+
+	/**
+	*	@brief Measures simplification, sampling and the mesh and point cloud exporters on the fragments of a fracture.
+	*/
+	void benchmarkFragments(std::vector<Model3D*>& fragments);
+
+	/**
+	*	@brief Measures the stages that work on the grid of a model.
+	*/
+	void benchmarkGrid(CADModel* model);
+
+	/**
+	*	@return Total size in bytes of the files within a folder.
+	*/
+	static uintmax_t getFolderSize(const std::string& folder);
+
+	/**
+	*	@return Current working set of the process.
+	*/
+	static size_t getWorkingSet();
+
+	/**
+	*	@brief Runs a stage and writes its row. The stage returns the amount of work it processed, given in unit.
+	*/
+	void measure(const std::string& stage, const std::string& unit, const std::function<double()>& stageFunction);
+
+	/**
+	*	@brief Writes the output of a stage into an empty scratch folder, measures it and removes it. The stage returns nothing, as its work is the 
+	*	number of written bytes.
+	*/
+	void measureExporter(const std::string& stage, const std::function<void(const std::string&)>& stageFunction);
+
+	/**
+	*	@brief Takes the working set as the baseline of a stage and starts sampling it, since the peak of the process would only grow from one stage to the next.
+	*/
+	void startMemorySampling();
+
+	/**
+	*	@brief Stops sampling the working set. Peaks shorter than MEMORY_SAMPLING_MS may be missed.
+	*/
+	void stopMemorySampling();
+
+	/**
+	*	@brief Writes the row of a measured stage.
+	*/
+	void writeMeasurement(const std::string& stage, const std::string& unit, double seconds, double work);
+
+public:
+	/**
+	*	@brief Constructor.
+	*/
+	StageBenchmark();
+
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~StageBenchmark();
+
+	/**
+	*	@brief Writes a revolved profile as a closed OBJ mesh.
+	*/
+	static bool createVessel(const VesselProfile& profile, const std::string& filename, unsigned numProfileSamples, unsigned numRevolutionSegments);
+
+	/**
+	*	@brief Revolves a profile into a closed mesh in memory, with the vertices and faces written into the OBJ file by the overload above.
+	*/
+	static void createVessel(const VesselProfile& profile, unsigned numProfileSamples, unsigned numRevolutionSegments, std::vector<vec4>& vertices, std::vector<uvec4>& faces);
+
+	/**
+	*	@return Dimensions of a grid whose largest side has the given resolution, keeping the aspect of the bounding box.
+	*/
+	static ivec3 getGridDimensions(const AABB& aabb, int resolution);
+
+	/**
+	*	@brief Measures the synthetic vessels and up to _maxRealModels files found in realFolder, writing the results in folder.
+	*/
+	bool run(const std::string& folder, const std::string& realFolder = "", const std::string& extension = ".obj");
+};
+
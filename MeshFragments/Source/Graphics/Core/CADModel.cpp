@@ -11,6 +11,8 @@
 #include "Simplify.h"
 #include "Utilities/FileManagement.h"
 #include "Utilities/ChronoUtilities.h"
+#include "Utilities/FragmentArchive.h"
+#include "Utilities/MeshCodec.h"
 
 // Initialization of static attributes
 std::unordered_map<std::string, std::unique_ptr<Material>> CADModel::_cadMaterials;
@@ -63,19 +65,22 @@ CADModel::~CADModel()
 {
 }
 
-void CADModel::endInsertionBatch(bool releaseMemory)
+void CADModel::endInsertionBatch(bool releaseMemory, bool gpuData)
 {
 #if !GENERATE_DATASET
-	for (ModelComponent* modelComponent : _modelComp)
+	if (gpuData)
 	{
-		this->computeMeshData(modelComponent);
+		for (ModelComponent* modelComponent : _modelComp)
+		{
+			this->computeMeshData(modelComponent);
 
-		modelComponent->buildTriangleMeshTopology();
-		modelComponent->buildWireframeTopology();
-		modelComponent->buildPointCloudTopology();
-	}
+			modelComponent->buildTriangleMeshTopology();
+			modelComponent->buildWireframeTopology();
+			modelComponent->buildPointCloudTopology();
+		}
 
-	this->setVAOData();
+		this->setVAOData();
+	}
 #endif
 
 	for (ModelComponent* modelComponent : _modelComp)
@@ -100,6 +105,9 @@ void CADModel::insert(vec4* vertices, unsigned numVertices, uvec4* faces, unsign
 	for (int idx = 0; idx < numVertices; ++idx)
 		modelComponent->_geometry[baseGeometryIndex + idx] = Model3D::VertexGPUData{ vec3(vertices[idx].x, vertices[idx].y, vertices[idx].z) };
 
+	for (unsigned idx = 0; idx < numVertices; ++idx)
+		_aabb.update(vec3(vertices[idx]));
+
 	unsigned baseTopologyIndex = modelComponent->_topology.size();
 	modelComponent->_topology.resize(modelComponent->_topology.size() + numFaces);
 #pragma omp parallel for
@@ -183,7 +191,7 @@ bool CADModel::load()
 	return true;
 }
 
-PointCloud3D* CADModel::sample(unsigned maxSamples, int randomFunction)
+PointCloud3D* CADModel::sample(unsigned maxSamples, int randomFunction, const RandomStream& stream)
 {
 	PointCloud3D* pointCloud = nullptr;
 
@@ -205,7 +213,7 @@ PointCloud3D* CADModel::sample(unsigned maxSamples, int randomFunction)
 		// Noise to generate randomized points within each triangle
 		std::vector<float> noiseBuffer;
 		unsigned noiseBufferSize = glm::ceil(maxArea / sumArea * maxSamples);
-		fracturer::Seeder::getFloatNoise(noiseBufferSize, noiseBufferSize * 2, randomFunction, noiseBuffer);
+		fracturer::Seeder::getFloatNoise(noiseBufferSize * 2, randomFunction, stream.getSubstream(0), noiseBuffer);
 		const GLuint noiseSSBO = ComputeShader::setReadBuffer(noiseBuffer, GL_STATIC_DRAW);
 
 		if (maxSamples > component->_topology.size())
@@ -222,17 +230,18 @@ PointCloud3D* CADModel::sample(unsigned maxSamples, int randomFunction)
 			numPoints = *ComputeShader::readData(countingSSBO, unsigned());
 			vec4* pointCloudData = ComputeShader::readData(pointCloudSSBO, vec4());
 			pointCloud->push_back(pointCloudData, numPoints);
-			pointCloud->subselect(maxSamples);
+			pointCloud->subselect(maxSamples, stream.getSubstream(2));
 		}
 		else
 		{
 			ComputeShader* shader = ShaderList::getInstance()->getComputeShader(RendEnum::SAMPLER_ALT_SHADER);
 
+			RandomStream faceStream = stream.getSubstream(1);
 			int activeFaces = 0, randomFace;
 			std::vector<uint8_t> activeBuffer(component->_topology.size(), uint8_t(0));
 			while (activeFaces < maxSamples)
 			{
-				randomFace = RandomUtilities::getUniformRandomInt(0, component->_topology.size() - 1);
+				randomFace = faceStream.getUniformRandomInt(0, component->_topology.size() - 1);
 				if (activeBuffer[randomFace] == 0)
 				{
 					activeBuffer[randomFace] = 1;
@@ -261,7 +270,7 @@ PointCloud3D* CADModel::sample(unsigned maxSamples, int randomFunction)
 	return pointCloud;
 }
 
-PointCloud3D* CADModel::sampleCPU(unsigned maxSamples, int randomFunction)
+PointCloud3D* CADModel::sampleCPU(unsigned maxSamples, int randomFunction, const RandomStream& stream)
 {
 	PointCloud3D* pointCloud = nullptr;
 
@@ -270,7 +279,6 @@ PointCloud3D* CADModel::sampleCPU(unsigned maxSamples, int randomFunction)
 		Model3D::ModelComponent* component = _modelComp[0];
 		pointCloud = new PointCloud3D;
 
-		unsigned numPoints = 0;
 		float sumArea = 0.0f, maxArea = .0f;
 		std::vector<float> triangleArea(component->_topology.size());
 		this->getSortedTriangleAreas(component, triangleArea, sumArea, maxArea);
@@ -278,15 +286,13 @@ PointCloud3D* CADModel::sampleCPU(unsigned maxSamples, int randomFunction)
 		// Noise to generate randomized points within each triangle
 		std::vector<float> noiseBuffer;
 		unsigned noiseBufferSize = glm::max(1, static_cast<int>(glm::ceil(maxArea / sumArea * maxSamples)));
-		fracturer::Seeder::getFloatNoise(noiseBufferSize, noiseBufferSize * 2, randomFunction, noiseBuffer);
+		fracturer::Seeder::getFloatNoise(noiseBufferSize * 2, randomFunction, stream.getSubstream(0), noiseBuffer);
 		noiseBufferSize *= 2;
 
-		// Data in common for the two branchs
-		int pointIndex = 0;
-
 		if (maxSamples > component->_topology.size())
 		{
-			std::vector<vec4> newPoint(maxSamples * 2);
+			// Samples of each triangle follow those of the previous triangles, so that the output does not depend on the scheduling of threads
+			std::vector<glm::uint> sampleOffset(component->_topology.size() + 1, 0);
 
 			#pragma omp parallel for
 			for (int index = 0; index < component->_topology.size(); ++index)
@@ -294,19 +300,23 @@ PointCloud3D* CADModel::sampleCPU(unsigned maxSamples, int randomFunction)
 				glm:: vec3 v1 = component->_geometry[component->_topology[index]._vertices.x]._position,
 						   v2 = component->_geometry[component->_topology[index]._vertices.y]._position,
 						   v3 = component->_geometry[component->_topology[index]._vertices.z]._position;
-				vec3 u = v2 - v1, v = v3 - v1;
-				float area = glm::length(glm::cross(u, v)) / 2.0f;
-				glm::uint numTriangleSamples = std::max(int(glm::ceil(area / sumArea * maxSamples)), 1), newPointIndex, end;
+				float area = glm::length(glm::cross(v2 - v1, v3 - v1)) / 2.0f;
+				sampleOffset[index + 1] = std::max(int(glm::ceil(area / sumArea * maxSamples)), 1);
+			}
 
-				#pragma omp critical
-				{
-					newPointIndex = pointIndex;
-					pointIndex += numTriangleSamples;
-				}
+			std::partial_sum(sampleOffset.begin(), sampleOffset.end(), sampleOffset.begin());
+			const glm::uint numPoints = sampleOffset.back();
+			std::vector<vec4> newPoint(numPoints);
 
-				end = newPointIndex + numTriangleSamples;
+			#pragma omp parallel for
+			for (int index = 0; index < component->_topology.size(); ++index)
+			{
+				glm:: vec3 v1 = component->_geometry[component->_topology[index]._vertices.x]._position,
+						   v2 = component->_geometry[component->_topology[index]._vertices.y]._position,
+						   v3 = component->_geometry[component->_topology[index]._vertices.z]._position;
+				vec3 u = v2 - v1, v = v3 - v1;
 
-				for (int i = newPointIndex; i < end; i++)
+				for (int i = sampleOffset[index]; i < sampleOffset[index + 1]; i++)
 				{
 					vec2 randomFactors = vec2(noiseBuffer[i % noiseBufferSize], noiseBuffer[(i + 1) % noiseBufferSize]);
 					if ((randomFactors.x + randomFactors.y) >= 1.0f)
@@ -317,20 +327,18 @@ PointCloud3D* CADModel::sampleCPU(unsigned maxSamples, int randomFunction)
 				}
 			}
 
-			newPoint.resize(pointIndex);
 			pointCloud->push_back(newPoint.data(), newPoint.size());
-			if (pointIndex > maxSamples) pointCloud->subselect(maxSamples);
+			if (numPoints > maxSamples) pointCloud->subselect(maxSamples, stream.getSubstream(2));
 		}
 		else
 		{
-			std::vector<vec4> newPoint(maxSamples);
-
 			// Randomly select which faces are active
+			RandomStream faceStream = stream.getSubstream(1);
 			int activeFaces = 0, randomFace;
 			std::vector<uint8_t> activeBuffer(component->_topology.size(), uint8_t(0));
 			while (activeFaces < maxSamples)
 			{
-				randomFace = RandomUtilities::getUniformRandomInt(0, component->_topology.size() - 1);
+				randomFace = faceStream.getUniformRandomInt(0, component->_topology.size() - 1);
 				if (activeBuffer[randomFace] == 0)
 				{
 					activeBuffer[randomFace] = 1;
@@ -338,27 +346,29 @@ PointCloud3D* CADModel::sampleCPU(unsigned maxSamples, int randomFunction)
 				}
 			}
 
-			#pragma omp parallel for
-			for (int index = 0; index < component->_topology.size(); ++index)
-			{
+			// Points are stored in the order of their faces
+			std::vector<unsigned> activeFaceIdx;
+			for (unsigned index = 0; index < activeBuffer.size(); ++index)
 				if (activeBuffer[index] != uint8_t(0))
-				{
-					vec3 v1 = component->_geometry[component->_topology[index]._vertices.x]._position,
-						v2 = component->_geometry[component->_topology[index]._vertices.y]._position,
-						v3 = component->_geometry[component->_topology[index]._vertices.z]._position;
-					vec3 u = v2 - v1, v = v3 - v1;
-					glm::uint newPointIndex;
+					activeFaceIdx.push_back(index);
 
-					#pragma omp critical
-					newPointIndex = pointIndex++;
+			std::vector<vec4> newPoint(activeFaceIdx.size());
 
-					vec2 randomFactors = vec2(noiseBuffer[index % noiseBufferSize], noiseBuffer[(index + 1) % noiseBufferSize]);
-					if (randomFactors.x + randomFactors.y >= 1.0f)
-						randomFactors = 1.0f - randomFactors;
+			#pragma omp parallel for
+			for (int pointIdx = 0; pointIdx < activeFaceIdx.size(); ++pointIdx)
+			{
+				const unsigned index = activeFaceIdx[pointIdx];
+				vec3 v1 = component->_geometry[component->_topology[index]._vertices.x]._position,
+					v2 = component->_geometry[component->_topology[index]._vertices.y]._position,
+					v3 = component->_geometry[component->_topology[index]._vertices.z]._position;
+				vec3 u = v2 - v1, v = v3 - v1;
 
-					vec3 point = v1 + u * randomFactors.x + v * randomFactors.y;
-					newPoint[newPointIndex] = vec4(point, 1.0f);
-				}
+				vec2 randomFactors = vec2(noiseBuffer[index % noiseBufferSize], noiseBuffer[(index + 1) % noiseBufferSize]);
+				if (randomFactors.x + randomFactors.y >= 1.0f)
+					randomFactors = 1.0f - randomFactors;
+
+				vec3 point = v1 + u * randomFactors.x + v * randomFactors.y;
+				newPoint[pointIdx] = vec4(point, 1.0f);
 			}
 
 			pointCloud->push_back(newPoint.data(), newPoint.size());
@@ -368,16 +378,16 @@ PointCloud3D* CADModel::sampleCPU(unsigned maxSamples, int randomFunction)
 	return pointCloud;
 }
 
-std::thread* CADModel::save(const std::string& filename, FractureParameters::ExportMeshExtension meshExtension)
+std::thread* CADModel::save(const std::string& filename, FractureParameters::ExportMeshExtension meshExtension, FragmentArchive* archive)
 {
 	const std::string meshExtensionStr = FractureParameters::ExportMesh_STR[meshExtension];
 	std::thread* thread = nullptr;
 	Model3D::ModelComponent* component = _modelComp[0]->copyComponent(!TESTING_FORMAT_MODE && !GENERATE_DATASET);
 
 	if (meshExtension == FractureParameters::ExportMeshExtension::BINARY_MESH)
-		thread = new std::thread(&CADModel::saveBinary, this, filename + "." + meshExtensionStr, component);
+		thread = new std::thread(&CADModel::saveBinary, this, filename + "." + meshExtensionStr, component, archive);
 	else
-		thread = new std::thread(&CADModel::saveAssimp, this, filename + "." + meshExtensionStr, meshExtensionStr, component);
+		thread = new std::thread(&CADModel::saveAssimp, this, filename + "." + meshExtensionStr, meshExtensionStr, component, archive);
 
 	return thread;
 }
@@ -782,7 +792,7 @@ void CADModel::remapVertices(Model3D::ModelComponent* modelComponent, std::vecto
 	}
 }
 
-void CADModel::saveAssimp(const std::string& filename, const std::string& extension, Model3D::ModelComponent* component)
+void CADModel::saveAssimp(const std::string& filename, const std::string& extension, Model3D::ModelComponent* component, FragmentArchive* archive)
 {
 	aiScene* scene = new aiScene;
 	scene->mRootNode = new aiNode();
@@ -830,28 +840,38 @@ void CADModel::saveAssimp(const std::string& filename, const std::string& extens
 	}
 
 	Assimp::Exporter exporter;
-	exporter.Export(scene, extension, filename);
+	if (archive)
+	{
+		// Only the main blob is kept, e.g. .mtl files are not needed for fragments
+		const aiExportDataBlob* blob = exporter.ExportToBlob(scene, extension);
+		if (blob) archive->append(std::filesystem::path(filename).filename().string(), static_cast<const char*>(blob->data), blob->size);
+	}
+	else
+		exporter.Export(scene, extension, filename);
 
 	delete component;
 	delete scene;
 }
 
-void CADModel::saveBinary(const std::string& filename, Model3D::ModelComponent* component)
+void CADModel::saveBinary(const std::string& filename, Model3D::ModelComponent* component, FragmentArchive* archive)
 {
-	std::ofstream fout(filename, std::ios::out | std::ios::binary);
-	if (!fout.is_open())
-		return;
-
-	const uint32_t numVertices = component->_geometry.size();
-	fout.write((char*)&numVertices, sizeof(uint32_t));
-	if (numVertices) fout.write((char*)&component->_geometry[0], numVertices * sizeof(Model3D::VertexGPUData));
-
-	const uint32_t numTriangles = component->_topology.size();
-	fout.write((char*)&numTriangles, sizeof(uint32_t));
-	if (numTriangles) fout.write((char*)&component->_topology[0], numTriangles * sizeof(Model3D::FaceGPUData));
+	if (archive)
+	{
+		std::ostringstream stream(std::ios::out | std::ios::binary);
+		this->writeComponent(stream, component);
+		archive->append(std::filesystem::path(filename).filename().string(), stream.str());
+	}
+	else
+	{
+		std::ofstream fout(filename, std::ios::out | std::ios::binary);
+		if (fout.is_open())
+		{
+			this->writeComponent(fout, component);
+			fout.close();
+		}
+	}
 
 	delete component;
-	fout.close();
 }
 
 bool CADModel::writeBinary(const std::string& path)
@@ -918,4 +938,14 @@ bool CADModel::writeBinary(const std::string& path)
 	fout.close();
 
 	return true;
-}
\ No newline at end of file
+}
+
+void CADModel::writeComponent(std::ostream& stream, Model3D::ModelComponent* component)
+{
+	// Normals are only worth storing if the component has them
+	const bool includeNormals = std::any_of(component->_geometry.begin(), component->_geometry.end(), [](const Model3D::VertexGPUData& vertex) { return vertex._normal != vec3(.0f); });
+	std::vector<char> data;
+
+	MeshCodec::encode(component, includeNormals, data);
+	stream.write(data.data(), data.size());
+}
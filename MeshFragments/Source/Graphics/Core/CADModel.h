@@ -9,6 +9,8 @@
 #include "Geometry/3D/Triangle3D.h"
 #include "Graphics/Core/Model3D.h"
 
+class FragmentArchive;
+
 /**
 *	@file CADModel.h
 *	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
@@ -84,14 +86,14 @@ protected:
 	void remapVertices(Model3D::ModelComponent* modelComponent, std::vector<int>& mapping);
 
 	/**
-	*	@brief Saves current model using assimp.
+	*	@brief Saves current model using assimp. If an archive is given, the model is appended to it as an entry named after the file.
 	*/
-	void saveAssimp(const std::string& filename, const std::string& extension, Model3D::ModelComponent* component);
+	void saveAssimp(const std::string& filename, const std::string& extension, Model3D::ModelComponent* component, FragmentArchive* archive);
 
 	/**
-	*	@brief Saves current model using the binary writer of C++.
+	*	@brief Saves current model using the binary writer of C++. If an archive is given, the model is appended to it as an entry named after the file.
 	*/
-	void saveBinary(const std::string& filename, Model3D::ModelComponent* component);
+	void saveBinary(const std::string& filename, Model3D::ModelComponent* component, FragmentArchive* archive);
 
 	/**
 	*	@brief Writes the model to a binary file in order to fasten the following executions.
@@ -99,6 +101,11 @@ protected:
 	*/
 	bool writeBinary(const std::string& path);
 
+	/**
+	*	@brief Writes a component into a stream with the layout of .binm files (see MeshCodec).
+	*/
+	void writeComponent(std::ostream& stream, Model3D::ModelComponent* component);
+
 public:
 	/**
 	*	@brief CADModel constructor.
@@ -129,9 +136,9 @@ public:
 	virtual ~CADModel();
 
 	/**
-	*	@brief Sends geometry & topology to GPU.
+	*	@brief Sends geometry & topology to GPU, unless gpuData is disabled, e.g., with no OpenGL context.
 	*/
-	void endInsertionBatch(bool releaseMemory = true);
+	void endInsertionBatch(bool releaseMemory = true, bool gpuData = true);
 
 	/**
 	*	@return Bounding box of the model.
@@ -144,7 +151,7 @@ public:
 	std::string getShortName() const;
 
 	/**
-	*	@brief Appends new geometry & topology.
+	*	@brief Appends new geometry & topology, growing the bounding box of the model.
 	*/
 	void insert(vec4* vertices, unsigned numVertices, uvec4* faces, unsigned numFaces, bool updateIndices = true);
 
@@ -161,19 +168,20 @@ public:
 	CADModel& operator=(const CADModel& model) = delete;
 
 	/**
-	*	@brief Samples the mesh as a set of points.
+	*	@brief Samples the mesh as a set of points. Noise, active faces and subselection are drawn from substreams of stream.
 	*/
-	PointCloud3D* sample(unsigned maxSamples, int randomFunction);
+	PointCloud3D* sample(unsigned maxSamples, int randomFunction, const RandomStream& stream);
 
 	/**
-	*	@brief Samples the mesh as a set of points.
+	*	@brief Samples the mesh as a set of points. The result only depends on the stream, not on the number of threads.
 	*/
-	PointCloud3D* sampleCPU(unsigned maxSamples, int randomFunction);
+	PointCloud3D* sampleCPU(unsigned maxSamples, int randomFunction, const RandomStream& stream);
 
 	/**
 	*	@brief Saves the model using assimp.
+	*	@param archive If not null, the model is appended to it instead of being written as a separate file.
 	*/
-	std::thread* save(const std::string& filename, FractureParameters::ExportMeshExtension meshExtension);
+	std::thread* save(const std::string& filename, FractureParameters::ExportMeshExtension meshExtension, FragmentArchive* archive = nullptr);
 
 	/**
 	*	@brief
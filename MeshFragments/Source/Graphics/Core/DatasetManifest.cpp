@@ -0,0 +1,243 @@
+#include "stdafx.h"
+#include "DatasetManifest.h"
+
+#include "Utilities/RandomStream.h"
+
+#include <io.h>
+
+/// Initialization of static attributes
+const std::string DatasetManifest::JOBS_EXTENSION = ".jobs";
+const std::string DatasetManifest::JOURNAL_EXTENSION = ".journal";
+
+// [Public methods]
+
+DatasetManifest::DatasetManifest() : _journal(nullptr), _numShards(1), _shardIdx(0)
+{
+}
+
+DatasetManifest::~DatasetManifest()
+{
+	if (_journal) fclose(_journal);
+}
+
+bool DatasetManifest::getRecord(const std::string& model, int numFragments, int iteration, Record& record) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	auto completedJob = _completedJobs.find(getJobKey(model, numFragments, iteration));
+	if (completedJob == _completedJobs.end())
+		return false;
+
+	record = completedJob->second;
+
+	return true;
+}
+
+bool DatasetManifest::isAssigned(const std::string& model) const
+{
+	return RandomStream::hash(model) % _numShards == _shardIdx;
+}
+
+bool DatasetManifest::isCompleted(const std::string& model) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _completedModels.find(model) != _completedModels.end();
+}
+
+bool DatasetManifest::isRecorded(const std::string& model, int numFragments, int iteration) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _completedJobs.find(getJobKey(model, numFragments, iteration)) != _completedJobs.end();
+}
+
+bool DatasetManifest::isStarted(const std::string& model) const
+{
+	const std::string prefix = model + "\t";
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (const auto& record : _completedJobs)
+		if (record.first.compare(0, prefix.size(), prefix) == 0)
+			return true;
+
+	return false;
+}
+
+bool DatasetManifest::open(const std::string& folder, unsigned shardIdx, unsigned numShards, bool resume)
+{
+	if (_journal) fclose(_journal);
+	_journal = nullptr;
+	_completedJobs.clear();
+	_completedModels.clear();
+
+	_numShards = glm::max(numShards, 1u);
+	_shardIdx = shardIdx % _numShards;
+	_filename = folder + "shard_" + std::to_string(_shardIdx) + "_" + std::to_string(_numShards);
+
+	if (!std::filesystem::exists(folder)) std::filesystem::create_directories(folder);
+
+	if (resume)
+	{
+		for (auto& file : std::filesystem::directory_iterator(folder))
+			if (file.path().extension() == JOURNAL_EXTENSION)
+				this->readJournal(file.path().string());
+	}
+	else
+		std::filesystem::remove(_filename + JOURNAL_EXTENSION);
+
+	if (fopen_s(&_journal, (_filename + JOURNAL_EXTENSION).c_str(), "ab") != 0)
+		_journal = nullptr;
+
+	return _journal != nullptr;
+}
+
+bool DatasetManifest::record(const Job& job, size_t numFragments, const std::vector<FragmentationProcedure::FragmentMetadata>& metadata)
+{
+	std::ostringstream block;
+	block << "job\t" << job._model << "\t" << job._numFragments << "\t" << job._iteration << "\t" << numFragments << "\t" << metadata.size() << "\n";
+
+	// The union is written through its widest member, which also holds the number of points
+	for (const FragmentationProcedure::FragmentMetadata& fragment : metadata)
+	{
+		block << fragment._type << "\t" << fragment._vesselName << "\t" <<
+			fragment._voxelizationSize.x << "\t" << fragment._voxelizationSize.y << "\t" << fragment._voxelizationSize.z << "\t" <<
+			fragment._id << "\t" << fragment._numVertices << "\t" << fragment._numFaces << "\t" << fragment._occupiedVoxels << "\t" <<
+			fragment._percentage << "\t" << fragment._voxels << "\n";
+	}
+
+	if (!this->writeBlock(block.str()))
+		return false;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_completedJobs[getJobKey(job._model, job._numFragments, job._iteration)] = Record{ metadata, numFragments };
+
+	return true;
+}
+
+bool DatasetManifest::record(const std::string& model)
+{
+	if (!this->writeBlock("model\t" + model + "\n"))
+		return false;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_completedModels.insert(model);
+
+	return true;
+}
+
+bool DatasetManifest::writeJobs(const std::vector<Job>& jobs)
+{
+	const std::string filename = _filename + JOBS_EXTENSION, tempFilename = filename + ".tmp";
+
+	std::ostringstream stream;
+	stream << "Model\tFragments\tIteration" << std::endl;
+	for (const Job& job : jobs)
+		stream << job._model << "\t" << job._numFragments << "\t" << job._iteration << "\n";
+
+	FILE* file;
+	if (fopen_s(&file, tempFilename.c_str(), "w") != 0) return false;
+
+	const bool success = persist(file, stream.str());
+	if (fclose(file) != 0 || !success) return false;
+
+	// Renaming replaces the previous manifest at once, so that it is never seen half-written
+	std::error_code error;
+	std::filesystem::rename(tempFilename, filename, error);
+
+	return !error;
+}
+
+// [Protected methods]
+
+std::string DatasetManifest::getJobKey(const std::string& model, int numFragments, int iteration)
+{
+	return model + "\t" + std::to_string(numFragments) + "\t" + std::to_string(iteration);
+}
+
+bool DatasetManifest::persist(FILE* file, const std::string& content)
+{
+	if (fwrite(content.data(), 1, content.size(), file) != content.size() || fflush(file) != 0)
+		return false;
+
+	return _commit(_fileno(file)) == 0;
+}
+
+void DatasetManifest::readJournal(const std::string& filename)
+{
+	std::ifstream stream(filename, std::ios::in | std::ios::binary);
+	if (stream.fail()) return;
+
+	std::string line, block;
+	std::vector<std::string> lines;
+
+	while (std::getline(stream, line))
+	{
+		if (line.compare(0, 4, "end\t") != 0)
+		{
+			// A header discards the lines of a block torn by a crash
+			if (line.compare(0, 4, "job\t") == 0 || line.compare(0, 6, "model\t") == 0)
+			{
+				lines.clear();
+				block.clear();
+			}
+
+			lines.push_back(line);
+			block += line + "\n";
+			continue;
+		}
+
+		// Blocks whose checksum does not match are ignored
+		const unsigned crc = lodepng_crc32(reinterpret_cast<const unsigned char*>(block.data()), block.size());
+		if (!lines.empty() && std::to_string(crc) == line.substr(4))
+		{
+			std::istringstream header(lines[0]);
+			std::string type, model;
+			std::getline(header, type, '\t');
+			std::getline(header, model, '\t');
+
+			if (type == "model")
+			{
+				_completedModels.insert(model);
+			}
+			else if (type == "job")
+			{
+				int numFragments, iteration;
+				size_t numMetadata;
+				Record record;
+				header >> numFragments >> iteration >> record._numFragments >> numMetadata;
+
+				for (size_t metadataIdx = 1; metadataIdx <= numMetadata && metadataIdx < lines.size(); ++metadataIdx)
+				{
+					std::istringstream fields(lines[metadataIdx]);
+					FragmentationProcedure::FragmentMetadata fragment;
+					int fragmentType;
+
+					fields >> fragmentType;
+					fields.ignore(1);
+					std::getline(fields, fragment._vesselName, '\t');
+					fields >> fragment._voxelizationSize.x >> fragment._voxelizationSize.y >> fragment._voxelizationSize.z >>
+						fragment._id >> fragment._numVertices >> fragment._numFaces >> fragment._occupiedVoxels >> fragment._percentage >> fragment._voxels;
+					fragment._type = static_cast<FragmentationProcedure::FragmentType>(fragmentType);
+
+					record._metadata.push_back(fragment);
+				}
+
+				if (record._metadata.size() == numMetadata)
+					_completedJobs[getJobKey(model, numFragments, iteration)] = std::move(record);
+			}
+		}
+
+		lines.clear();
+		block.clear();
+	}
+}
+
+bool DatasetManifest::writeBlock(const std::string& block)
+{
+	const unsigned crc = lodepng_crc32(reinterpret_cast<const unsigned char*>(block.data()), block.size());
+	const std::string content = block + "end\t" + std::to_string(crc) + "\n";
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_journal) return false;
+
+	return persist(_journal, content);
+}
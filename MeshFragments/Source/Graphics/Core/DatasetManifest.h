@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Graphics/Core/FragmentationProcedure.h"
+
+/**
+*	@file DatasetManifest.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Persistent state of a dataset run, so that it can be resumed after a crash and split into shards run by different processes. Models
+*	are assigned to shards by hashing their name. The jobs of a shard are listed in a manifest, whereas finished jobs and models are appended to 
+*	a journal as blocks closed by a checksum, so that a block torn by a crash is ignored when the journal is read back.
+*/
+class DatasetManifest
+{
+public:
+	const static std::string JOBS_EXTENSION;								//!< File extension of job manifests
+	const static std::string JOURNAL_EXTENSION;								//!< File extension of completion journals
+
+	struct Job
+	{
+		std::string				_model;										//!< Short name of the model
+		int						_numFragments;								//!< Number of seeds
+		int						_iteration;									//!< Iteration within the number of fragments
+	};
+
+	struct Record
+	{
+		std::vector<FragmentationProcedure::FragmentMetadata>	_metadata;		//!< Metadata of the exported files
+		size_t													_numFragments;	//!< Number of extracted fragments
+	};
+
+protected:
+	std::unordered_map<std::string, Record>	_completedJobs;					//!< Finished jobs, indexed by getJobKey()
+	std::unordered_set<std::string>			_completedModels;				//!< Models whose jobs and metadata are written
+	std::string								_filename;						//!< Path of the files of this shard, without extension
+	FILE*									_journal;						//!< Completion journal of this shard
+	mutable std::mutex						_mutex;							//!< Records are written by the export thread while the main thread queries them
+	unsigned								_numShards;						//!< Number of processes the run is split into
+	unsigned								_shardIdx;						//!< Shard of this process
+
+protected:
+	/**
+	*	@return Unique key of a job.
+	*/
+	static std::string getJobKey(const std::string& model, int numFragments, int iteration);
+
+	/**
+	*	@brief Writes the content and forces it to disk before returning, so that it survives a crash of the system and not only of the process.
+	*/
+	static bool persist(FILE* file, const std::string& content);
+
+	/**
+	*	@brief Loads the valid blocks of a journal.
+	*/
+	void readJournal(const std::string& filename);
+
+	/**
+	*	@brief Appends a block to the journal and forces it to disk.
+	*/
+	bool writeBlock(const std::string& block);
+
+public:
+	/**
+	*	@brief Default constructor.
+	*/
+	DatasetManifest();
+
+	/**
+	*	@brief Destructor.
+	*/
+	virtual ~DatasetManifest();
+
+	/**
+	*	@brief Copies the record of a finished job. Thread-safe.
+	*	@return False if the job must be run.
+	*/
+	bool getRecord(const std::string& model, int numFragments, int iteration, Record& record) const;
+
+	/**
+	*	@return True if the model belongs to the shard of this process.
+	*/
+	bool isAssigned(const std::string& model) const;
+
+	/**
+	*	@return True if every job of the model was finished and its metadata was written. Thread-safe.
+	*/
+	bool isCompleted(const std::string& model) const;
+
+	/**
+	*	@return True if the job was finished. Thread-safe.
+	*/
+	bool isRecorded(const std::string& model, int numFragments, int iteration) const;
+
+	/**
+	*	@return True if any job of the model was finished. Thread-safe.
+	*/
+	bool isStarted(const std::string& model) const;
+
+	/**
+	*	@brief Opens the journal of a shard within the given folder. If resuming, the journals of every shard are read, so that finished work is
+	*	kept even if the number of shards changes; otherwise, the journal of this shard is discarded.
+	*/
+	bool open(const std::string& folder, unsigned shardIdx, unsigned numShards, bool resume);
+
+	/**
+	*	@brief Records a finished job. Thread-safe.
+	*/
+	bool record(const Job& job, size_t numFragments, const std::vector<FragmentationProcedure::FragmentMetadata>& metadata);
+
+	/**
+	*	@brief Records a finished model. Thread-safe.
+	*/
+	bool record(const std::string& model);
+
+	/**
+	*	@brief Writes the jobs of this shard, replacing any previous manifest at once.
+	*/
+	bool writeJobs(const std::vector<Job>& jobs);
+};
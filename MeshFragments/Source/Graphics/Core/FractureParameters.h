@@ -1,6 +1,7 @@
 #pragma once
 
 #include "stdafx.h"
+#include "Utilities/RandomStream.h"
 
 /**
 *	@file FractureParameters.h
@@ -33,17 +34,19 @@ public:
 	enum ExportMeshExtension { OBJ, STL, BINARY_MESH, NUM_EXPORT_MESH_EXTENSIONS };
 	inline static const char* ExportMesh_STR[NUM_EXPORT_MESH_EXTENSIONS] = { "obj", "stl", "binm" };
 
-	enum ExportGrid { RLE, QUADSTACK, VOX, UNCOMPRESSED_BINARY, NUM_GRID_EXTENSIONS };
-	inline static const char* ExportGrid_STR[NUM_GRID_EXTENSIONS] = { "rle", "qstack", "vox", "bing"};
+	enum ExportGrid { RLE, QUADSTACK, VOX, UNCOMPRESSED_BINARY, NUMPY_GRID, NUM_GRID_EXTENSIONS };
+	inline static const char* ExportGrid_STR[NUM_GRID_EXTENSIONS] = { "rle", "qstack", "vox", "bing", "npy" };
 
-	enum ExportPointCloudExtension { PLY, XYZ, COMPRESSED_POINT_CLOUD, NUM_POINT_CLOUD_EXTENSIONS };
-	inline static const char* ExportPointCloud_STR[NUM_POINT_CLOUD_EXTENSIONS] = { "ply", "xyz", "binp" };
+	enum ExportPointCloudExtension { PLY, XYZ, COMPRESSED_POINT_CLOUD, NUMPY_POINT_CLOUD, QUANTIZED_POINT_CLOUD, NUM_POINT_CLOUD_EXTENSIONS };
+	inline static const char* ExportPointCloud_STR[NUM_POINT_CLOUD_EXTENSIONS] = { "ply", "xyz", "binp", "npy", "binq" };
 	 
 public:
 	int				_biasFocus;
 	int				_biasSeeds;
 	float			_boundaryMCWeight, _boundaryMCIterations;
 	int				_clampVoxelMetricUnit;
+	bool			_conservativeVoxelization;
+	bool			_cpuSmoothing;
 	bool			_erode;
 	int				_erosionConvolution;
 	int				_erosionIterations;
@@ -52,21 +55,28 @@ public:
 	float			_erosionThreshold;
 	int				_fractureAlgorithm;
 	int				_distanceFunction;
+	bool			_highResolutionFragments;
+	int				_iteration;
 	bool			_launchGPU;
+	bool			_localizedImpacts;
 	int				_marchingCubesSubdivisions;
 	int				_mergeSeedsDistanceFunction;
 	bool			_metricVoxelization;
+	uint64_t		_modelKey;
 	int             _neighbourhoodType;
 	float 			_nonBoundaryMCWeight, _nonBoundaryMCIterations;
 	int				_numExtraSeeds;
 	int				_numImpacts;
 	int				_numSeeds;
 	int				_pointCloudSeedingRandom;
+	bool			_rayImpacts;
 	bool			_removeIsolatedRegions;
 	int				_seed;
 	int				_seedingRandom;
+	bool			_solidVoxelization;
 	std::vector<int> _targetPoints;
 	std::vector<int> _targetTriangles;
+	bool			_taubinSmoothing;
 	int				_voxelPerMetricUnit;
 	ivec3			_voxelizationSize;
 
@@ -80,6 +90,8 @@ public:
 	int				_exportMeshExtension;
 	int				_exportPointCloudExtension;
 
+	bool			_exportContacts;
+	bool			_exportDescriptors;
 	bool			_exportGrid;
 	bool			_exportMesh;
 	bool			_exportPointCloud;
@@ -93,6 +105,8 @@ public:
 		_boundaryMCIterations(0.048f),
 		_boundaryMCWeight(0.2f),
 		_clampVoxelMetricUnit(200),
+		_conservativeVoxelization(false),
+		_cpuSmoothing(false),
 		_erode(false),
 		_erosionConvolution(ELLIPSE),
 		_erosionProbability(.5f),
@@ -101,10 +115,14 @@ public:
 		_erosionThreshold(0.5f),
 		_fractureAlgorithm(FLOOD),
 		_distanceFunction(CHEBYSHEV),
+		_highResolutionFragments(false),
+		_iteration(0),
 		_launchGPU(true),
+		_localizedImpacts(false),
 		_marchingCubesSubdivisions(1),
 		_mergeSeedsDistanceFunction(EUCLIDEAN),
 		_metricVoxelization(false),
+		_modelKey(0),
 		_neighbourhoodType(VON_NEUMANN),
 		_nonBoundaryMCIterations(0.048f),
 		_nonBoundaryMCWeight(0.9f),
@@ -112,12 +130,15 @@ public:
 		_numImpacts(0),
 		_numSeeds(8),
 		_pointCloudSeedingRandom(STD_UNIFORM),
+		_rayImpacts(false),
 		_removeIsolatedRegions(true),
 		_seed(80),
 		_seedingRandom(STD_UNIFORM),
+		_solidVoxelization(true),
 		_biasFocus(5),
 		_targetPoints({ 1024 }),
 		_targetTriangles({ 10000 }),
+		_taubinSmoothing(false),
 		_voxelPerMetricUnit(20),
 		_voxelizationSize(128),
 
@@ -129,6 +150,8 @@ public:
 		_exportMeshExtension(OBJ),
 		_exportPointCloudExtension(PLY),
 
+		_exportContacts(false),
+		_exportDescriptors(false),
 		_exportGrid(false),
 		_exportMesh(false),
 		_exportPointCloud(false)
@@ -143,5 +166,10 @@ public:
 		while (_voxelizationSize.x % 4 != 0)
 			_voxelizationSize -= ivec3(1);
 	}
+
+	/**
+	*	@return Random stream of the given stage for the current seed, model and iteration.
+	*/
+	RandomStream getRandomStream(RandomStream::Stage stage) const { return RandomStream(_seed, _modelKey, _iteration, stage); }
 };
 
@@ -0,0 +1,496 @@
+#include "stdafx.h"
+#include "FragmentMeshBuilder.h"
+
+#include "DataStructures/RegularGrid.h"
+#include "Graphics/Core/CADModel.h"
+#include "Graphics/Core/FractureParameters.h"
+#include "Graphics/Core/LaplacianSmoother.h"
+
+/// [Public methods]
+
+FragmentMeshBuilder::FragmentMeshBuilder(RegularGrid* grid, Model3D* sourceMesh) :
+	_aabbMin(grid->getAABB().min()), _cellSize(grid->getAABB().size() / vec3(grid->getNumSubdivisions())), _grid(grid), _numDivs(grid->getNumSubdivisions())
+{
+	for (Model3D::ModelComponent* modelComponent : sourceMesh->getModelComponents())
+	{
+		const unsigned baseIndex = _sourceVertices.size();
+
+		_sourceVertices.insert(_sourceVertices.end(), modelComponent->_geometry.begin(), modelComponent->_geometry.end());
+		for (const Model3D::FaceGPUData& face : modelComponent->_topology)
+			_sourceFaces.push_back(Model3D::FaceGPUData{ face._vertices + uvec3(baseIndex), face._modelCompID });
+	}
+
+	std::vector<unsigned> boundaryFaces;
+	_grid->queryClusterCPU(_sourceVertices, _sourceFaces, _faceLabel, boundaryFaces, _faceClusterOccupancy);
+
+	_isBoundaryFace.resize(_sourceFaces.size(), 0);
+	for (unsigned faceIdx : boundaryFaces)
+		_isBoundaryFace[faceIdx] = 1;
+}
+
+void FragmentMeshBuilder::build(const std::vector<uint16_t>& labels, std::vector<Model3D*>& fragments, const FractureParameters& fractParameters)
+{
+	std::unordered_map<uint16_t, unsigned> labelIndex;
+	for (unsigned idx = 0; idx < labels.size(); ++idx)
+		labelIndex[labels[idx]] = idx;
+
+	// Source faces of each fragment; faces crossing several fragments are assigned to all of them and split later
+	std::vector<std::vector<unsigned>> fragmentFaces(labels.size());
+	for (unsigned faceIdx = 0; faceIdx < _sourceFaces.size(); ++faceIdx)
+	{
+		if (_faceLabel[faceIdx] <= VOXEL_FREE)
+			continue;
+
+		if (!_isBoundaryFace[faceIdx])
+		{
+			auto labelIt = labelIndex.find(static_cast<uint16_t>(_faceLabel[faceIdx]));
+			if (labelIt != labelIndex.end())
+				fragmentFaces[labelIt->second].push_back(faceIdx);
+		}
+		else
+		{
+			for (const auto& occupancy : _faceClusterOccupancy[faceIdx])
+			{
+				auto labelIt = labelIndex.find(static_cast<uint16_t>(occupancy.first + VOXEL_FREE + 1));
+				if (labelIt != labelIndex.end())
+					fragmentFaces[labelIt->second].push_back(faceIdx);
+			}
+		}
+	}
+
+	// Fragments with no marching cubes mesh take the voxel faces shared with other fragments as crack surface
+	std::vector<std::vector<uvec4>> voxelFaces(labels.size());
+	if (std::find(fragments.begin(), fragments.end(), nullptr) != fragments.end())
+		this->getVoxelCrackFaces(labelIndex, voxelFaces);
+
+	const unsigned maxVoxels = glm::max(_numDivs.x, glm::max(_numDivs.y, _numDivs.z)), smoothingIterations = maxVoxels * fractParameters._nonBoundaryMCIterations;
+	std::vector<Mesh> meshes(labels.size());
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int idx = 0; idx < labels.size(); ++idx)
+	{
+		VertexMap vertexMap;
+
+		this->addSourceSurface(fragmentFaces[idx], labels[idx], meshes[idx], vertexMap);
+
+		const size_t firstCrackFace = meshes[idx]._faces.size();
+		if (fragments[idx])
+			this->addCrackSurface(fragments[idx]->getModelComponent(0), labels[idx], meshes[idx]);
+		else
+			this->addVoxelCrackSurface(voxelFaces[idx], meshes[idx]);
+		this->stitch(meshes[idx], firstCrackFace);
+
+		// Voxel faces are smoothed as marching cubes surfaces are; crack vertices welded to the outer border took its w, hence they stay fixed
+		if (!fragments[idx] && smoothingIterations)
+		{
+			LaplacianSmoother smoother(meshes[idx]._vertices.data(), meshes[idx]._vertices.size(), meshes[idx]._faces.data(), meshes[idx]._faces.size());
+			smoother.smooth(smoothingIterations, fractParameters._nonBoundaryMCWeight, false, fractParameters._taubinSmoothing);
+			smoother.getVertices(meshes[idx]._vertices);
+		}
+	}
+
+	// Models are created sequentially as they may allocate GPU buffers
+	for (int idx = 0; idx < labels.size(); ++idx)
+	{
+		if (meshes[idx]._faces.empty() && fragments[idx])
+			continue;
+
+		CADModel* model = new CADModel();
+		model->insert(meshes[idx]._vertices.data(), meshes[idx]._vertices.size(), meshes[idx]._faces.data(), meshes[idx]._faces.size());
+		model->endInsertionBatch(false, fragments[idx] != nullptr);
+
+		delete fragments[idx];
+		fragments[idx] = model;
+	}
+}
+
+/// [Protected methods]
+
+void FragmentMeshBuilder::addCrackSurface(Model3D::ModelComponent* fragment, uint16_t label, Mesh& mesh) const
+{
+	std::vector<unsigned> vertexIndex(fragment->_geometry.size(), std::numeric_limits<unsigned>::max());
+
+	for (const Model3D::FaceGPUData& face : fragment->_topology)
+	{
+		const vec3 a = fragment->_geometry[face._vertices.x]._position, b = fragment->_geometry[face._vertices.y]._position, c = fragment->_geometry[face._vertices.z]._position;
+		const vec3 normal = glm::cross(b - a, c - a);
+		const float normalLength = glm::length(normal);
+
+		if (normalLength <= glm::epsilon<float>())
+			continue;
+
+		// A crack triangle has another fragment on one of its sides, whereas the outer surface only touches empty space
+		const vec3 centroid = (a + b + c) / 3.0f, offset = normal / normalLength * _cellSize * .75f;
+		const uint16_t front = this->getLabel(centroid + offset), back = this->getLabel(centroid - offset);
+		if ((front <= VOXEL_FREE || front == label) && (back <= VOXEL_FREE || back == label))
+			continue;
+
+		uvec4 newFace(0);
+		for (int vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+		{
+			unsigned& index = vertexIndex[face._vertices[vertexIdx]];
+			if (index == std::numeric_limits<unsigned>::max())
+			{
+				index = mesh._vertices.size();
+				mesh._vertices.push_back(vec4(fragment->_geometry[face._vertices[vertexIdx]]._position, .0f));
+			}
+
+			newFace[vertexIdx] = index;
+		}
+
+		mesh._faces.push_back(newFace);
+	}
+}
+
+void FragmentMeshBuilder::addSourceSurface(const std::vector<unsigned>& faces, uint16_t label, Mesh& mesh, VertexMap& vertexMap) const
+{
+	for (unsigned faceIdx : faces)
+	{
+		const Model3D::FaceGPUData& face = _sourceFaces[faceIdx];
+		const vec3 a = _sourceVertices[face._vertices.x]._position, b = _sourceVertices[face._vertices.y]._position, c = _sourceVertices[face._vertices.z]._position;
+
+		if (!_isBoundaryFace[faceIdx])
+			mesh._faces.push_back(uvec4(this->addVertex(a, mesh, vertexMap), this->addVertex(b, mesh, vertexMap), this->addVertex(c, mesh, vertexMap), 0));
+		else
+			this->splitTriangle(a, b, c, label, static_cast<uint16_t>(_faceLabel[faceIdx]), 0, mesh, vertexMap);
+	}
+}
+
+unsigned FragmentMeshBuilder::addVertex(const vec3& position, Mesh& mesh, VertexMap& vertexMap, float w) const
+{
+	VertexKey key;
+	std::memcpy(key._bits, &position.x, sizeof(key._bits));
+
+	auto vertexIt = vertexMap.find(key);
+	if (vertexIt != vertexMap.end())
+		return vertexIt->second;
+
+	const unsigned index = mesh._vertices.size();
+	mesh._vertices.push_back(vec4(position, w));
+	vertexMap[key] = index;
+
+	return index;
+}
+
+void FragmentMeshBuilder::addVoxelCrackSurface(const std::vector<uvec4>& voxelFaces, Mesh& mesh) const
+{
+	// Crack vertices are only welded among themselves, as stitching welds them to the outer surface
+	VertexMap vertexMap;
+
+	for (const uvec4& voxelFace : voxelFaces)
+	{
+		// The other two axes follow the face axis cyclically, hence their cross product faces the positive side
+		const int axis = voxelFace.w / 2, u = (axis + 1) % 3, v = (axis + 2) % 3;
+		vec3 origin(voxelFace.x, voxelFace.y, voxelFace.z), du(.0f), dv(.0f);
+		origin[axis] += voxelFace.w % 2;
+		du[u] = dv[v] = 1.0f;
+
+		const vec3 corners[4] = { origin, origin + du, origin + du + dv, origin + dv };
+		unsigned indices[4];
+		for (int cornerIdx = 0; cornerIdx < 4; ++cornerIdx)
+			indices[cornerIdx] = this->addVertex(_aabbMin + corners[cornerIdx] * _cellSize, mesh, vertexMap, .0f);
+
+		if (voxelFace.w % 2)
+		{
+			mesh._faces.push_back(uvec4(indices[0], indices[1], indices[2], 0));
+			mesh._faces.push_back(uvec4(indices[0], indices[2], indices[3], 0));
+		}
+		else
+		{
+			mesh._faces.push_back(uvec4(indices[0], indices[2], indices[1], 0));
+			mesh._faces.push_back(uvec4(indices[0], indices[3], indices[2], 0));
+		}
+	}
+}
+
+uint64_t FragmentMeshBuilder::getEdgeKey(unsigned v1, unsigned v2)
+{
+	return (uint64_t(glm::min(v1, v2)) << 32) | glm::max(v1, v2);
+}
+
+uint16_t FragmentMeshBuilder::getLabel(const vec3& position) const
+{
+	// Surfaces lying on the maximum faces of the bounding box would otherwise fall outside the grid
+	const ivec3 cell = glm::clamp(ivec3(glm::floor((position - _aabbMin) / _cellSize)), ivec3(0), ivec3(_numDivs) - ivec3(1));
+
+	return _grid->getLabel(cell.x, cell.y, cell.z);
+}
+
+void FragmentMeshBuilder::getVoxelCrackFaces(const std::unordered_map<uint16_t, unsigned>& labelIndex, std::vector<std::vector<uvec4>>& voxelFaces) const
+{
+	// Every pair of neighbour voxels is visited once, from the lower one, and their face is added to both fragments
+	for (int x = 0; x < _numDivs.x; ++x)
+		for (int y = 0; y < _numDivs.y; ++y)
+			for (int z = 0; z < _numDivs.z; ++z)
+			{
+				const uint16_t label = _grid->getLabel(x, y, z);
+				if (label <= VOXEL_FREE)
+					continue;
+
+				auto labelIt = labelIndex.find(label);
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					ivec3 neighbour(x, y, z);
+					if (++neighbour[axis] >= static_cast<int>(_numDivs[axis]))
+						continue;
+
+					const uint16_t neighbourLabel = _grid->getLabel(neighbour.x, neighbour.y, neighbour.z);
+					if (neighbourLabel <= VOXEL_FREE || neighbourLabel == label)
+						continue;
+
+					if (labelIt != labelIndex.end())
+						voxelFaces[labelIt->second].push_back(uvec4(x, y, z, axis * 2 + 1));
+
+					auto neighbourIt = labelIndex.find(neighbourLabel);
+					if (neighbourIt != labelIndex.end())
+						voxelFaces[neighbourIt->second].push_back(uvec4(neighbour.x, neighbour.y, neighbour.z, axis * 2));
+				}
+			}
+}
+
+std::vector<uint64_t> FragmentMeshBuilder::getOpenEdges(const Mesh& mesh, size_t firstFace, size_t lastFace)
+{
+	// Open edges are those used by a single face
+	std::unordered_map<uint64_t, unsigned> edgeCount;
+	for (size_t faceIdx = firstFace; faceIdx < lastFace; ++faceIdx)
+		for (int edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+			++edgeCount[getEdgeKey(mesh._faces[faceIdx][edgeIdx], mesh._faces[faceIdx][(edgeIdx + 1) % 3])];
+
+	std::vector<uint64_t> openEdges;
+	for (const auto& edge : edgeCount)
+		if (edge.second == 1)
+			openEdges.push_back(edge.first);
+
+	// Hash maps are not ordered, whereas the results of the stitching depend on the order of the edges
+	std::sort(openEdges.begin(), openEdges.end());
+
+	return openEdges;
+}
+
+size_t FragmentMeshBuilder::splitEdges(Mesh& mesh, size_t firstFace, size_t lastFace, const EdgeSplits& splits)
+{
+	if (splits.empty())
+		return lastFace;
+
+	std::vector<uvec4> faces;
+	std::vector<unsigned> polygon;
+
+	for (size_t faceIdx = firstFace; faceIdx < lastFace; ++faceIdx)
+	{
+		const uvec4& face = mesh._faces[faceIdx];
+		polygon.clear();
+
+		for (int edgeIdx = 0; edgeIdx < 3; ++edgeIdx)
+		{
+			const unsigned v1 = face[edgeIdx], v2 = face[(edgeIdx + 1) % 3];
+			polygon.push_back(v1);
+
+			auto splitIt = splits.find(getEdgeKey(v1, v2));
+			if (splitIt == splits.end())
+				continue;
+
+			// Parameters run from the lower vertex index, hence they are reversed if the face traverses the edge the other way
+			std::vector<std::pair<float, unsigned>> points = splitIt->second;
+			if (v1 > v2)
+				for (auto& point : points)
+					point.first = 1.0f - point.first;
+
+			std::sort(points.begin(), points.end());
+			for (const auto& point : points)
+				polygon.push_back(point.second);
+		}
+
+		if (polygon.size() == 3)
+		{
+			faces.push_back(face);
+			continue;
+		}
+
+		// A fan around the centroid avoids the degenerate triangles of a fan around a corner, whose adjacent edges may hold split points
+		const unsigned centroid = mesh._vertices.size();
+		mesh._vertices.push_back((mesh._vertices[face.x] + mesh._vertices[face.y] + mesh._vertices[face.z]) / 3.0f);
+
+		for (size_t vertexIdx = 0; vertexIdx < polygon.size(); ++vertexIdx)
+			faces.push_back(uvec4(centroid, polygon[vertexIdx], polygon[(vertexIdx + 1) % polygon.size()], 0));
+	}
+
+	mesh._faces.erase(mesh._faces.begin() + firstFace, mesh._faces.begin() + lastFace);
+	mesh._faces.insert(mesh._faces.begin() + firstFace, faces.begin(), faces.end());
+
+	return firstFace + faces.size();
+}
+
+void FragmentMeshBuilder::splitTriangle(const vec3& a, const vec3& b, const vec3& c, uint16_t label, uint16_t fallbackLabel, int depth, Mesh& mesh, VertexMap& vertexMap) const
+{
+	// Source triangles lie on the surface, so their samples may fall into empty voxels; these are not considered transitions
+	const uint16_t samples[4] = { this->getLabel((a + b + c) / 3.0f), this->getLabel(a), this->getLabel(b), this->getLabel(c) };
+	uint16_t sampleLabel = VOXEL_EMPTY;
+	bool uniform = true;
+
+	for (uint16_t sample : samples)
+	{
+		if (sample <= VOXEL_FREE)
+			continue;
+
+		if (sampleLabel == VOXEL_EMPTY)
+			sampleLabel = sample;
+		else if (sample != sampleLabel)
+			uniform = false;
+	}
+
+	const vec3 cellEdges = glm::max(glm::abs(b - a), glm::max(glm::abs(c - b), glm::abs(a - c))) / _cellSize;
+	const float maxEdge = glm::max(cellEdges.x, glm::max(cellEdges.y, cellEdges.z));
+
+	if ((uniform && maxEdge <= 2.0f) || maxEdge <= .5f || depth == MAX_SPLIT_DEPTH)
+	{
+		if ((sampleLabel == VOXEL_EMPTY ? fallbackLabel : sampleLabel) == label)
+			mesh._faces.push_back(uvec4(this->addVertex(a, mesh, vertexMap), this->addVertex(b, mesh, vertexMap), this->addVertex(c, mesh, vertexMap), 0));
+
+		return;
+	}
+
+	const vec3 ab = (a + b) / 2.0f, bc = (b + c) / 2.0f, ca = (c + a) / 2.0f;
+	this->splitTriangle(a, ab, ca, label, fallbackLabel, depth + 1, mesh, vertexMap);
+	this->splitTriangle(ab, b, bc, label, fallbackLabel, depth + 1, mesh, vertexMap);
+	this->splitTriangle(ca, bc, c, label, fallbackLabel, depth + 1, mesh, vertexMap);
+	this->splitTriangle(ab, bc, ca, label, fallbackLabel, depth + 1, mesh, vertexMap);
+}
+
+void FragmentMeshBuilder::stitch(Mesh& mesh, size_t firstCrackFace) const
+{
+	const float tolerance = glm::max(_cellSize.x, glm::max(_cellSize.y, _cellSize.z)), weldDistance = tolerance * .1f;
+	auto cellKey = [&](const ivec3& cell) { return (uint64_t(uint32_t(cell.x) & 0x1FFFFF) << 42) | (uint64_t(uint32_t(cell.y) & 0x1FFFFF) << 21) | uint64_t(uint32_t(cell.z) & 0x1FFFFF); };
+
+	// Spatial hash of open edges, where each edge is found from every cell overlapped by its bounding box; cells are as large as the snapping tolerance
+	auto hashEdges = [&](const std::vector<uint64_t>& edges) -> std::unordered_map<uint64_t, std::vector<unsigned>>
+		{
+			std::unordered_map<uint64_t, std::vector<unsigned>> edgeHash;
+			for (unsigned edgeIdx = 0; edgeIdx < edges.size(); ++edgeIdx)
+			{
+				const vec3 p = vec3(mesh._vertices[edges[edgeIdx] >> 32]), q = vec3(mesh._vertices[edges[edgeIdx] & 0xFFFFFFFF]);
+				const ivec3 minCell(glm::floor(glm::min(p, q) / tolerance)), maxCell(glm::floor(glm::max(p, q) / tolerance));
+
+				for (int x = minCell.x; x <= maxCell.x; ++x)
+					for (int y = minCell.y; y <= maxCell.y; ++y)
+						for (int z = minCell.z; z <= maxCell.z; ++z)
+							edgeHash[cellKey(ivec3(x, y, z))].push_back(edgeIdx);
+			}
+
+			return edgeHash;
+		};
+
+	// Closest open edge within the tolerance, along with the parameter of the closest point from its lower vertex index
+	auto findClosestEdge = [&](const vec3& position, const std::vector<uint64_t>& edges, const std::unordered_map<uint64_t, std::vector<unsigned>>& edgeHash, float& t) -> int
+		{
+			const ivec3 cell(glm::floor(position / tolerance));
+			float minDistance = tolerance;
+			int closestEdge = -1;
+
+			for (int x = -1; x <= 1; ++x)
+				for (int y = -1; y <= 1; ++y)
+					for (int z = -1; z <= 1; ++z)
+					{
+						auto cellIt = edgeHash.find(cellKey(cell + ivec3(x, y, z)));
+						if (cellIt == edgeHash.end())
+							continue;
+
+						for (unsigned edgeIdx : cellIt->second)
+						{
+							const vec3 p = vec3(mesh._vertices[edges[edgeIdx] >> 32]), pq = vec3(mesh._vertices[edges[edgeIdx] & 0xFFFFFFFF]) - p;
+							const float edgeT = glm::clamp(glm::dot(position - p, pq) / glm::max(glm::dot(pq, pq), glm::epsilon<float>()), .0f, 1.0f);
+							const float distance = glm::length(p + pq * edgeT - position);
+
+							if (distance < minDistance)
+							{
+								minDistance = distance;
+								closestEdge = static_cast<int>(edgeIdx);
+								t = edgeT;
+							}
+						}
+					}
+
+			return closestEdge;
+		};
+
+	// Open vertices of the crack are welded to the closest point of the outer border; those landing within an outer edge split it
+	const std::vector<uint64_t> outerEdges = getOpenEdges(mesh, 0, firstCrackFace), crackEdges = getOpenEdges(mesh, firstCrackFace, mesh._faces.size());
+	if (outerEdges.empty())
+		return;
+
+	const std::unordered_map<uint64_t, std::vector<unsigned>> outerHash = hashEdges(outerEdges);
+	std::vector<unsigned> remap(mesh._vertices.size());
+	std::iota(remap.begin(), remap.end(), 0);
+	std::vector<uint8_t> isVisited(mesh._vertices.size(), 0);
+	EdgeSplits outerSplits;
+
+	for (uint64_t edge : crackEdges)
+	{
+		for (unsigned vertexIdx : { unsigned(edge >> 32), unsigned(edge & 0xFFFFFFFF) })
+		{
+			if (isVisited[vertexIdx])
+				continue;
+
+			float t;
+			const int edgeIdx = findClosestEdge(vec3(mesh._vertices[vertexIdx]), outerEdges, outerHash, t);
+			isVisited[vertexIdx] = 1;
+			if (edgeIdx < 0)
+				continue;
+
+			const unsigned p = outerEdges[edgeIdx] >> 32, q = outerEdges[edgeIdx] & 0xFFFFFFFF;
+			const float edgeLength = glm::length(vec3(mesh._vertices[q]) - vec3(mesh._vertices[p]));
+
+			if (t * edgeLength <= weldDistance)
+				remap[vertexIdx] = p;
+			else if ((1.0f - t) * edgeLength <= weldDistance)
+				remap[vertexIdx] = q;
+			else
+			{
+				mesh._vertices[vertexIdx] = glm::mix(mesh._vertices[p], mesh._vertices[q], t);
+				outerSplits[outerEdges[edgeIdx]].push_back(std::make_pair(t, vertexIdx));
+			}
+		}
+	}
+
+	firstCrackFace = splitEdges(mesh, 0, firstCrackFace, outerSplits);
+
+	// Snapping collapses some crack triangles, which are removed
+	size_t numFaces = firstCrackFace;
+	for (size_t faceIdx = firstCrackFace; faceIdx < mesh._faces.size(); ++faceIdx)
+	{
+		const uvec4 face(remap[mesh._faces[faceIdx].x], remap[mesh._faces[faceIdx].y], remap[mesh._faces[faceIdx].z], 0);
+		if (face.x != face.y && face.y != face.z && face.z != face.x)
+			mesh._faces[numFaces++] = face;
+	}
+
+	mesh._faces.resize(numFaces);
+
+	// Outer border vertices skipped by the crack, i.e. lying between two of its welded vertices, split the crack edge in turn
+	const std::vector<uint64_t> weldedCrackEdges = getOpenEdges(mesh, firstCrackFace, mesh._faces.size());
+	if (weldedCrackEdges.empty())
+		return;
+
+	std::vector<uint8_t> isCrackVertex(mesh._vertices.size(), 0);
+	for (size_t faceIdx = firstCrackFace; faceIdx < mesh._faces.size(); ++faceIdx)
+		isCrackVertex[mesh._faces[faceIdx].x] = isCrackVertex[mesh._faces[faceIdx].y] = isCrackVertex[mesh._faces[faceIdx].z] = 1;
+
+	const std::unordered_map<uint64_t, std::vector<unsigned>> crackHash = hashEdges(weldedCrackEdges);
+	EdgeSplits crackSplits;
+
+	for (uint64_t edge : getOpenEdges(mesh, 0, firstCrackFace))
+	{
+		for (unsigned vertexIdx : { unsigned(edge >> 32), unsigned(edge & 0xFFFFFFFF) })
+		{
+			if (isCrackVertex[vertexIdx])
+				continue;
+
+			float t;
+			const int edgeIdx = findClosestEdge(vec3(mesh._vertices[vertexIdx]), weldedCrackEdges, crackHash, t);
+			isCrackVertex[vertexIdx] = 1;
+
+			if (edgeIdx >= 0 && t > .0f && t < 1.0f)
+				crackSplits[weldedCrackEdges[edgeIdx]].push_back(std::make_pair(t, vertexIdx));
+		}
+	}
+
+	splitEdges(mesh, firstCrackFace, mesh._faces.size(), crackSplits);
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Graphics/Core/Model3D.h"
+
+class RegularGrid;
+struct FractureParameters;
+
+/**
+*	@file FragmentMeshBuilder.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Rebuilds fragment meshes at the resolution of the source mesh. The outer surface of each fragment is made of the source triangles labelled
+*	with its value, whereas triangles crossing several fragments are subdivided and split along the voxel labels. Marching cubes triangles are only kept
+*	where they separate two fragments, and their open borders are welded to the borders of the outer surface, splitting the edges of either border at
+*	the vertices of the other one so that no T-junction is left. Borders further apart than a voxel are not welded, hence the seam stays open there.
+*	Fragments with no marching cubes mesh take the voxel faces shared with other fragments as crack surface, which is smoothed with LaplacianSmoother
+*	while the outer surface stays fixed. Everything runs on the CPU.
+*/
+class FragmentMeshBuilder
+{
+protected:
+	const static int MAX_SPLIT_DEPTH = 8;						//!< Maximum number of 1-to-4 subdivisions of a triangle crossing several fragments
+
+	/**
+	*	@brief Triangle mesh as expected by CADModel::insert.
+	*/
+	struct Mesh
+	{
+		std::vector<uvec4>	_faces;
+		std::vector<vec4>	_vertices;								//!< The w component is 1 for the outer surface and 0 for the crack surface, as expected by LaplacianSmoother
+	};
+
+	/**
+	*	@brief Welds vertices with identical coordinates.
+	*/
+	struct VertexKey
+	{
+		uint32_t _bits[3];
+
+		bool operator==(const VertexKey& key) const { return _bits[0] == key._bits[0] && _bits[1] == key._bits[1] && _bits[2] == key._bits[2]; }
+	};
+
+	struct VertexKeyHash
+	{
+		size_t operator()(const VertexKey& key) const { return (size_t(key._bits[0]) * 73856093) ^ (size_t(key._bits[1]) * 19349663) ^ (size_t(key._bits[2]) * 83492791); }
+	};
+
+	typedef std::unordered_map<VertexKey, unsigned, VertexKeyHash> VertexMap;
+	typedef std::unordered_map<uint64_t, std::vector<std::pair<float, unsigned>>> EdgeSplits;		//!< Vertices inserted into each edge, along with their parameter from its lower vertex index
+
+protected:
+	vec3									_aabbMin;			//!< Minimum corner of the grid
+	vec3									_cellSize;			//!< Size of a voxel
+	std::vector<std::unordered_map<unsigned, float>> _faceClusterOccupancy;	//!< Fragments overlapped by each source face
+	std::vector<float>						_faceLabel;			//!< Predominant label of each source face, VOXEL_FREE if none
+	RegularGrid*							_grid;				//!< Labelled voxelization
+	std::vector<uint8_t>					_isBoundaryFace;	//!< Source faces overlapping several fragments
+	uvec3									_numDivs;			//!< Dimensions of the grid
+	std::vector<Model3D::FaceGPUData>		_sourceFaces;		//!< Faces of every component of the source mesh
+	std::vector<Model3D::VertexGPUData>		_sourceVertices;	//!< Vertices of every component of the source mesh
+
+protected:
+	/**
+	*	@brief Appends the marching cubes triangles of a fragment that lie between it and another fragment.
+	*/
+	void addCrackSurface(Model3D::ModelComponent* fragment, uint16_t label, Mesh& mesh) const;
+
+	/**
+	*	@brief Appends the source triangles of a fragment, splitting those that cross several fragments.
+	*/
+	void addSourceSurface(const std::vector<unsigned>& faces, uint16_t label, Mesh& mesh, VertexMap& vertexMap) const;
+
+	/**
+	*	@return Index of a vertex, which is inserted if no other vertex has the same position.
+	*/
+	unsigned addVertex(const vec3& position, Mesh& mesh, VertexMap& vertexMap, float w = 1.0f) const;
+
+	/**
+	*	@brief Appends the given voxel faces as the crack surface of a fragment with no marching cubes mesh.
+	*/
+	void addVoxelCrackSurface(const std::vector<uvec4>& voxelFaces, Mesh& mesh) const;
+
+	/**
+	*	@return Key of an undirected edge, with the lower vertex index in the upper 32 bits.
+	*/
+	static uint64_t getEdgeKey(unsigned v1, unsigned v2);
+
+	/**
+	*	@return Unmasked label of the voxel containing the position, which is clamped to the grid.
+	*/
+	uint16_t getLabel(const vec3& position) const;
+
+	/**
+	*	@brief Collects the voxel faces separating each of the given labels from another fragment. Each face is given by the voxel of the fragment (xyz)
+	*	and its direction (w), which is twice the axis plus one if it faces the positive side.
+	*/
+	void getVoxelCrackFaces(const std::unordered_map<uint16_t, unsigned>& labelIndex, std::vector<std::vector<uvec4>>& voxelFaces) const;
+
+	/**
+	*	@return Sorted keys of the edges used by a single face within the given range.
+	*/
+	static std::vector<uint64_t> getOpenEdges(const Mesh& mesh, size_t firstFace, size_t lastFace);
+
+	/**
+	*	@brief Inserts vertices into edges of the faces within the given range, retriangulating every face with a split edge as a fan around its centroid.
+	*	@return End of the range once retriangulated.
+	*/
+	static size_t splitEdges(Mesh& mesh, size_t firstFace, size_t lastFace, const EdgeSplits& splits);
+
+	/**
+	*	@brief Subdivides a triangle until each piece belongs to a single fragment or is smaller than half a voxel, keeping the pieces of the given label.
+	*/
+	void splitTriangle(const vec3& a, const vec3& b, const vec3& c, uint16_t label, uint16_t fallbackLabel, int depth, Mesh& mesh, VertexMap& vertexMap) const;
+
+	/**
+	*	@brief Welds the open borders of the crack surface, which starts at the given face, to the closest open border of the outer surface. Crack
+	*	vertices landing within an outer edge split it, and outer vertices lying between two welded crack vertices split the crack edge in turn.
+	*/
+	void stitch(Mesh& mesh, size_t firstCrackFace) const;
+
+public:
+	/**
+	*	@brief Constructor. Labels the faces of the source mesh with the fragments of the grid.
+	*/
+	FragmentMeshBuilder(RegularGrid* grid, Model3D* sourceMesh);
+
+	/**
+	*	@brief Replaces the marching cubes meshes of the given labels with high-resolution meshes. Null fragments, e.g., from grids built with no OpenGL
+	*	context, get a voxel crack surface smoothed on the CPU with the non-boundary marching cubes parameters, and no GPU data.
+	*/
+	void build(const std::vector<uint16_t>& labels, std::vector<Model3D*>& fragments, const FractureParameters& fractParameters);
+};
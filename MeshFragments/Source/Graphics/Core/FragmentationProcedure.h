@@ -5,7 +5,8 @@
 
 struct FragmentationProcedure
 {
-	bool				_compressResultingFiles = true;
+	bool				_archiveResultingFiles = true;				// Fragments of each model are appended to a single FragmentArchive
+	bool				_compressResultingFiles = true;				// Archive entries are deflated
 	std::string			_currentDestinationFolder = "";
 
 	FractureParameters	_fractureParameters;
@@ -14,7 +15,13 @@ struct FragmentationProcedure
 	std::string			_folder = "D:/allopezr/Datasets/Vessels_200/";
 	std::string			_destinationFolder = "D:/allopezr/Fragments/Vessels_200_ours/";
 	size_t				_maxFragmentsModel = /*std::numeric_limits<size_t>::max()*/1000;
+	unsigned			_numShards = 1;						// Processes the models are split into, each one running a different _shardIdx
+	unsigned			_numWorkers = 1;						// Iterations fractured concurrently with the CPU naive fracturer; other algorithms and erosion use a single worker
 	std::string			_onlineFolder = "E:/Online_Testing/";
+	bool				_packPointClouds = false;			// Point clouds exported as .npy are packed into a single .npz per iteration
+	unsigned			_pipelineDepth = 2;					// Iterations that may wait between consecutive stages of the dataset generation
+	bool				_resume = true;						// Jobs finished by a previous run are skipped, as recorded in its manifest
+	unsigned			_shardIdx = 0;
 	std::string			_startVessel = "";
 	std::string			_searchExtension = ".obj";
 
@@ -49,6 +56,8 @@ struct FragmentationProcedure
 		_fractureParameters._renderMesh = true;
 		_fractureParameters._renderPointCloud = false;
 
+		_fractureParameters._exportContacts = true;
+		_fractureParameters._exportDescriptors = true;
 		_fractureParameters._exportGrid = true;
 		_fractureParameters._exportMesh = true;
 		_fractureParameters._exportPointCloud = true;
@@ -57,6 +66,16 @@ struct FragmentationProcedure
 		_fractureParameters._exportMeshExtension = FractureParameters::BINARY_MESH;
 		_fractureParameters._exportPointCloudExtension = FractureParameters::ExportPointCloudExtension::COMPRESSED_POINT_CLOUD;
 	}
+
+	/**
+	*	@return Number of iterations for the given number of fragments, interpolated within _iterationInterval.
+	*/
+	int getNumIterations(int numFragments) const
+	{
+		return glm::mix(
+			_iterationInterval.x, _iterationInterval.y,
+			static_cast<float>(numFragments - _fragmentInterval.x) / (_fragmentInterval.y - _fragmentInterval.x));
+	}
 };
 
 typedef std::vector<FragmentationProcedure::FragmentMetadata> FragmentMetadataBuffer;
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "LaplacianSmoother.h"
+
+// [Public methods]
+
+LaplacianSmoother::LaplacianSmoother(const vec4* vertices, unsigned numVertices, const uvec4* faces, unsigned numFaces)
+{
+	_boundary.resize(numVertices);
+	_w.resize(numVertices);
+	for (int i = 0; i < 3; ++i)
+	{
+		_coordinates[i].resize(numVertices);
+		_relaxed[i].resize(numVertices);
+	}
+
+	#pragma omp parallel for
+	for (int vertex = 0; vertex < numVertices; ++vertex)
+	{
+		for (int i = 0; i < 3; ++i)
+			_coordinates[i][vertex] = vertices[vertex][i];
+
+		_boundary[vertex] = vertices[vertex].w > .5f;
+		_w[vertex] = vertices[vertex].w;
+	}
+
+	// Each corner has the other two corners of its face as neighbours. Keys sort entries by vertex and keep the corner of the neighbour
+	const unsigned numEntries = numFaces * 6;
+	std::vector<uint64_t> vertexNeighbour(numEntries);
+
+	#pragma omp parallel for
+	for (int face = 0; face < numFaces; ++face)
+		for (int i = 0; i < 3; ++i)
+			for (int j = 1; j < 3; ++j)
+				vertexNeighbour[face * 6 + i * 2 + j - 1] = (uint64_t(faces[face][i]) << 32) | (face * 3 + (i + j) % 3);
+
+	std::sort(std::execution::par_unseq, vertexNeighbour.begin(), vertexNeighbour.end());
+
+	_interiorFace.resize(numEntries);
+	_neighbour.resize(numEntries);
+	_neighbourOffset.resize(numVertices + 1, numEntries);
+
+	#pragma omp parallel for
+	for (int idx = 0; idx < numEntries; ++idx)
+	{
+		const unsigned vertex = static_cast<unsigned>(vertexNeighbour[idx] >> 32), corner = static_cast<unsigned>(vertexNeighbour[idx] & 0xFFFFFFFF);
+		const uvec4& face = faces[corner / 3];
+
+		_neighbour[idx] = face[corner % 3];
+		_interiorFace[idx] = !_boundary[face.x] && !_boundary[face.y] && !_boundary[face.z];
+
+		if (idx == 0 || static_cast<unsigned>(vertexNeighbour[idx - 1] >> 32) != vertex)
+			_neighbourOffset[vertex] = idx;
+	}
+
+	// Vertices without faces start where the following vertex does
+	for (int vertex = static_cast<int>(numVertices) - 1; vertex >= 0; --vertex)
+		if (_neighbourOffset[vertex] == numEntries)
+			_neighbourOffset[vertex] = _neighbourOffset[vertex + 1];
+}
+
+void LaplacianSmoother::getVertices(std::vector<vec4>& vertices) const
+{
+	vertices.resize(_w.size());
+
+	#pragma omp parallel for
+	for (int vertex = 0; vertex < vertices.size(); ++vertex)
+		vertices[vertex] = vec4(_coordinates[0][vertex], _coordinates[1][vertex], _coordinates[2][vertex], _w[vertex]);
+}
+
+void LaplacianSmoother::smooth(unsigned numIterations, float weight, bool boundary, bool taubin)
+{
+	const float mu = 1.0f / (TAUBIN_PASS_BAND - 1.0f / weight);
+
+	for (unsigned iteration = 0; iteration < numIterations; ++iteration)
+	{
+		this->relax(weight, boundary);
+		if (taubin && weight > .0f)
+			this->relax(mu, boundary);
+	}
+}
+
+// [Protected methods]
+
+void LaplacianSmoother::relax(float weight, bool boundary)
+{
+	const int numVertices = static_cast<int>(_boundary.size());
+
+	#pragma omp parallel for
+	for (int vertex = 0; vertex < numVertices; ++vertex)
+	{
+		float sum[3] = { .0f, .0f, .0f };
+		unsigned count = 0;
+
+		if (_boundary[vertex] == boundary)
+		{
+			for (unsigned entry = _neighbourOffset[vertex]; entry < _neighbourOffset[vertex + 1]; ++entry)
+			{
+				if (!boundary && !_interiorFace[entry])
+					continue;
+
+				for (int i = 0; i < 3; ++i)
+					sum[i] += _coordinates[i][_neighbour[entry]];
+				++count;
+			}
+		}
+
+		for (int i = 0; i < 3; ++i)
+			_relaxed[i][vertex] = count ? _coordinates[i][vertex] + weight * (sum[i] / count - _coordinates[i][vertex]) : _coordinates[i][vertex];
+	}
+
+	for (int i = 0; i < 3; ++i)
+		_coordinates[i].swap(_relaxed[i]);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "stdafx.h"
+
+/**
+*	@file LaplacianSmoother.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief CPU counterpart of the Laplacian smoothing of MarchingCubes. Vertex neighbours are stored in compressed rows built with a single sort, 
+*	once per face they share as the GPU accumulates them, and positions are kept as separate coordinate arrays relaxed with parallel Jacobi iterations.
+*	The w component of vertices tells boundary (1) from non-boundary (0) vertices, so that each pass only moves one type. Taubin smoothing 
+*	follows each shrinking step with an inflating one. As it only takes CPU arrays, it also smooths the voxel crack surfaces built by 
+*	FragmentMeshBuilder for CPU-only grids.
+*/
+class LaplacianSmoother
+{
+public:
+	inline const static float TAUBIN_PASS_BAND = 0.1f;			//!< Pass-band frequency from which the inflating weight is derived
+
+protected:
+	std::vector<uint8_t>	_boundary;							//!< Type of each vertex
+	std::vector<float>		_coordinates[3];					//!< Position of each vertex, one array per axis
+	std::vector<uint8_t>	_interiorFace;						//!< Whether the face of each neighbour entry has no boundary vertices
+	std::vector<unsigned>	_neighbour;							//!< Neighbour vertex of each entry
+	std::vector<unsigned>	_neighbourOffset;					//!< Start of the neighbours of each vertex in _neighbour, with one more element
+	std::vector<float>		_relaxed[3];						//!< Positions written by a Jacobi iteration
+	std::vector<float>		_w;									//!< Original w component, given back untouched
+
+protected:
+	/**
+	*	@brief Moves every vertex of the target type towards the average of its neighbours in a single Jacobi iteration. Non-boundary vertices
+	*	only average neighbours from faces without boundary vertices, whereas boundary vertices average all of them.
+	*/
+	void relax(float weight, bool boundary);
+
+public:
+	/**
+	*	@brief Constructor from the vertices and faces of a welded mesh, as read from the marching cubes buffers.
+	*/
+	LaplacianSmoother(const vec4* vertices, unsigned numVertices, const uvec4* faces, unsigned numFaces);
+
+	/**
+	*	@brief Retrieves the smoothed vertices with their original w component.
+	*/
+	void getVertices(std::vector<vec4>& vertices) const;
+
+	/**
+	*	@brief Smooths the vertices of the given type. If taubin is enabled, each iteration is followed by an inflating step of weight 
+	*	mu, with 1 / weight + 1 / mu = TAUBIN_PASS_BAND, so that the surface does not shrink.
+	*/
+	void smooth(unsigned numIterations, float weight, bool boundary, bool taubin = false);
+};
+
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "MarchingCubes.h"
 
+#include "Graphics/Core/LaplacianSmoother.h"
 #include "Graphics/Core/ShaderList.h"
 
 const int MarchingCubes::_triangleTable[256 * 16] = {
@@ -361,7 +362,7 @@ MarchingCubes::~MarchingCubes()
 	delete[] _indices;
 }
 
-CADModel* MarchingCubes::triangulateFieldGPU(GLuint gridSSBO, uint16_t targetValue, FractureParameters& fractureParams, const mat4& modelMatrix)
+CADModel* MarchingCubes::triangulateFieldGPU(GLuint gridSSBO, uint16_t targetValue, FractureParameters& fractureParams, const mat4& modelMatrix, const uvec3& minCell, const uvec3& maxCell, vec2* surfaceArea)
 {
 	CADModel* model = new CADModel();
 	unsigned numSteps = _gridSubdivisions * _gridSubdivisions * _gridSubdivisions, stepIdx = 0;
@@ -373,9 +374,24 @@ CADModel* MarchingCubes::triangulateFieldGPU(GLuint gridSSBO, uint16_t targetVal
 		{
 			for (int z = 0; z < _numDivs.z; z += _steps.z)
 			{
-				uvec3 start = uvec3(x, y, z), size = glm::min(start + _steps, _numDivs) - start;
+				uvec3 start = uvec3(x, y, z), end = glm::min(start + _steps, _numDivs);
 				++stepIdx;
 
+				// Cube c of the padded field touches voxels c - 1 and c of the regular grid, hence only cubes within [minCell, maxCell + 1] are needed
+				bool outside = false;
+				for (int i = 0; i < 3; ++i)
+				{
+					start[i] = glm::max(start[i], minCell[i]);
+					if (maxCell[i] < _numDivs[i])
+						end[i] = glm::min(end[i], maxCell[i] + 2);
+					outside |= start[i] >= end[i];
+				}
+
+				if (outside)
+					continue;
+
+				uvec3 size = end - start;
+
 				this->resetCounter(_numVerticesSSBO);
 
 				_marchingCubesShader->bindBuffers(std::vector<GLuint>{ _gridSSBO, _verticesSSBO, _numVerticesSSBO, _triangleTableSSBO, _edgeTableSSBO, _supportVerticesSSBO });
@@ -385,7 +401,7 @@ CADModel* MarchingCubes::triangulateFieldGPU(GLuint gridSSBO, uint16_t targetVal
 				_marchingCubesShader->setUniform("localSize", size);
 				_marchingCubesShader->setUniform("start", start);
 				_marchingCubesShader->setUniform("targetValue", targetValue);
-				_marchingCubesShader->execute(_numGroups, 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
+				_marchingCubesShader->execute(ComputeShader::getNumGroups(size.x * size.y * size.z), 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 
 				unsigned numVertices = glm::min(*ComputeShader::readData(_numVerticesSSBO, unsigned()), _maxNumPoints);
 				//vec4* vertexData = ComputeShader::readData(_verticesSSBO, vec4());
@@ -397,13 +413,34 @@ CADModel* MarchingCubes::triangulateFieldGPU(GLuint gridSSBO, uint16_t targetVal
 					unsigned newNumVertices = this->fuseSimilarVertices(numVertices, modelMatrix);
 					this->buildMarchingCubesFaces(numVertices);
 					this->markBoundaryTriangles(numVertices / 3);
-					this->smoothSurface(newNumVertices, numVertices / 3, maxVoxels * fractureParams._nonBoundaryMCIterations, fractureParams._nonBoundaryMCWeight, false);
-					this->smoothSurface(newNumVertices, numVertices / 3, maxVoxels * fractureParams._boundaryMCIterations, fractureParams._boundaryMCWeight, true);
+
+					const unsigned nonBoundaryIterations = maxVoxels * fractureParams._nonBoundaryMCIterations, boundaryIterations = maxVoxels * fractureParams._boundaryMCIterations;
+					if (!fractureParams._cpuSmoothing)
+					{
+						this->smoothSurface(newNumVertices, numVertices / 3, nonBoundaryIterations, fractureParams._nonBoundaryMCWeight, false);
+						this->smoothSurface(newNumVertices, numVertices / 3, boundaryIterations, fractureParams._boundaryMCWeight, true);
+					}
 
 					vec4* vertices = ComputeShader::readData(_vertexSSBO, vec4(), 0, sizeof(vec4) * newNumVertices);
 					uvec4* faces = ComputeShader::readData(_faceSSBO, uvec4(), 0, sizeof(uvec4) * numVertices / 3);
 
-					model->insert(vertices, newNumVertices, faces, numVertices / 3);
+					if (fractureParams._cpuSmoothing)
+					{
+						// Same passes as smoothSurface(), over a copy of the vertices
+						std::vector<vec4> smoothedVertices;
+						LaplacianSmoother smoother(vertices, newNumVertices, faces, numVertices / 3);
+						smoother.smooth(nonBoundaryIterations, fractureParams._nonBoundaryMCWeight, false, fractureParams._taubinSmoothing);
+						smoother.smooth(boundaryIterations, fractureParams._boundaryMCWeight, true, fractureParams._taubinSmoothing);
+						smoother.getVertices(smoothedVertices);
+
+						model->insert(smoothedVertices.data(), newNumVertices, faces, numVertices / 3);
+						if (surfaceArea) this->measureSurface(smoothedVertices.data(), faces, numVertices / 3, *surfaceArea);
+					}
+					else
+					{
+						model->insert(vertices, newNumVertices, faces, numVertices / 3);
+						if (surfaceArea) this->measureSurface(vertices, faces, numVertices / 3, *surfaceArea);
+					}
 				}
 			}
 		}
@@ -488,6 +525,25 @@ void MarchingCubes::markBoundaryTriangles(unsigned numFaces)
 	_markBoundaryTrianglesShader->execute(ComputeShader::getNumGroups(numFaces), 1, 1, ComputeShader::getMaxGroupSize(), 1, 1);
 }
 
+void MarchingCubes::measureSurface(const vec4* vertices, const uvec4* faces, unsigned numFaces, vec2& surfaceArea) const
+{
+	double boundaryArea = .0, nonBoundaryArea = .0;
+
+	#pragma omp parallel for reduction(+: boundaryArea, nonBoundaryArea)
+	for (int faceIdx = 0; faceIdx < numFaces; ++faceIdx)
+	{
+		const vec3 v1(vertices[faces[faceIdx].x]), v2(vertices[faces[faceIdx].y]), v3(vertices[faces[faceIdx].z]);
+		const double area = .5 * glm::length(glm::cross(v2 - v1, v3 - v1));
+
+		if (faces[faceIdx].w)
+			boundaryArea += area;
+		else
+			nonBoundaryArea += area;
+	}
+
+	surfaceArea += vec2(boundaryArea, nonBoundaryArea);
+}
+
 void MarchingCubes::smoothSurface(unsigned numVertices, unsigned numFaces, unsigned numIterations, float weight, bool boundary)
 {
 	for (int i = 0; i < numIterations; ++i)
@@ -515,20 +571,26 @@ void MarchingCubes::smoothSurface(unsigned numVertices, unsigned numFaces, unsig
 
 void MarchingCubes::setGrid(RegularGrid& regularGrid)
 {
-	uint16_t* gridData = (uint16_t*)malloc(sizeof(float) * _numDivs.x * _numDivs.y * _numDivs.z);
+	this->setGrid(regularGrid, uvec3(0), _numDivs - uvec3(3));
+}
+
+void MarchingCubes::setGrid(RegularGrid& regularGrid, const uvec3& minCell, const uvec3& maxCell)
+{
+	// Slabs of the padded grid, where cell x is found at x + 1
+	const unsigned firstSlab = minCell.x, lastSlab = glm::min(maxCell.x + 2, _numDivs.x - 1);
+	const unsigned slabSize = _numDivs.y * _numDivs.z, numSlabs = lastSlab - firstSlab + 1;
+	uint16_t* gridData = (uint16_t*)malloc(sizeof(uint16_t) * slabSize * numSlabs);
+
 #pragma omp parallel for
-	for (int x = 0; x < _numDivs.x; ++x)
+	for (int x = firstSlab; x <= lastSlab; ++x)
 		for (int y = 0; y < _numDivs.y; ++y)
 			for (int z = 0; z < _numDivs.z; ++z)
-				gridData[x * _numDivs.y * _numDivs.z + y * _numDivs.z + z] = VOXEL_FREE;
-
-#pragma omp parallel for
-	for (int x = 1; x < _numDivs.x - 1; ++x)
-		for (int y = 1; y < _numDivs.y - 1; ++y)
-			for (int z = 1; z < _numDivs.z - 1; ++z)
-				gridData[x * _numDivs.y * _numDivs.z + y * _numDivs.z + z] = regularGrid.at(x - 1, y - 1, z - 1);
+			{
+				bool isPadding = x == 0 || y == 0 || z == 0 || x == _numDivs.x - 1 || y == _numDivs.y - 1 || z == _numDivs.z - 1;
+				gridData[(x - firstSlab) * slabSize + y * _numDivs.z + z] = isPadding ? uint16_t(VOXEL_FREE) : regularGrid.at(x - 1, y - 1, z - 1);
+			}
 
-	ComputeShader::updateReadBufferSubset(_gridSSBO, gridData, 0, _numDivs.x * _numDivs.y * _numDivs.z);
+	ComputeShader::updateReadBufferSubset(_gridSSBO, gridData, firstSlab * slabSize * sizeof(uint16_t), slabSize * numSlabs);
 	free(gridData);
 }
 
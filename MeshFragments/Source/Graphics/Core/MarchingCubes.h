@@ -75,6 +75,11 @@ protected:
 	*/
 	void markBoundaryTriangles(unsigned numFaces);
 
+	/**
+	*   @brief Adds the area of triangles marked as boundary to surfaceArea.x and the area of the remaining ones to surfaceArea.y.
+	*/
+	void measureSurface(const vec4* vertices, const uvec4* faces, unsigned numFaces, vec2& surfaceArea) const;
+
 	/**
 	*   @brief Resets counter for number of vertices in the GPU.
 	*/
@@ -106,10 +111,18 @@ public:
 	*/
 	void setGrid(RegularGrid& regularGrid);
 
+	/**
+	*   @brief Modifies the content related to the voxels between minCell and maxCell, plus one voxel around them. Whole slabs along x are uploaded.
+	*/
+	void setGrid(RegularGrid& regularGrid, const uvec3& minCell, const uvec3& maxCell);
+
 	/**
 	*   @brief Triangulate a scalar field represented by `scalarFunction`. `isovalue` should be used for isovalue computation.
+	*	Blocks not touching the voxels between minCell and maxCell, given in the coordinates of the regular grid, are skipped.
+	*	If surfaceArea is given, it receives the area of the triangles emitted from voxels masked as boundary (x) and the rest (y).
 	*/
-	CADModel* triangulateFieldGPU(GLuint gridSSBO, uint16_t targetValue, FractureParameters& fractureParams, const mat4& modelMatrix);
+	CADModel* triangulateFieldGPU(GLuint gridSSBO, uint16_t targetValue, FractureParameters& fractureParams, const mat4& modelMatrix, 
+		const uvec3& minCell = uvec3(0), const uvec3& maxCell = uvec3(std::numeric_limits<glm::uint>::max()), vec2* surfaceArea = nullptr);
 
 	// Getters
 
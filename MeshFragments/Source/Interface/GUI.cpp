@@ -232,6 +232,8 @@ void GUI::showFractureSettings()
 			if (ImGui::BeginTabItem("General settings"))
 			{
 				ImGui::SliderInt("Grid Subdivisions", &_fractureParameters->_voxelizationSize[0], 1, _fractureParameters->_clampVoxelMetricUnit);
+				ImGui::Checkbox("Conservative Voxelization", &_fractureParameters->_conservativeVoxelization); ImGui::SameLine(0, 20);
+				ImGui::Checkbox("Solid Voxelization", &_fractureParameters->_solidVoxelization);
 
 				int maxSeeds = std::pow(2, fracturer::Seeder::VOXEL_ID_POSITION) / 2;
 
@@ -247,6 +249,8 @@ void GUI::showFractureSettings()
 				ImGui::SliderInt("Impacts", &_fractureParameters->_numImpacts, 0, 10);
 				ImGui::SliderInt("Biased Seeds", &_fractureParameters->_biasSeeds, 0, maxSeeds - _fractureParameters->_numSeeds); 
 				ImGui::SliderInt("Spreading of Biased Points", &_fractureParameters->_biasFocus, 1, 15);
+				ImGui::Checkbox("Localized Impacts", &_fractureParameters->_localizedImpacts);
+				ImGui::Checkbox("Ray-Casted Impacts", &_fractureParameters->_rayImpacts);
 
 				ImGui::EndTabItem();
 			}
@@ -277,6 +281,15 @@ void GUI::showFractureSettings()
 				ImGui::SliderFloat("Non Boundary Iterations", &_fractureParameters->_nonBoundaryMCIterations, 0.0f, 0.1f);
 				ImGui::SliderFloat("Non Boundary Weight", &_fractureParameters->_nonBoundaryMCWeight, 0.0f, 1.0f);
 
+				this->leaveSpace(1);
+
+				ImGui::Checkbox("Smooth on CPU", &_fractureParameters->_cpuSmoothing); ImGui::SameLine(0, 20);
+				ImGui::Checkbox("Taubin Smoothing", &_fractureParameters->_taubinSmoothing);
+
+				this->leaveSpace(1);
+
+				ImGui::Checkbox("High-Resolution Fragments", &_fractureParameters->_highResolutionFragments);
+
 				ImGui::EndTabItem();
 			}
 
@@ -286,6 +299,9 @@ void GUI::showFractureSettings()
 				ImGui::SameLine(0, 20);
 				if (ImGui::Button("Export Grid"))
 					_scene->exportGrid(*_fractureParameters);
+				ImGui::SameLine(0, 20);
+				if (ImGui::Button("Export Contact Graph"))
+					_scene->exportContactGraph();
 
 				ImGui::Combo("Mesh Extension", &_fractureParameters->_exportMeshExtension, FractureParameters::ExportMesh_STR, IM_ARRAYSIZE(FractureParameters::ExportMesh_STR));
 				ImGui::SameLine(0, 20);
@@ -1,4 +1,7 @@
 #define GENERATE_DATASET false
+#define BENCHMARK_MODE false							// Requires GENERATE_DATASET, as stages are measured the way the dataset generation runs them
+#define GOLDEN_DIGEST_MODE false						// Compares fixed-seed jobs against Assets/Golden/ digests, also requiring GENERATE_DATASET. GENERATE_DATASET builds also run CPU-only jobs headless with --golden-cpu[-record]
+#define GOLDEN_DIGEST_RECORD false						// Records the digests of GOLDEN_DIGEST_MODE as the new golden file instead of comparing them
 #define TESTING_FORMAT_MODE false
 
 #include <windows.h>								// DWORD is undefined otherwise
@@ -22,10 +25,13 @@
 // [Standard libraries: basic]
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cassert>
+#include <charconv>
 #include <chrono>
 #include <climits>
+#include <condition_variable>
 #include <cstdint>
 #include <exception>
 #include <execution>
@@ -36,6 +42,7 @@
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <random>
 #include <regex>
@@ -50,6 +57,7 @@
 
 // [Standard libraries: data structures]
 
+#include <deque>
 #include <map>
 #include <set>
 #include <unordered_map>
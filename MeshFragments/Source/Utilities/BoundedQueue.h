@@ -0,0 +1,101 @@
+#pragma once
+
+#include "stdafx.h"
+
+/**
+*	@file BoundedQueue.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Blocking FIFO queue connecting two pipeline stages. Producers wait while the queue is full, so that a fast stage cannot run 
+*	arbitrarily ahead of a slow one, whereas consumers wait until an item is available or the queue is closed.
+*/
+template<typename T>
+class BoundedQueue
+{
+protected:
+	size_t						_capacity;			//!< Maximum number of queued items
+	bool						_closed;			//!< No more items are accepted
+	std::condition_variable		_notEmpty;			//!< Signaled whenever an item is pushed or the queue is closed
+	std::condition_variable		_notFull;			//!< Signaled whenever an item is popped or the queue is closed
+	std::mutex					_mutex;				//!< Guards the rest of the members
+	std::deque<T>				_queue;				//!< Queued items
+
+public:
+	/**
+	*	@brief Constructor.
+	*/
+	BoundedQueue(size_t capacity = std::numeric_limits<size_t>::max()) : _capacity(glm::max(capacity, size_t(1))), _closed(false) {}
+
+	/**
+	*	@brief Rejects further items and wakes up every waiting thread. Items already queued can still be popped.
+	*/
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_closed = true;
+		}
+
+		_notEmpty.notify_all();
+		_notFull.notify_all();
+	}
+
+	/**
+	*	@brief Waits until an item is available.
+	*	@return False if the queue is closed and empty.
+	*/
+	bool pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_notEmpty.wait(lock, [this]() { return !_queue.empty() || _closed; });
+
+		if (_queue.empty())
+			return false;
+
+		item = std::move(_queue.front());
+		_queue.pop_front();
+		lock.unlock();
+		_notFull.notify_one();
+
+		return true;
+	}
+
+	/**
+	*	@brief Waits until there is room for the item.
+	*	@return False if the queue is closed, in which case the item is not queued.
+	*/
+	bool push(T item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_notFull.wait(lock, [this]() { return _queue.size() < _capacity || _closed; });
+
+		if (_closed)
+			return false;
+
+		_queue.push_back(std::move(item));
+		lock.unlock();
+		_notEmpty.notify_one();
+
+		return true;
+	}
+
+	/**
+	*	@brief Pops an item only if available, without waiting.
+	*/
+	bool tryPop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (_queue.empty())
+			return false;
+
+		item = std::move(_queue.front());
+		_queue.pop_front();
+		lock.unlock();
+		_notFull.notify_one();
+
+		return true;
+	}
+};
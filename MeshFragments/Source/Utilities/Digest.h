@@ -0,0 +1,90 @@
+#pragma once
+
+#include "stdafx.h"
+
+/**
+*	@file Digest.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Incremental FNV-1a hash of 64 bits. It is meant to fingerprint outputs, e.g., to compare them against stored golden values, rather
+*	than to protect them.
+*/
+class Digest
+{
+protected:
+	uint64_t	_value;				//!< Hash of the bytes appended so far
+
+public:
+	/**
+	*	@brief Constructor of the digest of an empty sequence.
+	*/
+	Digest() : _value(0xCBF29CE484222325ull) {}
+
+	/**
+	*	@return Hash of the bytes appended so far.
+	*/
+	uint64_t getValue() const { return _value; }
+
+	/**
+	*	@return Hash as 16 hexadecimal digits.
+	*/
+	std::string toString() const;
+
+	/**
+	*	@brief Appends a sequence of bytes.
+	*/
+	void update(const void* data, size_t size);
+
+	/**
+	*	@brief Appends the bytes of a trivially copyable value.
+	*/
+	template<typename T>
+	void update(const T& value) { this->update(&value, sizeof(T)); }
+
+	/**
+	*	@brief Appends the length of a vector and the bytes of its elements.
+	*/
+	template<typename T>
+	void update(const std::vector<T>& values) { this->update(static_cast<uint64_t>(values.size())); this->update(values.data(), values.size() * sizeof(T)); }
+
+	/**
+	*	@brief Appends the length and characters of a string.
+	*/
+	void update(const std::string& string) { this->update(static_cast<uint64_t>(string.size())); this->update(string.data(), string.size()); }
+
+	/**
+	*	@brief Appends the content of a file. Returns false if it cannot be read.
+	*/
+	bool updateFile(const std::string& filename);
+};
+
+inline std::string Digest::toString() const
+{
+	char buffer[17];
+	snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(_value));
+
+	return std::string(buffer);
+}
+
+inline void Digest::update(const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t idx = 0; idx < size; ++idx)
+		_value = (_value ^ bytes[idx]) * 0x100000001B3ull;
+}
+
+inline bool Digest::updateFile(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	std::vector<char> buffer(1 << 16);
+	while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0)
+		this->update(buffer.data(), static_cast<size_t>(file.gcount()));
+
+	return true;
+}
@@ -0,0 +1,260 @@
+#include "stdafx.h"
+#include "FragmentArchive.h"
+
+/// Initialization of static attributes
+const std::string FragmentArchive::EXTENSION = ".farc";
+
+// [Public methods]
+
+FragmentArchive::FragmentArchive() : _compression(STORED), _offset(0)
+{
+	static_assert(sizeof(Header) == 24 && sizeof(EntryHeader) == 32, "Archive records are written as raw structs");
+}
+
+FragmentArchive::~FragmentArchive()
+{
+	this->close();
+}
+
+bool FragmentArchive::append(const std::string& name, const char* data, size_t size)
+{
+	EntryHeader header;
+	header._size = size;
+	header._crc = lodepng_crc32(reinterpret_cast<const unsigned char*>(data), size);
+	header._compression = STORED;
+	header._padding = 0;
+	header._nameLength = static_cast<uint16_t>(name.size());
+
+	// Compression is performed before locking so that saving threads do not serialize on it
+	std::vector<unsigned char> compressed;
+	if (_compression == DEFLATE && size > 0 && !lodepng::compress(compressed, reinterpret_cast<const unsigned char*>(data), size) && compressed.size() < size)
+	{
+		header._compression = DEFLATE;
+		data = reinterpret_cast<const char*>(compressed.data());
+		size = compressed.size();
+	}
+
+	header._storedSize = size;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_file.is_open()) return false;
+
+	header._offset = _offset + sizeof(EntryHeader) + name.size();
+	_file.write(reinterpret_cast<const char*>(&header), sizeof(EntryHeader));
+	_file.write(name.data(), name.size());
+	_file.write(data, size);
+
+	_offset = header._offset + size;
+	_entries.push_back(Entry{ name, header });
+
+	return !_file.fail();
+}
+
+bool FragmentArchive::appendFile(const std::string& name, const std::string& path)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file.is_open()) return false;
+
+	const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+	std::filesystem::remove(path);
+
+	return this->append(name, content);
+}
+
+bool FragmentArchive::close()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_file.is_open()) return false;
+
+	// Only archives being written own an index still to be flushed
+	const bool writing = _offset > 0;
+	if (writing)
+	{
+		Header header{ { 'F', 'A', 'R', 'C' }, 1, _offset, _entries.size() };
+
+		_file.seekp(_offset);
+		for (const Entry& entry : _entries)
+		{
+			_file.write(reinterpret_cast<const char*>(&entry._header), sizeof(EntryHeader));
+			_file.write(entry._name.data(), entry._name.size());
+		}
+
+		_file.seekp(0);
+		_file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	}
+
+	const bool success = !_file.fail();
+	_file.close();
+	_entries.clear();
+	_offset = 0;
+
+	return success;
+}
+
+bool FragmentArchive::create(const std::string& filename, Compression compression)
+{
+	this->close();
+
+	_file.open(filename, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!_file.is_open()) return false;
+
+	// Header is rewritten once the index location is known
+	Header header{ { 'F', 'A', 'R', 'C' }, 1, 0, 0 };
+	_file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+	_compression = compression;
+	_offset = sizeof(Header);
+
+	return !_file.fail();
+}
+
+const FragmentArchive::Entry* FragmentArchive::find(const std::string& name) const
+{
+	// Entries rewritten after resuming an archive supersede the previous ones
+	for (auto entry = _entries.rbegin(); entry != _entries.rend(); ++entry)
+		if (entry->_name == name)
+			return &(*entry);
+
+	return nullptr;
+}
+
+bool FragmentArchive::flush()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_file.is_open()) return false;
+
+	_file.flush();
+
+	return !_file.fail();
+}
+
+bool FragmentArchive::open(const std::string& filename)
+{
+	this->close();
+
+	_file.open(filename, std::ios::in | std::ios::binary);
+	if (!_file.is_open()) return false;
+
+	if (!this->readIndex())
+	{
+		_file.close();
+		_entries.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool FragmentArchive::read(const Entry& entry, std::vector<char>& data)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_file.is_open()) return false;
+
+	std::vector<char> stored(entry._header._storedSize);
+	_file.seekg(entry._header._offset);
+	_file.read(stored.data(), stored.size());
+	if (_file.fail()) return false;
+
+	if (entry._header._compression == DEFLATE)
+	{
+		std::vector<unsigned char> decompressed;
+		if (lodepng::decompress(decompressed, reinterpret_cast<const unsigned char*>(stored.data()), stored.size())) return false;
+		data.assign(decompressed.begin(), decompressed.end());
+	}
+	else
+		data = std::move(stored);
+
+	return data.size() == entry._header._size && lodepng_crc32(reinterpret_cast<const unsigned char*>(data.data()), data.size()) == entry._header._crc;
+}
+
+bool FragmentArchive::read(const std::string& name, std::vector<char>& data)
+{
+	const Entry* entry = this->find(name);
+	return entry && this->read(*entry, data);
+}
+
+bool FragmentArchive::resume(const std::string& filename, Compression compression, const std::function<bool(const std::string&)>& keep)
+{
+	this->close();
+
+	_file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+	if (!_file.is_open()) return false;
+
+	if (!this->readIndex())
+	{
+		_file.close();
+		_entries.clear();
+		return false;
+	}
+
+	// New entries are appended after the last payload, overwriting the index of a closed archive
+	uint64_t offset = sizeof(Header);
+	for (const Entry& entry : _entries)
+		offset = glm::max(offset, entry._header._offset + entry._header._storedSize);
+
+	std::vector<Entry> entries;
+	std::unordered_set<std::string> names;
+	for (auto entry = _entries.rbegin(); entry != _entries.rend(); ++entry)
+		if (keep(entry->_name) && names.insert(entry->_name).second)
+			entries.push_back(*entry);
+	_entries.assign(entries.rbegin(), entries.rend());
+
+	// Flagged as not closed, hence a later crash is recovered by walking entry headers
+	Header header{ { 'F', 'A', 'R', 'C' }, 1, 0, 0 };
+	_file.seekp(0);
+	_file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	_file.seekp(offset);
+
+	_compression = compression;
+	_offset = offset;
+
+	return !_file.fail();
+}
+
+// [Protected methods]
+
+bool FragmentArchive::readIndex()
+{
+	Header header;
+	_file.read(reinterpret_cast<char*>(&header), sizeof(Header));
+	if (_file.fail() || std::strncmp(header._magic, "FARC", 4) != 0) return false;
+
+	_file.seekg(0, std::ios::end);
+	const uint64_t fileSize = _file.tellg();
+	Entry entry;
+
+	if (header._indexOffset)
+	{
+		_file.seekg(header._indexOffset);
+		for (uint64_t entryIdx = 0; entryIdx < header._numEntries; ++entryIdx)
+		{
+			_file.read(reinterpret_cast<char*>(&entry._header), sizeof(EntryHeader));
+			entry._name.resize(entry._header._nameLength);
+			_file.read(entry._name.data(), entry._name.size());
+			if (_file.fail()) return false;
+
+			_entries.push_back(entry);
+		}
+	}
+	else
+	{
+		// The archive was not closed, so entries are recovered by walking their headers until a truncated one is found
+		uint64_t offset = sizeof(Header);
+		while (offset + sizeof(EntryHeader) <= fileSize)
+		{
+			_file.seekg(offset);
+			_file.read(reinterpret_cast<char*>(&entry._header), sizeof(EntryHeader));
+			entry._name.resize(entry._header._nameLength);
+			_file.read(entry._name.data(), entry._name.size());
+			if (_file.fail() || entry._header._offset != offset + sizeof(EntryHeader) + entry._name.size() || entry._header._offset + entry._header._storedSize > fileSize) break;
+
+			_entries.push_back(entry);
+			offset = entry._header._offset + entry._header._storedSize;
+		}
+
+		_file.clear();
+	}
+
+	return true;
+}
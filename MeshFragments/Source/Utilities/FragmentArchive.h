@@ -0,0 +1,139 @@
+#pragma once
+
+/**
+*	@file FragmentArchive.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Single-file container where the fragments of a model are appended as they are saved. Each payload is preceded by its own entry
+*	header, as in tar, and an index with every entry is written at the end so that any fragment is read with a single seek.
+*/
+class FragmentArchive
+{
+public:
+	const static std::string EXTENSION;									//!< File extension for fragment archives
+
+	enum Compression : uint8_t { STORED, DEFLATE, NUM_COMPRESSION_TYPES };
+
+	/**
+	*	@brief File header. The index offset remains zero until the archive is closed.
+	*/
+	struct Header
+	{
+		char		_magic[4];											//!< FARC
+		uint32_t	_version;											//!< Layout version
+		uint64_t	_indexOffset;										//!< Offset of the first index record
+		uint64_t	_numEntries;										//!< Number of index records
+	};
+
+	/**
+	*	@brief Record written both before each payload and in the index, followed by _nameLength characters.
+	*/
+	struct EntryHeader
+	{
+		uint64_t	_offset;											//!< Offset of the payload from the start of the file
+		uint64_t	_storedSize;										//!< Size of the payload as written
+		uint64_t	_size;												//!< Size of the payload once decompressed
+		uint32_t	_crc;												//!< CRC-32 of the decompressed payload
+		uint8_t		_compression;										//!< Compression enum
+		uint8_t		_padding;
+		uint16_t	_nameLength;										//!< Length of the name following this record
+	};
+
+	struct Entry
+	{
+		std::string	_name;
+		EntryHeader	_header;
+	};
+
+protected:
+	Compression					_compression;							//!< Compression of new entries
+	std::vector<Entry>			_entries;								//!< Entries written so far
+	std::fstream				_file;									//!< Archive stream
+	std::mutex					_mutex;									//!< Appends may come from several saving threads
+	uint64_t					_offset;								//!< End of the last written entry
+
+protected:
+	/**
+	*	@brief Loads the index, or rebuilds it from the entry headers if the archive was not closed.
+	*/
+	bool readIndex();
+
+public:
+	/**
+	*	@brief Default constructor.
+	*/
+	FragmentArchive();
+
+	/**
+	*	@brief Destructor. Closes the archive if it is still open.
+	*/
+	virtual ~FragmentArchive();
+
+	/**
+	*	@brief Appends a new entry, compressing it in the calling thread. Thread-safe.
+	*/
+	bool append(const std::string& name, const char* data, size_t size);
+
+	/**
+	*	@brief Appends a new entry from a memory buffer. Thread-safe.
+	*/
+	bool append(const std::string& name, const std::string& data) { return this->append(name, data.data(), data.size()); }
+
+	/**
+	*	@brief Appends the content of a file, which is then removed. Intended for writers that can only target files.
+	*/
+	bool appendFile(const std::string& name, const std::string& path);
+
+	/**
+	*	@brief Writes the index and closes the file.
+	*/
+	bool close();
+
+	/**
+	*	@brief Creates a new archive, overwriting any previous file.
+	*/
+	bool create(const std::string& filename, Compression compression = STORED);
+
+	/**
+	*	@return Latest entry with the given name, or nullptr if it is not in the archive.
+	*/
+	const Entry* find(const std::string& name) const;
+
+	/**
+	*	@brief Pushes written entries to the file, so that they survive a crash of the process. Thread-safe.
+	*/
+	bool flush();
+
+	/**
+	*	@return Entries of the archive.
+	*/
+	const std::vector<Entry>& getEntries() const { return _entries; }
+
+	/**
+	*	@return True if the archive is open.
+	*/
+	bool isOpen() const { return _file.is_open(); }
+
+	/**
+	*	@brief Opens an existing archive in order to read its entries.
+	*/
+	bool open(const std::string& filename);
+
+	/**
+	*	@brief Reads and decompresses an entry.
+	*/
+	bool read(const Entry& entry, std::vector<char>& data);
+
+	/**
+	*	@brief Reads and decompresses the entry with the given name.
+	*/
+	bool read(const std::string& name, std::vector<char>& data);
+
+	/**
+	*	@brief Reopens an archive, closed or not, in order to append more entries. Only entries accepted by keep are indexed; the rest are left as dead space.
+	*/
+	bool resume(const std::string& filename, Compression compression, const std::function<bool(const std::string&)>& keep);
+};
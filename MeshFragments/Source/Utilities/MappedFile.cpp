@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// Public methods
+
+#ifdef _WIN32
+MappedFile::MappedFile() : _data(nullptr), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(nullptr)
+#else
+MappedFile::MappedFile() : _data(nullptr), _size(0), _file(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	this->close();
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (_data) UnmapViewOfFile(_data);
+	if (_mapping) CloseHandle(_mapping);
+	if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+
+	_mapping = nullptr;
+	_file = INVALID_HANDLE_VALUE;
+#else
+	if (_data) munmap(const_cast<char*>(_data), _size);
+	if (_file >= 0) ::close(_file);
+
+	_file = -1;
+#endif
+
+	_data = nullptr;
+	_size = 0;
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+	this->close();
+
+#ifdef _WIN32
+	_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (_file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(_file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		this->close();
+		return false;
+	}
+
+	_size = static_cast<size_t>(fileSize.QuadPart);
+	_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mapping) _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	_file = ::open(filename.c_str(), O_RDONLY);
+	if (_file < 0) return false;
+
+	struct stat fileStat;
+	if (fstat(_file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		this->close();
+		return false;
+	}
+
+	_size = static_cast<size_t>(fileStat.st_size);
+	void* view = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+	if (view != MAP_FAILED) _data = static_cast<const char*>(view);
+#endif
+
+	if (!_data)
+	{
+		this->close();
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+/**
+*	@file MappedFile.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Read-only view of a whole file mapped into memory. Pages are loaded by the OS on demand, so large files can be queried without reading them first.
+*/
+class MappedFile
+{
+protected:
+	const char*		_data;										//!< First byte of the mapped view
+	size_t			_size;										//!< Size of the file in bytes
+
+#ifdef _WIN32
+	HANDLE			_file;										//!< Handle of the opened file
+	HANDLE			_mapping;									//!< Handle of the file mapping
+#else
+	int				_file;										//!< Descriptor of the opened file
+#endif
+
+public:
+	/**
+	*	@brief Constructor.
+	*/
+	MappedFile();
+
+	/**
+	*	@brief Invalid copy constructor.
+	*/
+	MappedFile(const MappedFile& file) = delete;
+
+	/**
+	*	@brief Destructor. Unmaps the file.
+	*/
+	virtual ~MappedFile();
+
+	/**
+	*	@brief Unmaps the current file, if any.
+	*/
+	void close();
+
+	/**
+	*	@return Mapped content, null if no file is open.
+	*/
+	const char* data() const { return _data; }
+
+	/**
+	*	@return True if a file is mapped.
+	*/
+	bool isOpen() const { return _data != nullptr; }
+
+	/**
+	*	@brief Maps a file. Empty files cannot be mapped.
+	*	@return Success of operation.
+	*/
+	bool open(const std::string& filename);
+
+	/**
+	*	@brief Invalid assignment operator.
+	*/
+	MappedFile& operator=(const MappedFile& file) = delete;
+
+	/**
+	*	@return Size of the mapped file in bytes.
+	*/
+	size_t size() const { return _size; }
+};
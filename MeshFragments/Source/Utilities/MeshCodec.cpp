@@ -0,0 +1,280 @@
+#include "stdafx.h"
+#include "MeshCodec.h"
+
+/// Private functions
+
+namespace
+{
+	void writeVarint(std::vector<char>& stream, uint32_t value)
+	{
+		while (value >= 0x80)
+		{
+			stream.push_back(static_cast<char>((value & 0x7F) | 0x80));
+			value >>= 7;
+		}
+
+		stream.push_back(static_cast<char>(value));
+	}
+
+	bool readVarint(const uint8_t*& stream, const uint8_t* end, uint32_t& value)
+	{
+		value = 0;
+		for (uint32_t shift = 0; shift < 35 && stream < end; shift += 7)
+		{
+			const uint8_t byte = *stream++;
+			value |= uint32_t(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) return true;
+		}
+
+		return false;
+	}
+
+	vec2 encodeOctahedron(const vec3& normal)
+	{
+		const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		if (length <= std::numeric_limits<float>::epsilon()) return vec2(.0f);
+
+		vec2 encoded = vec2(normal.x, normal.y) / length;
+		if (normal.z < .0f)
+			encoded = (1.0f - glm::abs(vec2(encoded.y, encoded.x))) * vec2(encoded.x >= .0f ? 1.0f : -1.0f, encoded.y >= .0f ? 1.0f : -1.0f);
+
+		return encoded;
+	}
+
+	vec3 decodeOctahedron(const vec2& encoded)
+	{
+		vec3 normal(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+		const float fold = std::max(-normal.z, .0f);
+		normal.x += normal.x >= .0f ? -fold : fold;
+		normal.y += normal.y >= .0f ? -fold : fold;
+
+		const float length = glm::length(normal);
+		return length > .0f ? normal / length : vec3(.0f);
+	}
+
+	/**
+	*	@brief Reorders faces with the Tipsy algorithm (Sander et al., 2007), which fans around the vertex expected to remain longest in a FIFO cache.
+	*	@return Order of the original faces.
+	*/
+	std::vector<unsigned> optimizeFaceOrder(const std::vector<Model3D::FaceGPUData>& faces, unsigned numVertices)
+	{
+		const unsigned numFaces = static_cast<unsigned>(faces.size());
+
+		// Vertex-face adjacency as compressed rows
+		std::vector<unsigned> liveFaces(numVertices, 0), offset(numVertices + 1, 0), adjacency(numFaces * 3);
+		for (const Model3D::FaceGPUData& face : faces)
+			for (int vertexIdx = 0; vertexIdx < 3; ++vertexIdx) ++liveFaces[face._vertices[vertexIdx]];
+
+		for (unsigned vertexIdx = 0; vertexIdx < numVertices; ++vertexIdx)
+			offset[vertexIdx + 1] = offset[vertexIdx] + liveFaces[vertexIdx];
+
+		std::vector<unsigned> cursor(offset.begin(), offset.end() - 1);
+		for (unsigned faceIdx = 0; faceIdx < numFaces; ++faceIdx)
+			for (int vertexIdx = 0; vertexIdx < 3; ++vertexIdx) adjacency[cursor[faces[faceIdx]._vertices[vertexIdx]]++] = faceIdx;
+
+		std::vector<unsigned> order, deadEnd, candidates, cacheTime(numVertices, 0);
+		std::vector<bool> emitted(numFaces, false);
+		unsigned time = MeshCodec::VERTEX_CACHE_SIZE + 1, nextVertex = 0;
+		int fanningVertex = numVertices ? 0 : -1;
+
+		order.reserve(numFaces);
+
+		while (fanningVertex >= 0)
+		{
+			candidates.clear();
+
+			for (unsigned adjacencyIdx = offset[fanningVertex]; adjacencyIdx < offset[fanningVertex + 1]; ++adjacencyIdx)
+			{
+				const unsigned faceIdx = adjacency[adjacencyIdx];
+				if (emitted[faceIdx]) continue;
+
+				for (int vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+				{
+					const unsigned vertex = faces[faceIdx]._vertices[vertexIdx];
+					deadEnd.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveFaces[vertex];
+
+					if (time - cacheTime[vertex] > MeshCodec::VERTEX_CACHE_SIZE) cacheTime[vertex] = time++;
+				}
+
+				emitted[faceIdx] = true;
+				order.push_back(faceIdx);
+			}
+
+			// Candidate that remains in cache after fanning around it, otherwise the most recent vertex with pending faces
+			int bestPriority = -1;
+			fanningVertex = -1;
+
+			for (unsigned vertex : candidates)
+			{
+				if (liveFaces[vertex] == 0) continue;
+
+				int priority = 0;
+				if (time - cacheTime[vertex] + 2 * liveFaces[vertex] <= MeshCodec::VERTEX_CACHE_SIZE) priority = time - cacheTime[vertex];
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					fanningVertex = vertex;
+				}
+			}
+
+			while (fanningVertex < 0 && !deadEnd.empty())
+			{
+				if (liveFaces[deadEnd.back()] > 0) fanningVertex = deadEnd.back();
+				deadEnd.pop_back();
+			}
+
+			while (fanningVertex < 0 && nextVertex < numVertices)
+			{
+				if (liveFaces[nextVertex] > 0) fanningVertex = nextVertex;
+				++nextVertex;
+			}
+		}
+
+		return order;
+	}
+}
+
+/// Public functions
+
+bool MeshCodec::decode(const char* data, size_t size, Model3D::ModelComponent* component)
+{
+	static_assert(sizeof(Header) == 48, "Header is read as a raw struct");
+
+	Header header;
+	if (size < sizeof(Header)) return false;
+	std::memcpy(&header, data, sizeof(Header));
+
+	const size_t positionSize = size_t(header._numVertices) * 3 * sizeof(uint16_t), normalSize = header._flags & HAS_NORMALS ? size_t(header._numVertices) * 2 * sizeof(int16_t) : 0;
+	if (std::strncmp(header._magic, "BINM", 4) != 0 || header._version != 2 || sizeof(Header) + positionSize + normalSize + header._indexStreamSize > size) return false;
+
+	const vec3 min(header._min[0], header._min[1], header._min[2]), scale = (vec3(header._max[0], header._max[1], header._max[2]) - min) / float(QUANTIZATION_LEVELS);
+	const int numVertices = static_cast<int>(header._numVertices);
+	const char* positions = data + sizeof(Header), *normals = positions + positionSize;
+
+	component->_geometry.assign(numVertices, Model3D::VertexGPUData());
+	component->_topology.resize(header._numFaces);
+
+	#pragma omp parallel for
+	for (int vertexIdx = 0; vertexIdx < numVertices; ++vertexIdx)
+	{
+		uint16_t quantized[3];
+		std::memcpy(quantized, positions + vertexIdx * sizeof(quantized), sizeof(quantized));
+		component->_geometry[vertexIdx]._position = min + vec3(quantized[0], quantized[1], quantized[2]) * scale;
+
+		if (normalSize)
+		{
+			int16_t encoded[2];
+			std::memcpy(encoded, normals + vertexIdx * sizeof(encoded), sizeof(encoded));
+			component->_geometry[vertexIdx]._normal = decodeOctahedron(glm::clamp(vec2(encoded[0], encoded[1]) / 32767.0f, vec2(-1.0f), vec2(1.0f)));
+		}
+	}
+
+	const uint8_t* stream = reinterpret_cast<const uint8_t*>(normals + normalSize), *end = stream + header._indexStreamSize;
+	uint32_t nextVertex = 0, distance;
+
+	for (Model3D::FaceGPUData& face : component->_topology)
+	{
+		for (int vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+		{
+			if (!readVarint(stream, end, distance) || distance > nextVertex) return false;
+
+			face._vertices[vertexIdx] = nextVertex - distance;
+			if (distance == 0 && ++nextVertex > header._numVertices) return false;
+		}
+
+		face._modelCompID = component->_id;
+	}
+
+	return true;
+}
+
+void MeshCodec::encode(const Model3D::ModelComponent* component, bool includeNormals, std::vector<char>& data)
+{
+	const std::vector<Model3D::VertexGPUData>& vertices = component->_geometry;
+	const std::vector<Model3D::FaceGPUData>& faces = component->_topology;
+	const int numVertices = static_cast<int>(vertices.size());
+
+	Header header{ { 'B', 'I', 'N', 'M' }, 2, static_cast<uint32_t>(numVertices), static_cast<uint32_t>(faces.size()), includeNormals ? HAS_NORMALS : 0, { .0f, .0f, .0f }, { .0f, .0f, .0f }, 0 };
+	vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+	for (const Model3D::VertexGPUData& vertex : vertices)
+	{
+		min = glm::min(min, vertex._position);
+		max = glm::max(max, vertex._position);
+	}
+
+	if (numVertices == 0) min = max = vec3(.0f);
+	const vec3 extent = glm::max(max - min, vec3(std::numeric_limits<float>::epsilon()));
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		header._min[axis] = min[axis];
+		header._max[axis] = min[axis] + extent[axis];
+	}
+
+	// Vertices are renumbered by their first use in the optimized face order; unreferenced vertices go last
+	const std::vector<unsigned> faceOrder = optimizeFaceOrder(faces, numVertices);
+	std::vector<unsigned> newIndex(numVertices, std::numeric_limits<unsigned>::max()), vertexOrder;
+	std::vector<char> indexStream;
+
+	vertexOrder.reserve(numVertices);
+	indexStream.reserve(faces.size() * 4);
+
+	for (unsigned faceIdx : faceOrder)
+	{
+		for (int vertexIdx = 0; vertexIdx < 3; ++vertexIdx)
+		{
+			const unsigned nextVertex = static_cast<unsigned>(vertexOrder.size());
+			unsigned& index = newIndex[faces[faceIdx]._vertices[vertexIdx]];
+			if (index == std::numeric_limits<unsigned>::max())
+			{
+				index = nextVertex;
+				vertexOrder.push_back(faces[faceIdx]._vertices[vertexIdx]);
+			}
+
+			writeVarint(indexStream, nextVertex - index);
+		}
+	}
+
+	for (int vertexIdx = 0; vertexIdx < numVertices; ++vertexIdx)
+		if (newIndex[vertexIdx] == std::numeric_limits<unsigned>::max()) vertexOrder.push_back(vertexIdx);
+
+	header._indexStreamSize = static_cast<uint32_t>(indexStream.size());
+
+	const size_t positionSize = size_t(numVertices) * 3 * sizeof(uint16_t), normalSize = includeNormals ? size_t(numVertices) * 2 * sizeof(int16_t) : 0;
+	data.resize(sizeof(Header) + positionSize + normalSize + indexStream.size());
+	std::memcpy(data.data(), &header, sizeof(Header));
+
+	char* positions = data.data() + sizeof(Header), *normals = positions + positionSize;
+
+	#pragma omp parallel for
+	for (int vertexIdx = 0; vertexIdx < numVertices; ++vertexIdx)
+	{
+		const Model3D::VertexGPUData& vertex = vertices[vertexOrder[vertexIdx]];
+		const vec3 quantized = glm::clamp(glm::round((vertex._position - min) / extent * float(QUANTIZATION_LEVELS)), vec3(.0f), vec3(QUANTIZATION_LEVELS));
+		const uint16_t position[3] = { static_cast<uint16_t>(quantized.x), static_cast<uint16_t>(quantized.y), static_cast<uint16_t>(quantized.z) };
+		std::memcpy(positions + vertexIdx * sizeof(position), position, sizeof(position));
+
+		if (includeNormals)
+		{
+			const vec2 encoded = glm::round(encodeOctahedron(vertex._normal) * 32767.0f);
+			const int16_t normal[2] = { static_cast<int16_t>(encoded.x), static_cast<int16_t>(encoded.y) };
+			std::memcpy(normals + vertexIdx * sizeof(normal), normal, sizeof(normal));
+		}
+	}
+
+	if (!indexStream.empty()) std::memcpy(normals + normalSize, indexStream.data(), indexStream.size());
+}
+
+bool MeshCodec::read(const std::string& filename, Model3D::ModelComponent* component)
+{
+	std::ifstream fin(filename, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!fin.is_open()) return false;
+
+	std::vector<char> data(static_cast<size_t>(fin.tellg()));
+	fin.seekg(0);
+	fin.read(data.data(), data.size());
+
+	return fin.good() && MeshCodec::decode(data.data(), data.size(), component);
+}
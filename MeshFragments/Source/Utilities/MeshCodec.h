@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Graphics/Core/Model3D.h"
+
+/**
+*	@file MeshCodec.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Compact indexed mesh format (.binm, version 2). Positions are quantized to 16 bits per axis within the bounding box of the mesh,
+*	normals are optionally stored with an octahedral encoding and faces are reordered for vertex cache locality (Tipsy) before
+*	their indices are delta-coded.
+*
+*	Layout (little-endian):
+*		Header					48 bytes, see MeshCodec::Header.
+*		Positions				3 x uint16 per vertex.
+*		Normals					2 x int16 per vertex, only if the HAS_NORMALS flag is set.
+*		Indices					_indexStreamSize bytes. Vertices are numbered by their first use, so every index is written as
+*								the distance to the next unused vertex (zero for a new vertex) with a LEB128 varint.
+*	Decoded vertices and faces follow the optimized order rather than the original one; winding is preserved.
+*/
+namespace MeshCodec
+{
+	const uint32_t HAS_NORMALS = 1;								//!< Flag of meshes with encoded normals
+	const uint32_t QUANTIZATION_LEVELS = 65535;					//!< Largest quantized coordinate
+	const uint32_t VERTEX_CACHE_SIZE = 16;							//!< Size of the simulated vertex cache
+
+	struct Header
+	{
+		char		_magic[4];									//!< BINM
+		uint32_t	_version;									//!< Layout version
+		uint32_t	_numVertices;								//!< Number of vertices
+		uint32_t	_numFaces;									//!< Number of triangles
+		uint32_t	_flags;										//!< Combination of HAS_NORMALS
+		float		_min[3];									//!< Minimum corner of the quantization box
+		float		_max[3];									//!< Maximum corner of the quantization box
+		uint32_t	_indexStreamSize;							//!< Bytes of the varint index stream
+	};
+
+	/**
+	*	@brief Decodes a buffer written by encode into the geometry and topology of a component.
+	*	@return False if the buffer is not a valid mesh.
+	*/
+	bool decode(const char* data, size_t size, Model3D::ModelComponent* component);
+
+	/**
+	*	@brief Encodes the geometry and topology of a component into a buffer with the layout described above.
+	*/
+	void encode(const Model3D::ModelComponent* component, bool includeNormals, std::vector<char>& data);
+
+	/**
+	*	@brief Reads a .binm file into a component.
+	*	@return False if the file could not be read or is not a valid mesh.
+	*/
+	bool read(const std::string& filename, Model3D::ModelComponent* component);
+}
@@ -0,0 +1,183 @@
+#include "stdafx.h"
+#include "NumpyFile.h"
+
+/// Private functions
+
+namespace
+{
+	template<typename T>
+	void appendValue(std::vector<char>& buffer, T value)
+	{
+		const char* bytes = reinterpret_cast<const char*>(&value);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+}
+
+/// Public functions
+
+void NumpyFile::NpzArchive::add(const std::string& name, const char* descr, const std::vector<size_t>& shape, const void* data, size_t numBytes)
+{
+	const std::string header = NumpyFile::getHeader(descr, shape);
+
+	ArchiveEntry entry;
+	entry._name = name;
+	entry._content.resize(header.size() + numBytes);
+	std::memcpy(entry._content.data(), header.data(), header.size());
+	std::memcpy(entry._content.data() + header.size(), data, numBytes);
+	entry._crc = NumpyFile::crc32(entry._content.data(), entry._content.size());
+
+	_entries.push_back(std::move(entry));
+}
+
+bool NumpyFile::NpzArchive::write(const std::string& filename) const
+{
+	std::ofstream file(filename, std::ios::out | std::ios::binary);
+	if (!file.is_open()) return false;
+
+	const bool success = this->write(file);
+	file.close();
+	if (!success) std::filesystem::remove(filename);
+
+	return success && !file.fail();
+}
+
+bool NumpyFile::NpzArchive::write(std::ostream& stream) const
+{
+	const uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50, CENTRAL_HEADER_SIGNATURE = 0x02014b50, END_OF_DIRECTORY_SIGNATURE = 0x06054b50;
+	const uint16_t ZIP_VERSION = 20, DOS_DATE = (1 << 5) | 1, ALIGNMENT_EXTRA_ID = 0xD935;
+	const size_t LOCAL_HEADER_SIZE = 30, ALIGNMENT_EXTRA_SIZE = 4;
+
+	std::vector<char> localHeader, centralDirectory;
+	size_t offset = 0;
+
+	for (const ArchiveEntry& entry : _entries)
+	{
+		const std::string name = entry._name + ".npy";
+		const size_t contentOffset = offset + LOCAL_HEADER_SIZE + name.size() + ALIGNMENT_EXTRA_SIZE;
+		const uint16_t padding = static_cast<uint16_t>((NPY_ALIGNMENT - contentOffset % NPY_ALIGNMENT) % NPY_ALIGNMENT);
+		const uint32_t size = static_cast<uint32_t>(entry._content.size());
+
+		if (contentOffset + padding + entry._content.size() > std::numeric_limits<uint32_t>::max())
+			return false;
+
+		// Local header, whose extra field pads the member so that it starts at an aligned offset
+		localHeader.clear();
+		appendValue(localHeader, LOCAL_HEADER_SIGNATURE);
+		appendValue(localHeader, ZIP_VERSION);
+		appendValue(localHeader, uint16_t(0));							// Flags
+		appendValue(localHeader, uint16_t(0));							// Stored
+		appendValue(localHeader, uint16_t(0));							// Time
+		appendValue(localHeader, DOS_DATE);
+		appendValue(localHeader, entry._crc);
+		appendValue(localHeader, size);
+		appendValue(localHeader, size);
+		appendValue(localHeader, static_cast<uint16_t>(name.size()));
+		appendValue(localHeader, static_cast<uint16_t>(ALIGNMENT_EXTRA_SIZE + padding));
+		localHeader.insert(localHeader.end(), name.begin(), name.end());
+		appendValue(localHeader, ALIGNMENT_EXTRA_ID);
+		appendValue(localHeader, padding);
+		localHeader.resize(localHeader.size() + padding, 0);
+
+		stream.write(localHeader.data(), localHeader.size());
+		stream.write(entry._content.data(), entry._content.size());
+
+		appendValue(centralDirectory, CENTRAL_HEADER_SIGNATURE);
+		appendValue(centralDirectory, ZIP_VERSION);						// Made by
+		appendValue(centralDirectory, ZIP_VERSION);						// Needed to extract
+		appendValue(centralDirectory, uint16_t(0));
+		appendValue(centralDirectory, uint16_t(0));
+		appendValue(centralDirectory, uint16_t(0));
+		appendValue(centralDirectory, DOS_DATE);
+		appendValue(centralDirectory, entry._crc);
+		appendValue(centralDirectory, size);
+		appendValue(centralDirectory, size);
+		appendValue(centralDirectory, static_cast<uint16_t>(name.size()));
+		appendValue(centralDirectory, uint16_t(0));						// Extra field
+		appendValue(centralDirectory, uint16_t(0));						// Comment
+		appendValue(centralDirectory, uint16_t(0));						// Disk
+		appendValue(centralDirectory, uint16_t(0));						// Internal attributes
+		appendValue(centralDirectory, uint32_t(0));						// External attributes
+		appendValue(centralDirectory, static_cast<uint32_t>(offset));
+		centralDirectory.insert(centralDirectory.end(), name.begin(), name.end());
+
+		offset += localHeader.size() + entry._content.size();
+	}
+
+	const uint32_t centralDirectorySize = static_cast<uint32_t>(centralDirectory.size());
+	appendValue(centralDirectory, END_OF_DIRECTORY_SIGNATURE);
+	appendValue(centralDirectory, uint16_t(0));
+	appendValue(centralDirectory, uint16_t(0));
+	appendValue(centralDirectory, static_cast<uint16_t>(_entries.size()));
+	appendValue(centralDirectory, static_cast<uint16_t>(_entries.size()));
+	appendValue(centralDirectory, centralDirectorySize);
+	appendValue(centralDirectory, static_cast<uint32_t>(offset));
+	appendValue(centralDirectory, uint16_t(0));
+
+	stream.write(centralDirectory.data(), centralDirectory.size());
+
+	return !stream.fail();
+}
+
+uint32_t NumpyFile::crc32(const char* data, size_t size)
+{
+	static const std::array<uint32_t, 256> table = []()
+	{
+		std::array<uint32_t, 256> crcTable;
+		for (uint32_t idx = 0; idx < 256; ++idx)
+		{
+			uint32_t crc = idx;
+			for (int bit = 0; bit < 8; ++bit)
+				crc = (crc & 1) ? (0xEDB88320u ^ (crc >> 1)) : (crc >> 1);
+			crcTable[idx] = crc;
+		}
+
+		return crcTable;
+	}();
+
+	uint32_t crc = 0xFFFFFFFFu;
+	for (size_t idx = 0; idx < size; ++idx)
+		crc = table[(crc ^ static_cast<uint8_t>(data[idx])) & 0xFF] ^ (crc >> 8);
+
+	return crc ^ 0xFFFFFFFFu;
+}
+
+std::string NumpyFile::getHeader(const char* descr, const std::vector<size_t>& shape)
+{
+	const size_t PREAMBLE_SIZE = 10;						// Magic string, version and header length
+
+	std::string dictionary = std::string("{'descr': '") + descr + "', 'fortran_order': False, 'shape': (";
+	for (size_t idx = 0; idx < shape.size(); ++idx)
+		dictionary += std::to_string(shape[idx]) + (idx + 1 < shape.size() ? ", " : "");
+	dictionary += (shape.size() == 1 ? ",), }" : "), }");
+
+	// Spaces and a final newline complete the header up to the alignment
+	const size_t headerSize = (PREAMBLE_SIZE + dictionary.size() + 1 + NPY_ALIGNMENT - 1) / NPY_ALIGNMENT * NPY_ALIGNMENT;
+	dictionary.append(headerSize - PREAMBLE_SIZE - dictionary.size() - 1, ' ');
+	dictionary += '\n';
+
+	const uint16_t dictionarySize = static_cast<uint16_t>(dictionary.size());
+	std::string header = "\x93NUMPY";
+	header += static_cast<char>(1);
+	header += static_cast<char>(0);
+	header.append(reinterpret_cast<const char*>(&dictionarySize), sizeof(uint16_t));
+
+	return header + dictionary;
+}
+
+bool NumpyFile::save(const std::string& filename, const char* descr, const std::vector<size_t>& shape, const void* data, size_t numBytes)
+{
+	std::ofstream file(filename, std::ios::out | std::ios::binary);
+	if (!file.is_open()) return false;
+
+	NumpyFile::write(file, descr, shape, data, numBytes);
+	file.close();
+
+	return !file.fail();
+}
+
+void NumpyFile::write(std::ostream& stream, const char* descr, const std::vector<size_t>& shape, const void* data, size_t numBytes)
+{
+	const std::string header = NumpyFile::getHeader(descr, shape);
+	stream.write(header.data(), header.size());
+	stream.write(static_cast<const char*>(data), numBytes);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "stdafx.h"
+
+/**
+*	@file NumpyFile.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Writers of NumPy .npy arrays and uncompressed .npz archives, so that exported data is read by np.load with no further conversion.
+*/
+namespace NumpyFile
+{
+	//!< Both the array data of a .npy file and every member of an .npz archive start at a multiple of this value
+	const size_t NPY_ALIGNMENT = 64;
+
+	/**
+	*	@brief Array of an .npz archive, already serialized as a .npy file.
+	*/
+	struct ArchiveEntry
+	{
+		std::string			_name;									//!< Key of the array once loaded, without the .npy extension
+		std::vector<char>	_content;								//!< Serialized .npy file
+		uint32_t			_crc;									//!< CRC-32 of the serialized file
+	};
+
+	/**
+	*	@brief Set of arrays written as a single zip file with stored (uncompressed) members.
+	*/
+	class NpzArchive
+	{
+	protected:
+		std::vector<ArchiveEntry>	_entries;						//!< Arrays to be written
+
+	public:
+		/**
+		*	@brief Serializes a new array into the archive.
+		*/
+		void add(const std::string& name, const char* descr, const std::vector<size_t>& shape, const void* data, size_t numBytes);
+
+		/**
+		*	@return True if no array has been added yet.
+		*/
+		bool empty() const { return _entries.empty(); }
+
+		/**
+		*	@brief Writes every array into a .npz file. Archives larger than 4GB are rejected since zip64 records are not written.
+		*/
+		bool write(const std::string& filename) const;
+
+		/**
+		*	@brief Writes every array into a stream with the layout of a .npz file.
+		*/
+		bool write(std::ostream& stream) const;
+	};
+
+	/**
+	*	@return CRC-32 checksum of a buffer, as required by zip files.
+	*/
+	uint32_t crc32(const char* data, size_t size);
+
+	/**
+	*	@return Header of a .npy file (version 1.0) describing a C-ordered array, padded so that the data is aligned to NPY_ALIGNMENT.
+	*	@param descr NumPy type string, e.g. "|u1", "<u2" or "<f4".
+	*/
+	std::string getHeader(const char* descr, const std::vector<size_t>& shape);
+
+	/**
+	*	@brief Writes a C-ordered array as a .npy file.
+	*/
+	bool save(const std::string& filename, const char* descr, const std::vector<size_t>& shape, const void* data, size_t numBytes);
+
+	/**
+	*	@brief Writes a C-ordered array into a stream with the layout of a .npy file.
+	*/
+	void write(std::ostream& stream, const char* descr, const std::vector<size_t>& shape, const void* data, size_t numBytes);
+}
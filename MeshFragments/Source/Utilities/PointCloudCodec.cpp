@@ -0,0 +1,261 @@
+#include "stdafx.h"
+#include "PointCloudCodec.h"
+
+/// Private functions
+
+namespace
+{
+	/**
+	*	@brief Writes bits into 64-bit words, starting from the least significant bit.
+	*/
+	class BitWriter
+	{
+	protected:
+		uint64_t				_accumulator;
+		uint32_t				_numBits;
+		std::vector<uint64_t>	_words;
+
+	public:
+		BitWriter(size_t reservedWords) : _accumulator(0), _numBits(0) { _words.reserve(reservedWords); }
+
+		void flush() { if (_numBits) _words.push_back(_accumulator); _accumulator = 0; _numBits = 0; }
+		const std::vector<uint64_t>& getWords() const { return _words; }
+
+		void write(uint64_t value, uint32_t numBits)
+		{
+			while (numBits)
+			{
+				const uint32_t chunkBits = std::min(numBits, 64 - _numBits);
+				const uint64_t chunk = chunkBits == 64 ? value : value & ((uint64_t(1) << chunkBits) - 1);
+
+				_accumulator |= chunk << _numBits;
+				_numBits += chunkBits;
+				value = chunkBits == 64 ? 0 : value >> chunkBits;
+				numBits -= chunkBits;
+
+				if (_numBits == 64)
+				{
+					_words.push_back(_accumulator);
+					_accumulator = 0;
+					_numBits = 0;
+				}
+			}
+		}
+	};
+
+	/**
+	*	@brief Reads bits written by BitWriter. Reading beyond the end returns zeros and flags the reader.
+	*/
+	class BitReader
+	{
+	protected:
+		const char*		_data;
+		size_t			_numWords;
+		size_t			_bitPosition;
+
+	public:
+		bool			_overflow;
+
+		BitReader(const char* data, size_t numWords) : _data(data), _numWords(numWords), _bitPosition(0), _overflow(false) {}
+
+		uint64_t peek(uint32_t numBits) const
+		{
+			uint64_t value = 0;
+			uint32_t readBits = 0;
+			size_t bitPosition = _bitPosition;
+
+			while (readBits < numBits)
+			{
+				const size_t wordIdx = bitPosition >> 6;
+				if (wordIdx >= _numWords) break;
+
+				uint64_t word;
+				std::memcpy(&word, _data + wordIdx * sizeof(uint64_t), sizeof(uint64_t));
+
+				const uint32_t offset = bitPosition & 63, chunkBits = std::min(numBits - readBits, 64 - offset);
+				const uint64_t chunk = (word >> offset) & (chunkBits == 64 ? ~uint64_t(0) : (uint64_t(1) << chunkBits) - 1);
+
+				value |= chunk << readBits;
+				readBits += chunkBits;
+				bitPosition += chunkBits;
+			}
+
+			return value;
+		}
+
+		uint64_t read(uint32_t numBits)
+		{
+			const uint64_t value = this->peek(numBits);
+			this->skip(numBits);
+
+			return value;
+		}
+
+		void skip(uint32_t numBits)
+		{
+			_bitPosition += numBits;
+			_overflow |= _bitPosition > _numWords * 64;
+		}
+
+		/**
+		*	@return Number of consecutive ones, up to limit. The terminating zero is consumed if found.
+		*/
+		uint32_t readUnary(uint32_t limit)
+		{
+			uint64_t bits = this->peek(limit + 1);
+			uint32_t count = 0;
+			while (count < limit && (bits & 1))
+			{
+				bits >>= 1;
+				++count;
+			}
+
+			this->skip(count < limit ? count + 1 : count);
+
+			return count;
+		}
+	};
+
+	uint64_t expandBits(uint64_t value)
+	{
+		value &= 0xFFFF;
+		value = (value | value << 32) & 0x1F00000000FFFF;
+		value = (value | value << 16) & 0x1F0000FF0000FF;
+		value = (value | value << 8) & 0x100F00F00F00F00F;
+		value = (value | value << 4) & 0x10C30C30C30C30C3;
+		value = (value | value << 2) & 0x1249249249249249;
+
+		return value;
+	}
+
+	uint32_t compactBits(uint64_t value)
+	{
+		value &= 0x1249249249249249;
+		value = (value ^ (value >> 2)) & 0x10C30C30C30C30C3;
+		value = (value ^ (value >> 4)) & 0x100F00F00F00F00F;
+		value = (value ^ (value >> 8)) & 0x1F0000FF0000FF;
+		value = (value ^ (value >> 16)) & 0x1F00000000FFFF;
+		value = (value ^ (value >> 32)) & 0x1FFFFF;
+
+		return static_cast<uint32_t>(value);
+	}
+
+	uint64_t getRiceCost(const std::vector<uint64_t>& gaps, uint32_t riceParameter)
+	{
+		uint64_t cost = 0;
+		for (uint64_t gap : gaps)
+		{
+			const uint64_t quotient = gap >> riceParameter;
+			cost += quotient < PointCloudCodec::ESCAPE_QUOTIENT ? quotient + 1 + riceParameter : PointCloudCodec::ESCAPE_QUOTIENT + PointCloudCodec::MORTON_BITS;
+		}
+
+		return cost;
+	}
+}
+
+/// Public functions
+
+bool PointCloudCodec::decode(const char* data, size_t size, std::vector<vec4>& points)
+{
+	static_assert(sizeof(Header) == 48, "Header is read as a raw struct");
+
+	Header header;
+	if (size < sizeof(Header)) return false;
+	std::memcpy(&header, data, sizeof(Header));
+
+	if (std::strncmp(header._magic, "BINQ", 4) != 0 || header._riceParameter >= MORTON_BITS || sizeof(Header) + header._payloadSize > size) return false;
+
+	const vec3 min(header._min[0], header._min[1], header._min[2]), scale = (vec3(header._max[0], header._max[1], header._max[2]) - min) / float(QUANTIZATION_LEVELS);
+	BitReader reader(data + sizeof(Header), header._payloadSize / sizeof(uint64_t));
+	uint64_t code = 0;
+
+	points.resize(header._numPoints);
+	for (uint32_t pointIdx = 0; pointIdx < header._numPoints; ++pointIdx)
+	{
+		const uint32_t quotient = reader.readUnary(ESCAPE_QUOTIENT);
+		if (quotient < ESCAPE_QUOTIENT)
+			code += (uint64_t(quotient) << header._riceParameter) | reader.read(header._riceParameter);
+		else
+			code += reader.read(MORTON_BITS);
+
+		points[pointIdx] = vec4(min + vec3(compactBits(code), compactBits(code >> 1), compactBits(code >> 2)) * scale, 1.0f);
+	}
+
+	return !reader._overflow;
+}
+
+void PointCloudCodec::encode(const std::vector<vec4>& points, std::vector<char>& data)
+{
+	const int numPoints = static_cast<int>(points.size());
+
+	Header header{ { 'B', 'I', 'N', 'Q' }, 1, static_cast<uint32_t>(numPoints), 0, { .0f, .0f, .0f }, { .0f, .0f, .0f }, 0 };
+	vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+	for (const vec4& point : points)
+	{
+		min = glm::min(min, vec3(point));
+		max = glm::max(max, vec3(point));
+	}
+
+	if (numPoints == 0) min = max = vec3(.0f);
+	const vec3 extent = glm::max(max - min, vec3(std::numeric_limits<float>::epsilon()));
+
+	// Quantization and Morton codes
+	std::vector<uint64_t> codes(numPoints);
+
+	#pragma omp parallel for
+	for (int pointIdx = 0; pointIdx < numPoints; ++pointIdx)
+	{
+		const uvec3 quantized(glm::clamp(glm::round((vec3(points[pointIdx]) - min) / extent * float(QUANTIZATION_LEVELS)), vec3(.0f), vec3(QUANTIZATION_LEVELS)));
+		codes[pointIdx] = expandBits(quantized.x) | (expandBits(quantized.y) << 1) | (expandBits(quantized.z) << 2);
+	}
+
+	std::sort(codes.begin(), codes.end());
+
+	std::vector<uint64_t> gaps(numPoints);
+	for (int pointIdx = numPoints - 1; pointIdx >= 0; --pointIdx)
+		gaps[pointIdx] = codes[pointIdx] - (pointIdx ? codes[pointIdx - 1] : 0);
+
+	// The Rice parameter is refined around the logarithm of the mean gap
+	const uint64_t meanGap = numPoints ? codes.back() / numPoints : 0;
+	int riceParameter = 0;
+	while (riceParameter + 1 < MORTON_BITS && (uint64_t(1) << (riceParameter + 1)) <= meanGap) ++riceParameter;
+
+	uint64_t bestCost = std::numeric_limits<uint64_t>::max();
+	for (int candidate = std::max(0, riceParameter - 3); candidate <= std::min(int(MORTON_BITS) - 1, riceParameter + 3); ++candidate)
+	{
+		const uint64_t cost = getRiceCost(gaps, candidate);
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			header._riceParameter = candidate;
+		}
+	}
+
+	BitWriter writer(bestCost / 64 + 1);
+	for (uint64_t gap : gaps)
+	{
+		const uint64_t quotient = gap >> header._riceParameter;
+		if (quotient < ESCAPE_QUOTIENT)
+		{
+			writer.write((uint64_t(1) << quotient) - 1, static_cast<uint32_t>(quotient) + 1);
+			writer.write(gap, header._riceParameter);
+		}
+		else
+		{
+			writer.write((uint64_t(1) << ESCAPE_QUOTIENT) - 1, ESCAPE_QUOTIENT);
+			writer.write(gap, MORTON_BITS);
+		}
+	}
+	writer.flush();
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		header._min[axis] = min[axis];
+		header._max[axis] = min[axis] + extent[axis];
+	}
+	header._payloadSize = writer.getWords().size() * sizeof(uint64_t);
+
+	data.resize(sizeof(Header) + header._payloadSize);
+	std::memcpy(data.data(), &header, sizeof(Header));
+	std::memcpy(data.data() + sizeof(Header), writer.getWords().data(), header._payloadSize);
+}
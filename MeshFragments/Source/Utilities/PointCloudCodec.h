@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+*	@file PointCloudCodec.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Lightweight point cloud compression without PCL. Points are quantized to 16 bits per axis within their bounding box,
+*	sorted along a Morton curve and the gaps between consecutive codes are written with Golomb-Rice codes.
+*
+*	Layout (little-endian):
+*		Header					48 bytes, see PointCloudCodec::Header.
+*		Bitstream				_payloadSize bytes, bits are read from the least significant bit of each 64-bit word onwards. For each point:
+*			q ones + one zero		Quotient of the gap to the previous Morton code (the first gap is measured from zero), q < ESCAPE_QUOTIENT.
+*			_riceParameter bits		Remainder of the gap.
+*		A gap whose quotient is ESCAPE_QUOTIENT or larger is written as ESCAPE_QUOTIENT ones followed by the gap in MORTON_BITS bits.
+*	Decoded points follow the Morton order rather than the original one; duplicated points are kept.
+*/
+namespace PointCloudCodec
+{
+	const uint32_t ESCAPE_QUOTIENT = 24;						//!< Longest unary quotient before the gap is written verbatim
+	const uint32_t MORTON_BITS = 48;							//!< Bits of a Morton code built from 16-bit coordinates
+	const uint32_t QUANTIZATION_LEVELS = 65535;					//!< Largest quantized coordinate
+
+	struct Header
+	{
+		char		_magic[4];									//!< BINQ
+		uint32_t	_version;									//!< Layout version
+		uint32_t	_numPoints;									//!< Number of encoded points
+		uint32_t	_riceParameter;								//!< Bits of the remainder of each gap
+		float		_min[3];									//!< Minimum corner of the quantization box
+		float		_max[3];									//!< Maximum corner of the quantization box
+		uint64_t	_payloadSize;								//!< Bytes of the bitstream, a multiple of 8
+	};
+
+	/**
+	*	@brief Decodes a buffer written by encode.
+	*	@return False if the buffer is not a valid stream.
+	*/
+	bool decode(const char* data, size_t size, std::vector<vec4>& points);
+
+	/**
+	*	@brief Encodes a point cloud into a buffer with the layout described above.
+	*/
+	void encode(const std::vector<vec4>& points, std::vector<char>& data);
+}
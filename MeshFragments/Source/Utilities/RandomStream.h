@@ -0,0 +1,159 @@
+#pragma once
+
+#include "stdafx.h"
+
+/**
+*	@file RandomStream.h
+*	@authors Alfonso Lpez Ruiz (alr00048@red.ujaen.es)
+*	@date 18/10/2026
+*/
+
+/**
+*	@brief Counter-based random number generator. The i-th value of a stream is a SplitMix64 hash of its key and i, hence values can be drawn 
+*	in any order and from any thread. Keys combine the global seed, model, iteration and stage, so that every stochastic stage of an iteration is 
+*	reproducible regardless of what was drawn before or of the number of threads.
+*/
+class RandomStream
+{
+public:
+	enum Stage : uint32_t { SEEDING, EXTRA_SEEDING, NEAR_SEEDING, EROSION_NOISE, CLUSTER_NOISE, POINT_CLOUD_SAMPLING, REFRACTURE, NUM_STAGES };
+
+protected:
+	uint64_t	_counter;			//!< Index of the next value drawn sequentially
+	uint64_t	_key;				//!< Hash of seed, model, iteration and stage
+
+public:
+	/**
+	*	@brief Constructor of a stream identified by the given tuple.
+	*/
+	RandomStream(uint64_t seed = 0, uint64_t model = 0, uint64_t iteration = 0, uint32_t stage = 0);
+
+	/**
+	*	@return 64-bit value at the given index of the stream.
+	*/
+	uint64_t at(uint64_t index) const;
+
+	/**
+	*	@return Random value biased towards the middle of [min, max), as the sum of divs uniform integers. Drawn sequentially.
+	*/
+	int getBiasedRandomInt(int min, int max, int divs);
+
+	/**
+	*	@return Value at the given index from a normal distribution.
+	*/
+	float getNormalRandom(float mean, float deviation, uint64_t index) const;
+
+	/**
+	*	@return Independent stream derived from the current one.
+	*/
+	RandomStream getSubstream(uint64_t index) const;
+
+	/**
+	*	@return Value at the given index from a uniform distribution in [0, 1).
+	*/
+	float getUniformRandom(uint64_t index) const;
+
+	/**
+	*	@return Value at the given index from a uniform distribution in [min, max).
+	*/
+	float getUniformRandom(float min, float max, uint64_t index) const;
+
+	/**
+	*	@return Next value from a uniform distribution in [min, max).
+	*/
+	float getUniformRandom(float min, float max);
+
+	/**
+	*	@return Next integer value in [min, max), following RandomUtilities::getUniformRandomInt.
+	*/
+	int getUniformRandomInt(int min, int max);
+
+	/**
+	*	@return FNV-1a hash of a string, e.g., to key a stream by the name of a model.
+	*/
+	static uint64_t hash(const std::string& string);
+
+	/**
+	*	@return SplitMix64 finalizer of value.
+	*/
+	static uint64_t mix(uint64_t value);
+
+	/**
+	*	@return Next 64-bit value of the stream.
+	*/
+	uint64_t next() { return this->at(_counter++); }
+};
+
+inline RandomStream::RandomStream(uint64_t seed, uint64_t model, uint64_t iteration, uint32_t stage) : _counter(0)
+{
+	_key = mix(mix(mix(mix(seed) ^ model) ^ iteration) ^ stage);
+}
+
+inline uint64_t RandomStream::at(uint64_t index) const
+{
+	return mix(_key + (index + 1) * 0x9E3779B97F4A7C15ull);
+}
+
+inline int RandomStream::getBiasedRandomInt(int min, int max, int divs)
+{
+	int number = min;
+	const int range = glm::max((max - min) / divs, 1);
+
+	for (int i = 0; i < divs; ++i)
+		number += static_cast<int>(this->next() % range);
+
+	return number;
+}
+
+inline float RandomStream::getNormalRandom(float mean, float deviation, uint64_t index) const
+{
+	// Box-Muller transform over two values of the stream
+	const float u1 = glm::max(this->getUniformRandom(index * 2), std::numeric_limits<float>::min()), u2 = this->getUniformRandom(index * 2 + 1);
+
+	return mean + deviation * std::sqrt(-2.0f * std::log(u1)) * std::cos(2.0f * glm::pi<float>() * u2);
+}
+
+inline RandomStream RandomStream::getSubstream(uint64_t index) const
+{
+	RandomStream stream;
+	stream._key = mix(_key ^ mix(index + 1));
+
+	return stream;
+}
+
+inline float RandomStream::getUniformRandom(uint64_t index) const
+{
+	return static_cast<float>(this->at(index) >> 40) * (1.0f / 16777216.0f);
+}
+
+inline float RandomStream::getUniformRandom(float min, float max, uint64_t index) const
+{
+	return min + (max - min) * this->getUniformRandom(index);
+}
+
+inline float RandomStream::getUniformRandom(float min, float max)
+{
+	return this->getUniformRandom(min, max, _counter++);
+}
+
+inline int RandomStream::getUniformRandomInt(int min, int max)
+{
+	return static_cast<int>(this->getUniformRandom(min, max));
+}
+
+inline uint64_t RandomStream::hash(const std::string& string)
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (const char character : string)
+		hash = (hash ^ static_cast<uint8_t>(character)) * 0x100000001B3ull;
+
+	return hash;
+}
+
+inline uint64_t RandomStream::mix(uint64_t value)
+{
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+
+	return value ^ (value >> 31);
+}
@@ -1,7 +1,9 @@
 #include "stdafx.h"
 
 #include "Graphics/Application/CADScene.h"
+#include "Graphics/Application/GoldenDigest.h"
 #include "Graphics/Application/Renderer.h"
+#include "Graphics/Application/StageBenchmark.h"
 #include "Graphics/Core/FragmentationProcedure.h"
 #include "Interface/Window.h"
 
@@ -21,6 +23,20 @@ int main(int argc, char* argv[])
 {
 	srand(time(nullptr));
 
+#if GENERATE_DATASET
+	// CPU-only golden jobs need neither a window nor an OpenGL context, hence they are checked or recorded on headless machines through this switch
+	const std::string mode = argc > 1 ? argv[1] : "";
+	if (mode == "--golden-cpu" || mode == "--golden-cpu-record")
+	{
+		GoldenDigest goldenDigest;
+		const bool success = goldenDigest.run("Output/GoldenCPU/", "Assets/Golden/digests_cpu.tsv", mode == "--golden-cpu-record", true);
+		if (!success)
+			std::cout << "__ Outputs diverge from the golden digests __" << std::endl;
+
+		return success ? 0 : 1;
+	}
+#endif
+
 	std::cout << "__ Starting fragmentation __" << std::endl;
 
 	const std::string title = "Vessel fragmentation";
@@ -33,6 +49,15 @@ int main(int argc, char* argv[])
 #if !GENERATE_DATASET
 			Renderer::getInstance()->getCurrentScene()->load();
 			window->startRenderingCycle();
+#elif BENCHMARK_MODE
+			FragmentationProcedure procedure;
+			StageBenchmark benchmark;
+			if (!benchmark.run("Output/Benchmark/", procedure._folder, procedure._searchExtension))
+				std::cout << "__ Failed to write benchmark results __" << std::endl;
+#elif GOLDEN_DIGEST_MODE
+			GoldenDigest goldenDigest;
+			if (!goldenDigest.run("Output/Golden/", "Assets/Golden/digests.tsv", GOLDEN_DIGEST_RECORD))
+				std::cout << "__ Outputs diverge from the golden digests __" << std::endl;
 #else
 			FragmentationProcedure procedure;
 			CADScene* scene = dynamic_cast<CADScene*>(Renderer::getInstance()->getCurrentScene());
@@ -5,13 +5,29 @@ import numpy as np
 from struct import unpack
 
 folder = 'samples/'
-grid_extension = 'rle'
+grid_extension = 'rle'              # 'rle' or 'bing'; 'npy' grids are exported ready to np.load, already flipped and padded
+
+
+def read_bing(grid_path):
+    # header: magic (4), version, bytes per voxel, flags, padding, stored dims (3 x uint32), grid dims (3 x uint32)
+    with open(grid_path, 'rb') as f:
+        magic, version, bytes_per_voxel, flags, _, width, height, depth, _, _, _ = unpack('<4sBBBB6I', f.read(32))
+        assert magic == b'BING' and bytes_per_voxel == 2
+        grid = np.fromfile(f, dtype='<u2', count=width * height * depth)
+
+    # the payload is already flipped in y and, if flags & 2, padded to a cube
+    return grid.reshape((width, height, depth)).astype(np.uint8)
 
 if __name__ == '__main__':
     # get grids in folder
     grids = glob.glob(folder + '*.' + grid_extension)
 
     for grid_path in grids:
+        if grid_extension == 'bing':
+            grid = read_bing(grid_path)
+            grid.tofile(grid_path.replace('.' + grid_extension, '.npy'))
+            continue
+
         # read binary file
         with open(grid_path, 'rb') as f:
             # read three unsigned integers
@@ -7,6 +7,76 @@ import numpy as np
 folder = 'samples/'
 mesh_extension = 'binm'
 
+def read_varints(data, count):
+    values = np.zeros(count, dtype=np.uint32)
+    position = 0
+    for value_idx in range(count):
+        value, shift = 0, 0
+        while True:
+            byte = data[position]
+            position += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                break
+        values[value_idx] = value
+
+    return values
+
+
+def decode_octahedron(encoded):
+    normals = np.zeros((encoded.shape[0], 3), dtype=np.float32)
+    normals[:, :2] = encoded
+    normals[:, 2] = 1.0 - np.abs(encoded[:, 0]) - np.abs(encoded[:, 1])
+    fold = np.maximum(-normals[:, 2], 0.0)
+    normals[:, 0] += np.where(normals[:, 0] >= 0.0, -fold, fold)
+    normals[:, 1] += np.where(normals[:, 1] >= 0.0, -fold, fold)
+
+    length = np.linalg.norm(normals, axis=1, keepdims=True)
+    return np.divide(normals, length, out=np.zeros_like(normals), where=length > 0)
+
+
+def read_binm(data):
+    # see MeshCodec.h: header, 16-bit positions, optional octahedral normals and varint indices
+    _, version, num_vertices, num_faces, flags = unpack('<4sIIII', data[:20])
+    aabb_min, aabb_max = np.array(unpack('<3f', data[20:32])), np.array(unpack('<3f', data[32:44]))
+    index_stream_size, = unpack('<I', data[44:48])
+    assert version == 2
+
+    position = 48
+    quantized = np.frombuffer(data, dtype='<u2', count=num_vertices * 3, offset=position).reshape(-1, 3)
+    vertices = (aabb_min + quantized * (aabb_max - aabb_min) / 65535.0).astype(np.float32)
+    position += num_vertices * 6
+
+    normals = None
+    if flags & 1:
+        encoded = np.frombuffer(data, dtype='<i2', count=num_vertices * 2, offset=position).reshape(-1, 2)
+        normals = decode_octahedron(np.clip(encoded / 32767.0, -1.0, 1.0))
+        position += num_vertices * 4
+
+    # every index is the distance to the next unused vertex
+    distances = read_varints(data[position:position + index_stream_size], num_faces * 3)
+    faces = np.zeros(num_faces * 3, dtype=np.uint32)
+    next_vertex = 0
+    for index_idx, distance in enumerate(distances):
+        faces[index_idx] = next_vertex - distance
+        next_vertex += distance == 0
+
+    return vertices, normals, faces.reshape(-1, 3)
+
+
+def read_binm_v1(data):
+    # raw VertexGPUData (16 floats) and FaceGPUData (4 uints) arrays, each preceded by its length
+    num_vertices, = unpack('<I', data[:4])
+    vertices = np.frombuffer(data, dtype='<f4', count=num_vertices * 16, offset=4).reshape(-1, 16)[:, :3].copy()
+
+    faces_offset = 4 + num_vertices * 64
+    num_faces, = unpack('<I', data[faces_offset:faces_offset + 4])
+    faces = np.frombuffer(data, dtype='<u4', count=num_faces * 4, offset=faces_offset + 4).reshape(-1, 4)[:, :3].copy()
+
+    return vertices, faces
+
+
 if __name__ == '__main__':
     # get grids in folder
     meshes = glob.glob(folder + '*.' + mesh_extension)
@@ -14,39 +84,25 @@ if __name__ == '__main__':
     for mesh_path in meshes:
         # read binary file
         with open(mesh_path, 'rb') as f:
-            num_vertices = int.from_bytes(f.read(4), byteorder='little')
-            f.read(4)        # read null float
-
-            # read until end of file
-            vertices = np.zeros((num_vertices, 3), dtype=np.float32)
-            vertices_data = unpack('f'*num_vertices*16, f.read(4*num_vertices*16))
-            for vertex_idx in range(num_vertices):
-                vertices[vertex_idx] = vertices_data[vertex_idx*16:vertex_idx*16+3]
-                vertices[vertex_idx][1] = -vertices[vertex_idx][1]         # flip z, only for our dataset
-
-            # faces
-            num_faces = int.from_bytes(f.read(4), byteorder='little')
-            f.read(4)       # null int
-
-            faces = np.zeros((num_faces, 3), dtype=np.uint32)
-            faces_data = unpack('I'*num_faces*4, f.read(4*num_faces*4))
-
-            for face_idx in range(num_faces):
-                faces[face_idx] = faces_data[face_idx*4:face_idx*4+3]
-
-            # save numpy arrays
-            vertices.tofile(mesh_path.replace('.' + mesh_extension, '_vertices.npy'))
-            faces.tofile(mesh_path.replace('.' + mesh_extension, '_faces.npy'))
-
-            # modify mesh for visualization
-            for vertex_idx in range(num_vertices):
-                # swap y and z
-                vertices[vertex_idx][1], vertices[vertex_idx][2] = vertices[vertex_idx][2], vertices[vertex_idx][1]
-
-            fig = plt.figure()
-            ax = fig.add_subplot(111, projection='3d')
-            ax.plot_trisurf(vertices[:, 0], vertices[:, 1], vertices[:, 2], triangles=faces)
-            ax.set_aspect('equal')
-            plt.tight_layout()
-            plt.savefig(mesh_path.replace('.' + mesh_extension, '.png'))
-            plt.show()
+            data = f.read()
+
+        if data[:4] == b'BINM':
+            vertices, normals, faces = read_binm(data)
+        else:
+            vertices, faces = read_binm_v1(data)
+        vertices[:, 1] = -vertices[:, 1]         # flip z, only for our dataset
+
+        # save numpy arrays
+        vertices.tofile(mesh_path.replace('.' + mesh_extension, '_vertices.npy'))
+        faces.tofile(mesh_path.replace('.' + mesh_extension, '_faces.npy'))
+
+        # modify mesh for visualization
+        vertices[:, [1, 2]] = vertices[:, [2, 1]]       # swap y and z
+
+        fig = plt.figure()
+        ax = fig.add_subplot(111, projection='3d')
+        ax.plot_trisurf(vertices[:, 0], vertices[:, 1], vertices[:, 2], triangles=faces)
+        ax.set_aspect('equal')
+        plt.tight_layout()
+        plt.savefig(mesh_path.replace('.' + mesh_extension, '.png'))
+        plt.show()
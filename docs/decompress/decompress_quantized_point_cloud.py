@@ -0,0 +1,63 @@
+import glob
+from struct import calcsize, unpack
+
+folder = 'samples/'
+extension = 'binq'
+
+# header: magic (4), version, number of points, rice parameter, min (3 x float), max (3 x float), payload size
+HEADER_FORMAT = '<4sIII6fQ'
+ESCAPE_QUOTIENT = 24
+MORTON_BITS = 48
+QUANTIZATION_LEVELS = 65535
+
+
+def compact_bits(code):
+    value = 0
+    for bit in range(16):
+        value |= ((code >> (3 * bit)) & 1) << bit
+    return value
+
+
+def read_binq(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    magic, version, num_points, rice, *bounds, payload_size = unpack(HEADER_FORMAT, data[:calcsize(HEADER_FORMAT)])
+    assert magic == b'BINQ'
+    min_corner, max_corner = bounds[:3], bounds[3:]
+    scale = [(max_corner[axis] - min_corner[axis]) / QUANTIZATION_LEVELS for axis in range(3)]
+
+    # bits are stored from the least significant bit of each byte onwards
+    payload = data[calcsize(HEADER_FORMAT):calcsize(HEADER_FORMAT) + payload_size]
+    bits = ''.join(format(byte, '08b')[::-1] for byte in payload)
+
+    points, code, position = [], 0, 0
+    for _ in range(num_points):
+        quotient = 0
+        while quotient < ESCAPE_QUOTIENT and bits[position] == '1':
+            quotient += 1
+            position += 1
+
+        if quotient < ESCAPE_QUOTIENT:
+            position += 1
+            remainder = int(bits[position:position + rice][::-1], 2) if rice else 0
+            position += rice
+            code += (quotient << rice) | remainder
+        else:
+            code += int(bits[position:position + MORTON_BITS][::-1], 2)
+            position += MORTON_BITS
+
+        points.append([min_corner[axis] + compact_bits(code >> axis) * scale[axis] for axis in range(3)])
+
+    return points
+
+
+if __name__ == '__main__':
+    for path in glob.glob(folder + '*.' + extension):
+        points = read_binq(path)
+        print('Loaded', len(points), 'points from', path)
+
+        # write as xyz
+        with open(path.replace('.' + extension, '.xyz'), 'w') as f:
+            for point in points:
+                f.write('%f %f %f\n' % tuple(point))
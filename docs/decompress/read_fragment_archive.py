@@ -0,0 +1,66 @@
+import os
+import sys
+import zlib
+from struct import calcsize, unpack
+
+# header: magic (4), version, index offset, number of entries
+HEADER_FORMAT = '<4sIQQ'
+# entry: payload offset, stored size, size, crc32, compression, padding, name length; followed by the name
+ENTRY_FORMAT = '<QQQIBBH'
+STORED, DEFLATE = 0, 1
+
+
+def read_entry_header(f):
+    offset, stored_size, size, crc, compression, _, name_length = unpack(ENTRY_FORMAT, f.read(calcsize(ENTRY_FORMAT)))
+    name = f.read(name_length).decode('utf-8')
+    return name, {'offset': offset, 'stored_size': stored_size, 'size': size, 'crc': crc, 'compression': compression}
+
+
+def read_index(archive_path):
+    with open(archive_path, 'rb') as f:
+        magic, version, index_offset, num_entries = unpack(HEADER_FORMAT, f.read(calcsize(HEADER_FORMAT)))
+        assert magic == b'FARC'
+
+        entries = {}
+        if index_offset:
+            f.seek(index_offset)
+            for _ in range(num_entries):
+                name, entry = read_entry_header(f)
+                entries[name] = entry
+        else:
+            # archive was not closed: walk the entry headers until a truncated one is found
+            file_size = os.path.getsize(archive_path)
+            offset = calcsize(HEADER_FORMAT)
+            while offset + calcsize(ENTRY_FORMAT) <= file_size:
+                f.seek(offset)
+                name, entry = read_entry_header(f)
+                if entry['offset'] != f.tell() or entry['offset'] + entry['stored_size'] > file_size:
+                    break
+                entries[name] = entry
+                offset = entry['offset'] + entry['stored_size']
+
+    return entries
+
+
+def read_entry(archive_path, entry):
+    with open(archive_path, 'rb') as f:
+        f.seek(entry['offset'])
+        data = f.read(entry['stored_size'])
+
+    if entry['compression'] == DEFLATE:
+        data = zlib.decompress(data)
+    assert len(data) == entry['size'] and zlib.crc32(data) == entry['crc']
+
+    return data
+
+
+if __name__ == '__main__':
+    # usage: read_fragment_archive.py archive.farc [destination folder]
+    archive_path = sys.argv[1]
+    destination = sys.argv[2] if len(sys.argv) > 2 else None
+
+    for name, entry in read_index(archive_path).items():
+        print(name, entry['size'], 'bytes')
+        if destination:
+            with open(os.path.join(destination, name), 'wb') as f:
+                f.write(read_entry(archive_path, entry))